@@ -0,0 +1,51 @@
+#include <stan/diff.hpp>
+#include <stan/driver/lilypond.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Measures stan::diff::compare() on two versions of a long score that differ
+// in a handful of places, the common case for review tooling.  Most of the
+// time goes to hashing every column once; Myers' search only sees the
+// stretch between the first and last change.
+//
+// usage: bench.diff [bars] [changes] [runs]
+
+int main(int argc, char **argv)
+{
+    int bars = argc > 1 ? std::stoi(argv[1]) : 25000;
+    int changes = argc > 2 ? std::stoi(argv[2]) : 10;
+    int runs = argc > 3 ? std::stoi(argv[3]) : 10;
+
+    // Four notes per bar: a quaver, a beamed pair and a three note chord.
+    std::string before;
+    std::string after;
+    for (int i = 0; i < bars; ++i) {
+        before += "c'8 [d'8 e'8] <c e g>4 ";
+        after += i % std::max(1, bars / changes) == 7 ? "c'8 [d'8 f'8] <c e g>4 "
+                                                      : "c'8 [d'8 e'8] <c e g>4 ";
+    }
+
+    stan::lilypond::reader read;
+    stan::sequential from = read.sequence(before);
+    stan::sequential to = read.sequence(after);
+
+    std::vector<double> millis;
+    std::size_t edits = 0;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        edits = stan::diff::compare(from, to).size();
+        millis.push_back(std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count());
+    }
+
+    std::sort(millis.begin(), millis.end());
+    fmt::print("diff of {} columns ({} notes), {} edits: min {:.2f}ms  median {:.2f}ms\n",
+               from.size(), bars * 6, edits, millis.front(), millis[millis.size() / 2]);
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <stan/index.hpp>
+#include <stan/driver/lilypond.hpp>
+
+#include <fmt/format.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Builds an index over a generated library of short scores and measures
+// the build and query times.  Each score is a random walk of quarter and
+// eighth notes, so n-grams repeat across scores about as often as they do
+// in real melodies.
+//
+// usage: bench.index [documents] [notes] [queries]
+
+namespace {
+
+const char *steps[] = { "c", "d", "e", "f", "g", "a", "b" };
+
+std::string random_melody(std::mt19937 &rng, int notes, std::vector<std::string> *fragment)
+{
+    std::string music;
+    int step = 14;
+    for (int i = 0; i < notes; ++i) {
+        step = std::clamp(step + static_cast<int>(rng() % 5) - 2, 7, 27);
+        std::string n = fmt::format("{}{}{} ", steps[step % 7], std::string(step / 7 - 1, '\''),
+                                    rng() % 3 ? "8" : "4");
+        music += n;
+        if (fragment and i < 6) {
+            fragment->push_back(n);
+        }
+    }
+    return music;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void remove_all(const std::string &path)
+{
+    DIR *dir = ::opendir(path.c_str());
+    while (dirent *d = dir ? ::readdir(dir) : nullptr) {
+        if (d->d_name[0] != '.') {
+            ::unlink((path + '/' + d->d_name).c_str());
+        }
+    }
+    if (dir) {
+        ::closedir(dir);
+    }
+    ::rmdir(path.c_str());
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int documents = argc > 1 ? std::stoi(argv[1]) : 50000;
+    int notes = argc > 2 ? std::stoi(argv[2]) : 64;
+    int queries = argc > 3 ? std::stoi(argv[3]) : 200;
+
+    char name[] = "/tmp/stan-bench-index.XXXXXX";
+    std::string root = ::mkdtemp(name);
+    std::string corpus = root + "/corpus";
+    std::string index = root + "/index";
+    ::mkdir(corpus.c_str(), 0755);
+
+    std::mt19937 rng(1);
+    std::vector<std::string> paths;
+    std::vector<std::string> fragments;
+    for (int d = 0; d < documents; ++d) {
+        std::vector<std::string> fragment;
+        paths.push_back(fmt::format("{}/{}.ly", corpus, d));
+        std::ofstream(paths.back()) << random_melody(rng, notes, &fragment);
+        if (d % std::max(1, documents / queries) == 0) {
+            std::string q;
+            for (const auto &n : fragment) {
+                q += n;
+            }
+            fragments.push_back(q);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    stan::index::build(index, paths);
+    double build = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    stan::index::searcher search(index);
+    double open = seconds_since(start);
+
+    stan::lilypond::reader read;
+    std::vector<double> millis;
+    std::size_t matches = 0;
+    for (const auto &f : fragments) {
+        stan::sequential q = read.sequence(f);
+        start = std::chrono::steady_clock::now();
+        matches += search.search(q).size();
+        millis.push_back(seconds_since(start) * 1000);
+    }
+    std::sort(millis.begin(), millis.end());
+
+    fmt::print("build {} documents of {} notes: {:.2f}s ({:.0f} documents/s)\n", documents, notes,
+               build, documents / build);
+    fmt::print("open: {:.2f}ms\n", open * 1000);
+    fmt::print("{} queries of 6 notes, {:.1f} matches each: median {:.3f}ms  max {:.3f}ms\n",
+               millis.size(), double(matches) / millis.size(), millis[millis.size() / 2],
+               millis.back());
+
+    remove_all(corpus);
+    remove_all(index);
+    ::rmdir(root.c_str());
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <stan/ingest.hpp>
+
+#include <fmt/format.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Measures files per second for loading a corpus of small scores: the naive
+// loop of one blocking open/read/close per file, stan::ingest() on a pool of
+// threads, and stan::ingest() on io_uring.  The corpus is generated in a
+// temporary directory and is normally hot in the page cache, so the numbers
+// are a lower bound on the gap for a cold cache or network storage, where each
+// blocking read waits longer.
+//
+// usage: bench.ingest [files] [bytes per file] [runs]
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+std::size_t naive(const std::vector<std::string> &paths)
+{
+    std::size_t bytes = 0;
+    std::string contents;
+    for (const auto &path : paths) {
+        std::ifstream in(path, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        bytes += contents.size();
+    }
+    return bytes;
+}
+
+std::size_t ingested(const std::vector<std::string> &paths, stan::ingest_backend backend)
+{
+    std::atomic<std::size_t> bytes{ 0 };
+    stan::ingest_options options;
+    options.m_backend = backend;
+    stan::ingest(
+        paths,
+        [&](std::size_t, std::string &contents, int) { bytes += contents.size(); },
+        options);
+    return bytes;
+}
+
+template <typename F>
+void measure(const char *name, std::size_t files, int runs, F &&f)
+{
+    double best = 0;
+    std::size_t bytes = 0;
+    for (int r = 0; r < runs; ++r) {
+        auto start = clock_type::now();
+        bytes = f();
+        double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+        best = std::max(best, files / seconds);
+    }
+    fmt::print("{:10} {:12.0f} files/s  ({} bytes)\n", name, best, bytes);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::size_t files = argc > 1 ? std::stoul(argv[1]) : 20000;
+    std::size_t size = argc > 2 ? std::stoul(argv[2]) : 400;
+    int runs = argc > 3 ? std::stoi(argv[3]) : 5;
+
+    char dir[] = "/tmp/stan-ingest.XXXXXX";
+    if (::mkdtemp(dir) == nullptr) {
+        fmt::print(stderr, "mkdtemp: {}\n", std::strerror(errno));
+        return 1;
+    }
+
+    std::string score;
+    while (score.size() < size) {
+        score += "c'8 d'8 [e'16 f'16 g'8] <c e g>4 ";
+    }
+    score.resize(size);
+
+    std::vector<std::string> paths;
+    for (std::size_t i = 0; i < files; ++i) {
+        paths.push_back(fmt::format("{}/{:06}.ly", dir, i));
+        std::ofstream(paths.back(), std::ios::binary) << score;
+    }
+
+    measure("naive", files, runs, [&] { return naive(paths); });
+    measure("threads", files, runs,
+            [&] { return ingested(paths, stan::ingest_backend::threads); });
+    try {
+        measure("io_uring", files, runs,
+                [&] { return ingested(paths, stan::ingest_backend::io_uring); });
+    } catch (std::exception &e) {
+        fmt::print("io_uring   {}\n", e.what());
+    }
+
+    for (const auto &path : paths) {
+        ::unlink(path.c_str());
+    }
+    ::rmdir(dir);
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <stan/intern.hpp>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Measures interning throughput from 1 to 64 threads at once, as parser
+// threads sharing one table would.  Each thread interns a stream of keys of
+// which most have been seen before, so lookups dominate as they do for the
+// chords of a real corpus.  stan::intern_table, with and without epoch
+// reclamation, is compared with one std::unordered_set behind a mutex.
+//
+// usage: bench.intern [operations per thread] [distinct keys]
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct locked_set
+{
+    const std::uint64_t *intern(std::uint64_t key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return &*m_set.insert(key).first;
+    }
+
+    std::mutex m_mutex;
+    std::unordered_set<std::uint64_t> m_set;
+};
+
+// A cheap, well spread stream of keys, different for each thread.
+std::uint64_t next_key(std::uint64_t &state, std::uint64_t distinct)
+{
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (state >> 33) % distinct;
+}
+
+template <typename Table>
+double run(unsigned threads, std::size_t operations, std::uint64_t distinct)
+{
+    Table table;
+    std::vector<std::thread> pool;
+    auto start = clock_type::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t]() {
+            std::uint64_t state = t + 1;
+            for (std::size_t i = 0; i < operations; ++i) {
+                table.intern(next_key(state, distinct));
+            }
+        });
+    }
+    for (auto &t : pool) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    return double(threads) * double(operations) / seconds / 1e6;
+}
+
+struct epoch_table : stan::intern_table<std::uint64_t>
+{
+    epoch_table() : intern_table(stan::reclamation::epoch) {}
+};
+
+struct plain_table : stan::intern_table<std::uint64_t>
+{
+    plain_table() : intern_table(stan::reclamation::none) {}
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::size_t operations = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    std::uint64_t distinct = argc > 2 ? std::stoull(argv[2]) : 100000;
+
+    fmt::print("{} interns per thread of {} distinct keys, {} cores, million per second:\n",
+               operations, distinct, std::thread::hardware_concurrency());
+    fmt::print("{:>8} {:>12} {:>12} {:>12}\n", "threads", "epoch", "none", "mutex");
+    for (unsigned threads = 1; threads <= 64; threads *= 2) {
+        fmt::print("{:>8} {:>12.1f} {:>12.1f} {:>12.1f}\n", threads,
+                   run<epoch_table>(threads, operations, distinct),
+                   run<plain_table>(threads, operations, distinct),
+                   run<locked_set>(threads, operations, distinct));
+    }
+    return 0;
+}
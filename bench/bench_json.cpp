@@ -0,0 +1,98 @@
+#include <stan/driver/debug.hpp>
+#include <stan/driver/json.hpp>
+#include <stan/driver/lilypond.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Measures the JSON writer on a long score with a verse of lyrics, against
+// the debug writer on the same music, which is the first half of turning its
+// output into JSON, and the escape routine against a byte at a time loop
+// over the verse's text.
+//
+// usage: bench.json [bars] [runs]
+
+namespace {
+
+double best_millis(int runs, const std::function<void()> &f)
+{
+    std::vector<double> millis;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        millis.push_back(std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count());
+    }
+    return *std::min_element(millis.begin(), millis.end());
+}
+
+void escape_slowly(std::string &out, const std::string &text)
+{
+    for (char c : text) {
+        if (c == '"' or c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += fmt::format("\\u{:04x}", c);
+        } else {
+            out += c;
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int bars = argc > 1 ? std::stoi(argv[1]) : 25000;
+    int runs = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    // Six notes per bar under four syllables.
+    std::string music = "{ ";
+    std::string words = " \\addlyrics { ";
+    for (int i = 0; i < bars; ++i) {
+        music += "c'8 [d'8 e'8] <c e g>4 \\tuplet 3/2 { f8 g8 a8 } ";
+        words += "Twin4 -- kle, twin -- kle ";
+    }
+    music += "}";
+    words += "}";
+
+    stan::lilypond::reader read;
+    stan::score score = read.score(music + words);
+
+    stan::driver::json::writer json;
+    stan::driver::debug::writer debug;
+    std::string out;
+    std::size_t size = 0;
+
+    double json_millis = best_millis(runs, [&]() {
+        out.clear();
+        json.append(out, score.m_music);
+        size = out.size();
+    });
+    double debug_millis = best_millis(runs, [&]() { size += debug(score.m_music).size(); });
+    fmt::print("{} columns: json {:.2f}ms, debug {:.2f}ms\n", score.m_music.size(),
+               json_millis, debug_millis);
+
+    std::string text = score.m_verses.front().pool();
+    for (int i = 0; i < 6; ++i) {
+        text += text;
+    }
+    double fast = best_millis(runs, [&]() {
+        out.clear();
+        stan::driver::json::escape(out, text);
+    });
+    double slow = best_millis(runs, [&]() {
+        out.clear();
+        escape_slowly(out, text);
+    });
+    fmt::print("escape {} MB of lyrics: {:.0f} MB/s, byte at a time {:.0f} MB/s\n",
+               text.size() >> 20, text.size() / fast / 1e3, text.size() / slow / 1e3);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <stan/notation.hpp>
+#include <stan/driver/lilypond.hpp>
+
+#include <fmt/format.h>
+
+#include <spawn.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
+
+extern char **environ;
+
+// Measures the time from process creation to the end of the first parse.
+// Short lived command line tools spend most of their life in exactly this
+// window: exec, dynamic loading, static initialization of libstan, and then
+// whatever lazily initialized tables the first parse touches.  The parent
+// spawns itself with --child many times and reports the distribution of wall
+// clock times.
+
+namespace {
+
+int child()
+{
+    stan::lilypond::reader read;
+    stan::column c = read("[c'8 <e g b>8]");
+    return std::holds_alternative<stan::beam>(c) ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 and std::strcmp(argv[1], "--child") == 0) {
+        return child();
+    }
+
+    int runs = argc > 1 ? std::stoi(argv[1]) : 200;
+    std::vector<double> micros;
+
+    char child_flag[] = "--child";
+    char *child_argv[] = { argv[0], child_flag, nullptr };
+
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+
+        pid_t pid;
+        if (posix_spawn(&pid, argv[0], nullptr, nullptr, child_argv, environ) != 0) {
+            fmt::print(stderr, "spawn failed: {}\n", std::strerror(errno));
+            return 1;
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+
+        auto stop = std::chrono::steady_clock::now();
+        if (not WIFEXITED(status) or WEXITSTATUS(status) != 0) {
+            fmt::print(stderr, "child failed\n");
+            return 1;
+        }
+        micros.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+    }
+
+    std::sort(micros.begin(), micros.end());
+    double mean = std::accumulate(micros.begin(), micros.end(), 0.0) / micros.size();
+    fmt::print("time to first parse over {} processes: "
+               "min {:.0f}us  median {:.0f}us  mean {:.0f}us  p95 {:.0f}us\n",
+               runs, micros.front(), micros[micros.size() / 2], mean,
+               micros[micros.size() * 95 / 100]);
+    return 0;
+}
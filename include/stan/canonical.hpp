@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stan/rewrite.hpp>
+#include <stan/hash.hpp>
+
+#include <vector>
+
+// One normal form for music lists that differ only in how the same music is
+// written, and a fingerprint of it, for deduplicating a corpus and keying
+// caches.  Two lists have the same normal form when they differ only in:
+//
+//   - beams nested in beams: "[[c16 d16] e8]" is "[c16 d16 e8]"
+//   - tuplets whose ratio is 1/1, or written with a different but equal
+//     ratio: "\tuplet 6/4" is "\tuplet 3/2"
+//   - a rest followed by a rest of half its value in the same measure:
+//     "r4 r8" is "r4.", but not where "r4." would run over the bar line
+//   - the order of meter, clef and key changes written together, and a
+//     change overridden by another of its kind written with it
+//   - a clef or key restated while it is still in force
+//
+// A restated meter is kept, as it starts a new measure.
+//
+// The normal form is not built in one pass.  The rewrite rules and a walk
+// dropping restatements alternate until neither changes anything.  Each round
+// is linear in the length of the music, and each round after the first
+// follows one that dropped a clef or key, so there is at most one round more
+// than there are clefs and keys: O(n) for most music, O(n * changes) at
+// worst.  Rests are then dotted in one more linear walk that keeps the time
+// and measure, and the fingerprint is one more again, over the normal form.
+
+namespace stan::canonical {
+
+// The rewrite rules of the normal form: the standard rules, and one putting
+// neighbouring changes in order.  Restatements are dropped, and rests dotted
+// within measures, by form().
+std::vector<rewrite::rule> rules();
+
+// Remembers the normal form of every beam and tuplet it has seen, like
+// rewrite::rewriter, so a corpus sharing material is normalized faster with
+// one canonicalizer for all of it.  Not safe to share between threads.
+class canonicalizer
+{
+  public:
+    canonicalizer();
+
+    sequential operator()(const sequential &);
+
+    // The fingerprint of the normal form.
+    hash128 fingerprint(const sequential &);
+
+  private:
+    rewrite::rewriter m_rewrite;
+};
+
+sequential form(const sequential &);
+
+// A 128 bit content hash of the normal form.  The normal form is built
+// first, as a copy, and then hashed in one walk over it with nothing encoded
+// to a buffer: music with the same normal form has the same fingerprint.  It is
+// stable across runs and machines, and changes only with
+// stan::driver::binary::version.
+hash128 fingerprint(const sequential &);
+
+} // namespace stan::canonical
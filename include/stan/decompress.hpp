@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stan/exception.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+// Block by block decompression of gzip and zstd input, so that compressed
+// archives can be read without ever holding a whole decompressed copy.  zstd
+// support depends on libstan having been built against libzstd; gzip is
+// always available.
+
+namespace stan {
+
+enum class compression
+{
+    none,
+    gzip,
+    zstd
+};
+
+const char *to_string(compression);
+
+// Recognizes the format from the first few bytes; anything unrecognized is
+// taken to be uncompressed.
+compression detect_compression(const char *data, std::size_t size);
+
+struct decompress_error : exception
+{
+    template <typename... Args>
+    decompress_error(const char *format, Args... args) :
+        exception((std::string("decompress error: ") + format).c_str(),
+                  std::forward<Args>(args)...) {}
+};
+
+class decompressor
+{
+  public:
+    explicit decompressor(compression);
+    ~decompressor();
+    decompressor(decompressor &&) noexcept;
+    decompressor &operator=(decompressor &&) noexcept;
+
+    // Supply the next piece of compressed input.  It must stay valid until
+    // read() has returned false.
+    void input(const char *data, std::size_t size);
+
+    // Replace block with up to block_size decompressed bytes.  Returns false,
+    // leaving block empty, once the current input is used up.
+    bool read(std::string &block, std::size_t block_size);
+
+    // True once the end of the compressed stream has been seen.
+    bool finished() const;
+
+    // One per format, defined in the implementation.
+    struct impl;
+
+  private:
+    std::unique_ptr<impl> m_impl;
+};
+
+using block_callback = std::function<void(const char *data, std::size_t size)>;
+
+// Calls sink with the decompressed contents of data, block_size bytes at a
+// time.  Uncompressed data is passed through in blocks of the same size.
+void decompress(const char *data, std::size_t size, std::size_t block_size,
+                const block_callback &sink);
+
+// As above, reading the file at path in block_size pieces as well, so neither
+// the compressed nor the decompressed file is ever held whole.
+void decompress_file(const std::string &path, std::size_t block_size,
+                     const block_callback &sink);
+
+} // namespace stan
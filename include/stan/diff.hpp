@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stan/notation.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Structural differences between two versions of a music list, for review
+// tooling.  Top level columns are compared by content hash with Myers' diff.
+// Where a run of columns was replaced, a beam that became a beam, or a
+// tuplet that became a tuplet of the same scale, is compared element by
+// element in turn, so a one note change deep inside a beam is reported as
+// that note rather than as the whole beam.
+
+namespace stan::diff {
+
+enum class operation
+{
+    remove,  // m_old is not in the new version
+    insert,  // m_new is not in the old version
+    replace  // m_old became m_new
+};
+
+// A position in a music list: { 3, 1 } is the second element of the beam or
+// tuplet that is the fourth column.
+using path = std::vector<std::size_t>;
+
+// One step of an edit script.  m_old_path is where the edit applies in the
+// old version, and m_new_path where its result is in the new one.  For an
+// insert, m_old_path is the position it is inserted before; for a remove,
+// m_new_path is the position it would have had.  The pointers refer into the
+// compared music lists, which must outlive the script.
+struct edit
+{
+    operation m_operation;
+    path m_old_path;
+    path m_new_path;
+    const column *m_old;
+    const column *m_new;
+};
+
+// Edits that turn from into to, in order of position.  Linear in the length
+// of the lists plus quadratic only in the number of differences, so large
+// scores with few changes diff quickly.
+std::vector<edit> compare(const sequential &from, const sequential &to);
+
+// One line per edit, with columns shown by the debug writer and positions
+// counted from 1:
+//
+//     ~ 4.2  e4:8 -> f4:8
+//     - 7    r:4
+//     + 9    c4:4
+std::string summary(const std::vector<edit> &);
+
+} // namespace stan::diff
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stan/notation.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Notes as a table in the Apache Arrow IPC file format (the ".arrow" or
+// Feather v2 format), for columnar tools such as pandas, polars and DuckDB.
+// Each note is a row, and a chord is one row per pitch.  Rests, meters,
+// clefs and keys have no rows, but still advance onsets and measures.
+//
+//   score       uint32   position of the score in the list written
+//   measure     uint32   as numbered by stan::measures(), from zero
+//   onset       int64    ticks from the start of the score, as given by
+//                        stan::note_times()
+//   duration    int64    ticks
+//   midi        int16    MIDI note number, middle C is 60
+//   pitchclass  utf8     as in stan::pitchclass_names, such as "cs"
+//   octave      uint8    scientific octave, middle C is in octave 4
+//   tuplet      int32    innermost enclosing tuplet, numbered per score in
+//                        order of appearance from zero; null outside one
+//   beam        int32    likewise for beams
+//
+// Scores are split into contiguous ranges, filled in parallel on
+// stan::default_executor(), each into its own set of column buffers, and
+// every range becomes one record batch.  The encoding, including the
+// flatbuffers metadata, is written here rather than through the Arrow
+// libraries.
+
+namespace stan::driver::arrow {
+
+struct writer
+{
+    // Ranges of scores, and so record batches; zero means one per thread of
+    // the default executor.
+    unsigned m_threads = 0;
+
+    std::string operator()(const sequential &) const;
+    std::string operator()(const std::vector<sequential> &scores) const;
+
+    // Parts as they sound or read after transposing, touching each column
+    // of the views once.
+    std::string operator()(const transposed &) const;
+    std::string operator()(const std::vector<transposed> &scores) const;
+};
+
+} // namespace stan::driver::arrow
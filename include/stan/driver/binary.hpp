@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stan/notation.hpp>
+#include <stan/hash.hpp>
+
+#include <cstdint>
+#include <string>
+
+// A compact binary encoding of stan notation, for caches and stores where
+// parsing text again would be the bottleneck.  Note values are encoded as an
+// index into value::all, and every object is rebuilt through its normal
+// constructor, so reading never bypasses stan's validity checks.
+
+namespace stan::driver::binary {
+
+// Bump whenever the encoding changes.  Data written with a different version
+// is rejected rather than misread.
+constexpr std::uint8_t version = 1;
+
+struct invalid_binary : exception
+{
+    template <typename... Args>
+    invalid_binary(const char *format, Args... args) :
+        exception((std::string("invalid binary: ") + format).c_str(),
+                  std::forward<Args>(args)...) {}
+};
+
+struct writer
+{
+    std::string operator()(column const &) const;
+    std::string operator()(sequential const &) const;
+
+    // Append the encoding to out, for callers that reuse a buffer.
+    void append(std::string &out, column const &) const;
+    void append(std::string &out, sequential const &) const;
+};
+
+struct reader
+{
+    column operator()(const std::string &) const;
+    sequential sequence(const std::string &) const;
+
+    sequential sequence(const char *data, std::size_t size) const;
+};
+
+// A content hash of a column and everything inside it, taken over its
+// encoding without the header.  Equal columns hash equal.  The encoding is
+// hashed as it is produced, in one walk and without a buffer.
+hash128 hash(column const &);
+hash128 hash(sequential const &);
+
+} // namespace stan::driver::binary
@@ -19,6 +19,7 @@ struct writer
     std::string operator()(clef const &) const;
     std::string operator()(key const &) const;
     std::string operator()(column const &) const;
+    std::string operator()(sequential const &) const;
     std::string operator()(std::unique_ptr<column> const &) const;
 
   private:
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stan/notation.hpp>
+
+#include <string>
+#include <string_view>
+
+// Music as JSON, for web clients.  Every column is an object tagged with its
+// type, and values and pitches are written as the debug writer spells them:
+//
+//   {"type":"rest","value":"4."}
+//   {"type":"note","value":"8","pitch":"cs4"}
+//   {"type":"chord","value":"2","pitches":["c4","e4","g4"]}
+//   {"type":"beam","elements":[...]}
+//   {"type":"tuplet","value":"4","elements":[...]}
+//   {"type":"meter","beats":[3],"value":"4"}
+//   {"type":"clef","clef":"bass"}
+//   {"type":"key","tonic":"g","mode":"major"}
+//
+// A key in a mode other than major or minor gives its mode as the semitones
+// of each degree above the tonic, such as [0,2,3,5,7,9,10].  A music list is
+// an array of columns, and a score an object:
+//
+//   {"music":[...],
+//    "verses":[[{"note":0,"text":"Twin","join":"hyphen"},...],...],
+//    "dynamics":[{"note":0,"dynamic":"mf"},...],
+//    "articulations":[{"note":3,"articulation":"staccato"},...],
+//    "spanners":[{"type":"slur","first":0,"last":3},...]}
+//
+// where notes are counted as by stan::note_count() and "join" is left out
+// of syllables that have none.  The writer appends to the caller's buffer as
+// it walks the music, from fixed strings for every token but the values
+// outside value::all, without building any document or strings in between.
+
+namespace stan::driver::json {
+
+struct writer
+{
+    std::string operator()(const sequential &) const;
+    std::string operator()(const score &) const;
+
+    // Append the JSON to out, for callers that reuse a buffer.
+    void append(std::string &out, const sequential &) const;
+    void append(std::string &out, const score &) const;
+};
+
+// Appends text to out as the inside of a JSON string: quotes, backslashes
+// and control characters escaped, and everything else, UTF-8 included,
+// copied as it is.  Sixteen bytes are checked at a time where SSE2 is
+// available, so text with nothing to escape is copied in blocks.
+void escape(std::string &out, std::string_view text);
+
+} // namespace stan::driver::json
@@ -13,11 +13,79 @@ struct writer
 {
     template <typename T>
     std::string operator()(const T &) const;
+
+    // Write chords by name, as "\chordmode { ... }".  Throws invalid_chord
+    // for a note, beam or tuplet, or a chord stan::name_of() cannot name.
+    std::string chordmode(const sequential &) const;
+
+  private:
+    // A music list "{ ... }" of the columns in [begin, end).
+    template <typename Iterator>
+    std::string list(Iterator begin, Iterator end) const;
 };
 
 struct reader
 {
+    // Bump whenever a change to the grammar could change what a given input
+    // parses to, so that caches of parse results are invalidated.
+    static constexpr std::uint32_t version = 3;
+
     column operator()(const std::string &);
+
+    // Parse a music list, either brace enclosed "{ c4 d4 }" or a bare run of
+    // columns as found in a file.
+    sequential sequence(const std::string &);
+
+    // As above, also setting spans to the source_span of every column.
+    sequential sequence(const std::string &, std::vector<source_span> &spans);
+
+    // Parse "\chordmode { ... }", or a bare run of chord names such as
+    // "c1 a2:m7 g2:7/b", into chords.  Rests, meters, clefs and keys may come
+    // between them.  A root with no octave marks is middle C's octave, as for
+    // notes, and a quality must be one of stan::chord_qualities.
+    sequential chordmode(const std::string &);
+
+    // Parse the syllables of "\lyricmode { ... }", or a bare run of them,
+    // onto notes 0, 1, 2 and so on.  "_" and "\skip" pass over a note,
+    // "--" and "__" join a syllable to the next, and durations written on
+    // syllables are ignored.
+    stan::lyrics lyricmode(const std::string &);
+
+    // Parse a music list followed by any number of "\addlyrics { ... }"
+    // verses.  Syllables past the last note are dropped, as LilyPond does.
+    // Dynamics such as "\p", articulations such as "-.", and the ends of
+    // slurs "( )", phrasing slurs "\( \)" and hairpins "\< \> \!" after
+    // notes and chords go into the score's side tables; the other readers
+    // skip them.
+    stan::score score(const std::string &);
 };
 
+// Parses a music list that arrives in pieces, such as blocks from a
+// decompressor, holding on to no more text than the column still being read.
+// A column is only handed out once the next one has parsed, since more input
+// could still extend it ("c4" followed by ".").
+struct stream_reader
+{
+    // Append the columns completed by this piece of text to music.
+    void feed(const char *data, std::size_t size, sequential &music);
+
+    // Append the remaining columns to music.  Throws, as reader::sequence
+    // does, if the text as a whole is not a music list.
+    void finish(sequential &music);
+
+  private:
+    void parse(sequential &music, bool last);
+
+    std::string m_pending;
+    bool m_started = false;
+    bool m_braced = false;
+};
+
+// Read a music list from a file, which may be gzip or zstd compressed.  The
+// file is decompressed in blocks on a second thread while this one parses.
+sequential read_file(const std::string &path, std::size_t block_size = 64 << 10);
+
+// Likewise for a file already read whole, such as by stan::ingest().
+sequential read_compressed(const std::string &data, std::size_t block_size = 64 << 10);
+
 } // namespace stan::lilypond
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stan/driver/lilypond.hpp>
+#include <stan/driver/binary.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace stan::lilypond {
+
+// A reader that remembers its results on disk.  Each parse is stored in the
+// binary encoding under a name derived from a hash of the input text, the
+// reader version and the binary encoding version, so identical input loads at
+// decode speed on any later run, and a grammar or encoding change simply
+// misses.  Entries are written to a temporary file and renamed into place, so
+// concurrent processes sharing a directory never see a partial entry.  When
+// the directory grows past max_bytes, the least recently used entries are
+// removed.  All member functions may be called from several threads at once.
+
+struct cached_reader
+{
+    struct statistics
+    {
+        std::uint64_t m_hits;
+        std::uint64_t m_misses;
+        std::uint64_t m_evictions;
+    };
+
+    explicit cached_reader(std::string directory,
+                           std::uint64_t max_bytes = std::uint64_t(1) << 30);
+
+    sequential sequence(const std::string &lily);
+
+    statistics stats() const;
+
+  private:
+    std::string entry_path(const std::string &lily) const;
+    bool load(const std::string &path, sequential &music);
+    void store(const std::string &path, const sequential &music);
+    void evict();
+
+    std::string m_directory;
+    std::uint64_t m_max_bytes;
+
+    reader m_read;
+    driver::binary::reader m_decode;
+    driver::binary::writer m_encode;
+
+    std::atomic<std::uint64_t> m_bytes{ 0 };
+    std::atomic<std::uint64_t> m_hits{ 0 };
+    std::atomic<std::uint64_t> m_misses{ 0 };
+    std::atomic<std::uint64_t> m_evictions{ 0 };
+    std::atomic<std::uint64_t> m_temporaries{ 0 };
+    std::mutex m_evict_mutex;
+};
+
+} // namespace stan::lilypond
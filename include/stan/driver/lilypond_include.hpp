@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stan/driver/lilypond.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace stan {
+class executor;
+}
+
+namespace stan::lilypond {
+
+struct include_error : exception
+{
+    template <typename... Args>
+    include_error(const char *format, Args... args) :
+        exception((std::string("include error: ") + format).c_str(),
+                  std::forward<Args>(args)...) {}
+};
+
+// Reads music lists that are split across files with \include "file".  An
+// include may appear between any two top level columns and is replaced by
+// the included file's columns.  Names are resolved relative to the including
+// file's directory, then to each directory of the search path in turn.
+//
+// Every file is parsed at most once per include_reader, and a file's includes
+// are loaded and parsed as tasks on stan::default_executor() while the file's
+// own text is parsed, so a deep or wide project loads in parallel without a
+// thread per file.  A file waiting for an include that no task has started
+// parses it itself, and otherwise helps with queued work, so waiting never
+// ties up a thread the includes need.  Files are not reread if they change,
+// so an include_reader is meant to live for one run.  An include cycle is
+// reported as an include_error rather than deadlocking.  All member
+// functions may be called from several threads at once.
+
+class include_reader
+{
+  public:
+    explicit include_reader(std::vector<std::string> search_path = {});
+    ~include_reader();
+
+    include_reader(const include_reader &) = delete;
+    include_reader &operator=(const include_reader &) = delete;
+
+    // Parse the file at path with its includes spliced in.
+    sequential read(const std::string &path);
+
+    // Parse text as though it were a file in directory.
+    sequential sequence(const std::string &lily, const std::string &directory = ".");
+
+    // The number of distinct files parsed so far.
+    std::size_t files() const;
+
+  private:
+    using shared_music = std::shared_future<std::shared_ptr<const sequential>>;
+
+    // A file being loaded.  Whoever claims it first, a task on the executor
+    // or a file that includes it, parses it.
+    struct file
+    {
+        std::string m_path;
+        std::atomic<bool> m_claimed{ false };
+        std::promise<std::shared_ptr<const sequential>> m_promise;
+        shared_music m_music = m_promise.get_future().share();
+    };
+
+    // Loads submitted to the executor, shared with them so that those still
+    // queued when the reader is destroyed can see that they must not start.
+    struct tasks
+    {
+        std::mutex m_mutex;
+        std::condition_variable m_idle;
+        std::size_t m_running = 0;
+        bool m_closing = false;
+    };
+
+    std::shared_ptr<file> load(const std::string &path);
+    void run(file &f);
+    const sequential &wait(file &f);
+    std::shared_ptr<const sequential> parse(const std::string &lily,
+                                            const std::string &directory,
+                                            const std::string &name);
+    std::string resolve(const std::string &target, const std::string &directory,
+                        const std::string &from) const;
+    void add_edge(const std::string &from, const std::string &to);
+
+    std::vector<std::string> m_search_path;
+    executor &m_executor;
+    std::shared_ptr<tasks> m_tasks;
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::shared_ptr<file>> m_files;
+    std::map<std::string, std::vector<std::string>> m_includes;
+};
+
+// Parse the contents of the file at path, already read whole, as the batch
+// tools do after stan::ingest().  Compressed contents go through
+// read_compressed(), decompressing on a second thread while this one
+// parses; text with an \include goes through includes, relative to path's
+// directory; and any other text through plain, which may be a cache.
+sequential read_contents(const std::string &path, const std::string &contents,
+                         include_reader &includes,
+                         const std::function<sequential(const std::string &)> &plain);
+
+} // namespace stan::lilypond
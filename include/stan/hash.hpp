@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace stan {
+
+// A 128 bit non-cryptographic hash, MurmurHash3 x64_128 by Austin Appleby.  It
+// consumes 16 bytes per round, so hashing input is cheap next to parsing it,
+// and 128 bits is wide enough to use the result as a content address.
+
+struct hash128
+{
+    std::uint64_t m_high;
+    std::uint64_t m_low;
+
+    // 32 lowercase hex digits, high word first.
+    std::string hex() const;
+
+    friend bool operator==(const hash128 &h1, const hash128 &h2)
+    {
+        return h1.m_high == h2.m_high and h1.m_low == h2.m_low;
+    }
+
+    friend bool operator!=(const hash128 &h1, const hash128 &h2)
+    {
+        return !(h1 == h2);
+    }
+
+    friend bool operator<(const hash128 &h1, const hash128 &h2)
+    {
+        return h1.m_high != h2.m_high ? h1.m_high < h2.m_high : h1.m_low < h2.m_low;
+    }
+};
+
+hash128 hash(const void *data, std::size_t size, std::uint64_t seed = 0);
+
+inline hash128 hash(const std::string &s, std::uint64_t seed = 0)
+{
+    return hash(s.data(), s.size(), seed);
+}
+
+// The same hash taken over input given in pieces, for hashing data as it is
+// produced instead of gathering it into a buffer first.  digest() of the
+// pieces equals hash() of them joined.
+class hasher
+{
+  public:
+    explicit hasher(std::uint64_t seed = 0) : m_h1(seed), m_h2(seed) {}
+
+    void byte(std::uint8_t b)
+    {
+        m_pending[m_used++] = b;
+        if (m_used == sizeof(m_pending)) {
+            round(m_pending);
+            m_used = 0;
+        }
+    }
+
+    void update(const void *data, std::size_t size);
+
+    // The hash of everything so far.  More input may follow.
+    hash128 digest() const;
+
+  private:
+    void round(const unsigned char *block);
+
+    std::uint64_t m_h1;
+    std::uint64_t m_h2;
+    std::uint64_t m_size = 0; // bytes in whole rounds
+    unsigned char m_pending[16];
+    std::size_t m_used = 0;
+};
+
+} // namespace stan
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stan/notation.hpp>
+#include <stan/exception.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// An inverted index for finding melodic fragments in a large library of
+// scores.  Each score is reduced to its melody, the top pitch of every note
+// or chord in order, and the melody to overlapping n-grams of two kinds:
+// intervals in semitones, which match a fragment in any key, and ratios of
+// successive durations, which match a rhythm at any tempo.  Rests end a
+// phrase, and no n-gram spans one.  A document is one music list, which in
+// stan is a single voice, so indexing by document is indexing by voice.
+//
+// Documents are split into shards of consecutive documents, each built
+// independently and written as one file: a sorted table of terms, then
+// every term's document list as delta coded LEB128 varints.  A query is the
+// intersection of the lists of all of its terms within each shard, so the
+// results are the documents containing every n-gram of the fragment,
+// though not necessarily next to each other.
+
+namespace stan::index {
+
+struct index_error : exception
+{
+    template <typename... Args>
+    index_error(const char *format, Args... args) :
+        exception((std::string("index error: ") + format).c_str(),
+                  std::forward<Args>(args)...) {}
+};
+
+// Bump whenever the shard format or term extraction changes.
+constexpr std::uint8_t version = 1;
+
+// An n-gram, hashed to 64 bits.
+using term = std::uint64_t;
+
+enum kind : unsigned
+{
+    melody = 1,
+    rhythm = 2,
+    both = melody | rhythm
+};
+
+// The distinct terms of a music list, sorted, for n-grams spanning length
+// notes.
+std::vector<term> terms(const sequential &, unsigned length, unsigned kinds = both);
+
+// Collects documents in memory and writes them as one shard.
+class shard_writer
+{
+  public:
+    explicit shard_writer(unsigned length);
+
+    // Adds the next document and returns its number within the shard.  A
+    // document that failed to load is added as an empty list, keeping
+    // document numbers in step with their names.
+    std::uint32_t add(const sequential &);
+    std::uint32_t add(const std::vector<term> &sorted_terms);
+
+    std::uint32_t documents() const { return m_documents; }
+
+    void write(const std::string &path) const;
+
+  private:
+    unsigned m_length;
+    std::uint32_t m_documents = 0;
+    std::vector<std::pair<term, std::uint32_t>> m_postings;
+};
+
+struct build_options
+{
+    // Notes per n-gram.  Longer n-grams give shorter posting lists and fewer
+    // false matches, but queries must be at least this long.
+    unsigned m_length = 4;
+
+    std::size_t m_shard_documents = 16384;
+
+    // Shards built at once; zero shares stan::default_executor().
+    unsigned m_threads = 0;
+
+    std::vector<std::string> m_include_path;
+};
+
+// Called for each file that could not be read or parsed.  The file is kept
+// in the index with no terms.  May run on several threads at once.
+using build_error_callback = std::function<void(std::size_t index, const std::string &message)>;
+
+// Indexes the LilyPond files in paths, which may be compressed, into
+// directory.  Document numbers are positions in paths.
+void build(const std::string &directory, const std::vector<std::string> &paths,
+           const build_options &options = {}, const build_error_callback &on_error = {});
+
+// Searches an index written by build().  Shards are mapped into memory
+// rather than read, so opening even a large index is quick.
+class searcher
+{
+  public:
+    explicit searcher(const std::string &directory);
+    ~searcher();
+
+    // Documents containing every term of query, in order.  Throws
+    // index_error if query has no run of length notes.
+    std::vector<std::size_t> search(const sequential &query, unsigned kinds = both) const;
+
+    std::size_t documents() const { return m_names.size(); }
+    const std::string &name(std::size_t document) const { return m_names[document]; }
+    unsigned length() const { return m_length; }
+
+  private:
+    struct shard;
+
+    unsigned m_length = 0;
+    std::vector<std::string> m_names;
+    std::vector<std::unique_ptr<shard>> m_shards;
+};
+
+} // namespace stan::index
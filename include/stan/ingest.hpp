@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Bulk loading of many small files.  Opening and reading a file costs a few
+// blocking system calls, and for a corpus of hundreds of thousands of short
+// scores that latency, not parsing, is what leaves cores idle.  ingest() keeps
+// many opens and reads in flight at once through Linux io_uring, and falls
+// back to ordinary blocking reads in tasks on stan::default_executor() where
+// io_uring is unavailable (older kernels, seccomp sandboxes, other systems).
+
+namespace stan {
+
+enum class ingest_backend
+{
+    automatic, // io_uring if the kernel supports it, otherwise threads
+    io_uring,
+    threads
+};
+
+const char *to_string(ingest_backend);
+
+struct ingest_options
+{
+    ingest_backend m_backend = ingest_backend::automatic;
+
+    // Files in flight at once with io_uring.
+    unsigned m_queue_depth = 64;
+
+    // Tasks reading at once for the fallback; zero means the default
+    // executor's concurrency().
+    unsigned m_threads = 0;
+};
+
+// Called once per path, in completion order.  On success error is zero and
+// contents holds the whole file, which the callee may move from.  Otherwise
+// error is an errno value and contents is empty.  The callback may run on
+// several threads at once and must be thread safe.  If it throws, no more
+// files are started, and ingest() rethrows the first exception once every
+// file already open has been closed and every reading task has finished;
+// callbacks running at the time may still finish.
+using ingest_callback =
+    std::function<void(std::size_t index, std::string &contents, int error)>;
+
+// Reads every file in paths and returns the backend that was used.
+ingest_backend ingest(const std::vector<std::string> &paths,
+                      const ingest_callback &callback,
+                      const ingest_options &options = {});
+
+} // namespace stan
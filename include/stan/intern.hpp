@@ -0,0 +1,342 @@
+#pragma once
+
+#include <stan/notation.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// A concurrent table of interned objects, so that parser threads can share
+// one copy of each chord, pitch set or subtree they produce, and compare
+// them by address.  Handles are plain pointers to the stored objects and
+// stay valid, never moving, for the life of the table.
+//
+// Lookups are lock free: the table is an open-addressing array of atomic
+// pointers, read with loads alone.  Inserts lock one of 64 stripes, chosen
+// by hash, so that two threads interning equal objects meet on the same
+// lock while threads interning different ones rarely do, and claim an empty
+// slot with a compare-and-swap.  Each stripe allocates its objects from its
+// own arena.
+//
+// When the array fills past half, the thread that notices takes every stripe
+// lock and rehashes into one twice the size.  Readers still walking the old
+// array are unaffected, so it can only be freed once they are done.  With
+// reclamation::epoch, lookups announce themselves in an epoch_gate and the
+// old array is freed after a grace period.  With reclamation::none lookups
+// skip that, and old arrays, which total less than the live one, are kept
+// until the table is destroyed.
+
+namespace stan {
+
+// Grace periods for memory that lock-free readers may still hold, by
+// epoch-based reclamation.  Readers count themselves in and out of the
+// current epoch on one of a few cache lines, and synchronize() moves to the
+// next epoch and waits for the previous one's readers to leave.
+class epoch_gate
+{
+  public:
+    class guard
+    {
+      public:
+        guard(guard &&g) noexcept : m_count(g.m_count) { g.m_count = nullptr; }
+        ~guard()
+        {
+            if (m_count != nullptr) {
+                m_count->fetch_sub(1);
+            }
+        }
+
+        guard(const guard &) = delete;
+        guard &operator=(const guard &) = delete;
+        guard &operator=(guard &&) = delete;
+
+      private:
+        friend class epoch_gate;
+        explicit guard(std::atomic<std::uint64_t> *count) : m_count(count) {}
+
+        std::atomic<std::uint64_t> *m_count;
+    };
+
+    // The calling thread reads until the guard is destroyed.
+    guard enter();
+
+    // Returns once every reader that entered before the call has left.
+    void synchronize();
+
+  private:
+    static constexpr std::size_t slots = 64;
+
+    struct alignas(64) slot
+    {
+        std::atomic<std::uint64_t> m_readers[2] = { { 0 }, { 0 } };
+    };
+
+    std::atomic<std::uint64_t> m_epoch{ 0 };
+    slot m_slots[slots];
+    std::mutex m_synchronize_mutex;
+};
+
+enum class reclamation
+{
+    none, // old arrays are kept until the table is destroyed
+    epoch // lookups enter an epoch_gate, and old arrays are freed
+};
+
+template <typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
+class intern_table
+{
+  public:
+    using handle = const T *;
+
+    explicit intern_table(reclamation r = reclamation::epoch, std::size_t capacity = 1024);
+    ~intern_table();
+
+    intern_table(const intern_table &) = delete;
+    intern_table &operator=(const intern_table &) = delete;
+
+    // The handle of the object equal to value, stored first if there is none.
+    handle intern(const T &value);
+    handle intern(T &&value);
+
+    // The handle of the object equal to value, or nullptr if there is none.
+    handle find(const T &value) const;
+
+    std::size_t size() const { return m_size.load(std::memory_order_relaxed); }
+
+  private:
+    static constexpr std::size_t stripes = 64;
+
+    struct entry
+    {
+        template <typename U>
+        entry(std::size_t hash, U &&value) : m_hash(hash), m_value(std::forward<U>(value)) {}
+
+        std::size_t m_hash;
+        T m_value;
+    };
+
+    struct array
+    {
+        explicit array(std::size_t capacity) :
+            m_mask(capacity - 1), m_slots(new std::atomic<entry *>[capacity])
+        {
+            for (std::size_t i = 0; i < capacity; ++i) {
+                m_slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        std::size_t m_mask;
+        std::unique_ptr<std::atomic<entry *>[]> m_slots;
+    };
+
+    struct alignas(64) stripe
+    {
+        std::mutex m_mutex;
+        std::deque<entry> m_arena;
+    };
+
+    std::size_t hash(const T &value) const;
+    handle probe(const array &, std::size_t hash, const T &value) const;
+    handle lookup(std::size_t hash, const T &value) const;
+    static void place(array &, entry *);
+
+    template <typename U>
+    handle insert(std::size_t hash, U &&value);
+    void grow();
+
+    Hash m_hasher;
+    Equal m_equal;
+    reclamation m_reclamation;
+
+    std::atomic<array *> m_array;
+    std::atomic<std::size_t> m_size{ 0 };
+    stripe m_stripes[stripes];
+
+    mutable epoch_gate m_gate;
+    std::mutex m_retired_mutex;
+    std::vector<std::unique_ptr<array>> m_retired;
+};
+
+// Hashes columns by their binary encoding, for intern_table<column>.
+struct column_hash
+{
+    std::size_t operator()(const column &) const;
+};
+
+template <typename T, typename Hash, typename Equal>
+intern_table<T, Hash, Equal>::intern_table(reclamation r, std::size_t capacity) :
+    m_reclamation(r)
+{
+    std::size_t size = 16;
+    while (size < capacity * 2) {
+        size *= 2;
+    }
+    m_array.store(new array(size));
+}
+
+template <typename T, typename Hash, typename Equal>
+intern_table<T, Hash, Equal>::~intern_table()
+{
+    delete m_array.load();
+}
+
+template <typename T, typename Hash, typename Equal>
+std::size_t intern_table<T, Hash, Equal>::hash(const T &value) const
+{
+    // Finalizer of MurmurHash3, since std::hash is often the identity and
+    // slots and stripes are picked by the low and high bits.
+    std::uint64_t h = m_hasher(value);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return static_cast<std::size_t>(h);
+}
+
+template <typename T, typename Hash, typename Equal>
+typename intern_table<T, Hash, Equal>::handle
+intern_table<T, Hash, Equal>::probe(const array &a, std::size_t hash, const T &value) const
+{
+    for (std::size_t i = hash & a.m_mask;; i = (i + 1) & a.m_mask) {
+        const entry *e = a.m_slots[i].load(std::memory_order_acquire);
+        if (e == nullptr) {
+            return nullptr;
+        }
+        if (e->m_hash == hash and m_equal(e->m_value, value)) {
+            return &e->m_value;
+        }
+    }
+}
+
+template <typename T, typename Hash, typename Equal>
+void intern_table<T, Hash, Equal>::place(array &a, entry *e)
+{
+    for (std::size_t i = e->m_hash & a.m_mask;; i = (i + 1) & a.m_mask) {
+        entry *empty = nullptr;
+        if (a.m_slots[i].compare_exchange_strong(empty, e, std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+template <typename T, typename Hash, typename Equal>
+typename intern_table<T, Hash, Equal>::handle
+intern_table<T, Hash, Equal>::lookup(std::size_t hash, const T &value) const
+{
+    if (m_reclamation == reclamation::epoch) {
+        epoch_gate::guard g = m_gate.enter();
+        return probe(*m_array.load(std::memory_order_acquire), hash, value);
+    }
+    return probe(*m_array.load(std::memory_order_acquire), hash, value);
+}
+
+template <typename T, typename Hash, typename Equal>
+typename intern_table<T, Hash, Equal>::handle
+intern_table<T, Hash, Equal>::find(const T &value) const
+{
+    return lookup(hash(value), value);
+}
+
+template <typename T, typename Hash, typename Equal>
+typename intern_table<T, Hash, Equal>::handle intern_table<T, Hash, Equal>::intern(const T &value)
+{
+    std::size_t h = hash(value);
+    handle found = lookup(h, value);
+    return found != nullptr ? found : insert(h, value);
+}
+
+template <typename T, typename Hash, typename Equal>
+typename intern_table<T, Hash, Equal>::handle intern_table<T, Hash, Equal>::intern(T &&value)
+{
+    std::size_t h = hash(value);
+    handle found = lookup(h, value);
+    return found != nullptr ? found : insert(h, std::move(value));
+}
+
+template <typename T, typename Hash, typename Equal>
+template <typename U>
+typename intern_table<T, Hash, Equal>::handle
+intern_table<T, Hash, Equal>::insert(std::size_t h, U &&value)
+{
+    stripe &s = m_stripes[h >> 58];
+    for (;;) {
+        handle out = nullptr;
+        bool full;
+        {
+            // The array cannot be replaced while any stripe lock is held.
+            std::lock_guard<std::mutex> lock(s.m_mutex);
+            array &a = *m_array.load(std::memory_order_acquire);
+            if (handle found = probe(a, h, value)) {
+                return found;
+            }
+
+            // Threads under other stripes' locks insert at the same time, so
+            // the slot is reserved before it is filled: the array then never
+            // holds more than three quarters of its slots, however many
+            // insert at once, and probing always reaches an empty one.
+            std::size_t size = m_size.fetch_add(1) + 1;
+            full = size * 4 > (a.m_mask + 1) * 3;
+            if (full) {
+                m_size.fetch_sub(1);
+            } else {
+                entry *e;
+                try {
+                    e = &s.m_arena.emplace_back(h, std::forward<U>(value));
+                } catch (...) {
+                    m_size.fetch_sub(1);
+                    throw;
+                }
+                place(a, e);
+                out = &e->m_value;
+                full = size * 2 > a.m_mask + 1;
+            }
+        }
+        if (full) {
+            grow();
+        }
+        if (out != nullptr) {
+            return out;
+        }
+    }
+}
+
+template <typename T, typename Hash, typename Equal>
+void intern_table<T, Hash, Equal>::grow()
+{
+    std::unique_ptr<array> old;
+    {
+        std::unique_lock<std::mutex> locks[stripes];
+        for (std::size_t i = 0; i < stripes; ++i) {
+            locks[i] = std::unique_lock<std::mutex>(m_stripes[i].m_mutex);
+        }
+        array *current = m_array.load();
+        if (m_size.load() * 2 <= current->m_mask + 1) {
+            return;
+        }
+        auto bigger = std::make_unique<array>((current->m_mask + 1) * 2);
+        for (std::size_t i = 0; i <= current->m_mask; ++i) {
+            if (entry *e = current->m_slots[i].load(std::memory_order_relaxed)) {
+                place(*bigger, e);
+            }
+        }
+        m_array.store(bigger.release(), std::memory_order_release);
+        old.reset(current);
+    }
+
+    if (m_reclamation == reclamation::epoch) {
+        m_gate.synchronize();
+    } else {
+        std::lock_guard<std::mutex> lock(m_retired_mutex);
+        m_retired.push_back(std::move(old));
+    }
+}
+
+} // namespace stan
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace stan {
+
+// A static centered interval tree, answering "which intervals meet this
+// range" in O(log n + k) for k answers.
+//
+// Each node holds the intervals that contain its center, twice: ascending by
+// low end and descending by high end.  A point left of the center meets
+// exactly a prefix of the first list and a point right of it a prefix of the
+// second, so a walk from the root to a leaf reports every interval holding
+// the point without looking at any that do not.  A range [low, high] meets
+// the intervals holding low, plus those starting inside it, which are a run
+// of one more list sorted by low end; taking from the walk only those that
+// start before low reports each once.
+//
+// Centers are medians of the endpoints below them, so the tree is balanced,
+// and nodes and lists live in a few flat vectors.
+template <typename Key>
+class interval_tree
+{
+  public:
+    // A closed interval [m_low, m_high], with an id to report it by.
+    struct interval
+    {
+        Key m_low;
+        Key m_high;
+        std::uint32_t m_id;
+    };
+
+    interval_tree() = default;
+    explicit interval_tree(std::vector<interval> intervals);
+
+    // Calls f(id) once for every interval meeting [low, high], in no
+    // particular order.
+    template <typename F>
+    void overlapping(Key low, Key high, F f) const;
+
+    std::size_t size() const { return m_by_start.size(); }
+    bool empty() const { return m_by_start.empty(); }
+
+  private:
+    struct node
+    {
+        Key m_center;
+        std::uint32_t m_first; // of this node's run in m_by_low and m_by_high
+        std::uint32_t m_count;
+        std::int32_t m_left;
+        std::int32_t m_right;
+    };
+
+    std::int32_t build(std::vector<interval> &intervals);
+
+    std::vector<node> m_nodes;
+    std::vector<interval> m_by_low;
+    std::vector<interval> m_by_high;
+    std::vector<interval> m_by_start;
+    std::int32_t m_root = -1;
+};
+
+template <typename Key>
+interval_tree<Key>::interval_tree(std::vector<interval> intervals)
+{
+    m_by_start = intervals;
+    std::sort(m_by_start.begin(), m_by_start.end(),
+              [](const interval &i1, const interval &i2) { return i1.m_low < i2.m_low; });
+    m_by_low.reserve(intervals.size());
+    m_by_high.reserve(intervals.size());
+    m_root = build(intervals);
+}
+
+template <typename Key>
+std::int32_t interval_tree<Key>::build(std::vector<interval> &intervals)
+{
+    if (intervals.empty()) {
+        return -1;
+    }
+
+    std::vector<Key> ends;
+    ends.reserve(intervals.size() * 2);
+    for (const auto &i : intervals) {
+        ends.push_back(i.m_low);
+        ends.push_back(i.m_high);
+    }
+    auto middle = ends.begin() + ends.size() / 2;
+    std::nth_element(ends.begin(), middle, ends.end());
+    Key center = *middle;
+
+    // The center is an end of some interval, so every node holds at least
+    // one and the recursion ends.
+    std::vector<interval> left;
+    std::vector<interval> right;
+    auto here = std::partition(intervals.begin(), intervals.end(), [&](const interval &i) {
+        return not(i.m_high < center) and not(center < i.m_low);
+    });
+    for (auto i = here; i != intervals.end(); ++i) {
+        (i->m_high < center ? left : right).push_back(*i);
+    }
+    intervals.erase(here, intervals.end());
+
+    auto first = static_cast<std::uint32_t>(m_by_low.size());
+    auto by_low = m_by_low.insert(m_by_low.end(), intervals.begin(), intervals.end());
+    std::sort(by_low, m_by_low.end(),
+              [](const interval &i1, const interval &i2) { return i1.m_low < i2.m_low; });
+    auto by_high = m_by_high.insert(m_by_high.end(), intervals.begin(), intervals.end());
+    std::sort(by_high, m_by_high.end(),
+              [](const interval &i1, const interval &i2) { return i2.m_high < i1.m_high; });
+
+    auto index = static_cast<std::int32_t>(m_nodes.size());
+    m_nodes.push_back({ center, first, static_cast<std::uint32_t>(intervals.size()), -1, -1 });
+    intervals = std::vector<interval>();
+
+    std::int32_t l = build(left);
+    std::int32_t r = build(right);
+    m_nodes[index].m_left = l;
+    m_nodes[index].m_right = r;
+    return index;
+}
+
+template <typename Key>
+template <typename F>
+void interval_tree<Key>::overlapping(Key low, Key high, F f) const
+{
+    if (high < low) {
+        return;
+    }
+
+    // Those holding low, that start before it.
+    for (std::int32_t n = m_root; n != -1;) {
+        const node &at = m_nodes[n];
+        const interval *first = m_by_low.data() + at.m_first;
+        const interval *last = first + at.m_count;
+        if (low < at.m_center) {
+            for (; first != last and first->m_low < low; ++first) {
+                f(first->m_id);
+            }
+            n = at.m_left;
+        } else {
+            const interval *i = m_by_high.data() + at.m_first;
+            for (const interval *end = i + at.m_count; i != end and not(i->m_high < low); ++i) {
+                if (i->m_low < low) {
+                    f(i->m_id);
+                }
+            }
+            n = at.m_center < low ? at.m_right : -1;
+        }
+    }
+
+    // Those starting in [low, high].
+    auto start = std::lower_bound(m_by_start.begin(), m_by_start.end(), low,
+                                  [](const interval &i, const Key &k) { return i.m_low < k; });
+    for (; start != m_by_start.end() and not(high < start->m_low); ++start) {
+        f(start->m_id);
+    }
+}
+
+} // namespace stan
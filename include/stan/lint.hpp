@@ -0,0 +1,281 @@
+#pragma once
+
+#include <stan/notation.hpp>
+#include <stan/scheduler.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+// Style and correctness checks over music lists.  A rule is a type that
+// names itself, declares the kinds of column it visits, and has a visit()
+// for each of them, which reports what it finds through the context:
+//
+//     struct no_clefs
+//     {
+//         static constexpr const char *name = "no-clefs";
+//         using visits = stan::lint::visits<stan::clef>;
+//
+//         void visit(const stan::clef &, stan::lint::context &ctx)
+//         {
+//             ctx.report(stan::lint::severity::warning, "clef change");
+//         }
+//     };
+//
+// A linter holds any number of rules and walks each voice once, handing each
+// column to the rules that visit its kind in the order the rules were given,
+// so adding a rule adds a call per column it visits rather than another
+// pass.  Every voice is checked with fresh copies of the rules, so rules
+// may keep state from one column to the next, and voices are checked in
+// parallel on a stan::executor.
+//
+//     std::vector<stan::lint::diagnostic> found = stan::lint::check(voices);
+
+namespace stan::lint {
+
+enum class severity : std::uint8_t
+{
+    warning, // legal, but unusual or hard to read
+    error,   // wrong music, such as a note that cannot be played
+};
+
+// A position in a music list, as for stan::diff: { 3, 1 } is the second
+// element of the beam or tuplet that is the fourth column.
+using path = std::vector<std::size_t>;
+
+// One problem a rule found.  m_span is where the column was read from, if
+// the voice came with spans.
+struct diagnostic
+{
+    const char *m_rule;
+    severity m_severity;
+    std::size_t m_voice;
+    path m_path;
+    std::optional<source_span> m_span;
+    std::string m_message;
+};
+
+// A music list to check, with the spans lilypond::reader::sequence() gave
+// for it if it was read from text.  Both must outlive the check.
+struct voice
+{
+    voice(const sequential &music, const std::vector<source_span> *spans = nullptr) :
+        m_music(&music), m_spans(spans)
+    {
+    }
+
+    const sequential *m_music;
+    const std::vector<source_span> *m_spans;
+};
+
+// The column kinds a rule visits.  Beams and tuplets are visited before the
+// columns they hold, which are visited in turn.
+template <typename... Columns>
+struct visits
+{
+};
+
+namespace detail {
+struct walker;
+} // namespace detail
+
+// Where the walk is, for the rule visiting a column.  Times are in ticks from
+// the start of the voice, stan::ticks_per_quarter to a quarter note, exact
+// inside tuplets but for rounding to the nearest tick.  Measures follow the
+// meters as for stan::measures(), counted from zero.
+class context
+{
+  public:
+    const path &where() const { return m_path; }
+    std::int64_t onset() const { return m_onset; }
+    std::int64_t end() const { return m_end; }
+
+    std::size_t measure() const { return m_measure; }
+    std::int64_t bar_start() const { return m_bar_start; }
+    std::int64_t bar_end() const { return m_bar_start + m_bar_length; }
+
+    // The key in force, C major before the first.
+    const stan::key &key() const { return *m_key; }
+
+    // Reports a problem with the column being visited.
+    void report(severity, std::string message);
+
+  private:
+    friend struct detail::walker;
+    template <typename... Rules>
+    friend class linter;
+
+    const voice *m_voice = nullptr;
+    std::size_t m_voice_index = 0;
+    std::vector<diagnostic> *m_out = nullptr;
+    const char *m_rule = nullptr;
+
+    path m_path;
+    std::size_t m_preorder = 0;
+    std::int64_t m_onset = 0;
+    std::int64_t m_end = 0;
+    std::size_t m_measure = 0;
+    std::int64_t m_bar_start = 0;
+    std::int64_t m_bar_length = 4 * ticks_per_quarter;
+    const stan::key *m_key = nullptr;
+};
+
+namespace detail {
+
+template <typename T, typename Visits>
+struct visited;
+
+template <typename T, typename... Columns>
+struct visited<T, visits<Columns...>> : std::disjunction<std::is_same<T, Columns>...>
+{
+};
+
+using dispatch = void (*)(void *rules, const column &, context &);
+
+// Walks one voice, calling visit with each column in preorder and keeping
+// the context's times, measures and key up to date around it.
+void walk(const voice &, std::size_t index, std::vector<diagnostic> &out, dispatch visit,
+          void *rules);
+
+} // namespace detail
+
+template <typename... Rules>
+class linter
+{
+  public:
+    explicit linter(Rules... rules) : m_rules(std::move(rules)...) {}
+
+    // What the rules find in the voices, in order of voice and then of
+    // position.
+    std::vector<diagnostic> operator()(executor &ex, const std::vector<voice> &voices) const
+    {
+        std::vector<std::vector<diagnostic>> found(voices.size());
+        parallel_for(ex, 0, voices.size(), [&](std::size_t v) {
+            std::tuple<Rules...> rules = m_rules;
+            detail::walk(voices[v], v, found[v], &dispatch, &rules);
+        });
+
+        std::vector<diagnostic> out;
+        for (auto &f : found) {
+            out.insert(out.end(), std::make_move_iterator(f.begin()),
+                       std::make_move_iterator(f.end()));
+        }
+        return out;
+    }
+
+    std::vector<diagnostic> operator()(const std::vector<voice> &voices) const
+    {
+        return (*this)(default_executor(), voices);
+    }
+
+  private:
+    template <typename Rule, typename T>
+    static void visit(Rule &rule, const T &c, context &ctx)
+    {
+        if constexpr (detail::visited<T, typename Rule::visits>::value) {
+            ctx.m_rule = Rule::name;
+            rule.visit(c, ctx);
+        }
+    }
+
+    static void dispatch(void *rules, const column &c, context &ctx)
+    {
+        std::visit(
+            [&](const auto &v) {
+                std::apply([&](auto &...rule) { (visit(rule, v, ctx), ...); },
+                           *static_cast<std::tuple<Rules...> *>(rules));
+            },
+            c);
+    }
+
+    std::tuple<Rules...> m_rules;
+};
+
+// The standard rules.
+
+// Chords whose voices, taken from the bottom up, move in parallel perfect
+// fifths (or twelfths) from the chord before.  A note or rest between
+// breaks the progression, and so does a change in the number of voices.
+struct parallel_fifths
+{
+    static constexpr const char *name = "parallel-fifths";
+    using visits = lint::visits<note, chord, rest>;
+
+    void visit(const chord &, context &);
+    void visit(const note &, context &) { m_previous.clear(); }
+    void visit(const rest &, context &) { m_previous.clear(); }
+
+    std::vector<int> m_previous;
+};
+
+// Pitches outside an instrument's range, a piano's by default.
+struct out_of_range
+{
+    static constexpr const char *name = "out-of-range";
+    using visits = lint::visits<note, chord>;
+
+    out_of_range() : out_of_range(pitch(pitchclass::a, octave(0)), pitch(pitchclass::c, octave(8)))
+    {
+    }
+    out_of_range(const pitch &lowest, const pitch &highest) : m_lowest(lowest), m_highest(highest)
+    {
+    }
+
+    void visit(const note &, context &);
+    void visit(const chord &, context &);
+    void check(const pitch &, context &) const;
+
+    pitch m_lowest;
+    pitch m_highest;
+};
+
+// Beams over fewer than two notes, over quarter notes or longer, which take
+// no beam, or across a bar line.
+struct odd_beaming
+{
+    static constexpr const char *name = "odd-beaming";
+    using visits = lint::visits<beam>;
+
+    void visit(const beam &, context &);
+};
+
+// Measures that do not hold what their meter says: a note, rest or chord
+// that runs over the bar line instead of being tied across it, and a meter
+// change partway through a measure, which cuts it short.
+struct bar_length
+{
+    static constexpr const char *name = "bar-length";
+    using visits = lint::visits<rest, note, chord, meter>;
+
+    void visit(const rest &, context &ctx) { overrun(ctx); }
+    void visit(const note &, context &ctx) { overrun(ctx); }
+    void visit(const chord &, context &ctx) { overrun(ctx); }
+    void visit(const meter &, context &);
+    void overrun(context &) const;
+};
+
+// Spellings outside the key that take more accidentals than the pitch needs:
+// es or cf where f or b would do, and double sharps or flats with a single
+// accidental equivalent.
+struct unnecessary_accidentals
+{
+    static constexpr const char *name = "unnecessary-accidentals";
+    using visits = lint::visits<note, chord>;
+
+    void visit(const note &, context &);
+    void visit(const chord &, context &);
+    void check(const pitch &, context &) const;
+};
+
+using standard = linter<parallel_fifths, out_of_range, odd_beaming, bar_length,
+                        unnecessary_accidentals>;
+
+// Runs the standard rules over the voices.
+std::vector<diagnostic> check(const std::vector<voice> &);
+
+} // namespace stan::lint
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stan/notation.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Three-way merge of two concurrent edits of one music list, for the
+// collaborative editor.  Each side is diffed against the common ancestor
+// with stan::diff; edits that touch different measures are both applied,
+// and edits from both sides within the same measure are reported as a
+// conflict over the affected measures, unless both sides made the identical
+// change.  Measures follow the \time signatures in the ancestor, 4/4 until
+// the first one.
+
+namespace stan::merge {
+
+struct conflict
+{
+    // Affected measures of the ancestor, counted from zero, inclusive.
+    std::size_t m_first_measure;
+    std::size_t m_last_measure;
+
+    // The columns of those measures in each version.
+    sequential m_base;
+    sequential m_ours;
+    sequential m_theirs;
+
+    // Where m_ours was placed in the merged list, pending resolution.
+    std::size_t m_position;
+};
+
+struct result
+{
+    // Both sides' edits applied.  Conflicting measures hold our version.
+    sequential m_merged;
+    std::vector<conflict> m_conflicts;
+};
+
+result merge(const sequential &base, const sequential &ours, const sequential &theirs);
+
+} // namespace stan::merge
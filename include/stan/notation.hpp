@@ -11,6 +11,17 @@
 #include <stan/notation/clef.hpp>
 #include <stan/notation/key.hpp>
 
+#include <stan/notation/interval.hpp>
+#include <stan/notation/chord_name.hpp>
+#include <stan/notation/transposed.hpp>
+#include <stan/notation/rope.hpp>
+
+#include <stan/notation/lyrics.hpp>
+#include <stan/notation/marks.hpp>
+#include <stan/notation/note_table.hpp>
+#include <stan/notation/spanner.hpp>
+#include <stan/notation/score.hpp>
+
 #include <stan/notation/copy.hpp>
 #include <stan/notation/duration.hpp>
 #include <stan/notation/equal.hpp>
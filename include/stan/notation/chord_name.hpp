@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stan/notation/chord.hpp>
+#include <stan/notation/interval.hpp>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+namespace stan {
+
+// A chord quality as LilyPond's \chordmode names it after the ":", with the
+// intervals it stacks above the root.
+struct chord_quality
+{
+    const char *m_name;
+    std::array<interval, 6> m_intervals;
+    std::size_t m_size;
+};
+
+// The qualities chord names are built from and recognized as.  A major triad
+// is first, for a name with no quality; otherwise a name lists the intervals
+// it adds, LilyPond's thirteenth leaving out the eleventh.  A step number
+// alone stacks thirds up to that step, so "c:5" is the major triad and the
+// power chord is "c:1.5", its steps listed.
+namespace chord_qualities {
+
+using namespace intervals;
+
+// clang-format off
+inline constexpr std::array<chord_quality, 21> all{ {
+    { "",      { P1, M3, P5 },               3 },
+    { "m",     { P1, m3, P5 },               3 },
+    { "aug",   { P1, M3, A5 },               3 },
+    { "dim",   { P1, m3, d5 },               3 },
+    { "sus2",  { P1, M2, P5 },               3 },
+    { "sus4",  { P1, P4, P5 },               3 },
+    { "1.5",   { P1, P5 },                   2 },
+    { "6",     { P1, M3, P5, M6 },           4 },
+    { "m6",    { P1, m3, P5, M6 },           4 },
+    { "7",     { P1, M3, P5, m7 },           4 },
+    { "maj7",  { P1, M3, P5, M7 },           4 },
+    { "m7",    { P1, m3, P5, m7 },           4 },
+    { "m7+",   { P1, m3, P5, M7 },           4 },
+    { "dim7",  { P1, m3, d5, d7 },           4 },
+    { "m7.5-", { P1, m3, d5, m7 },           4 },
+    { "aug7",  { P1, M3, A5, m7 },           4 },
+    { "9",     { P1, M3, P5, m7, M9 },       5 },
+    { "maj9",  { P1, M3, P5, M7, M9 },       5 },
+    { "m9",    { P1, m3, P5, m7, M9 },       5 },
+    { "11",    { P1, M3, P5, m7, M9, P11 },  6 },
+    { "13",    { P1, M3, P5, m7, M9, M13 },  6 },
+} };
+// clang-format on
+
+inline constexpr const chord_quality &major = all[0];
+
+} // namespace chord_qualities
+
+// A chord by name, as in "c1:m7/bf": its root, its quality, and a bass
+// pitch class sounding below the root.  A bass that is a chord tone moves
+// down from its place in the chord, an inversion, and any other is added.
+struct chord_name
+{
+    pitch m_root;
+    const chord_quality *m_quality;
+    std::optional<pitchclass> m_bass;
+};
+
+// The chord a name spells, stacked up from the root, with the bass in the
+// highest octave below the rest.
+chord spell(const value &, const chord_name &);
+
+// The name of a chord, if spell() builds it from one.  Root position names
+// are found with one binary search over a table of the qualities' semitone
+// patterns, and inversions by trying the qualities on the notes above the
+// bass.
+//
+// Only the voicing spell() builds is named, so that a chord written by its
+// name reads back as the same chord.  Other voicings of the same pitch
+// classes have no name: <e g c'> is a C major triad over E, but "c/e" spells
+// <e, c g>, so name_of(<e g c'>) is empty.
+std::optional<chord_name> name_of(const chord &);
+
+} // namespace stan
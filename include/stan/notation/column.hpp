@@ -2,7 +2,10 @@
 
 #include <stan/notation/duration.hpp>
 
+#include <cstddef>
+#include <cstdint>
 #include <variant>
+#include <vector>
 
 namespace stan {
 
@@ -17,7 +20,69 @@ struct key;
 
 using column = std::variant<rest, note, chord, beam, tuplet, meter, clef, key>;
 
+// Columns played one after another, as in a LilyPond "{ ... }" music list.
+using sequential = std::vector<column>;
+
 duration operator+(const duration &d, const column &c);
 
+// The measure each column starts in, counted from zero.  Measures follow the
+// meters in the list, 4/4 before the first, and a change of meter part way
+// through a measure starts a new one.
+std::vector<std::size_t> measures(const sequential &);
+
+// The notes and chords in a music list, inside beams and tuplets included.
+// Side tables, such as lyrics, refer to a note by its position in this order,
+// counted from zero.
+std::size_t note_count(const sequential &);
+
+// Where a column was read from, as byte offsets [m_begin, m_end) into the
+// text, marks written after it included.  Readers that track them give one
+// for every column in preorder: a beam or tuplet comes before the columns it
+// holds.
+struct source_span
+{
+    std::size_t m_begin;
+    std::size_t m_end;
+};
+
+// Ticks per quarter note for note_times(), as in MIDI.
+constexpr std::int64_t ticks_per_quarter = 960;
+
+// An exact time in whole notes, as LilyPond's moments are.  A tuplet nested
+// in a tuplet can give one beyond any stan::duration, so walks that scale
+// durations by tuplets add these, and round only when asking for ticks.
+struct moment
+{
+    std::uint64_t m_num = 0;
+    std::uint64_t m_den = 1;
+
+    moment() = default;
+    moment(std::uint64_t num, std::uint64_t den);
+    moment(const duration &d);
+
+    friend moment operator+(const moment &m1, const moment &m2);
+    friend moment operator*(const moment &m1, const moment &m2);
+
+    // To the nearest tick.
+    std::int64_t ticks() const;
+};
+
+// What a tuplet scales the durations it holds by: its own length over the
+// sum of theirs.
+moment time_scale(const tuplet &);
+
+// When a note sounds, in ticks from the start of the music, ending where the
+// next note played after it would start.
+struct note_time
+{
+    std::int64_t m_onset;
+    std::int64_t m_end;
+};
+
+// The time of every note and chord, in note_count() order.  Tuplets whose
+// durations do not divide a tick evenly are rounded to the nearest tick,
+// measured from the start so that rounding never accumulates.
+std::vector<note_time> note_times(const sequential &);
+
 } // namespace stan
 
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stan/notation/pitch.hpp>
+#include <stan/exception.hpp>
+
+#include <cstdint>
+
+namespace stan {
+
+struct invalid_interval : exception
+{
+    template <typename... Args>
+    invalid_interval(const char *format, Args... args) :
+        exception((std::string("invalid interval: ") + format).c_str(),
+                  std::forward<Args>(args)...) {}
+};
+
+// An interval counts letter names as well as semitones, so that adding one
+// to a pitch spells the result the way a musician would: a major third up
+// from af is c, but a diminished fourth up from af is dff.  Steps count from
+// zero, so a third is two steps, and either count is negative for an
+// interval down.
+struct interval
+{
+    std::int8_t m_steps;
+    std::int8_t m_semitones;
+
+    friend constexpr bool operator==(const interval &i1, const interval &i2)
+    {
+        return i1.m_steps == i2.m_steps and i1.m_semitones == i2.m_semitones;
+    }
+    friend constexpr bool operator!=(const interval &i1, const interval &i2)
+    {
+        return !(i1 == i2);
+    }
+
+    friend constexpr interval operator+(const interval &i1, const interval &i2)
+    {
+        return { static_cast<std::int8_t>(i1.m_steps + i2.m_steps),
+                 static_cast<std::int8_t>(i1.m_semitones + i2.m_semitones) };
+    }
+    friend constexpr interval operator-(const interval &i)
+    {
+        return { static_cast<std::int8_t>(-i.m_steps), static_cast<std::int8_t>(-i.m_semitones) };
+    }
+};
+
+// The common intervals, named as in harmony texts: P perfect, M major, m
+// minor, A augmented and d diminished.
+namespace intervals {
+
+// clang-format off
+inline constexpr interval P1{ 0, 0 },  A1{ 0, 1 };
+inline constexpr interval m2{ 1, 1 },  M2{ 1, 2 },  A2{ 1, 3 };
+inline constexpr interval m3{ 2, 3 },  M3{ 2, 4 };
+inline constexpr interval d4{ 3, 4 },  P4{ 3, 5 },  A4{ 3, 6 };
+inline constexpr interval d5{ 4, 6 },  P5{ 4, 7 },  A5{ 4, 8 };
+inline constexpr interval m6{ 5, 8 },  M6{ 5, 9 };
+inline constexpr interval d7{ 6, 9 },  m7{ 6, 10 }, M7{ 6, 11 };
+inline constexpr interval P8{ 7, 12 };
+inline constexpr interval m9{ 8, 13 }, M9{ 8, 14 }, A9{ 8, 15 };
+inline constexpr interval P11{ 10, 17 }, A11{ 10, 18 };
+inline constexpr interval m13{ 12, 20 }, M13{ 12, 21 };
+// clang-format on
+
+} // namespace intervals
+
+// The pitch an interval away.  Throws invalid_interval if it would need more
+// than two sharps or flats, or fall outside octaves 0 to 9.
+pitch operator+(const pitch &, const interval &);
+pitch operator-(const pitch &, const interval &);
+
+// The pitch class an interval away, in any octave.
+pitchclass operator+(pitchclass, const interval &);
+
+// The interval from the second pitch up to the first, negative if the first
+// is lower.
+interval operator-(const pitch &, const pitch &);
+
+} // namespace stan
@@ -5,16 +5,22 @@
 
 #include <boost/hana/define_struct.hpp>
 
+#include <array>
 #include <vector>
 #include <numeric>
-#include <iostream>
 
 namespace stan {
   
 namespace mode {
 
-static const std::vector<std::uint8_t> major { 0, 2, 4, 5, 7, 9, 11 };
-static const std::vector<std::uint8_t> minor { 0, 2, 3, 5, 7, 8, 10 };
+// Inline, so the whole program shares one copy of each mode instead of every
+// translation unit that includes this header constructing its own.  They
+// cannot be constexpr: a key holds its mode as a std::vector, which C++17
+// cannot build at compile time, and a constexpr array would need converting
+// to one at every key constructed from it.  So each is built once, before
+// main().
+inline const std::vector<std::uint8_t> major { 0, 2, 4, 5, 7, 9, 11 };
+inline const std::vector<std::uint8_t> minor { 0, 2, 3, 5, 7, 8, 10 };
 
 }
 
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stan/exception.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stan {
+
+struct invalid_lyrics : exception
+{
+    template <typename... Args>
+    invalid_lyrics(const char *format, Args... args) :
+        exception((std::string("invalid lyrics: ") + format).c_str(),
+                  std::forward<Args>(args)...) {}
+};
+
+// One verse of sung text, kept beside the music rather than in it.  The text
+// of every syllable is appended to one UTF-8 pool, and each syllable is a
+// fixed twelve byte record of the note it is sung on, as counted by
+// stan::note_count(), and where its text lies in the pool.  A verse of
+// thousands of syllables is then two allocations, and the records, sorted by
+// note, are searched in place.
+class lyrics
+{
+  public:
+    // How a syllable leads into the next: "--" between syllables of a word,
+    // "__" to extend it over the notes that follow.
+    enum class join : std::uint8_t
+    {
+        none,
+        hyphen,
+        extender
+    };
+
+    struct syllable
+    {
+        std::uint32_t m_note;
+        std::uint32_t m_offset;
+        std::uint16_t m_length;
+        join m_join;
+    };
+
+    // Appends a syllable.  Notes must increase from one syllable to the
+    // next, and the text must be at most 65535 bytes.
+    void add(std::uint32_t note, std::string_view text, join j = join::none);
+
+    // Appends a syllable whose text write(std::string &) appends to the pool
+    // itself, as a reader unescaping a string does.  If it throws, the pool is
+    // left as it was.
+    template <typename Write>
+    void add_with(std::uint32_t note, Write &&write, join j = join::none)
+    {
+        check(note);
+        std::size_t start = m_pool.size();
+        try {
+            write(m_pool);
+            push(note, start, j);
+        } catch (...) {
+            m_pool.resize(start);
+            throw;
+        }
+    }
+
+    // Sets how the last syllable leads into the next.
+    void set_join(join j);
+
+    std::string_view text(const syllable &s) const
+    {
+        return std::string_view(m_pool).substr(s.m_offset, s.m_length);
+    }
+
+    // The syllable sung on a note, or nullptr if there is none.
+    const syllable *find(std::uint32_t note) const;
+
+    const std::vector<syllable> &syllables() const { return m_syllables; }
+    const std::string &pool() const { return m_pool; }
+    bool empty() const { return m_syllables.empty(); }
+
+    // Equal if the same syllables fall on the same notes, however the pools
+    // are laid out.
+    friend bool operator==(const lyrics &, const lyrics &);
+    friend bool operator!=(const lyrics &l1, const lyrics &l2) { return !(l1 == l2); }
+
+  private:
+    void check(std::uint32_t note) const;
+    void push(std::uint32_t note, std::size_t start, join j);
+
+    std::string m_pool;
+    std::vector<syllable> m_syllables;
+};
+
+} // namespace stan
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stan/static_map.hpp>
+
+#include <cstdint>
+
+namespace stan {
+
+// Marks written after a note, held in note_tables beside the music.
+
+enum class dynamic : std::uint8_t
+{
+    ppp,
+    pp,
+    p,
+    mp,
+    mf,
+    f,
+    ff,
+    fff,
+    fp,
+    sf,
+    sfz,
+};
+
+// As written in LilyPond, after the backslash.
+// clang-format off
+inline constexpr static_map<dynamic, const char *, 11> dynamic_names{ {{
+    { dynamic::ppp, "ppp" }, { dynamic::pp, "pp" }, { dynamic::p, "p" },
+    { dynamic::mp, "mp" }, { dynamic::mf, "mf" }, { dynamic::f, "f" },
+    { dynamic::ff, "ff" }, { dynamic::fff, "fff" }, { dynamic::fp, "fp" },
+    { dynamic::sf, "sf" }, { dynamic::sfz, "sfz" },
+} } };
+// clang-format on
+
+static_assert(dynamic_names.sorted());
+
+enum class articulation : std::uint8_t
+{
+    staccato,
+    accent,
+    tenuto,
+    marcato,
+    staccatissimo,
+    portato,
+};
+
+// As written in LilyPond, after the "-".
+// clang-format off
+inline constexpr static_map<articulation, const char *, 6> articulation_names{ {{
+    { articulation::staccato, "." }, { articulation::accent, ">" },
+    { articulation::tenuto, "-" }, { articulation::marcato, "^" },
+    { articulation::staccatissimo, "!" }, { articulation::portato, "_" },
+} } };
+// clang-format on
+
+static_assert(articulation_names.sorted());
+
+} // namespace stan
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace stan {
+
+// A sparse side table of values attached to notes, by their index as counted
+// by stan::note_count().  Most notes carry no dynamic or articulation, so
+// rather than a field in every note, which would widen every stan::column,
+// they live here as records sorted by note and found by binary search.  A
+// note may carry several values, which keep the order they were added in.
+template <typename T>
+class note_table
+{
+  public:
+    struct entry
+    {
+        std::uint32_t m_note;
+        T m_value;
+    };
+
+    using const_iterator = typename std::vector<entry>::const_iterator;
+
+    // Adds a value to a note, after any it already has.  Adding in note
+    // order, as a parser does, appends.
+    void add(std::uint32_t note, T value)
+    {
+        if (m_entries.empty() or m_entries.back().m_note <= note) {
+            m_entries.push_back({ note, std::move(value) });
+            return;
+        }
+        m_entries.insert(upper(note), { note, std::move(value) });
+    }
+
+    // The values on a note.
+    std::pair<const_iterator, const_iterator> equal_range(std::uint32_t note) const
+    {
+        return { lower(note), upper(note) };
+    }
+
+    // The first value on a note, or nullptr if there is none.
+    const T *find(std::uint32_t note) const
+    {
+        auto found = lower(note);
+        return found != m_entries.end() and found->m_note == note ? &found->m_value : nullptr;
+    }
+
+    const std::vector<entry> &entries() const { return m_entries; }
+    std::size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+    const_iterator begin() const { return m_entries.begin(); }
+    const_iterator end() const { return m_entries.end(); }
+
+    friend bool operator==(const note_table &t1, const note_table &t2)
+    {
+        return std::equal(t1.begin(), t1.end(), t2.begin(), t2.end(),
+                          [](const entry &e1, const entry &e2) {
+                              return e1.m_note == e2.m_note and e1.m_value == e2.m_value;
+                          });
+    }
+    friend bool operator!=(const note_table &t1, const note_table &t2) { return !(t1 == t2); }
+
+  private:
+    const_iterator lower(std::uint32_t note) const
+    {
+        return std::lower_bound(m_entries.begin(), m_entries.end(), note,
+                                [](const entry &e, std::uint32_t n) { return e.m_note < n; });
+    }
+
+    const_iterator upper(std::uint32_t note) const
+    {
+        return std::upper_bound(m_entries.begin(), m_entries.end(), note,
+                                [](std::uint32_t n, const entry &e) { return n < e.m_note; });
+    }
+
+    std::vector<entry> m_entries;
+};
+
+} // namespace stan
@@ -1,10 +1,11 @@
 #pragma once
 
+#include <stan/static_map.hpp>
+
 #include <type_safe/strong_typedef.hpp>
 #include <boost/hana/define_struct.hpp>
 
 #include <set>
-#include <map>
 
 namespace stan {
 
@@ -31,7 +32,26 @@ enum struct pitchclass : std::uint8_t
     // clang-format on
 };
 
-extern std::map<pitchclass, const char *> const pitchclass_names;
+// clang-format off
+inline constexpr static_map<pitchclass, const char *, 35> pitchclass_names{ {{
+    { pitchclass::cff, "cff" }, { pitchclass::cf, "cf" }, { pitchclass::c, "c" },
+    { pitchclass::cs, "cs" }, { pitchclass::css, "css" },
+    { pitchclass::dff, "dff" }, { pitchclass::df, "df" }, { pitchclass::d, "d" },
+    { pitchclass::ds, "ds" }, { pitchclass::dss, "dss" },
+    { pitchclass::eff, "eff" }, { pitchclass::ef, "ef" }, { pitchclass::e, "e" },
+    { pitchclass::es, "es" }, { pitchclass::ess, "ess" },
+    { pitchclass::fff, "fff" }, { pitchclass::ff, "ff" }, { pitchclass::f, "f" },
+    { pitchclass::fs, "fs" }, { pitchclass::fss, "fss" },
+    { pitchclass::gff, "gff" }, { pitchclass::gf, "gf" }, { pitchclass::g, "g" },
+    { pitchclass::gs, "gs" }, { pitchclass::gss, "gss" },
+    { pitchclass::aff, "aff" }, { pitchclass::af, "af" }, { pitchclass::a, "a" },
+    { pitchclass::as, "as" }, { pitchclass::ass, "ass" },
+    { pitchclass::bff, "bff" }, { pitchclass::bf, "bf" }, { pitchclass::b, "b" },
+    { pitchclass::bs, "bs" }, { pitchclass::bss, "bss" },
+} } };
+// clang-format on
+
+static_assert(pitchclass_names.sorted());
 
 // An octave is a std::uint8_t, with very limited semantics
 struct octave : ts::strong_typedef<octave, std::uint8_t>,
@@ -59,6 +79,10 @@ struct pitch
 
     staffline get_staffline() const;
 
+    // The MIDI note number, with middle C (octave 4) at 60.  Enharmonic pitches
+    // share a number.
+    int midi() const;
+
     pitch operator+(const pitch &);
 
     friend bool operator<(const pitch &, const pitch &);
@@ -2,6 +2,10 @@
 
 #include <stan/exception.hpp>
 
+#include <cassert>
+#include <cmath>
+#include <utility>
+
 namespace stan {
 
 // A note value behaves so similarly to a rational number that it was tempting
@@ -21,8 +25,8 @@ struct rational
 {
     using integer = T;
 
-    T num() const;
-    T den() const;
+    constexpr T num() const;
+    constexpr T den() const;
 
     void operator=(const rational &v);
 
@@ -40,14 +44,12 @@ struct rational
     // Make it impossible to contain an arbitrary value by allowing only
     // subclasses to construct valid values.
 
-    rational(T n, T d)
-    {
-        integer gcd = compute_gcd(n, d);
-        m_num = n / gcd;
-        m_den = d / gcd;
-    }
+    // The constructor and compute_gcd() are constexpr so that tables of values,
+    // like value::all, are built at compile time rather than before main().
+    constexpr rational(T n, T d) :
+        m_num(n / compute_gcd(n, d)), m_den(d / compute_gcd(n, d)) {}
 
-    static integer compute_gcd(integer a, integer b);
+    static constexpr integer compute_gcd(integer a, integer b);
 
   private:
     T m_num;
@@ -55,13 +57,13 @@ struct rational
 };
 
 template <typename T>
-T rational<T>::num() const
+constexpr T rational<T>::num() const
 {
     return m_num;
 }
 
 template <typename T>
-T rational<T>::den() const
+constexpr T rational<T>::den() const
 {
     assert(m_den > 0); // Silence clang DivideZero warning
     return m_den;
@@ -129,10 +131,12 @@ bool operator==(rational<T> const &p1, std::pair<T, T> const &p2)
 }
 
 template <typename T>
-T rational<T>::compute_gcd(T a, T b)
+constexpr T rational<T>::compute_gcd(T a, T b)
 {
     while (b != 0) {
-        a = std::exchange(b, a % b);
+        T r = a % b;
+        a = b;
+        b = r;
     }
     assert(a > 0); // Silence clang DivideZero warning
     return a;
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stan/notation/column.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace stan {
+
+// A sequence of columns for editing, where a std::vector<column> would shift
+// every column after an insertion or deletion.  It is a B+ tree: leaves hold
+// up to 64 consecutive columns and are linked in order, and each branch
+// keeps, beside each child, how many columns the child holds and how long
+// they last in ticks (stan::ticks_per_quarter to a quarter note).  Inserting,
+// erasing, replacing and finding a column by position or by time descend
+// one path, so each is O(log n); iterating walks the leaves.
+//
+//     stan::rope music(reader.sequence(text));
+//     music.insert(music.at_time(4 * stan::ticks_per_quarter), column);
+//     std::string lily = writer(music);
+class rope
+{
+    struct node;
+
+  public:
+    class const_iterator
+    {
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = column;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const column *;
+        using reference = const column &;
+
+        const_iterator() = default;
+
+        reference operator*() const { return m_leaf->m_columns[m_index]; }
+        pointer operator->() const { return &**this; }
+
+        const_iterator &operator++();
+        const_iterator operator++(int)
+        {
+            const_iterator i = *this;
+            ++*this;
+            return i;
+        }
+        const_iterator &operator--();
+        const_iterator operator--(int)
+        {
+            const_iterator i = *this;
+            --*this;
+            return i;
+        }
+
+        friend bool operator==(const const_iterator &i1, const const_iterator &i2)
+        {
+            return i1.m_leaf == i2.m_leaf and i1.m_index == i2.m_index;
+        }
+        friend bool operator!=(const const_iterator &i1, const const_iterator &i2)
+        {
+            return !(i1 == i2);
+        }
+
+      private:
+        friend class rope;
+        const_iterator(const node *leaf, std::size_t i) : m_leaf(leaf), m_index(i) {}
+
+        const node *m_leaf = nullptr;
+        std::size_t m_index = 0;
+    };
+
+    using value_type = column;
+    using iterator = const_iterator;
+
+    rope();
+    explicit rope(const sequential &);
+    rope(const rope &);
+    rope(rope &&) noexcept;
+    rope &operator=(const rope &);
+    rope &operator=(rope &&) noexcept;
+    ~rope();
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    // The length of the whole sequence in ticks.
+    std::int64_t ticks() const { return m_ticks; }
+
+    const column &operator[](std::size_t i) const;
+
+    // As operator[], but throws std::out_of_range past the end.
+    const column &at(std::size_t i) const;
+
+    // Inserts c before position i, or at the end if i is size().  These
+    // throw std::out_of_range for a position past the end.
+    void insert(std::size_t i, column c);
+    void push_back(column c) { insert(m_size, std::move(c)); }
+    void erase(std::size_t i);
+    void replace(std::size_t i, column c);
+
+    // Ticks from the start to column i, or to the end if i is size().
+    std::int64_t onset(std::size_t i) const;
+
+    // The column sounding at tick t: the first to end after it, so never
+    // one that takes no time, such as a clef, or size() if none does.  A
+    // tick before the start is read as the start.
+    std::size_t at_time(std::int64_t t) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    sequential flatten() const;
+
+  private:
+    struct node
+    {
+        bool m_leaf;
+
+        // A leaf's columns, or a branch's children with the number of
+        // columns under each and their length.
+        std::vector<column> m_columns;
+        std::vector<std::unique_ptr<node>> m_children;
+        std::vector<std::size_t> m_counts;
+        std::vector<std::int64_t> m_ticks;
+
+        // Neighbouring leaves, in order.
+        node *m_prev = nullptr;
+        node *m_next = nullptr;
+
+        std::size_t width() const { return m_leaf ? m_columns.size() : m_children.size(); }
+    };
+
+    static std::unique_ptr<node> split(node &);
+    static void rebalance(node &parent, std::size_t child);
+    static void recount(node &parent, std::size_t child);
+    static std::unique_ptr<node> insert(node &, std::size_t i, column &c, std::int64_t ticks);
+    static std::int64_t erase(node &, std::size_t i);
+    static std::int64_t replace(node &, std::size_t i, column &c, std::int64_t ticks);
+
+    std::unique_ptr<node> m_root;
+    std::size_t m_size = 0;
+    std::int64_t m_ticks = 0;
+};
+
+} // namespace stan
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stan/notation/column.hpp>
+#include <stan/notation/lyrics.hpp>
+#include <stan/notation/marks.hpp>
+#include <stan/notation/note_table.hpp>
+#include <stan/notation/spanner.hpp>
+
+#include <boost/hana/define_struct.hpp>
+
+#include <vector>
+
+namespace stan {
+
+// A music list with what is written beside it rather than in it, in side
+// tables that refer to notes by index, so that music without them costs
+// nothing extra.
+struct score
+{
+    BOOST_HANA_DEFINE_STRUCT(score,
+                             (sequential, m_music),
+                             (std::vector<lyrics>, m_verses),
+                             (note_table<dynamic>, m_dynamics),
+                             (note_table<articulation>, m_articulations),
+                             (std::vector<spanner>, m_spanners));
+};
+
+} // namespace stan
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stan/interval_tree.hpp>
+#include <stan/notation/column.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace stan {
+
+struct score;
+
+// A mark drawn across a run of notes, from the note it starts on to the note
+// it ends on, both by their index as counted by stan::note_count().  The run
+// may cross beams, tuplets and measures.
+struct spanner
+{
+    enum class type : std::uint8_t
+    {
+        slur,          // "(" to ")"
+        phrasing_slur, // "\(" to "\)"
+        crescendo,     // "\<" to "\!", or to the next dynamic or hairpin
+        decrescendo,   // "\>" likewise
+    };
+
+    std::uint32_t m_first;
+    std::uint32_t m_last;
+    type m_type;
+
+    friend bool operator==(const spanner &s1, const spanner &s2)
+    {
+        return s1.m_first == s2.m_first and s1.m_last == s2.m_last and s1.m_type == s2.m_type;
+    }
+    friend bool operator!=(const spanner &s1, const spanner &s2) { return !(s1 == s2); }
+};
+
+// Finds the spanners of a score that cover a run of notes or a stretch of
+// time, through one interval tree over note indices and another over the
+// times of the notes, as given by stan::note_times().  The index refers to
+// the score's spanners, which must outlive it and not change.
+class spanner_index
+{
+  public:
+    explicit spanner_index(const score &);
+
+    // The spanners covering any of notes first to last, in score order.
+    std::vector<const spanner *> notes(std::uint32_t first, std::uint32_t last) const;
+
+    // The spanners sounding at any time in [begin, end), in ticks, in score
+    // order.  A spanner sounds from the onset of its first note to the end
+    // of its last.
+    std::vector<const spanner *> times(std::int64_t begin, std::int64_t end) const;
+
+  private:
+    std::vector<const spanner *> collect(std::vector<std::uint32_t> ids) const;
+
+    const std::vector<spanner> &m_spanners;
+    interval_tree<std::uint32_t> m_notes;
+    interval_tree<std::int64_t> m_times;
+};
+
+} // namespace stan
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stan/notation/column.hpp>
+#include <stan/notation/interval.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+namespace stan {
+
+// A column moved by an interval: the pitches of notes and chords and the
+// tonic of keys, inside beams and tuplets too.  Other columns are unchanged.
+column transpose(const column &, const interval &);
+sequential transpose(const sequential &, const interval &);
+
+// A music list as it reads moved by an interval, such as a clarinet part in
+// concert pitch, without a transposed copy of it all.  Each top-level column
+// is transposed the first time it is read and kept for later reads; columns
+// without pitches, such as rests and meters, are read straight from the
+// music, so a view costs a pointer per column plus the columns touched.
+//
+//     // A B flat clarinet sounds a major second below written pitch.
+//     stan::transposed concert(part, -stan::intervals::M2);
+//     std::string lily = writer(concert);
+//
+// Reading is safe from any number of threads at once: threads that transpose
+// the same column together keep the first result to be published.  The music
+// must outlive the view and not change.  A view moved from is left empty.
+class transposed
+{
+  public:
+    class iterator
+    {
+      public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = column;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const column *;
+        using reference = const column &;
+
+        iterator(const transposed *view, std::size_t i) : m_view(view), m_index(i) {}
+
+        reference operator*() const { return (*m_view)[m_index]; }
+        pointer operator->() const { return &**this; }
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        iterator &operator++() { ++m_index; return *this; }
+        iterator operator++(int) { iterator i = *this; ++m_index; return i; }
+        iterator &operator--() { --m_index; return *this; }
+        iterator operator--(int) { iterator i = *this; --m_index; return i; }
+        iterator &operator+=(difference_type n) { m_index += n; return *this; }
+        iterator &operator-=(difference_type n) { m_index -= n; return *this; }
+
+        friend iterator operator+(iterator i, difference_type n) { return i += n; }
+        friend iterator operator+(difference_type n, iterator i) { return i += n; }
+        friend iterator operator-(iterator i, difference_type n) { return i -= n; }
+        friend difference_type operator-(const iterator &i1, const iterator &i2)
+        {
+            return difference_type(i1.m_index) - difference_type(i2.m_index);
+        }
+
+        friend bool operator==(const iterator &i1, const iterator &i2) { return i1.m_index == i2.m_index; }
+        friend bool operator!=(const iterator &i1, const iterator &i2) { return i1.m_index != i2.m_index; }
+        friend bool operator<(const iterator &i1, const iterator &i2) { return i1.m_index < i2.m_index; }
+        friend bool operator>(const iterator &i1, const iterator &i2) { return i1.m_index > i2.m_index; }
+        friend bool operator<=(const iterator &i1, const iterator &i2) { return i1.m_index <= i2.m_index; }
+        friend bool operator>=(const iterator &i1, const iterator &i2) { return i1.m_index >= i2.m_index; }
+
+      private:
+        const transposed *m_view;
+        std::size_t m_index;
+    };
+
+    using value_type = column;
+    using const_iterator = iterator;
+
+    transposed(const sequential &music, const interval &by);
+    ~transposed();
+
+    transposed(transposed &&) noexcept;
+    transposed(const transposed &) = delete;
+    transposed &operator=(const transposed &) = delete;
+    transposed &operator=(transposed &&) = delete;
+
+    const column &operator[](std::size_t i) const;
+
+    std::size_t size() const { return m_music->size(); }
+    bool empty() const { return m_music->empty(); }
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size()); }
+
+    // The music as written, whose durations and meters the view shares.
+    const sequential &base() const { return *m_music; }
+    const interval &by() const { return m_interval; }
+
+    // How many columns have been transposed and kept so far.
+    std::size_t cached() const;
+
+  private:
+    const sequential *m_music;
+    interval m_interval;
+    std::unique_ptr<std::atomic<const column *>[]> m_cache;
+};
+
+} // namespace stan
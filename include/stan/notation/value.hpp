@@ -3,6 +3,7 @@
 #include <stan/notation/rational.hpp>
 #include <stan/exception.hpp>
 
+#include <array>
 #include <vector>
 
 namespace stan {
@@ -20,14 +21,14 @@ struct invalid_value : exception
 struct value : rational<std::uint16_t>
 {
   public:
-    static value whole() { return { 1, 1 }; }
-    static value half() { return { 1, 2 }; }
-    static value quarter() { return { 1, 4 }; }
-    static value eighth() { return { 1, 8 }; }
-    static value sixteenth() { return { 1, 16 }; }
-    static value thirtysecond() { return { 1, 32 }; }
-    static value sixtyfourth() { return { 1, 64 }; }
-    static value instantaneous() { return { 0, 1 }; }
+    static constexpr value whole() { return { 1, 1 }; }
+    static constexpr value half() { return { 1, 2 }; }
+    static constexpr value quarter() { return { 1, 4 }; }
+    static constexpr value eighth() { return { 1, 8 }; }
+    static constexpr value sixteenth() { return { 1, 16 }; }
+    static constexpr value thirtysecond() { return { 1, 32 }; }
+    static constexpr value sixtyfourth() { return { 1, 64 }; }
+    static constexpr value instantaneous() { return { 0, 1 }; }
 
     operator duration() const;
     using dots_t = std::uint8_t;
@@ -36,17 +37,52 @@ struct value : rational<std::uint16_t>
     using rational<std::uint16_t>::rational;
 
     // The free function dot() needs the constructor.
-    friend value dot(const value &v);
+    friend constexpr value dot(const value &v);
     friend value dimin(const value &v);
     friend value augment(const value &v);
     friend duration operator*(int, value const &);
 
     // friend bool operator==(const value &, const value &);
-    static const std::vector<value> all;
+    static const std::array<value, 18> all;
 };
 
-value dot(const value &v);
+constexpr value dot(const value &v);
 value dimin(const value &v);
 value augment(const value &v);
 
+constexpr value dot(const value &v)
+{
+    // The operation is either going from 0->1 dot, or 1->2 dots.  There
+    // are no other valid situations.
+    if (v.num() != 1 and v.num() != 3) {
+        throw invalid_value("values can have exactly 0, 1, or 2 dots");
+    }
+    return {
+        static_cast<value::integer>(2 * v.num() + 1),
+        static_cast<value::integer>(2 * v.den())
+    };
+}
+
+// Every valid note value, computed at compile time.
+inline constexpr std::array<value, 18> value::all{
+    whole(),
+    half(),
+    quarter(),
+    eighth(),
+    sixteenth(),
+    thirtysecond(),
+    sixtyfourth(),
+    dot(whole()),
+    dot(half()),
+    dot(quarter()),
+    dot(eighth()),
+    dot(sixteenth()),
+    dot(thirtysecond()),
+    dot(dot(whole())),
+    dot(dot(half())),
+    dot(dot(quarter())),
+    dot(dot(eighth())),
+    dot(dot(sixteenth()))
+};
+
 } // namespace stan
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <stan/notation.hpp>
+#include <stan/hash.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// Declarative rewrites of music lists, for normalizing a corpus.  A rule
+// matches a run of neighbouring columns by their kinds and fields and gives
+// the columns to put in its place:
+//
+//     // Two rests r4 r8 become one dotted rest r4.
+//     stan::rewrite::rule dotted{
+//         "dot-rests",
+//         { stan::rewrite::kind<stan::rest>(), stan::rewrite::kind<stan::rest>() },
+//         [](const stan::column *run) -> std::optional<stan::sequential> { ... },
+//     };
+//
+// A rewriter applies its rules bottom up: the lists inside a beam or tuplet
+// are rewritten before the list holding it, and each list is rewritten until
+// no rule matches, in one forward pass.  Beams and tuplets are memoized on a
+// content hash built bottom up from stan::driver::binary::hash() of the
+// columns they hold, so a subtree that occurs many times in a score or
+// across a corpus is hashed once per call and rewritten once.
+
+namespace stan::rewrite {
+
+namespace detail {
+
+template <typename T, typename Variant>
+struct index_of;
+
+template <typename T, typename... Ts>
+struct index_of<T, std::variant<Ts...>>
+{
+    static constexpr std::size_t value = [] {
+        constexpr bool same[] = { std::is_same_v<T, Ts>... };
+        std::size_t i = 0;
+        while (!same[i]) {
+            ++i;
+        }
+        return i;
+    }();
+};
+
+} // namespace detail
+
+// One column of a pattern: its kind, as the index of its alternative in
+// stan::column, and a test of its fields if there is one.
+struct match
+{
+    std::size_t m_kind;
+    std::function<bool(const column &)> m_test;
+};
+
+// Any column of kind T.
+template <typename T>
+match kind()
+{
+    return { detail::index_of<T, column>::value, nullptr };
+}
+
+// A column of kind T for which test(const T &) holds.
+template <typename T, typename Test>
+match kind(Test test)
+{
+    return { detail::index_of<T, column>::value,
+             [test](const column &c) { return test(std::get<T>(c)); } };
+}
+
+// The lists a rule applies in.
+enum class scope : std::uint8_t
+{
+    anywhere,
+    top_level,
+    in_beam,
+    in_tuplet,
+};
+
+struct rule
+{
+    const char *m_name;
+    std::vector<match> m_pattern;
+
+    // The columns to put in place of a run that matched the pattern, given
+    // its first column, or nullopt to leave it.  A rule must never undo
+    // another, or rewriting would not end.
+    std::function<std::optional<sequential>(const column *)> m_rewrite;
+
+    scope m_scope = scope::anywhere;
+};
+
+// A rest followed by a rest of half its value, the two becoming one dotted
+// rest: "r4 r8" is "r4.", as tied notes are written with a dot.  A rule sees
+// neither the meter nor where the run starts, so this one would dot two rests
+// on either side of a bar line; it is not a standard rule, and
+// dot_rests_within_measures() below dots only where the bar allows.
+rule dot_rests();
+
+// Dots rests as dot_rests() does, but only where the dotted rest ends at or
+// before the end of the measure it starts in: "\time 3/4 c2 r4 r8 c8" keeps
+// its rests, as "r4." would run over the bar line.  Measures follow the
+// meters as for stan::measures(), counted in scaled time inside tuplets.
+// Tells whether any rests were dotted.
+bool dot_rests_within_measures(sequential &);
+
+// The standard rules.
+
+// A beam directly inside a beam, its notes joining the outer beam: secondary
+// beams follow from the note values anyway.
+rule flatten_beams();
+
+// A tuplet whose ratio is 1/1, which is just its columns.
+rule unwrap_tuplets();
+
+std::vector<rule> standard();
+
+// Applies rules to music lists, remembering the rewritten form of every beam
+// and tuplet it has seen until clear().  Not safe to share between threads;
+// give each thread a rewriter of its own.
+class rewriter
+{
+  public:
+    explicit rewriter(std::vector<rule> rules = standard());
+
+    sequential operator()(const sequential &);
+
+    // How many beams and tuplets are remembered, and how many times one was
+    // found already rewritten.
+    std::size_t memoized() const { return m_memo.size(); }
+    std::size_t hits() const { return m_hits; }
+
+    void clear();
+
+  private:
+    struct hasher
+    {
+        std::size_t operator()(const hash128 &h) const { return h.m_low; }
+    };
+
+    hash128 index(const column &);
+    sequential list(const sequential &, scope);
+    column node(const column &);
+    void apply(sequential &, scope) const;
+
+    std::vector<rule> m_rules;
+
+    // The rules, by position, whose patterns start with each kind of column.
+    std::array<std::vector<std::size_t>, std::variant_size_v<column>> m_starting;
+    std::size_t m_longest = 1;
+
+    struct remembered
+    {
+        column m_original;
+        column m_rewritten;
+    };
+
+    // The key of every beam and tuplet in the music being rewritten, in
+    // preorder, with how many of them its subtree holds, itself included.
+    struct subtree
+    {
+        hash128 m_key;
+        std::size_t m_size;
+    };
+
+    std::vector<subtree> m_keys;
+    std::size_t m_next = 0;
+
+    std::unordered_map<hash128, remembered, hasher> m_memo;
+    std::size_t m_hits = 0;
+};
+
+} // namespace stan::rewrite
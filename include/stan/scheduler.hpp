@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+// One pool of threads for all the parallel work in the library, so that
+// nested and concurrent parallel calls share the cores instead of each
+// starting threads of its own.
+//
+// The library's default is a work-stealing scheduler with one thread per
+// core, or as many as the STAN_THREADS environment variable says.  An
+// application with a thread pool of its own can install it as the default
+// executor instead, and the library then runs all its work there.
+//
+// fork_join() and parallel_for() never wait for work that has not started:
+// a task the executor has not yet run is claimed and run by the waiting
+// thread itself.  They are therefore safe to nest, and safe on any
+// executor, even one with a single thread or one whose threads are all
+// busy waiting.
+
+namespace stan {
+
+class executor
+{
+  public:
+    virtual ~executor() = default;
+
+    // Runs task at some later time, on any thread.  Tasks must not throw;
+    // fork_join() and parallel_for() catch what their callables throw.
+    virtual void submit(std::function<void()> task) = 0;
+
+    // How many tasks the executor runs at once, used to size work.
+    virtual unsigned concurrency() const = 0;
+
+    // Runs one queued task on the calling thread and returns true, or
+    // returns false if there is none.  Threads waiting for a join call this
+    // to help instead of blocking.
+    virtual bool run_one() { return false; }
+};
+
+// A work-stealing scheduler.  Each thread has its own double-ended queue,
+// pushing and popping tasks it submits at the back, so that forked work
+// stays hot in its cache, while idle threads steal the oldest tasks, the
+// largest pieces of work, from the front of others' queues.  Tasks
+// submitted from other threads go into a shared queue.
+class scheduler final : public executor
+{
+  public:
+    // Zero threads means one per core.
+    explicit scheduler(unsigned threads = 0);
+
+    // Runs every task already submitted, then stops the threads.
+    ~scheduler() override;
+
+    scheduler(const scheduler &) = delete;
+    scheduler &operator=(const scheduler &) = delete;
+
+    void submit(std::function<void()> task) override;
+    unsigned concurrency() const override;
+    bool run_one() override;
+
+  private:
+    struct state;
+    std::unique_ptr<state> m_state;
+};
+
+// The executor the library's parallel work runs on.  Created on first use
+// unless one has been set.
+executor &default_executor();
+
+// Replaces the default executor; nullptr restores the library's own.  Work
+// already running on the previous executor finishes there, and it is kept
+// until exit, so set this once at startup rather than per call.
+void set_default_executor(std::shared_ptr<executor>);
+
+namespace detail {
+
+// Completion of the pieces of one fork_join() or parallel_for().
+class join_counter
+{
+  public:
+    explicit join_counter(std::size_t pieces) : m_pending(pieces) {}
+
+    // Marks a piece finished, with the exception it threw if any.  The first
+    // exception is the one rethrown by wait().
+    void finish(std::exception_ptr failure = nullptr);
+
+    // Returns once every piece has finished, helping ex in the meantime, and
+    // rethrows the first exception.
+    void wait(executor &ex);
+
+    bool failed() const { return m_failed.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<std::size_t> m_pending;
+    std::atomic<bool> m_failed{ false };
+    std::exception_ptr m_failure;
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+};
+
+} // namespace detail
+
+// Runs f and g, possibly at the same time, and returns when both have
+// finished.  If either throws, the first exception thrown is rethrown once
+// both have finished.
+template <typename F, typename G>
+void fork_join(executor &ex, F &&f, G &&g)
+{
+    struct shared
+    {
+        detail::join_counter m_join{ 2 };
+        std::atomic<bool> m_claimed{ false };
+        std::remove_reference_t<G> *m_g = nullptr;
+
+        void run()
+        {
+            try {
+                (*m_g)();
+                m_join.finish();
+            } catch (...) {
+                m_join.finish(std::current_exception());
+            }
+        }
+    };
+
+    auto s = std::make_shared<shared>();
+    s->m_g = &g;
+    ex.submit([s]() {
+        if (!s->m_claimed.exchange(true)) {
+            s->run();
+        }
+    });
+
+    try {
+        std::forward<F>(f)();
+        s->m_join.finish();
+    } catch (...) {
+        s->m_join.finish(std::current_exception());
+    }
+    if (!s->m_claimed.exchange(true)) {
+        s->run();
+    }
+    s->m_join.wait(ex);
+}
+
+template <typename F, typename G>
+void fork_join(F &&f, G &&g)
+{
+    fork_join(default_executor(), std::forward<F>(f), std::forward<G>(g));
+}
+
+// Calls body(i) for every i in [first, last), in parallel, in chunks of at
+// least grain consecutive indices.  If any call throws, the remaining chunks
+// are skipped and the first exception is rethrown.
+template <typename F>
+void parallel_for(executor &ex, std::size_t first, std::size_t last, F &&body,
+                  std::size_t grain = 1)
+{
+    if (first >= last) {
+        return;
+    }
+    std::size_t count = last - first;
+    grain = std::max<std::size_t>(grain, 1);
+
+    // A few chunks per thread, so that threads finishing early take up the
+    // slack from uneven work.
+    std::size_t width = std::max(1u, ex.concurrency());
+    std::size_t size = std::max(grain, count / (width * 4 + 1));
+    std::size_t chunks = (count + size - 1) / size;
+    if (chunks == 1) {
+        for (std::size_t i = first; i < last; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    struct shared
+    {
+        explicit shared(std::size_t chunks) : m_join(chunks) {}
+
+        detail::join_counter m_join;
+        std::atomic<std::size_t> m_next{ 0 };
+        std::size_t m_chunks = 0;
+        std::size_t m_first = 0;
+        std::size_t m_last = 0;
+        std::size_t m_size = 0;
+        std::remove_reference_t<F> *m_body = nullptr;
+
+        // Runs chunks until there are none left to claim.
+        void run()
+        {
+            for (std::size_t c; (c = m_next.fetch_add(1)) < m_chunks;) {
+                if (m_join.failed()) {
+                    m_join.finish();
+                    continue;
+                }
+                try {
+                    std::size_t begin = m_first + c * m_size;
+                    std::size_t end = std::min(m_last, begin + m_size);
+                    for (std::size_t i = begin; i < end; ++i) {
+                        (*m_body)(i);
+                    }
+                    m_join.finish();
+                } catch (...) {
+                    m_join.finish(std::current_exception());
+                }
+            }
+        }
+    };
+
+    auto s = std::make_shared<shared>(chunks);
+    s->m_chunks = chunks;
+    s->m_first = first;
+    s->m_last = last;
+    s->m_size = size;
+    s->m_body = &body;
+
+    std::size_t helpers = std::min(chunks, width) - 1;
+    for (std::size_t h = 0; h < helpers; ++h) {
+        ex.submit([s]() { s->run(); });
+    }
+    s->run();
+    s->m_join.wait(ex);
+}
+
+template <typename F>
+void parallel_for(std::size_t first, std::size_t last, F &&body, std::size_t grain = 1)
+{
+    parallel_for(default_executor(), first, last, std::forward<F>(body), grain);
+}
+
+} // namespace stan
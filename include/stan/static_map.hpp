@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+namespace stan {
+
+// A read only lookup table that is built entirely at compile time.  A
+// namespace scope std::map runs its constructor before main() in every process
+// that links stan, and a function static one pays an allocation per entry plus
+// a guarded initialization on first use.  A static_map is just a sorted
+// std::array, so it is constant initialized and at() is a binary search.
+// Entries must be listed in ascending key order, which sorted() verifies in a
+// static_assert next to each table.
+
+template <typename Key, typename Value, std::size_t N>
+struct static_map
+{
+    using value_type = std::pair<Key, Value>;
+    using const_iterator = typename std::array<value_type, N>::const_iterator;
+
+    std::array<value_type, N> m_entries;
+
+    constexpr const Value &at(const Key &k) const
+    {
+        const_iterator found = find(k);
+        if (found == end()) {
+            throw std::out_of_range("static_map::at");
+        }
+        return found->second;
+    }
+
+    constexpr const_iterator find(const Key &k) const
+    {
+        std::size_t lo = 0;
+        std::size_t hi = N;
+        while (lo < hi) {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if (m_entries[mid].first < k) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == N or k < m_entries[lo].first) {
+            return end();
+        }
+        return begin() + lo;
+    }
+
+    constexpr std::size_t count(const Key &k) const { return find(k) == end() ? 0 : 1; }
+
+    constexpr bool sorted() const
+    {
+        for (std::size_t i = 1; i < N; ++i) {
+            if (not(m_entries[i - 1].first < m_entries[i].first)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr std::size_t size() const { return N; }
+    constexpr const_iterator begin() const { return m_entries.begin(); }
+    constexpr const_iterator end() const { return m_entries.end(); }
+};
+
+} // namespace stan
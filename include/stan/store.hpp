@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stan/notation.hpp>
+#include <stan/exception.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A single file store of parsed scores, for services that fetch a few bars at
+// a time.  Scores are split into measures, each kept in the binary encoding,
+// and a B+ tree over (score, measure) finds any range of bars without reading
+// the rest of the score.
+//
+// The file is a sequence of fixed size pages, each with a CRC-32 of its
+// contents that is checked whenever it is read.  Pages are never modified
+// once written: a change writes new copies of the tree nodes on its path
+// after the end of the file, then commits by writing a new root to the
+// older of two header pages.  A crash leaves the newer header intact, and
+// readers, which map the file into memory, can never see a partly written
+// tree.  Readers in any number of processes share the OS page cache, and
+// writers in different processes are serialized with flock(2).
+//
+// Replaced pages are not reused, so a store that is updated often grows
+// until it is copied afresh.
+
+namespace stan {
+
+struct store_error : exception
+{
+    template <typename... Args>
+    store_error(const char *format, Args... args) :
+        exception((std::string("store error: ") + format).c_str(),
+                  std::forward<Args>(args)...) {}
+};
+
+class score_store
+{
+  public:
+    // Bump whenever the file format changes.
+    static constexpr std::uint32_t version = 1;
+    static constexpr std::size_t page_size = 4096;
+
+    // Opens the store at path, creating it if it does not exist.
+    explicit score_store(const std::string &path);
+    ~score_store();
+
+    score_store(const score_store &) = delete;
+    score_store &operator=(const score_store &) = delete;
+
+    // Adds or replaces scores in one durable transaction.  Measures are
+    // numbered as by stan::measures().  An empty score is not stored.
+    void put(std::uint64_t score, const sequential &music);
+    void put(const std::vector<std::pair<std::uint64_t, sequential>> &scores);
+
+    void remove(std::uint64_t score);
+
+    // Measures first through last of a score, inclusive, or as many of them
+    // as it has.  Empty if the score is not stored.
+    sequential get(std::uint64_t score, std::size_t first_measure,
+                   std::size_t last_measure) const;
+    sequential get(std::uint64_t score) const;
+
+    // The number of measures in a score, or zero if it is not stored.
+    std::size_t measures(std::uint64_t score) const;
+
+  private:
+    struct meta
+    {
+        std::uint64_t m_transaction = 0;
+        std::uint64_t m_root = 0;
+        std::uint64_t m_pages = 2;
+    };
+
+    struct key;
+    struct transaction;
+
+    void write(const std::vector<std::pair<std::uint64_t, const sequential *>> &scores);
+
+    // The newest committed header, with the map large enough to read it.
+    // Called, and the result used, with m_map_mutex held shared.
+    meta current(std::shared_lock<std::shared_mutex> &lock) const;
+    void remap(std::uint64_t pages) const;
+
+    const unsigned char *page(const meta &, std::uint64_t number, std::uint8_t type) const;
+
+    template <typename Visit>
+    void scan(const meta &, std::uint64_t node, const key &low, const key &high,
+              const Visit &visit) const;
+
+    std::string m_path;
+    int m_fd = -1;
+
+    // The whole file is mapped with room to grow, and remapped only when it
+    // outgrows the mapping.  Readers hold m_map_mutex shared while they use
+    // pointers into the map.
+    mutable std::shared_mutex m_map_mutex;
+    mutable unsigned char *m_map = nullptr;
+    mutable std::size_t m_map_size = 0;
+
+    std::mutex m_write_mutex;
+};
+
+} // namespace stan
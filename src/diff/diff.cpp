@@ -0,0 +1,245 @@
+#include <stan/diff.hpp>
+#include <stan/driver/binary.hpp>
+#include <stan/driver/debug.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+
+namespace stan::diff {
+
+namespace {
+
+// Beyond this many differences between two lists, Myers' search stops and
+// the unmatched middle is reported as one replaced run.  The search costs
+// time proportional to the list length times the differences, and memory to
+// the square of the differences, so this bounds both for unrelated inputs.
+constexpr int max_cost = 4096;
+
+enum class step
+{
+    keep,
+    remove,
+    insert
+};
+
+// Myers' greedy O((N+M)D) shortest edit script over column hashes.  trace[d]
+// holds the furthest reaching x on each diagonal k in [-d, d] after d edits,
+// which is enough to walk the path back once both ends meet.
+std::vector<step> shortest_edit(const hash128 *a, int n, const hash128 *b, int m)
+{
+    int limit = std::min(n + m, max_cost);
+    std::vector<int> v(2 * limit + 3, 0);
+    int offset = limit + 1;
+    std::vector<std::vector<int>> trace;
+
+    for (int d = 0; d <= limit; ++d) {
+        for (int k = -d; k <= d; k += 2) {
+            int x = (k == -d or (k != d and v[offset + k - 1] < v[offset + k + 1]))
+                ? v[offset + k + 1]
+                : v[offset + k - 1] + 1;
+            int y = x - k;
+            while (x < n and y < m and a[x] == b[y]) {
+                ++x;
+                ++y;
+            }
+            v[offset + k] = x;
+
+            if (x >= n and y >= m) {
+                std::vector<step> steps;
+                for (int e = d; e > 0; --e) {
+                    const std::vector<int> &prev = trace[e - 1];
+                    int k = x - y;
+                    bool down =
+                        k == -e or (k != e and prev[k - 1 + e - 1] < prev[k + 1 + e - 1]);
+                    int prev_k = down ? k + 1 : k - 1;
+                    int prev_x = prev[prev_k + e - 1];
+                    int prev_y = prev_x - prev_k;
+                    for (; x > prev_x and y > prev_y; --x, --y) {
+                        steps.push_back(step::keep);
+                    }
+                    steps.push_back(down ? step::insert : step::remove);
+                    x = prev_x;
+                    y = prev_y;
+                }
+                for (; x > 0; --x) {
+                    steps.push_back(step::keep);
+                }
+                std::reverse(steps.begin(), steps.end());
+                return steps;
+            }
+        }
+        trace.emplace_back(v.begin() + offset - d, v.begin() + offset + d + 1);
+    }
+
+    std::vector<step> steps(n, step::remove);
+    steps.insert(steps.end(), m, step::insert);
+    return steps;
+}
+
+bool recursable(const column &c1, const column &c2)
+{
+    if (std::holds_alternative<beam>(c1) and std::holds_alternative<beam>(c2)) {
+        return true;
+    }
+    if (std::holds_alternative<tuplet>(c1) and std::holds_alternative<tuplet>(c2)) {
+        return std::get<tuplet>(c1).m_value == std::get<tuplet>(c2).m_value;
+    }
+    return false;
+}
+
+const std::vector<column> &elements(const column &c)
+{
+    if (const auto *b = std::get_if<beam>(&c)) {
+        return b->m_elements;
+    }
+    return std::get<tuplet>(c).m_elements;
+}
+
+struct differ
+{
+    std::vector<edit> &m_edits;
+    path m_old_path;
+    path m_new_path;
+
+    void add(operation op, std::size_t i, std::size_t j, const column *c1, const column *c2)
+    {
+        m_old_path.push_back(i);
+        m_new_path.push_back(j);
+        m_edits.push_back({ op, m_old_path, m_new_path, c1, c2 });
+        m_old_path.pop_back();
+        m_new_path.pop_back();
+    }
+
+    // Old columns [i0, i1) were replaced by new columns [j0, j1).  Within the
+    // run, columns are paired up by kind with a second, much smaller diff,
+    // so that an inserted note before a changed beam still lines the beam up
+    // with its new version.
+    void hunk(const std::vector<column> &a, std::size_t i0, std::size_t i1,
+              const std::vector<column> &b, std::size_t j0, std::size_t j1)
+    {
+        auto kinds = [](const std::vector<column> &l, std::size_t begin, std::size_t end) {
+            std::vector<hash128> k;
+            for (std::size_t i = begin; i < end; ++i) {
+                k.push_back({ l[i].index(), 0 });
+            }
+            return k;
+        };
+        std::vector<hash128> ka = kinds(a, i0, i1);
+        std::vector<hash128> kb = kinds(b, j0, j1);
+
+        std::size_t i = i0;
+        std::size_t j = j0;
+        for (step s : shortest_edit(ka.data(), static_cast<int>(ka.size()), kb.data(),
+                                    static_cast<int>(kb.size()))) {
+            if (s == step::remove) {
+                add(operation::remove, i, j, &a[i], nullptr);
+                ++i;
+            } else if (s == step::insert) {
+                add(operation::insert, i, j, nullptr, &b[j]);
+                ++j;
+            } else if (recursable(a[i], b[j])) {
+                m_old_path.push_back(i);
+                m_new_path.push_back(j);
+                lists(elements(a[i]), elements(b[j]));
+                m_old_path.pop_back();
+                m_new_path.pop_back();
+                ++i;
+                ++j;
+            } else {
+                add(operation::replace, i, j, &a[i], &b[j]);
+                ++i;
+                ++j;
+            }
+        }
+    }
+
+    void lists(const std::vector<column> &a, const std::vector<column> &b)
+    {
+        std::vector<hash128> ha(a.size());
+        std::vector<hash128> hb(b.size());
+        auto hash = [](const column &c) { return driver::binary::hash(c); };
+        std::transform(a.begin(), a.end(), ha.begin(), hash);
+        std::transform(b.begin(), b.end(), hb.begin(), hash);
+
+        // Most edits touch a small part of a score; matching the common ends
+        // first keeps Myers' search to the part that changed.
+        std::size_t prefix = 0;
+        while (prefix < a.size() and prefix < b.size() and ha[prefix] == hb[prefix]) {
+            ++prefix;
+        }
+        std::size_t suffix = 0;
+        while (suffix < a.size() - prefix and suffix < b.size() - prefix and
+               ha[a.size() - 1 - suffix] == hb[b.size() - 1 - suffix]) {
+            ++suffix;
+        }
+
+        std::vector<step> steps = shortest_edit(ha.data() + prefix,
+                                                static_cast<int>(a.size() - prefix - suffix),
+                                                hb.data() + prefix,
+                                                static_cast<int>(b.size() - prefix - suffix));
+
+        std::size_t i = prefix;
+        std::size_t j = prefix;
+        std::size_t i0 = i;
+        std::size_t j0 = j;
+        for (step s : steps) {
+            if (s == step::keep) {
+                if (i0 != i or j0 != j) {
+                    hunk(a, i0, i, b, j0, j);
+                }
+                i0 = ++i;
+                j0 = ++j;
+            } else if (s == step::remove) {
+                ++i;
+            } else {
+                ++j;
+            }
+        }
+        if (i0 != i or j0 != j) {
+            hunk(a, i0, i, b, j0, j);
+        }
+    }
+};
+
+std::string position(const path &p)
+{
+    std::string s;
+    for (std::size_t i : p) {
+        s += (s.empty() ? "" : ".") + std::to_string(i + 1);
+    }
+    return s;
+}
+
+} // namespace
+
+std::vector<edit> compare(const sequential &from, const sequential &to)
+{
+    std::vector<edit> edits;
+    differ{ edits, {}, {} }.lists(from, to);
+    return edits;
+}
+
+std::string summary(const std::vector<edit> &edits)
+{
+    std::string out;
+    for (const auto &e : edits) {
+        switch (e.m_operation) {
+        case operation::remove:
+            out += fmt::format("- {:<6} {}\n", position(e.m_old_path),
+                               driver::debug::write(*e.m_old));
+            break;
+        case operation::insert:
+            out += fmt::format("+ {:<6} {}\n", position(e.m_new_path),
+                               driver::debug::write(*e.m_new));
+            break;
+        case operation::replace:
+            out += fmt::format("~ {:<6} {} -> {}\n", position(e.m_old_path),
+                               driver::debug::write(*e.m_old), driver::debug::write(*e.m_new));
+            break;
+        }
+    }
+    return out;
+}
+
+} // namespace stan::diff
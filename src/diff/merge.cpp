@@ -0,0 +1,182 @@
+#include <stan/merge.hpp>
+#include <stan/diff.hpp>
+
+#include <algorithm>
+
+namespace stan::merge {
+
+namespace {
+
+// A change one side made: ancestor columns [m_base_begin, m_base_end) became
+// that side's columns [m_side_begin, m_side_end).
+struct region
+{
+    std::size_t m_base_begin;
+    std::size_t m_base_end;
+    std::size_t m_side_begin;
+    std::size_t m_side_end;
+    std::size_t m_first_measure;
+    std::size_t m_last_measure;
+    bool m_theirs;
+};
+
+// Collapses an edit script to changed runs of top level columns.  An edit
+// inside a beam or tuplet changes the whole top level column for merging.
+std::vector<region> regions(const std::vector<diff::edit> &edits, bool theirs)
+{
+    std::vector<region> out;
+    for (const auto &e : edits) {
+        std::size_t i = e.m_old_path.front();
+        std::size_t j = e.m_new_path.front();
+        bool nested = e.m_old_path.size() > 1;
+        region r{ i, i + 1, j, j + 1, 0, 0, theirs };
+        if (!nested and e.m_operation == diff::operation::remove) {
+            r.m_side_end = j;
+        } else if (!nested and e.m_operation == diff::operation::insert) {
+            r.m_base_end = i;
+        }
+
+        if (!out.empty() and r.m_base_begin <= out.back().m_base_end and
+            r.m_side_begin <= out.back().m_side_end) {
+            out.back().m_base_end = std::max(out.back().m_base_end, r.m_base_end);
+            out.back().m_side_end = std::max(out.back().m_side_end, r.m_side_end);
+        } else {
+            out.push_back(r);
+        }
+    }
+    return out;
+}
+
+template <typename Iterator>
+void append(sequential &out, Iterator begin, Iterator end)
+{
+    out.insert(out.end(), begin, end);
+}
+
+bool same_change(const std::vector<region> &rs, const sequential &ours,
+                 const sequential &theirs)
+{
+    std::vector<const region *> o;
+    std::vector<const region *> t;
+    for (const auto &r : rs) {
+        (r.m_theirs ? t : o).push_back(&r);
+    }
+    if (o.size() != t.size()) {
+        return false;
+    }
+    for (std::size_t k = 0; k < o.size(); ++k) {
+        if (o[k]->m_base_begin != t[k]->m_base_begin or o[k]->m_base_end != t[k]->m_base_end or
+            !std::equal(ours.begin() + o[k]->m_side_begin, ours.begin() + o[k]->m_side_end,
+                        theirs.begin() + t[k]->m_side_begin, theirs.begin() + t[k]->m_side_end)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+result merge(const sequential &base, const sequential &ours, const sequential &theirs)
+{
+    std::vector<region> all = regions(diff::compare(base, ours), false);
+    std::vector<region> t = regions(diff::compare(base, theirs), true);
+    all.insert(all.end(), t.begin(), t.end());
+
+    result res;
+    if (all.empty()) {
+        res.m_merged = ours;
+        return res;
+    }
+
+    std::vector<std::size_t> measure = measures(base);
+    auto measure_of = [&](std::size_t i) {
+        return measure.empty() ? 0 : measure[std::min(i, measure.size() - 1)];
+    };
+    for (auto &r : all) {
+        r.m_first_measure = measure_of(r.m_base_begin);
+        r.m_last_measure = r.m_base_end > r.m_base_begin ? measure_of(r.m_base_end - 1)
+                                                         : r.m_first_measure;
+    }
+    std::stable_sort(all.begin(), all.end(), [](const region &r1, const region &r2) {
+        return r1.m_first_measure < r2.m_first_measure or
+            (r1.m_first_measure == r2.m_first_measure and r1.m_base_begin < r2.m_base_begin);
+    });
+
+    // Offsets from ancestor positions to each side's positions, as of the
+    // start of the current cluster of regions.
+    std::ptrdiff_t ours_shift = 0;
+    std::ptrdiff_t theirs_shift = 0;
+    std::size_t cursor = 0;
+
+    for (auto begin = all.begin(); begin != all.end();) {
+        // Regions whose measures overlap, directly or through each other.
+        std::size_t last_measure = begin->m_last_measure;
+        auto end = begin + 1;
+        while (end != all.end() and end->m_first_measure <= last_measure) {
+            last_measure = std::max(last_measure, end->m_last_measure);
+            ++end;
+        }
+        std::vector<region> cluster(begin, end);
+        begin = end;
+
+        bool has_ours = std::any_of(cluster.begin(), cluster.end(),
+                                    [](const region &r) { return !r.m_theirs; });
+        bool has_theirs = std::any_of(cluster.begin(), cluster.end(),
+                                      [](const region &r) { return r.m_theirs; });
+
+        std::ptrdiff_t ours_change = 0;
+        std::ptrdiff_t theirs_change = 0;
+        for (const auto &r : cluster) {
+            std::ptrdiff_t change = std::ptrdiff_t(r.m_side_end - r.m_side_begin) -
+                std::ptrdiff_t(r.m_base_end - r.m_base_begin);
+            (r.m_theirs ? theirs_change : ours_change) += change;
+        }
+
+        if (!(has_ours and has_theirs) or same_change(cluster, ours, theirs)) {
+            bool take_theirs = !has_ours;
+            const sequential &side = take_theirs ? theirs : ours;
+            std::sort(cluster.begin(), cluster.end(), [](const region &r1, const region &r2) {
+                return r1.m_base_begin < r2.m_base_begin;
+            });
+            for (const auto &r : cluster) {
+                if (r.m_theirs != take_theirs) {
+                    continue;
+                }
+                append(res.m_merged, base.begin() + cursor, base.begin() + r.m_base_begin);
+                append(res.m_merged, side.begin() + r.m_side_begin, side.begin() + r.m_side_end);
+                cursor = r.m_base_end;
+            }
+        } else {
+            std::size_t first_measure = cluster.front().m_first_measure;
+            std::size_t b0 = std::lower_bound(measure.begin(), measure.end(), first_measure) -
+                measure.begin();
+            std::size_t b1 = std::upper_bound(measure.begin(), measure.end(), last_measure) -
+                measure.begin();
+            b0 = std::min(b0, cluster.front().m_base_begin);
+
+            std::size_t o0 = b0 + ours_shift;
+            std::size_t o1 = b1 + ours_shift + ours_change;
+            std::size_t t0 = b0 + theirs_shift;
+            std::size_t t1 = b1 + theirs_shift + theirs_change;
+
+            append(res.m_merged, base.begin() + cursor, base.begin() + b0);
+            conflict c{ first_measure,
+                        last_measure,
+                        sequential(base.begin() + b0, base.begin() + b1),
+                        sequential(ours.begin() + o0, ours.begin() + o1),
+                        sequential(theirs.begin() + t0, theirs.begin() + t1),
+                        res.m_merged.size() };
+            append(res.m_merged, c.m_ours.begin(), c.m_ours.end());
+            res.m_conflicts.push_back(std::move(c));
+            cursor = b1;
+        }
+
+        ours_shift += ours_change;
+        theirs_shift += theirs_change;
+    }
+
+    append(res.m_merged, base.begin() + cursor, base.end());
+    return res;
+}
+
+} // namespace stan::merge
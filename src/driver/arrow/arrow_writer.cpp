@@ -0,0 +1,491 @@
+#include <stan/driver/arrow.hpp>
+#include <stan/scheduler.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace stan::driver::arrow {
+
+namespace {
+
+// A minimal flatbuffers builder, enough for Arrow's Message, Schema,
+// RecordBatch and Footer tables.  Like the reference builder, it writes back
+// to front, so every table's children already exist when the table is
+// written and all offsets point forward.  Positions are distances from the
+// end of the buffer until finish() fixes the front.
+class flatbuffer
+{
+  public:
+    using offset = std::uint32_t;
+
+    template <typename T>
+    void scalar(T v)
+    {
+        align(sizeof(T));
+        prepend(&v, sizeof(T));
+    }
+
+    offset string(const std::string &s)
+    {
+        pre_align(s.size() + 1, 4);
+        m_data.insert(m_data.begin(), '\0');
+        m_data.insert(m_data.begin(), s.begin(), s.end());
+        scalar(static_cast<std::uint32_t>(s.size()));
+        return size();
+    }
+
+    offset offsets(const std::vector<offset> &elements)
+    {
+        pre_align(elements.size() * 4, 4);
+        for (auto e = elements.rbegin(); e != elements.rend(); ++e) {
+            refer(*e);
+        }
+        scalar(static_cast<std::uint32_t>(elements.size()));
+        return size();
+    }
+
+    // A vector of structs of 64 bit integers, such as FieldNode or Block.
+    offset structs(const std::vector<std::int64_t> &words, std::size_t count)
+    {
+        pre_align(words.size() * 8, 8);
+        for (auto w = words.rbegin(); w != words.rend(); ++w) {
+            scalar(*w);
+        }
+        scalar(static_cast<std::uint32_t>(count));
+        return size();
+    }
+
+    void start()
+    {
+        m_fields.clear();
+        m_table_end = size();
+    }
+
+    template <typename T>
+    void field(int id, T v)
+    {
+        scalar(v);
+        m_fields.emplace_back(id, size());
+    }
+
+    void field_offset(int id, offset o)
+    {
+        refer(o);
+        m_fields.emplace_back(id, size());
+    }
+
+    offset end()
+    {
+        scalar(std::int32_t(0));
+        offset table = size();
+
+        int count = 0;
+        for (const auto &f : m_fields) {
+            count = std::max(count, f.first + 1);
+        }
+        std::vector<std::uint16_t> vtable(2 + count, 0);
+        vtable[0] = static_cast<std::uint16_t>(2 * vtable.size());
+        vtable[1] = static_cast<std::uint16_t>(table - m_table_end);
+        for (const auto &f : m_fields) {
+            vtable[2 + f.first] = static_cast<std::uint16_t>(table - f.second);
+        }
+        for (auto v = vtable.rbegin(); v != vtable.rend(); ++v) {
+            scalar(*v);
+        }
+
+        // The table starts with the distance back to its vtable.
+        auto distance = static_cast<std::int32_t>(size() - table);
+        std::memcpy(&m_data[m_data.size() - table], &distance, 4);
+        return table;
+    }
+
+    std::string finish(offset root)
+    {
+        pre_align(4, m_min_align);
+        refer(root);
+        return m_data;
+    }
+
+  private:
+    offset size() const { return static_cast<offset>(m_data.size()); }
+
+    void prepend(const void *data, std::size_t n)
+    {
+        // Arrow is little endian, like every platform stan builds on.
+        m_data.insert(0, static_cast<const char *>(data), n);
+    }
+
+    // Pads so that n more bytes end aligned.
+    void pre_align(std::size_t n, std::size_t alignment)
+    {
+        m_min_align = std::max(m_min_align, alignment);
+        m_data.insert(0, (alignment - (m_data.size() + n) % alignment) % alignment, '\0');
+    }
+
+    void align(std::size_t alignment) { pre_align(0, alignment); }
+
+    void refer(offset o)
+    {
+        align(4);
+        scalar(static_cast<std::uint32_t>(size() + 4 - o));
+    }
+
+    std::string m_data;
+    std::size_t m_min_align = 1;
+    offset m_table_end = 0;
+    std::vector<std::pair<int, offset>> m_fields;
+};
+
+// Arrow.Message and friends, numbered as in the Arrow format's .fbs files.
+constexpr std::int16_t metadata_v5 = 4;
+constexpr std::uint8_t header_schema = 1;
+constexpr std::uint8_t header_record_batch = 3;
+constexpr std::uint8_t type_int = 2;
+constexpr std::uint8_t type_utf8 = 5;
+
+struct column_type
+{
+    const char *m_name;
+    std::uint8_t m_type;
+    int m_bits;
+    bool m_signed;
+    bool m_nullable;
+};
+
+const column_type schema[] = {
+    { "score", type_int, 32, false, false },   { "measure", type_int, 32, false, false },
+    { "onset", type_int, 64, true, false },    { "duration", type_int, 64, true, false },
+    { "midi", type_int, 16, true, false },     { "pitchclass", type_utf8, 0, false, false },
+    { "octave", type_int, 8, false, false },   { "tuplet", type_int, 32, true, true },
+    { "beam", type_int, 32, true, true },
+};
+
+flatbuffer::offset write_schema(flatbuffer &fb)
+{
+    std::vector<flatbuffer::offset> fields;
+    for (const auto &c : schema) {
+        flatbuffer::offset type;
+        fb.start();
+        if (c.m_type == type_int) {
+            fb.field(0, std::int32_t(c.m_bits));
+            fb.field(1, std::uint8_t(c.m_signed));
+        }
+        type = fb.end();
+
+        flatbuffer::offset children = fb.offsets({});
+        flatbuffer::offset name = fb.string(c.m_name);
+        fb.start();
+        fb.field_offset(0, name);
+        fb.field(1, std::uint8_t(c.m_nullable));
+        fb.field(2, c.m_type);
+        fb.field_offset(3, type);
+        fb.field_offset(5, children);
+        fields.push_back(fb.end());
+    }
+
+    flatbuffer::offset vector = fb.offsets(fields);
+    fb.start();
+    fb.field_offset(1, vector);
+    return fb.end();
+}
+
+// One thread's share of the table.
+struct columns
+{
+    std::vector<std::uint32_t> m_score;
+    std::vector<std::uint32_t> m_measure;
+    std::vector<std::int64_t> m_onset;
+    std::vector<std::int64_t> m_duration;
+    std::vector<std::int16_t> m_midi;
+    std::vector<std::int32_t> m_pitchclass_offsets{ 0 };
+    std::string m_pitchclass;
+    std::vector<std::uint8_t> m_octave;
+    std::vector<std::int32_t> m_tuplet;
+    std::vector<std::int32_t> m_beam;
+
+    // Validity bitmaps, least significant bit first.
+    std::vector<std::uint8_t> m_tuplet_valid;
+    std::vector<std::uint8_t> m_beam_valid;
+    std::size_t m_tuplet_nulls = 0;
+    std::size_t m_beam_nulls = 0;
+
+    std::size_t rows() const { return m_score.size(); }
+};
+
+void append_nullable(std::vector<std::int32_t> &values, std::vector<std::uint8_t> &valid,
+                     std::size_t &nulls, std::size_t row, std::int32_t v)
+{
+    if (row % 8 == 0) {
+        valid.push_back(0);
+    }
+    if (v < 0) {
+        ++nulls;
+        values.push_back(0);
+    } else {
+        valid.back() |= static_cast<std::uint8_t>(1u << (row % 8));
+        values.push_back(v);
+    }
+}
+
+// The music whose meters and durations a list shares, for measures().
+const sequential &written(const sequential &music) { return music; }
+const sequential &written(const transposed &music) { return music.base(); }
+
+struct flattener
+{
+    columns &m_columns;
+    std::uint32_t m_score;
+    std::uint32_t m_measure = 0;
+    std::vector<note_time> m_times;
+    std::size_t m_note = 0;
+    std::int32_t m_tuplet = -1;
+    std::int32_t m_beam = -1;
+    std::int32_t m_tuplets = 0;
+    std::int32_t m_beams = 0;
+
+    void row(const pitch &p, const note_time &t)
+    {
+        columns &c = m_columns;
+        std::size_t row = c.rows();
+        c.m_score.push_back(m_score);
+        c.m_measure.push_back(m_measure);
+        c.m_onset.push_back(t.m_onset);
+        c.m_duration.push_back(t.m_end - t.m_onset);
+        c.m_midi.push_back(static_cast<std::int16_t>(p.midi()));
+        c.m_pitchclass += pitchclass_names.at(p.m_pitchclass);
+        c.m_pitchclass_offsets.push_back(static_cast<std::int32_t>(c.m_pitchclass.size()));
+        c.m_octave.push_back(static_cast<std::uint8_t>(p.m_octave));
+        append_nullable(c.m_tuplet, c.m_tuplet_valid, c.m_tuplet_nulls, row, m_tuplet);
+        append_nullable(c.m_beam, c.m_beam_valid, c.m_beam_nulls, row, m_beam);
+    }
+
+    void add(const column &col)
+    {
+        if (const auto *n = std::get_if<note>(&col)) {
+            row(n->m_pitch, m_times[m_note++]);
+        } else if (const auto *ch = std::get_if<chord>(&col)) {
+            const note_time &t = m_times[m_note++];
+            for (const auto &p : ch->m_pitches) {
+                row(p, t);
+            }
+        } else if (const auto *b = std::get_if<beam>(&col)) {
+            std::int32_t outer = m_beam;
+            m_beam = m_beams++;
+            for (const auto &e : b->m_elements) {
+                add(e);
+            }
+            m_beam = outer;
+        } else if (const auto *t = std::get_if<tuplet>(&col)) {
+            std::int32_t outer = m_tuplet;
+            m_tuplet = m_tuplets++;
+            for (const auto &e : t->m_elements) {
+                add(e);
+            }
+            m_tuplet = outer;
+        }
+    }
+
+    // Notes and chords are visited in note_count() order, the order of the
+    // times note_times() gives them.
+    template <typename Music>
+    void add(const Music &music)
+    {
+        std::vector<std::size_t> measure = measures(written(music));
+        m_times = note_times(written(music));
+        for (std::size_t i = 0; i < music.size(); ++i) {
+            m_measure = static_cast<std::uint32_t>(measure[i]);
+            add(music[i]);
+        }
+    }
+};
+
+// Body buffers of one record batch, each padded to eight bytes as the
+// format requires.
+struct body
+{
+    std::string m_data;
+    std::vector<std::int64_t> m_buffers; // offset, length pairs
+    std::vector<std::int64_t> m_nodes;   // length, null count pairs
+
+    void buffer(const void *data, std::size_t size)
+    {
+        m_buffers.push_back(static_cast<std::int64_t>(m_data.size()));
+        m_buffers.push_back(static_cast<std::int64_t>(size));
+        m_data.append(static_cast<const char *>(data), size);
+        m_data.append((8 - size % 8) % 8, '\0');
+    }
+
+    template <typename T>
+    void column(const std::vector<T> &values)
+    {
+        m_nodes.push_back(static_cast<std::int64_t>(values.size()));
+        m_nodes.push_back(0);
+        buffer(nullptr, 0);
+        buffer(values.data(), values.size() * sizeof(T));
+    }
+
+    void nullable(const std::vector<std::int32_t> &values,
+                  const std::vector<std::uint8_t> &valid, std::size_t nulls)
+    {
+        m_nodes.push_back(static_cast<std::int64_t>(values.size()));
+        m_nodes.push_back(static_cast<std::int64_t>(nulls));
+        // A column with no nulls may omit its bitmap.
+        buffer(valid.data(), nulls == 0 ? 0 : valid.size());
+        buffer(values.data(), values.size() * sizeof(std::int32_t));
+    }
+
+    void strings(const std::vector<std::int32_t> &offsets, const std::string &data)
+    {
+        m_nodes.push_back(static_cast<std::int64_t>(offsets.size() - 1));
+        m_nodes.push_back(0);
+        buffer(nullptr, 0);
+        buffer(offsets.data(), offsets.size() * sizeof(std::int32_t));
+        buffer(data.data(), data.size());
+    }
+};
+
+struct block
+{
+    std::int64_t m_offset;
+    std::int32_t m_metadata;
+    std::int64_t m_body;
+};
+
+// Appends an encapsulated message: a continuation marker, the metadata
+// length, the Message flatbuffer padded to eight bytes, then the body.
+block message(std::string &out, const std::string &metadata, const std::string &body)
+{
+    block b{ static_cast<std::int64_t>(out.size()), 0, static_cast<std::int64_t>(body.size()) };
+    std::size_t padded = (metadata.size() + 7) / 8 * 8;
+    std::uint32_t prefix[2] = { 0xffffffffu, static_cast<std::uint32_t>(padded) };
+    out.append(reinterpret_cast<const char *>(prefix), sizeof(prefix));
+    out += metadata;
+    out.append(padded - metadata.size(), '\0');
+    out += body;
+    b.m_metadata = static_cast<std::int32_t>(sizeof(prefix) + padded);
+    return b;
+}
+
+std::string message_header(std::uint8_t type,
+                           const std::function<flatbuffer::offset(flatbuffer &)> &header,
+                           std::int64_t body_length)
+{
+    flatbuffer fb;
+    flatbuffer::offset h = header(fb);
+    fb.start();
+    fb.field(0, metadata_v5);
+    fb.field(1, type);
+    fb.field_offset(2, h);
+    fb.field(3, body_length);
+    return fb.finish(fb.end());
+}
+
+block record_batch(std::string &out, const columns &c)
+{
+    body b;
+    b.column(c.m_score);
+    b.column(c.m_measure);
+    b.column(c.m_onset);
+    b.column(c.m_duration);
+    b.column(c.m_midi);
+    b.strings(c.m_pitchclass_offsets, c.m_pitchclass);
+    b.column(c.m_octave);
+    b.nullable(c.m_tuplet, c.m_tuplet_valid, c.m_tuplet_nulls);
+    b.nullable(c.m_beam, c.m_beam_valid, c.m_beam_nulls);
+
+    std::string metadata = message_header(
+        header_record_batch,
+        [&](flatbuffer &fb) {
+            flatbuffer::offset buffers = fb.structs(b.m_buffers, b.m_buffers.size() / 2);
+            flatbuffer::offset nodes = fb.structs(b.m_nodes, b.m_nodes.size() / 2);
+            fb.start();
+            fb.field(0, static_cast<std::int64_t>(c.rows()));
+            fb.field_offset(1, nodes);
+            fb.field_offset(2, buffers);
+            return fb.end();
+        },
+        static_cast<std::int64_t>(b.m_data.size()));
+    return message(out, metadata, b.m_data);
+}
+
+std::string footer(const std::vector<block> &batches)
+{
+    flatbuffer fb;
+    std::vector<std::int64_t> words;
+    for (const auto &b : batches) {
+        // Block is { long offset; int metaDataLength; (pad); long bodyLength; }.
+        words.push_back(b.m_offset);
+        words.push_back(static_cast<std::uint32_t>(b.m_metadata));
+        words.push_back(b.m_body);
+    }
+    flatbuffer::offset blocks = fb.structs(words, batches.size());
+    flatbuffer::offset s = write_schema(fb);
+    fb.start();
+    fb.field(0, metadata_v5);
+    fb.field_offset(1, s);
+    fb.field_offset(3, blocks);
+    return fb.finish(fb.end());
+}
+
+// Writes count scores, score(s) giving the sth.
+template <typename Score>
+std::string write_scores(unsigned threads_wanted, std::size_t count, const Score &score)
+{
+    executor &ex = default_executor();
+    std::size_t threads = threads_wanted ? threads_wanted : ex.concurrency();
+    threads = std::max<std::size_t>(1, std::min(threads, count));
+
+    // Contiguous ranges of scores, so that batches come out in score order.
+    std::vector<columns> chunks(threads);
+    parallel_for(ex, 0, threads, [&](std::size_t t) {
+        std::size_t begin = count * t / threads;
+        std::size_t end = count * (t + 1) / threads;
+        for (std::size_t s = begin; s < end; ++s) {
+            flattener{ chunks[t], static_cast<std::uint32_t>(s) }.add(score(s));
+        }
+    });
+
+    std::string out("ARROW1\0\0", 8);
+    message(out, message_header(header_schema, write_schema, 0), std::string());
+    std::vector<block> batches;
+    for (const auto &c : chunks) {
+        batches.push_back(record_batch(out, c));
+    }
+
+    // End of stream marker, then the footer and its length.
+    std::uint32_t eos[2] = { 0xffffffffu, 0 };
+    out.append(reinterpret_cast<const char *>(eos), sizeof(eos));
+    std::string f = footer(batches);
+    auto length = static_cast<std::int32_t>(f.size());
+    out += f;
+    out.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    out.append("ARROW1", 6);
+    return out;
+}
+
+} // namespace
+
+std::string writer::operator()(const sequential &music) const
+{
+    return write_scores(m_threads, 1, [&](std::size_t) -> const sequential & { return music; });
+}
+
+std::string writer::operator()(const std::vector<sequential> &scores) const
+{
+    return write_scores(m_threads, scores.size(),
+                        [&](std::size_t s) -> const sequential & { return scores[s]; });
+}
+
+std::string writer::operator()(const transposed &music) const
+{
+    return write_scores(m_threads, 1, [&](std::size_t) -> const transposed & { return music; });
+}
+
+std::string writer::operator()(const std::vector<transposed> &scores) const
+{
+    return write_scores(m_threads, scores.size(),
+                        [&](std::size_t s) -> const transposed & { return scores[s]; });
+}
+
+} // namespace stan::driver::arrow
@@ -0,0 +1,218 @@
+#include <stan/notation.hpp>
+#include <stan/driver/binary.hpp>
+
+namespace stan::driver::binary {
+
+namespace {
+
+// Nesting deeper than this is not music, it is a corrupt or hostile input
+// trying to exhaust the stack.
+constexpr int max_depth = 64;
+
+struct decoder
+{
+    const unsigned char *m_pos;
+    const unsigned char *m_end;
+    int m_depth = 0;
+
+    std::uint8_t byte()
+    {
+        if (m_pos == m_end) {
+            throw invalid_binary("truncated input");
+        }
+        return *m_pos++;
+    }
+
+    std::size_t count()
+    {
+        std::size_t n = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::uint8_t b = byte();
+            n |= std::size_t(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                // Every element takes at least one byte, so a count larger
+                // than the remaining input is corrupt; checking here keeps a
+                // bad count from turning into a huge reserve().
+                if (n > static_cast<std::size_t>(m_end - m_pos)) {
+                    throw invalid_binary("count {} exceeds remaining input", n);
+                }
+                return n;
+            }
+        }
+        throw invalid_binary("malformed count");
+    }
+
+    void header(char kind)
+    {
+        if (byte() != 'S' or byte() != 'T' or byte() != 'B') {
+            throw invalid_binary("bad magic number");
+        }
+        std::uint8_t v = byte();
+        if (v != version) {
+            throw invalid_binary("version {} is not {}", v, version);
+        }
+        if (byte() != static_cast<std::uint8_t>(kind)) {
+            throw invalid_binary("expected a {}", kind == 'c' ? "column" : "sequential");
+        }
+    }
+
+    void finish()
+    {
+        if (m_pos != m_end) {
+            throw invalid_binary("{} trailing bytes", m_end - m_pos);
+        }
+    }
+
+    value read_value()
+    {
+        std::uint8_t index = byte();
+        if (index == 0xff) {
+            return value::instantaneous();
+        }
+        if (index == 0xfe) {
+            int exponent = byte();
+            int dots = byte();
+            if (dots > 2 or exponent + dots > 15) {
+                throw invalid_binary("value 1/2^{} with {} dots out of range", exponent, dots);
+            }
+            value v = value::whole();
+            for (int i = 0; i < exponent; ++i) {
+                v = dimin(v);
+            }
+            for (int i = 0; i < dots; ++i) {
+                v = dot(v);
+            }
+            return v;
+        }
+        if (index >= value::all.size()) {
+            throw invalid_binary("value index {} out of range", index);
+        }
+        return value::all[index];
+    }
+
+    pitchclass read_pitchclass()
+    {
+        pitchclass pc{ byte() };
+        if (pitchclass_names.count(pc) == 0) {
+            throw invalid_binary("pitchclass {} out of range", static_cast<int>(pc));
+        }
+        return pc;
+    }
+
+    pitch read_pitch()
+    {
+        pitchclass pc = read_pitchclass();
+        return pitch{ pc, octave{ byte() } };
+    }
+
+    column read_column()
+    {
+        // A column that decodes but breaks the rules of notation, such as a
+        // chord with a repeated pitch, is as corrupt as a bad byte.
+        try {
+            return decode_column();
+        } catch (invalid_binary &) {
+            throw;
+        } catch (exception &e) {
+            throw invalid_binary("{}", e.what());
+        }
+    }
+
+    column decode_column()
+    {
+        switch (byte()) {
+        case 0:
+            return rest{ read_value() };
+        case 1: {
+            value v = read_value();
+            return note{ v, read_pitch() };
+        }
+        case 2: {
+            value v = read_value();
+            std::vector<pitch> pitches(count(), pitch{ pitchclass::c, octave{ 4 } });
+            for (auto &p : pitches) {
+                p = read_pitch();
+            }
+            return chord{ v, pitches };
+        }
+        case 3:
+            return beam{ read_sequential() };
+        case 4: {
+            value v = read_value();
+            return tuplet{ v, read_sequential() };
+        }
+        case 5: {
+            std::vector<std::uint8_t> beats(count());
+            for (auto &b : beats) {
+                b = byte();
+            }
+            return meter{ beats, read_value() };
+        }
+        case 6: {
+            std::uint8_t type = byte();
+            if (type > static_cast<std::uint8_t>(clef::type::percussion)) {
+                throw invalid_binary("clef type {} out of range", type);
+            }
+            return clef{ static_cast<clef::type>(type) };
+        }
+        case 7: {
+            pitchclass tonic = read_pitchclass();
+            std::vector<std::uint8_t> mode(count());
+            for (auto &step : mode) {
+                step = byte();
+            }
+            return key{ tonic, mode };
+        }
+        default:
+            throw invalid_binary("unknown column type");
+        }
+    }
+
+    sequential read_sequential()
+    {
+        if (++m_depth > max_depth) {
+            throw invalid_binary("nesting deeper than {}", max_depth);
+        }
+        std::size_t n = count();
+        sequential s;
+        s.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            s.push_back(read_column());
+        }
+        --m_depth;
+        return s;
+    }
+};
+
+decoder make_decoder(const char *data, std::size_t size)
+{
+    const auto *begin = reinterpret_cast<const unsigned char *>(data);
+    return decoder{ begin, begin + size };
+}
+
+} // namespace
+
+column reader::operator()(const std::string &data) const
+{
+    decoder d = make_decoder(data.data(), data.size());
+    d.header('c');
+    column c = d.read_column();
+    d.finish();
+    return c;
+}
+
+sequential reader::sequence(const char *data, std::size_t size) const
+{
+    decoder d = make_decoder(data, size);
+    d.header('s');
+    sequential s = d.read_sequential();
+    d.finish();
+    return s;
+}
+
+sequential reader::sequence(const std::string &data) const
+{
+    return sequence(data.data(), data.size());
+}
+
+} // namespace stan::driver::binary
@@ -0,0 +1,204 @@
+#include <stan/notation.hpp>
+#include <stan/driver/binary.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace stan::driver::binary {
+
+namespace {
+
+// Encoding, all integers unsigned:
+//
+//   header      'S' 'T' 'B' version kind       kind is 'c' or 's'
+//   sequential  count column...
+//   column      index payload                  index into the column variant
+//   value       byte                           index into value::all, or 0xff
+//                                              for value::instantaneous()
+//               0xfe exponent dots             any other value: a whole note
+//                                              halved exponent times, dotted
+//   pitch       pitchclass octave              one byte each
+//   count       LEB128 varint
+//
+// Column payloads follow the hana members of each type in declaration order.
+
+// Where encoded bytes go: a buffer, or straight into a hash.
+struct to_string
+{
+    std::string &m_out;
+
+    void byte(std::uint8_t b) { m_out.push_back(static_cast<char>(b)); }
+    void append(const char *s) { m_out.append(s); }
+};
+
+struct to_hash
+{
+    hasher &m_out;
+
+    void byte(std::uint8_t b) { m_out.byte(b); }
+    void append(const char *s) { m_out.update(s, std::strlen(s)); }
+};
+
+template <typename Sink>
+struct encoder
+{
+    Sink m_out;
+
+    void byte(std::uint8_t b) { m_out.byte(b); }
+
+    void count(std::size_t n)
+    {
+        while (n >= 0x80) {
+            byte(static_cast<std::uint8_t>(n | 0x80));
+            n >>= 7;
+        }
+        byte(static_cast<std::uint8_t>(n));
+    }
+
+    void header(char kind)
+    {
+        m_out.append("STB");
+        byte(version);
+        byte(static_cast<std::uint8_t>(kind));
+    }
+
+    void operator()(const value &v)
+    {
+        if (v == value::instantaneous()) {
+            byte(0xff);
+            return;
+        }
+        auto found = std::find(value::all.begin(), value::all.end(), v);
+        if (found != value::all.end()) {
+            byte(static_cast<std::uint8_t>(found - value::all.begin()));
+            return;
+        }
+
+        // Short values with dots, such as 3/128 for "64.", are not in the
+        // table and are spelled out.
+        int dots = v.dots();
+        int exponent = 0;
+        while ((1 << (exponent + dots)) < v.den()) {
+            ++exponent;
+        }
+        if (v.num() != (2 << dots) - 1 or (1 << (exponent + dots)) != v.den()) {
+            throw invalid_binary("value {}/{} cannot be encoded", v.num(), v.den());
+        }
+        byte(0xfe);
+        byte(static_cast<std::uint8_t>(exponent));
+        byte(static_cast<std::uint8_t>(dots));
+    }
+
+    void operator()(const pitch &p)
+    {
+        byte(static_cast<std::uint8_t>(p.m_pitchclass));
+        byte(static_cast<std::uint8_t>(p.m_octave));
+    }
+
+    void operator()(const rest &r) { (*this)(r.m_value); }
+
+    void operator()(const note &n)
+    {
+        (*this)(n.m_value);
+        (*this)(n.m_pitch);
+    }
+
+    void operator()(const chord &c)
+    {
+        (*this)(c.m_value);
+        count(c.m_pitches.size());
+        for (const auto &p : c.m_pitches) {
+            (*this)(p);
+        }
+    }
+
+    void operator()(const beam &b) { (*this)(b.m_elements); }
+
+    void operator()(const tuplet &t)
+    {
+        (*this)(t.m_value);
+        (*this)(t.m_elements);
+    }
+
+    void operator()(const meter &m)
+    {
+        count(m.m_beats.size());
+        for (auto b : m.m_beats) {
+            byte(b);
+        }
+        (*this)(m.m_value);
+    }
+
+    void operator()(const clef &c) { byte(static_cast<std::uint8_t>(c.m_type)); }
+
+    void operator()(const key &k)
+    {
+        byte(static_cast<std::uint8_t>(k.m_tonic));
+        count(k.m_mode.size());
+        for (auto step : k.m_mode) {
+            byte(step);
+        }
+    }
+
+    void operator()(const column &c)
+    {
+        byte(static_cast<std::uint8_t>(c.index()));
+        std::visit(*this, c);
+    }
+
+    void operator()(const sequential &s)
+    {
+        count(s.size());
+        for (const auto &c : s) {
+            (*this)(c);
+        }
+    }
+};
+
+} // namespace
+
+void writer::append(std::string &out, column const &c) const
+{
+    encoder<to_string> e{ { out } };
+    e.header('c');
+    e(c);
+}
+
+void writer::append(std::string &out, sequential const &s) const
+{
+    encoder<to_string> e{ { out } };
+    e.header('s');
+    e(s);
+}
+
+std::string writer::operator()(column const &c) const
+{
+    std::string out;
+    append(out, c);
+    return out;
+}
+
+std::string writer::operator()(sequential const &s) const
+{
+    std::string out;
+    append(out, s);
+    return out;
+}
+
+hash128 hash(column const &c)
+{
+    hasher h;
+    encoder<to_hash> e{ { h } };
+    e(c);
+    return h.digest();
+}
+
+hash128 hash(sequential const &s)
+{
+    hasher h;
+    encoder<to_hash> e{ { h } };
+    e(s);
+    return h.digest();
+}
+
+} // namespace stan::driver::binary
@@ -94,12 +94,14 @@ std::string writer::operator()(meter const &r) const
 
 std::string writer::operator()(clef const &c) const
 {
-	static std::map<clef::type, std::string> clefname {
+	constexpr static_map<clef::type, const char *, 5> clefname { {{
 		{ clef::type::treble, "treble"}, 
 		{ clef::type::alto, "alto"}, 
 		{ clef::type::tenor, "tenor"}, 
 		{ clef::type::bass, "bass"}, 
-	};
+		{ clef::type::percussion, "percussion"}, 
+	}} };
+	static_assert(clefname.sorted());
 
 	return fmt::format("{} clef", clefname.at(c.m_type));
 }
@@ -122,6 +124,21 @@ std::string writer::operator()(key const &k) const
 }
 
 
+std::string writer::operator()(sequential const &s) const
+{
+    static writer write;
+
+    std::string elements = std::accumulate(
+        s.begin(),
+        s.end(),
+        std::string(),
+        [](std::string res, const auto &p) { return res + write(p) + " "; });
+    if (!elements.empty()) {
+        elements.resize(elements.size() - 1);
+    }
+    return fmt::format("{{{}}}", elements);
+}
+
 std::string writer::operator()(std::unique_ptr<column> const &ptr) const
 {
     return operator()(*ptr);
@@ -0,0 +1,389 @@
+#include <stan/notation.hpp>
+#include <stan/driver/debug.hpp>
+#include <stan/driver/json.hpp>
+
+#include <array>
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace stan::driver::json {
+
+namespace {
+
+// A short string spelled out once, ready to append.
+struct token
+{
+    char m_text[15];
+    std::uint8_t m_size;
+
+    void set(std::string_view s)
+    {
+        std::memcpy(m_text, s.data(), s.size());
+        m_size = static_cast<std::uint8_t>(s.size());
+    }
+};
+
+// Every token whose spelling depends on the music, built on first use.
+// Writing a value or pitch is then a lookup and a copy instead of
+// formatting.
+struct tokens
+{
+    // The values of value::all by numerator and denominator, quoted:
+    // "\"8.\"".
+    token m_values[8][128] = {};
+
+    // Pitches in two halves, the class with its opening quote and the octave
+    // with its closing one: "\"cs" and "4\"".
+    std::array<token, 256> m_pitchclasses = {};
+    std::array<token, 256> m_octaves = {};
+
+    // The escaped form of every byte that needs one in a JSON string, and
+    // an empty token for the rest.
+    std::array<token, 256> m_escapes = {};
+
+    tokens()
+    {
+        for (const value &v : value::all) {
+            m_values[v.num()][v.den()].set('"' + debug::write(v) + '"');
+        }
+        m_values[0][1].set("\"0\"");
+
+        for (const auto &[pc, name] : pitchclass_names) {
+            m_pitchclasses[static_cast<std::uint8_t>(pc)].set(std::string("\"") + name);
+        }
+        for (int octave = 0; octave < 256; ++octave) {
+            m_octaves[octave].set(std::to_string(octave) + '"');
+        }
+
+        const char *hex = "0123456789abcdef";
+        for (int c = 0; c < 0x20; ++c) {
+            m_escapes[c].set(std::string("\\u00") + hex[c >> 4] + hex[c & 15]);
+        }
+        m_escapes['\b'].set("\\b");
+        m_escapes['\f'].set("\\f");
+        m_escapes['\n'].set("\\n");
+        m_escapes['\r'].set("\\r");
+        m_escapes['\t'].set("\\t");
+        m_escapes['"'].set("\\\"");
+        m_escapes['\\'].set("\\\\");
+    }
+
+    static const tokens &get()
+    {
+        static const tokens t;
+        return t;
+    }
+};
+
+// clang-format off
+constexpr std::string_view clef_names[] = {
+    "\"treble\"", "\"alto\"", "\"tenor\"", "\"bass\"", "\"percussion\"",
+};
+constexpr std::string_view articulation_names[] = {
+    "\"staccato\"", "\"accent\"", "\"tenuto\"", "\"marcato\"", "\"staccatissimo\"",
+    "\"portato\"",
+};
+constexpr std::string_view spanner_names[] = {
+    "\"slur\"", "\"phrasing_slur\"", "\"crescendo\"", "\"decrescendo\"",
+};
+constexpr std::string_view join_names[] = {
+    "", ",\"join\":\"hyphen\"", ",\"join\":\"extender\"",
+};
+// clang-format on
+
+struct emitter
+{
+    std::string &m_out;
+    const tokens &m_tokens;
+
+    template <std::size_t N>
+    void literal(const char (&s)[N])
+    {
+        m_out.append(s, N - 1);
+    }
+
+    void literal(std::string_view s) { m_out.append(s.data(), s.size()); }
+
+    void put(const token &t) { m_out.append(t.m_text, t.m_size); }
+
+    void number(std::uint32_t n)
+    {
+        char digits[10];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), n);
+        m_out.append(digits, end - digits);
+    }
+
+    void string(std::string_view text)
+    {
+        m_out.push_back('"');
+        escape(m_out, text);
+        m_out.push_back('"');
+    }
+
+    void operator()(const value &v)
+    {
+        if (v.num() < 8 and v.den() < 128 and m_tokens.m_values[v.num()][v.den()].m_size > 0) {
+            put(m_tokens.m_values[v.num()][v.den()]);
+            return;
+        }
+        // The rarer values with dots, such as "64.", are formatted as they
+        // come.
+        m_out.push_back('"');
+        m_out += debug::write(v);
+        m_out.push_back('"');
+    }
+
+    void operator()(const pitch &p)
+    {
+        put(m_tokens.m_pitchclasses[static_cast<std::uint8_t>(p.m_pitchclass)]);
+        put(m_tokens.m_octaves[static_cast<std::uint8_t>(p.m_octave)]);
+    }
+
+    void operator()(const rest &r)
+    {
+        literal(R"({"type":"rest","value":)");
+        (*this)(r.m_value);
+        m_out.push_back('}');
+    }
+
+    void operator()(const note &n)
+    {
+        literal(R"({"type":"note","value":)");
+        (*this)(n.m_value);
+        literal(R"(,"pitch":)");
+        (*this)(n.m_pitch);
+        m_out.push_back('}');
+    }
+
+    void operator()(const chord &c)
+    {
+        literal(R"({"type":"chord","value":)");
+        (*this)(c.m_value);
+        literal(R"(,"pitches":[)");
+        for (std::size_t i = 0; i < c.m_pitches.size(); ++i) {
+            if (i > 0) {
+                m_out.push_back(',');
+            }
+            (*this)(c.m_pitches[i]);
+        }
+        literal("]}");
+    }
+
+    void operator()(const beam &b)
+    {
+        literal(R"({"type":"beam","elements":)");
+        (*this)(b.m_elements);
+        m_out.push_back('}');
+    }
+
+    void operator()(const tuplet &t)
+    {
+        literal(R"({"type":"tuplet","value":)");
+        (*this)(t.m_value);
+        literal(R"(,"elements":)");
+        (*this)(t.m_elements);
+        m_out.push_back('}');
+    }
+
+    void operator()(const meter &m)
+    {
+        literal(R"({"type":"meter","beats":[)");
+        for (std::size_t i = 0; i < m.m_beats.size(); ++i) {
+            if (i > 0) {
+                m_out.push_back(',');
+            }
+            number(m.m_beats[i]);
+        }
+        literal(R"(],"value":)");
+        (*this)(m.m_value);
+        m_out.push_back('}');
+    }
+
+    void operator()(const clef &c)
+    {
+        literal(R"({"type":"clef","clef":)");
+        literal(clef_names[static_cast<std::uint8_t>(c.m_type)]);
+        m_out.push_back('}');
+    }
+
+    void operator()(const key &k)
+    {
+        literal(R"({"type":"key","tonic":)");
+        put(m_tokens.m_pitchclasses[static_cast<std::uint8_t>(k.m_tonic)]);
+        literal(R"(","mode":)");
+        if (k.m_mode == mode::major) {
+            literal(R"("major")");
+        } else if (k.m_mode == mode::minor) {
+            literal(R"("minor")");
+        } else {
+            m_out.push_back('[');
+            for (std::size_t i = 0; i < k.m_mode.size(); ++i) {
+                if (i > 0) {
+                    m_out.push_back(',');
+                }
+                number(k.m_mode[i]);
+            }
+            m_out.push_back(']');
+        }
+        m_out.push_back('}');
+    }
+
+    void operator()(const column &c) { std::visit(*this, c); }
+
+    void operator()(const sequential &s)
+    {
+        m_out.push_back('[');
+        for (std::size_t i = 0; i < s.size(); ++i) {
+            if (i > 0) {
+                m_out.push_back(',');
+            }
+            (*this)(s[i]);
+        }
+        m_out.push_back(']');
+    }
+
+    void operator()(const lyrics &verse)
+    {
+        m_out.push_back('[');
+        bool first = true;
+        for (const auto &s : verse.syllables()) {
+            literal(first ? R"({"note":)" : R"(,{"note":)");
+            first = false;
+            number(s.m_note);
+            literal(R"(,"text":)");
+            string(verse.text(s));
+            literal(join_names[static_cast<std::uint8_t>(s.m_join)]);
+            m_out.push_back('}');
+        }
+        m_out.push_back(']');
+    }
+
+    void operator()(const score &s)
+    {
+        literal(R"({"music":)");
+        (*this)(s.m_music);
+
+        literal(R"(,"verses":[)");
+        for (std::size_t i = 0; i < s.m_verses.size(); ++i) {
+            if (i > 0) {
+                m_out.push_back(',');
+            }
+            (*this)(s.m_verses[i]);
+        }
+
+        literal(R"(],"dynamics":[)");
+        bool first = true;
+        for (const auto &e : s.m_dynamics) {
+            literal(first ? R"({"note":)" : R"(,{"note":)");
+            first = false;
+            number(e.m_note);
+            literal(R"(,"dynamic":")");
+            literal(dynamic_names.at(e.m_value));
+            literal(R"("})");
+        }
+
+        literal(R"(],"articulations":[)");
+        first = true;
+        for (const auto &e : s.m_articulations) {
+            literal(first ? R"({"note":)" : R"(,{"note":)");
+            first = false;
+            number(e.m_note);
+            literal(R"(,"articulation":)");
+            literal(articulation_names[static_cast<std::uint8_t>(e.m_value)]);
+            m_out.push_back('}');
+        }
+
+        literal(R"(],"spanners":[)");
+        first = true;
+        for (const auto &sp : s.m_spanners) {
+            literal(first ? R"({"type":)" : R"(,{"type":)");
+            first = false;
+            literal(spanner_names[static_cast<std::uint8_t>(sp.m_type)]);
+            literal(R"(,"first":)");
+            number(sp.m_first);
+            literal(R"(,"last":)");
+            number(sp.m_last);
+            m_out.push_back('}');
+        }
+        literal("]}");
+    }
+};
+
+} // namespace
+
+void escape(std::string &out, std::string_view text)
+{
+    const tokens &t = tokens::get();
+    const char *p = text.data();
+    const char *end = p + text.size();
+    const char *copied = p; // text before here is already in out
+
+    auto escape_at = [&](const char *at) {
+        out.append(copied, at - copied);
+        const token &e = t.m_escapes[static_cast<unsigned char>(*at)];
+        out.append(e.m_text, e.m_size);
+        copied = at + 1;
+    };
+
+#if defined(__SSE2__)
+    // A byte needs escaping if it is a quote, a backslash, or below 0x20;
+    // the last is tested unsigned, as min(byte, 0x1f) == byte.
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(block, control), block));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+        if (mask == 0) {
+            p += 16;
+            continue;
+        }
+        // Escape the first, and test again from just after it.
+        p += __builtin_ctz(mask);
+        escape_at(p);
+        ++p;
+    }
+#endif
+
+    for (; p < end; ++p) {
+        if (t.m_escapes[static_cast<unsigned char>(*p)].m_size > 0) {
+            escape_at(p);
+        }
+    }
+    out.append(copied, end - copied);
+}
+
+void writer::append(std::string &out, const sequential &s) const
+{
+    emitter e{ out, tokens::get() };
+    e(s);
+}
+
+void writer::append(std::string &out, const score &s) const
+{
+    emitter e{ out, tokens::get() };
+    e(s);
+}
+
+std::string writer::operator()(const sequential &s) const
+{
+    std::string out;
+    append(out, s);
+    return out;
+}
+
+std::string writer::operator()(const score &s) const
+{
+    std::string out;
+    append(out, s);
+    return out;
+}
+
+} // namespace stan::driver::json
@@ -0,0 +1,189 @@
+#include <stan/driver/lilypond_cache.hpp>
+#include <stan/hash.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace stan::lilypond {
+
+namespace {
+
+constexpr const char *suffix = ".stb";
+
+struct entry
+{
+    std::string m_path;
+    std::uint64_t m_size;
+    struct timespec m_mtime;
+};
+
+bool has_suffix(const std::string &name)
+{
+    std::size_t n = std::strlen(suffix);
+    return name.size() > n and name.compare(name.size() - n, n, suffix) == 0;
+}
+
+std::vector<entry> list_entries(const std::string &directory)
+{
+    std::vector<entry> entries;
+    DIR *dir = ::opendir(directory.c_str());
+    if (dir == nullptr) {
+        return entries;
+    }
+    while (dirent *d = ::readdir(dir)) {
+        std::string name = d->d_name;
+        if (!has_suffix(name)) {
+            continue;
+        }
+        std::string path = directory + '/' + name;
+        struct stat st;
+        if (::stat(path.c_str(), &st) == 0) {
+            entries.push_back({ path, static_cast<std::uint64_t>(st.st_size), st.st_mtim });
+        }
+    }
+    ::closedir(dir);
+    return entries;
+}
+
+} // namespace
+
+cached_reader::cached_reader(std::string directory, std::uint64_t max_bytes) :
+    m_directory(std::move(directory)), m_max_bytes(max_bytes)
+{
+    if (::mkdir(m_directory.c_str(), 0755) != 0 and errno != EEXIST) {
+        throw exception("cannot create cache directory {}: {}", m_directory,
+                        std::strerror(errno));
+    }
+
+    std::uint64_t bytes = 0;
+    for (const auto &e : list_entries(m_directory)) {
+        bytes += e.m_size;
+    }
+    m_bytes = bytes;
+    if (bytes > m_max_bytes) {
+        evict();
+    }
+}
+
+std::string cached_reader::entry_path(const std::string &lily) const
+{
+    std::uint64_t seed = (std::uint64_t(reader::version) << 8) | driver::binary::version;
+    return m_directory + '/' + hash(lily, seed).hex() + suffix;
+}
+
+bool cached_reader::load(const std::string &path, sequential &music)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    try {
+        music = m_decode.sequence(data);
+    } catch (driver::binary::invalid_binary &) {
+        // Corrupt or foreign; drop it and parse again.  An entry another
+        // process stored is not counted, and taking it off may wrap
+        // m_bytes, but then the next store evicts, which recounts.
+        if (::unlink(path.c_str()) == 0) {
+            m_bytes -= data.size();
+        }
+        return false;
+    }
+
+    // Mark the entry recently used for eviction.
+    ::utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    return true;
+}
+
+void cached_reader::store(const std::string &path, const sequential &music)
+{
+    std::string data = m_encode(music);
+    std::string temporary = fmt::format("{}/.tmp-{}-{}", m_directory, ::getpid(), m_temporaries++);
+
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            ::unlink(temporary.c_str());
+            return; // A cache that cannot be written is just a slower reader.
+        }
+    }
+
+    // An entry dropped as corrupt, or stored by another thread meanwhile,
+    // is replaced and no longer counts.
+    struct stat old;
+    std::uint64_t replaced = ::stat(path.c_str(), &old) == 0 ? old.st_size : 0;
+
+    if (::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return;
+    }
+
+    if ((m_bytes += data.size() - replaced) > m_max_bytes) {
+        evict();
+    }
+}
+
+void cached_reader::evict()
+{
+    std::lock_guard<std::mutex> lock(m_evict_mutex);
+
+    // Rescan rather than trust m_bytes, since other processes may share the
+    // directory.  Evict down to 90% of the limit so that the next few stores
+    // do not immediately trigger another scan.
+    std::vector<entry> entries = list_entries(m_directory);
+    std::sort(entries.begin(), entries.end(), [](const entry &e1, const entry &e2) {
+        return e1.m_mtime.tv_sec != e2.m_mtime.tv_sec ? e1.m_mtime.tv_sec < e2.m_mtime.tv_sec
+                                                      : e1.m_mtime.tv_nsec < e2.m_mtime.tv_nsec;
+    });
+
+    std::uint64_t bytes = 0;
+    for (const auto &e : entries) {
+        bytes += e.m_size;
+    }
+
+    std::uint64_t target = m_max_bytes / 10 * 9;
+    for (const auto &e : entries) {
+        if (bytes <= target) {
+            break;
+        }
+        if (::unlink(e.m_path.c_str()) == 0) {
+            bytes -= e.m_size;
+            ++m_evictions;
+        }
+    }
+    m_bytes = bytes;
+}
+
+sequential cached_reader::sequence(const std::string &lily)
+{
+    std::string path = entry_path(lily);
+
+    sequential music;
+    if (load(path, music)) {
+        ++m_hits;
+        return music;
+    }
+
+    ++m_misses;
+    music = m_read.sequence(lily);
+    store(path, music);
+    return music;
+}
+
+cached_reader::statistics cached_reader::stats() const
+{
+    return { m_hits, m_misses, m_evictions };
+}
+
+} // namespace stan::lilypond
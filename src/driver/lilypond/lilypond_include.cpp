@@ -0,0 +1,311 @@
+#include <stan/driver/lilypond_include.hpp>
+#include <stan/decompress.hpp>
+#include <stan/scheduler.hpp>
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <set>
+#include <variant>
+
+namespace stan::lilypond {
+
+namespace {
+
+const char *directive = "\\include";
+
+struct include
+{
+    std::string m_target;
+};
+
+using segment = std::variant<std::string, include>;
+
+std::string directory_of(const std::string &path)
+{
+    std::size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+bool exists(const std::string &path)
+{
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 and S_ISREG(st.st_mode);
+}
+
+std::string canonical(const std::string &path)
+{
+    char resolved[PATH_MAX];
+    if (::realpath(path.c_str(), resolved) == nullptr) {
+        throw include_error("cannot resolve {}: {}", path, std::strerror(errno));
+    }
+    return resolved;
+}
+
+std::string read_text(const std::string &path)
+{
+    std::string text;
+    decompress_file(path, 64 << 10,
+                    [&](const char *data, std::size_t size) { text.append(data, size); });
+    return text;
+}
+
+// Splits a file into runs of column text and the includes between them.  An
+// outer pair of braces around the whole file is dropped, so that each run is
+// a bare music list.  Only includes at the top level are recognized; one
+// nested inside a beam or tuplet is left in place and fails to parse.
+std::vector<segment> split(const std::string &lily, const std::string &name)
+{
+    std::size_t begin = lily.find_first_not_of(" \t\r\n");
+    std::size_t end = lily.find_last_not_of(" \t\r\n") + 1;
+    if (begin == std::string::npos) {
+        return {};
+    }
+    if (lily[begin] == '{' and lily[end - 1] == '}' and end - begin >= 2) {
+        ++begin;
+        --end;
+    }
+
+    std::vector<segment> segments;
+    std::size_t run = begin;
+    int depth = 0;
+    int chords = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+        char c = lily[i];
+        // Angle brackets also spell marks: the "->" accent, and the "\<"
+        // and "\>" hairpins.  Only a bracket after neither opens or closes
+        // a chord.
+        bool mark = i > begin and (lily[i - 1] == '-' or lily[i - 1] == '\\');
+        if (c == '{' or c == '[') {
+            ++depth;
+        } else if (c == '}' or c == ']') {
+            --depth;
+        } else if (c == '<' and !mark) {
+            ++chords;
+        } else if (c == '>' and !mark and chords > 0) {
+            --chords;
+        } else if (c == '\\' and depth == 0 and chords == 0 and
+                   lily.compare(i, std::strlen(directive), directive) == 0) {
+            std::size_t quote = lily.find_first_not_of(" \t\r\n", i + std::strlen(directive));
+            std::size_t close = quote == std::string::npos ? quote : lily.find('"', quote + 1);
+            if (quote >= end or lily[quote] != '"' or close >= end) {
+                throw include_error("malformed \\include in {}", name);
+            }
+            segments.emplace_back(lily.substr(run, i - run));
+            segments.emplace_back(include{ lily.substr(quote + 1, close - quote - 1) });
+            run = close + 1;
+            i = close;
+        }
+    }
+    segments.emplace_back(lily.substr(run, end - run));
+    return segments;
+}
+
+} // namespace
+
+include_reader::include_reader(std::vector<std::string> search_path) :
+    m_search_path(std::move(search_path)),
+    m_executor(default_executor()),
+    m_tasks(std::make_shared<tasks>()) {}
+
+include_reader::~include_reader()
+{
+    // Loads refer to this object.  Stop those still queued from starting,
+    // then wait for those already parsing; a file they wait for that no task
+    // has started, they parse themselves.
+    std::unique_lock<std::mutex> lock(m_tasks->m_mutex);
+    m_tasks->m_closing = true;
+    m_tasks->m_idle.wait(lock, [&]() { return m_tasks->m_running == 0; });
+}
+
+sequential include_reader::read(const std::string &path)
+{
+    return wait(*load(canonical(path)));
+}
+
+sequential include_reader::sequence(const std::string &lily, const std::string &directory)
+{
+    return *parse(lily, directory, "<input>");
+}
+
+std::size_t include_reader::files() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_files.size();
+}
+
+std::shared_ptr<include_reader::file> include_reader::load(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto found = m_files.find(path);
+    if (found != m_files.end()) {
+        return found->second;
+    }
+
+    auto f = std::make_shared<file>();
+    f->m_path = path;
+    m_files.emplace(path, f);
+
+    m_executor.submit([this, f, t = m_tasks]() {
+        {
+            std::lock_guard<std::mutex> lock(t->m_mutex);
+            if (t->m_closing) {
+                return;
+            }
+            ++t->m_running;
+        }
+        if (!f->m_claimed.exchange(true)) {
+            run(*f);
+        }
+        std::lock_guard<std::mutex> lock(t->m_mutex);
+        if (--t->m_running == 0) {
+            t->m_idle.notify_all();
+        }
+    });
+    return f;
+}
+
+void include_reader::run(file &f)
+{
+    try {
+        f.m_promise.set_value(parse(read_text(f.m_path), directory_of(f.m_path), f.m_path));
+    } catch (...) {
+        f.m_promise.set_exception(std::current_exception());
+    }
+}
+
+// As with stan::fork_join(), a waiting thread never waits for work that has
+// not started: it claims the file, or runs other queued tasks until the
+// thread that did claim it finishes.
+const sequential &include_reader::wait(file &f)
+{
+    if (!f.m_claimed.exchange(true)) {
+        run(f);
+    }
+    while (f.m_music.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        if (!m_executor.run_one()) {
+            f.m_music.wait();
+        }
+    }
+    return *f.m_music.get();
+}
+
+std::shared_ptr<const sequential> include_reader::parse(const std::string &lily,
+                                                        const std::string &directory,
+                                                        const std::string &name)
+{
+    std::vector<segment> segments = split(lily, name);
+
+    // Start every include loading before parsing anything here, so that the
+    // whole tree below this file is in flight at once.
+    std::vector<std::shared_ptr<file>> included;
+    for (const auto &s : segments) {
+        if (const auto *inc = std::get_if<include>(&s)) {
+            std::string path = resolve(inc->m_target, directory, name);
+            add_edge(name, path);
+            included.push_back(load(path));
+        }
+    }
+
+    auto music = std::make_shared<sequential>();
+    reader read;
+    auto next = included.begin();
+    for (const auto &s : segments) {
+        if (const auto *text = std::get_if<std::string>(&s)) {
+            sequential part;
+            try {
+                part = read.sequence(*text);
+            } catch (std::exception &e) {
+                throw include_error("{}: {}", name, e.what());
+            }
+            music->insert(music->end(), part.begin(), part.end());
+        } else {
+            const sequential &part = wait(**next++);
+            music->insert(music->end(), part.begin(), part.end());
+        }
+    }
+    return music;
+}
+
+std::string include_reader::resolve(const std::string &target, const std::string &directory,
+                                    const std::string &from) const
+{
+    if (!target.empty() and target.front() == '/') {
+        if (exists(target)) {
+            return canonical(target);
+        }
+    } else {
+        if (exists(directory + '/' + target)) {
+            return canonical(directory + '/' + target);
+        }
+        for (const auto &dir : m_search_path) {
+            if (exists(dir + '/' + target)) {
+                return canonical(dir + '/' + target);
+            }
+        }
+    }
+    throw include_error("cannot find {} included from {}", target, from);
+}
+
+// Records that from includes to, first checking that to does not already
+// lead back to from.  Each file waits only for the files it includes, so as
+// long as the include graph stays acyclic, no load can wait on itself.
+void include_reader::add_edge(const std::string &from, const std::string &to)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<std::string> chain{ to };
+    std::set<std::string> visited;
+    std::function<bool(const std::string &)> leads_to_from = [&](const std::string &file) {
+        if (file == from) {
+            return true;
+        }
+        if (!visited.insert(file).second) {
+            return false;
+        }
+        auto edges = m_includes.find(file);
+        if (edges != m_includes.end()) {
+            for (const auto &next : edges->second) {
+                chain.push_back(next);
+                if (leads_to_from(next)) {
+                    return true;
+                }
+                chain.pop_back();
+            }
+        }
+        return false;
+    };
+
+    if (leads_to_from(to)) {
+        std::string cycle = from;
+        for (const auto &file : chain) {
+            cycle += " -> " + file;
+        }
+        throw include_error("include cycle: {}", cycle);
+    }
+    m_includes[from].push_back(to);
+}
+
+sequential read_contents(const std::string &path, const std::string &contents,
+                         include_reader &includes,
+                         const std::function<sequential(const std::string &)> &plain)
+{
+    if (detect_compression(contents.data(), contents.size()) != compression::none) {
+        return read_compressed(contents);
+    }
+    if (contents.find(directive) != std::string::npos) {
+        return includes.sequence(contents, directory_of(path));
+    }
+    return plain(contents);
+}
+
+} // namespace stan::lilypond
@@ -7,9 +7,12 @@
 // #define BOOST_SPIRIT_X3_DEBUG
 #include <boost/spirit/home/x3.hpp>
 
+#include <cctype>
+#include <cstring>
 #include <fstream>
 #include <memory>
 #include <numeric>
+#include <optional>
 #include <iostream>
 
 namespace stan {
@@ -22,88 +25,127 @@ namespace stan {
 // on default constructors in this file only.  This is still pretty safe,
 // because X3 won't allow invalid values to be parsed (that is it's purpose).
 // So default_ctor<T> is just a class T with a default constructor defined.
-// Specializations of default_value<T> follow, which actually define what the
-// default constructor should instantiate.
+// Specializations of default_value<T>() follow, which actually define what the
+// default constructor should instantiate.  They are functions with a local
+// static rather than variables, so that nothing is built until the first
+// parse; a key with its 256 entry table, a chord and a handful of beams are
+// not free, and most processes linking stan never parse at all.
 
 template <typename T>
-auto default_value = T{};
+const T &default_value();
 
 template <typename T>
 struct default_ctor : T
 {
     default_ctor() :
-        T{ stan::default_value<T> } {}
+        T{ stan::default_value<T>() } {}
 
     default_ctor(const T &v) :
         T(v) {}
 };
 
 template <>
-const auto default_value<stan::pitch> = stan::pitch{
-    stan::pitchclass::c,
-    stan::octave{ 4 }
-};
+const stan::pitch &default_value<stan::pitch>()
+{
+    static const stan::pitch v{ stan::pitchclass::c, stan::octave{ 4 } };
+    return v;
+}
 
 template <>
-const auto default_value<stan::value> = stan::value{
-    stan::value::quarter()
-};
+const stan::value &default_value<stan::value>()
+{
+    static const stan::value v{ stan::value::quarter() };
+    return v;
+}
 
 template <>
-const auto default_value<stan::rest> = stan::rest{
-    default_value<stan::value>
-};
+const stan::rest &default_value<stan::rest>()
+{
+    static const stan::rest v{ default_value<stan::value>() };
+    return v;
+}
 
 template <>
-const auto default_value<stan::note> = stan::note{
-    default_value<stan::value>,
-    default_value<stan::pitch>
-};
+const stan::note &default_value<stan::note>()
+{
+    static const stan::note v{
+        default_value<stan::value>(),
+        default_value<stan::pitch>()
+    };
+    return v;
+}
 
 template <>
-const auto default_value<stan::chord> = stan::chord{
-    default_value<stan::value>,
-    stan::pitch{ stan::pitchclass::c, stan::octave{ 4 } },
-    stan::pitch{ stan::pitchclass::e, stan::octave{ 4 } },
-    stan::pitch{ stan::pitchclass::g, stan::octave{ 4 } },
-};
+const stan::chord &default_value<stan::chord>()
+{
+    static const stan::chord v{
+        default_value<stan::value>(),
+        stan::pitch{ stan::pitchclass::c, stan::octave{ 4 } },
+        stan::pitch{ stan::pitchclass::e, stan::octave{ 4 } },
+        stan::pitch{ stan::pitchclass::g, stan::octave{ 4 } },
+    };
+    return v;
+}
 
 template <>
-const auto default_value<beam> = beam{
-    note{ value::eighth(), default_value<pitch> },
-    note{ value::eighth(), default_value<pitch> }
-};
+const beam &default_value<beam>()
+{
+    static const beam v{
+        note{ value::eighth(), default_value<pitch>() },
+        note{ value::eighth(), default_value<pitch>() }
+    };
+    return v;
+}
 
 template <>
-const auto default_value<tuplet> = tuplet{
-    value::quarter(),
-    note{ value::eighth(), default_value<pitch> },
-    note{ value::eighth(), default_value<pitch> },
-    note{ value::eighth(), default_value<pitch> },
-
-};
+const tuplet &default_value<tuplet>()
+{
+    static const tuplet v{
+        value::quarter(),
+        note{ value::eighth(), default_value<pitch>() },
+        note{ value::eighth(), default_value<pitch>() },
+        note{ value::eighth(), default_value<pitch>() },
+    };
+    return v;
+}
 
 template <>
-const auto default_value<meter> = meter{
-    { 4 },
-    value::quarter()
-};
+const meter &default_value<meter>()
+{
+    static const meter v{
+        { 4 },
+        value::quarter()
+    };
+    return v;
+}
 
 template <>
-const auto default_value<clef> = clef { 
+const clef &default_value<clef>()
+{
+    static const clef v{
 	clef::type::treble
-};
+    };
+    return v;
+}
 
 template <>
-const auto default_value<key> = key { 
+const key &default_value<key>()
+{
+    static const key v{
 	pitchclass::c,
 	mode::major
-};
+    };
+    return v;
+}
 
 template <>
-const auto default_value<stan::column> = stan::column{
-    default_value<stan::note>
-};
+const stan::column &default_value<stan::column>()
+{
+    static const stan::column v{
+        default_value<stan::note>()
+    };
+    return v;
+}
 
 } // namespace stan
 
@@ -124,7 +166,7 @@ struct transform_attribute<T, stan::default_ctor<T>, x3::parser_id>
     using type = stan::default_ctor<T>;
     using exposed_type = T;
 
-    static type pre(const exposed_type &ev) { return stan::default_value<T>; }
+    static type pre(const exposed_type &ev) { return stan::default_value<T>(); }
 
     static void post(exposed_type &ev, const type &bv)
     {
@@ -138,6 +180,32 @@ namespace x3 = boost::spirit::x3;
 
 namespace stan::lilypond {
 
+// An x3::symbols table allocates and fills a ternary search tree in its
+// constructor.  As namespace scope objects, the tables below would be built
+// before main() in every process linking stan.  lazy_symbols<Symbols> is an
+// empty parser which builds its table on the first parse instead, and
+// otherwise forwards to it.
+
+template <typename Symbols>
+struct lazy_symbols : x3::parser<lazy_symbols<Symbols>>
+{
+    using attribute_type = typename Symbols::attribute_type;
+    static bool const has_attribute = true;
+
+    static const Symbols &table()
+    {
+        static const Symbols symbols;
+        return symbols;
+    }
+
+    template <typename Iterator, typename Context, typename RContext, typename Attribute>
+    bool parse(Iterator &first, Iterator const &last, Context const &context,
+               RContext &rcontext, Attribute &attr) const
+    {
+        return table().parse(first, last, context, rcontext, attr);
+    }
+};
+
 struct pitchclass_ : x3::symbols<stan::pitchclass>
 {
     pitchclass_()
@@ -156,7 +224,8 @@ struct pitchclass_ : x3::symbols<stan::pitchclass>
 	;
         // clang-format on
     }
-} pitchclass;
+};
+const lazy_symbols<pitchclass_> pitchclass;
 
 struct clef_ : x3::symbols<stan::clef::type>
 {
@@ -172,7 +241,8 @@ struct clef_ : x3::symbols<stan::clef::type>
 	    ;
     // clang-format on
     }
-} clef;
+};
+const lazy_symbols<clef_> clef;
 
 struct mode_ : x3::symbols<std::vector<std::uint8_t>>
 {
@@ -185,7 +255,8 @@ struct mode_ : x3::symbols<std::vector<std::uint8_t>>
 	    ;
     // clang-format on
     }
-} mode;
+};
+const lazy_symbols<mode_> mode;
 
 struct basevalue_ : x3::symbols<default_ctor<stan::value>>
 {
@@ -203,7 +274,77 @@ struct basevalue_ : x3::symbols<default_ctor<stan::value>>
 	    ;
         // clang-format on
     }
-} basevalue;
+};
+const lazy_symbols<basevalue_> basevalue;
+
+struct dynamic_ : x3::symbols<stan::dynamic>
+{
+    dynamic_()
+    {
+        for (const auto &[d, name] : stan::dynamic_names) {
+            add(std::string("\\") + name, d);
+        }
+    }
+};
+const lazy_symbols<dynamic_> dynamic;
+
+struct articulation_ : x3::symbols<stan::articulation>
+{
+    articulation_()
+    {
+        for (const auto &[a, name] : stan::articulation_names) {
+            add(std::string("-") + name, a);
+        }
+    }
+};
+const lazy_symbols<articulation_> articulation;
+
+// Qualities after the ":" of a \chordmode name.  A major triad has none.
+struct chord_quality_ : x3::symbols<const stan::chord_quality *>
+{
+    chord_quality_()
+    {
+        for (const auto &q : stan::chord_qualities::all) {
+            if (*q.m_name != '\0') {
+                add(q.m_name, &q);
+            }
+        }
+        // Thirds stacked up to the fifth, which LilyPond also accepts.
+        add("5", &stan::chord_qualities::major);
+    }
+};
+const lazy_symbols<chord_quality_> chord_quality;
+
+// The ends of the spans of stan::spanner.
+enum class span_mark
+{
+    slur,
+    slur_end,
+    phrasing_slur,
+    phrasing_slur_end,
+    crescendo,
+    decrescendo,
+    hairpin_end,
+};
+
+struct span_ : x3::symbols<span_mark>
+{
+    span_()
+    {
+    // clang-format off
+	add
+	    ("(", span_mark::slur)
+	    (")", span_mark::slur_end)
+	    ("\\(", span_mark::phrasing_slur)
+	    ("\\)", span_mark::phrasing_slur_end)
+	    ("\\<", span_mark::crescendo)
+	    ("\\>", span_mark::decrescendo)
+	    ("\\!", span_mark::hairpin_end)
+	    ;
+    // clang-format on
+    }
+};
+const lazy_symbols<span_> span;
 
 // struct clef_ : x3::symbols<stan::clef> {
 //     clef_() {
@@ -234,6 +375,47 @@ using x3::string;
 using x3::ushort_;
 using x3::ascii::char_;
 
+// reader::sequence() puts the spans it is asked for in the context under
+// spans_tag, and every column adds its own as it completes, children before
+// the beam or tuplet that holds them; sorting by start puts them in preorder.
+// As with marks, a column can only be backtracked over by a parse that
+// fails as a whole.
+struct spans_tag
+{
+};
+
+struct spans
+{
+    std::string::const_iterator m_text;
+    std::vector<stan::source_span> &m_spans;
+};
+
+template <typename Iterator>
+void add_span(x3::unused_type, const Iterator &, const Iterator &)
+{
+}
+
+template <typename Iterator>
+void add_span(spans &s, const Iterator &first, Iterator last)
+{
+    // Parsers skip the space after them looking for marks that are not there.
+    while (last != first and std::isspace(static_cast<unsigned char>(*(last - 1)))) {
+        --last;
+    }
+    s.m_spans.push_back({ static_cast<std::size_t>(first - s.m_text),
+                          static_cast<std::size_t>(last - s.m_text) });
+}
+
+struct pcolumn
+{
+    template <typename Iterator, typename Attribute, typename Context>
+    void on_success(const Iterator &first, const Iterator &last, Attribute &,
+                    const Context &ctx) const
+    {
+        add_span(x3::get<spans_tag>(ctx), first, last);
+    }
+};
+
 x3::rule<struct ppitch, default_ctor<stan::pitch>> ppitch = "pitch";
 x3::rule<struct poctave, stan::octave> poctave = "octave";
 x3::rule<struct pvalue, default_ctor<stan::value>> pvalue = "value";
@@ -246,6 +428,10 @@ x3::rule<struct pmeter, default_ctor<stan::meter>> pmeter = "meter";
 x3::rule<struct pclef, default_ctor<stan::clef>> pclef = "clef";
 x3::rule<struct pkey, default_ctor<stan::key>> pkey = "key";
 x3::rule<struct pcolumn, default_ctor<stan::column>> column = "column";
+x3::rule<struct psequential, std::vector<default_ctor<stan::column>>> sequential = "sequential";
+x3::rule<struct pchordname, default_ctor<stan::chord>> pchordname = "chordname";
+x3::rule<struct pchordcolumn, default_ctor<stan::column>> chordcolumn = "chordcolumn";
+x3::rule<struct pchordmode, std::vector<default_ctor<stan::column>>> chordmode = "chordmode";
 
 // x3::rule<struct pmusic, std::shared_ptr<stan::column>> music = "music";
 // x3::rule<struct music_list, stan::sequential> music_list = "music_list";
@@ -326,22 +512,140 @@ auto to_tuplet = [](auto &ctx) {
 auto to_meter = [](auto &ctx) {
     auto attr = _attr(ctx);
     // This works only for simple meter so far
+    if (at_c<0>(attr) > 255) {
+        throw invalid_meter("{} beats are more than 255", at_c<0>(attr));
+    }
     x3::_val(ctx) = meter{
         { static_cast<std::uint8_t>(at_c<0>(attr)) },
         at_c<1>(attr)
     };
 };
 
+// Marks after a note or chord, such as "c4->\p", go into the side tables of
+// the stan::score being read, which reader::score() puts in the context
+// under marks_tag.  Without one, as when reading a bare music list, they are
+// parsed and dropped.  Notes are counted as they complete, so a mark belongs
+// to the last one counted; a parse that backtracks over a counted note fails
+// as a whole, so the count never runs ahead of the music.  Spanners are
+// recorded as they close, and a close with nothing open fails the parse.
+struct marks_tag
+{
+};
+
+struct marks
+{
+    using type = stan::spanner::type;
+
+    stan::score &m_score;
+    std::uint32_t m_notes = 0;
+
+    // The notes the open spanners start on.
+    std::optional<std::uint32_t> m_slur;
+    std::optional<std::uint32_t> m_phrasing_slur;
+    std::optional<std::uint32_t> m_hairpin;
+    type m_hairpin_type = type::crescendo;
+
+    std::uint32_t note() const { return m_notes - 1; }
+
+    void close(std::optional<std::uint32_t> &start, type t)
+    {
+        m_score.m_spanners.push_back({ *start, note(), t });
+        start.reset();
+    }
+
+    bool open(std::optional<std::uint32_t> &start)
+    {
+        if (start) {
+            return false;
+        }
+        start = note();
+        return true;
+    }
+};
+
+void count_note(x3::unused_type) {}
+void count_note(marks &m) { ++m.m_notes; }
+
+template <typename T>
+bool add_mark(x3::unused_type, T)
+{
+    return true;
+}
+
+bool add_mark(marks &m, stan::dynamic d)
+{
+    // A dynamic ends a hairpin begun on an earlier note.
+    if (m.m_hairpin and *m.m_hairpin < m.note()) {
+        m.close(m.m_hairpin, m.m_hairpin_type);
+    }
+    m.m_score.m_dynamics.add(m.note(), d);
+    return true;
+}
+
+bool add_mark(marks &m, stan::articulation a)
+{
+    m.m_score.m_articulations.add(m.note(), a);
+    return true;
+}
+
+bool add_mark(marks &m, span_mark s)
+{
+    using type = stan::spanner::type;
+    switch (s) {
+    case span_mark::slur:
+        return m.open(m.m_slur);
+    case span_mark::phrasing_slur:
+        return m.open(m.m_phrasing_slur);
+    case span_mark::slur_end:
+        if (!m.m_slur) {
+            return false;
+        }
+        m.close(m.m_slur, type::slur);
+        return true;
+    case span_mark::phrasing_slur_end:
+        if (!m.m_phrasing_slur) {
+            return false;
+        }
+        m.close(m.m_phrasing_slur, type::phrasing_slur);
+        return true;
+    case span_mark::crescendo:
+    case span_mark::decrescendo:
+        // A hairpin ends the one before it.
+        if (m.m_hairpin) {
+            m.close(m.m_hairpin, m.m_hairpin_type);
+        }
+        m.m_hairpin_type = s == span_mark::crescendo ? type::crescendo : type::decrescendo;
+        return m.open(m.m_hairpin);
+    case span_mark::hairpin_end:
+        // As in LilyPond, "\!" with no hairpin open is allowed, and does nothing.
+        if (m.m_hairpin) {
+            m.close(m.m_hairpin, m.m_hairpin_type);
+        }
+        return true;
+    }
+    return false;
+}
+
+auto counted = [](auto &ctx) { count_note(x3::get<marks_tag>(ctx)); };
+auto marked = [](auto &ctx) { x3::_pass(ctx) = add_mark(x3::get<marks_tag>(ctx), _attr(ctx)); };
+
+auto const pmark =
+    x3::lexeme[dynamic >> !x3::alpha][marked] | articulation[marked] | span[marked];
+
 auto const prest_def = x3::lit('r') >> pvalue[construct<stan::rest>()];
-auto const pnote_def = (ppitch >> pvalue)[construct<stan::note, 1, 0>()];
+auto const pnote_def =
+    (ppitch >> pvalue)[construct<stan::note, 1, 0>()] >> eps[counted] >> *pmark;
 auto const ppitch_def = (pitchclass >> poctave)[construct<stan::pitch, 0, 1>()];
 
 auto add_dot = [](auto &ctx) { _val(ctx) = dot(_val(ctx)); };
 
 auto const pvalue_def =
     basevalue[construct<stan::value>()] >> x3::repeat(0, 2)[lit('.')[add_dot]];
-auto const pchord_def = ('<' >> +ppitch >> '>' >> pvalue)[construct<stan::chord, 1, 0>()];
-auto const pbeam_def = '[' >> (+column)[construct<stan::beam>()] >> ']';
+auto const pchord_def = ('<' >> +ppitch >> '>' >> pvalue)[construct<stan::chord, 1, 0>()] >>
+                        eps[counted] >> *pmark;
+// LilyPond takes "]" as a mark of the note before it, so marks may follow it,
+// as in "[e8 f8])", and belong to that note.
+auto const pbeam_def = '[' >> (+column)[construct<stan::beam>()] >> ']' >> *pmark;
 auto const ptuplet_def =
     (lit(R"(\tuplet)") >> x3::int_ >> '/' >> x3::int_ >> '{' >> (+column) >> '}')
         [to_tuplet];
@@ -353,6 +657,26 @@ auto const pkey_def =
     (lit(R"(\key)") >> pitchclass >> mode)[construct<stan::key, 0, 1>()];
 auto const column_def = (prest | pnote | pchord | pbeam | ptuplet | pmeter | pclef | pkey)
     [construct<stan::column>()];
+auto const sequential_def = ('{' >> *column >> '}') | *column;
+
+// Chord names, as in "\chordmode { c1 f2:maj7 g2:7/b }", spelled from the
+// table of qualities and the interval arithmetic of stan::spell().
+auto to_named_chord = [](auto &ctx) {
+    auto attr = _attr(ctx);
+    std::optional<stan::pitchclass> bass;
+    if (at_c<3>(attr)) {
+        bass = *at_c<3>(attr);
+    }
+    const stan::chord_quality *quality =
+        at_c<2>(attr) ? *at_c<2>(attr) : &stan::chord_qualities::major;
+    x3::_val(ctx) = stan::spell(at_c<1>(attr), { at_c<0>(attr), quality, bass });
+};
+auto const pchordname_def =
+    (ppitch >> pvalue >> -(':' >> chord_quality) >> -('/' >> pitchclass))[to_named_chord];
+auto const chordcolumn_def = (prest | pchordname | pmeter | pclef | pkey)
+    [construct<stan::column>()];
+auto const chordmode_def =
+    -lit(R"(\chordmode)") >> (('{' >> *chordcolumn >> '}') | *chordcolumn);
 // auto make_shared = [](auto &ctx) { _val = std::make_shared<column>(std::move(_attr(ctx))); };
 // auto const music_def = column[make_shared];
 // auto const variant_def = note | chord_body | key | meter | clef ;
@@ -370,10 +694,14 @@ BOOST_SPIRIT_DEFINE(pmeter)
 BOOST_SPIRIT_DEFINE(pclef)
 BOOST_SPIRIT_DEFINE(pkey)
 BOOST_SPIRIT_DEFINE(column)
+BOOST_SPIRIT_DEFINE(sequential)
+BOOST_SPIRIT_DEFINE(pchordname)
+BOOST_SPIRIT_DEFINE(chordcolumn)
+BOOST_SPIRIT_DEFINE(chordmode)
 
 stan::column reader::operator()(const std::string &lily)
 {
-    stan::column music{ stan::default_value<stan::note> };
+    stan::column music{ stan::default_value<stan::note>() };
     auto iter = lily.begin();
 
     if (!x3::phrase_parse(iter, lily.end(), column, x3::space, music)) {
@@ -387,4 +715,378 @@ stan::column reader::operator()(const std::string &lily)
     return std::move(music);
 }
 
+stan::sequential reader::sequence(const std::string &lily)
+{
+    std::vector<default_ctor<stan::column>> music;
+    auto iter = lily.begin();
+
+    if (!x3::phrase_parse(iter, lily.end(), sequential, x3::space, music)) {
+        throw std::runtime_error("parse error");
+    }
+
+    if (iter != lily.end()) {
+        throw std::runtime_error("incomplete parse");
+    }
+
+    // Slice off default_ctor explicitly.  Constructing a column directly from
+    // a default_ctor<column> picks std::variant's converting constructor,
+    // which happily builds a beam out of it, recursively.
+    stan::sequential result;
+    result.reserve(music.size());
+    for (auto &c : music) {
+        result.push_back(static_cast<stan::column &&>(c));
+    }
+    return result;
+}
+
+stan::sequential reader::sequence(const std::string &lily,
+                                  std::vector<stan::source_span> &out)
+{
+    std::vector<default_ctor<stan::column>> music;
+    out.clear();
+    spans context{ lily.begin(), out };
+    auto iter = lily.begin();
+
+    if (!x3::phrase_parse(iter, lily.end(), x3::with<spans_tag>(context)[sequential],
+                          x3::space, music)) {
+        throw std::runtime_error("parse error");
+    }
+
+    if (iter != lily.end()) {
+        throw std::runtime_error("incomplete parse");
+    }
+
+    std::sort(out.begin(), out.end(),
+              [](const stan::source_span &s1, const stan::source_span &s2) {
+                  return s1.m_begin < s2.m_begin;
+              });
+
+    stan::sequential result;
+    result.reserve(music.size());
+    for (auto &c : music) {
+        result.push_back(static_cast<stan::column &&>(c));
+    }
+    return result;
+}
+
+stan::sequential reader::chordmode(const std::string &lily)
+{
+    std::vector<default_ctor<stan::column>> music;
+    auto iter = lily.begin();
+
+    if (!x3::phrase_parse(iter, lily.end(), lilypond::chordmode, x3::space, music)) {
+        throw std::runtime_error("parse error");
+    }
+
+    if (iter != lily.end()) {
+        throw std::runtime_error("incomplete parse");
+    }
+
+    stan::sequential result;
+    result.reserve(music.size());
+    for (auto &c : music) {
+        result.push_back(static_cast<stan::column &&>(c));
+    }
+    return result;
+}
+
+namespace {
+
+// Lyrics are scanned by hand rather than with X3.  A syllable is almost any
+// run of characters up to white space, so the grammar is only a handful of
+// special tokens, and scanning straight into the pool of a stan::lyrics
+// leaves no per-syllable strings behind.
+struct lyric_scanner
+{
+    const std::string &m_text;
+    std::size_t m_pos = 0;
+
+    bool at_end()
+    {
+        while (m_pos < m_text.size() and std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+            ++m_pos;
+        }
+        return m_pos == m_text.size();
+    }
+
+    bool keyword(const char *word)
+    {
+        std::size_t n = std::strlen(word);
+        if (m_text.compare(m_pos, n, word) != 0 or
+            (m_pos + n < m_text.size() and std::isalpha(static_cast<unsigned char>(m_text[m_pos + n])))) {
+            return false;
+        }
+        m_pos += n;
+        return true;
+    }
+
+    // Syllables until the brace closing the block, or the end of the text if
+    // the block is not braced.  note is the next note to sing on.
+    void syllables(stan::lyrics &out, std::uint32_t &note, std::uint32_t notes, bool braced)
+    {
+        int depth = braced ? 1 : 0;
+        for (;;) {
+            if (at_end()) {
+                if (depth != 0) {
+                    throw std::runtime_error("unterminated lyrics");
+                }
+                return;
+            }
+            char c = m_text[m_pos];
+            if (c == '{') {
+                ++depth;
+                ++m_pos;
+            } else if (c == '}') {
+                if (depth == 0) {
+                    throw std::runtime_error("parse error");
+                }
+                ++m_pos;
+                if (--depth == 0 and braced) {
+                    return;
+                }
+            } else if (c == '"') {
+                if (note < notes) {
+                    out.add_with(note, [this](std::string &pool) { quoted(&pool); });
+                } else {
+                    quoted(nullptr);
+                }
+                ++note;
+                duration();
+            } else if (c == '\\') {
+                if (!keyword("\\skip")) {
+                    throw std::runtime_error("unsupported lyric command");
+                }
+                at_end();
+                duration();
+                ++note;
+            } else {
+                std::size_t start = m_pos;
+                while (m_pos < m_text.size() and !std::isspace(static_cast<unsigned char>(m_text[m_pos])) and
+                       m_text[m_pos] != '{' and m_text[m_pos] != '}') {
+                    ++m_pos;
+                }
+                std::string_view word(m_text.data() + start, m_pos - start);
+                if (word == "--" or word == "__") {
+                    if (!out.empty() and out.syllables().back().m_note + 1 == note) {
+                        out.set_join(word == "--" ? stan::lyrics::join::hyphen
+                                                  : stan::lyrics::join::extender);
+                    }
+                } else if (word == "_") {
+                    ++note;
+                } else {
+                    // A trailing number is a duration, as in "Twin4.".
+                    std::size_t end = word.size();
+                    while (end > 0 and word[end - 1] == '.') {
+                        --end;
+                    }
+                    std::size_t digits = end;
+                    while (digits > 0 and std::isdigit(static_cast<unsigned char>(word[digits - 1]))) {
+                        --digits;
+                    }
+                    if (digits > 0 and digits < end) {
+                        word = word.substr(0, digits);
+                    }
+                    add(out, note, notes, word);
+                }
+            }
+        }
+    }
+
+    // Skips a quoted string, appending its unescaped text to text if given.
+    void quoted(std::string *text)
+    {
+        std::size_t run = ++m_pos;
+        for (; m_pos < m_text.size() and m_text[m_pos] != '"'; ++m_pos) {
+            if (m_text[m_pos] == '\\' and m_pos + 1 < m_text.size()) {
+                if (text != nullptr) {
+                    text->append(m_text, run, m_pos - run);
+                }
+                run = ++m_pos;
+            }
+        }
+        if (m_pos == m_text.size()) {
+            throw std::runtime_error("unterminated string");
+        }
+        if (text != nullptr) {
+            text->append(m_text, run, m_pos - run);
+        }
+        ++m_pos;
+    }
+
+    // Skips a duration such as "4" or "8.", if one follows.
+    void duration()
+    {
+        while (m_pos < m_text.size() and std::isdigit(static_cast<unsigned char>(m_text[m_pos]))) {
+            ++m_pos;
+        }
+        while (m_pos < m_text.size() and m_text[m_pos] == '.') {
+            ++m_pos;
+        }
+    }
+
+    static void add(stan::lyrics &out, std::uint32_t &note, std::uint32_t notes,
+                    std::string_view text)
+    {
+        if (note < notes) {
+            out.add(note, text);
+        }
+        ++note;
+    }
+};
+
+} // namespace
+
+stan::lyrics reader::lyricmode(const std::string &lily)
+{
+    lyric_scanner scan{ lily };
+    bool braced = false;
+    if (!scan.at_end() and scan.keyword("\\lyricmode")) {
+        if (scan.at_end() or lily[scan.m_pos] != '{') {
+            throw std::runtime_error("parse error");
+        }
+        ++scan.m_pos;
+        braced = true;
+    }
+
+    stan::lyrics out;
+    std::uint32_t note = 0;
+    scan.syllables(out, note, UINT32_MAX, braced);
+    if (!scan.at_end()) {
+        throw std::runtime_error("incomplete parse");
+    }
+    return out;
+}
+
+stan::score reader::score(const std::string &lily)
+{
+    stan::score out;
+    std::size_t verses = lily.find("\\addlyrics");
+
+    std::vector<default_ctor<stan::column>> music;
+    marks context{ out };
+    auto iter = lily.begin();
+    auto end = verses == std::string::npos ? lily.end() : lily.begin() + verses;
+    if (!x3::phrase_parse(iter, end, x3::with<marks_tag>(context)[sequential], x3::space,
+                          music)) {
+        throw std::runtime_error("parse error");
+    }
+    if (iter != end) {
+        throw std::runtime_error("incomplete parse");
+    }
+    if (context.m_slur or context.m_phrasing_slur or context.m_hairpin) {
+        throw std::runtime_error("unterminated spanner");
+    }
+    std::stable_sort(out.m_spanners.begin(), out.m_spanners.end(),
+                     [](const stan::spanner &s1, const stan::spanner &s2) {
+                         return s1.m_first < s2.m_first;
+                     });
+
+    out.m_music.reserve(music.size());
+    for (auto &c : music) {
+        out.m_music.push_back(static_cast<stan::column &&>(c));
+    }
+    if (verses == std::string::npos) {
+        return out;
+    }
+
+    auto notes = static_cast<std::uint32_t>(
+        std::min<std::size_t>(note_count(out.m_music), UINT32_MAX));
+    lyric_scanner scan{ lily, verses };
+    while (!scan.at_end()) {
+        if (!scan.keyword("\\addlyrics") or scan.at_end() or lily[scan.m_pos] != '{') {
+            throw std::runtime_error("parse error");
+        }
+        ++scan.m_pos;
+        std::uint32_t note = 0;
+        scan.syllables(out.m_verses.emplace_back(), note, notes, true);
+    }
+    return out;
+}
+
+namespace {
+
+// A syntax error mid file would otherwise leave everything after it pending.
+// No well formed column comes anywhere near this size.
+constexpr std::size_t max_pending = 16 << 20;
+
+} // namespace
+
+void stream_reader::feed(const char *data, std::size_t size, stan::sequential &music)
+{
+    m_pending.append(data, size);
+    parse(music, false);
+    if (m_pending.size() > max_pending) {
+        throw std::runtime_error("incomplete parse");
+    }
+}
+
+void stream_reader::finish(stan::sequential &music)
+{
+    parse(music, true);
+
+    auto iter = m_pending.cbegin();
+    x3::phrase_parse(iter, m_pending.cend(), x3::eps, x3::space);
+    if (m_braced and (iter == m_pending.cend() or *iter++ != '}')) {
+        throw std::runtime_error("incomplete parse");
+    }
+    x3::phrase_parse(iter, m_pending.cend(), x3::eps, x3::space);
+    if (iter != m_pending.cend()) {
+        throw std::runtime_error("incomplete parse");
+    }
+
+    m_pending.clear();
+    m_started = m_braced = false;
+}
+
+void stream_reader::parse(stan::sequential &music, bool last)
+{
+    auto begin = m_pending.cbegin();
+    auto iter = begin;
+
+    if (!m_started) {
+        x3::phrase_parse(iter, m_pending.cend(), x3::eps, x3::space);
+        if (iter == m_pending.cend()) {
+            return;
+        }
+        m_started = true;
+        if (*iter == '{') {
+            m_braced = true;
+            ++iter;
+        }
+    }
+
+    auto consumed = iter;
+    std::optional<stan::column> held;
+    for (;;) {
+        auto start = iter;
+        stan::column c{ stan::default_value<stan::note>() };
+        bool parsed = false;
+        try {
+            parsed = x3::phrase_parse(iter, m_pending.cend(), column, x3::space, c);
+        } catch (std::exception &) {
+            // Cut short, a valid column can fail validation, as "[e16 f16]"
+            // does as "[e16 f1" since a beam's contents are checked before
+            // its closing bracket.  Wait for the rest unless there is none.
+            if (last) {
+                throw;
+            }
+        }
+        if (!parsed) {
+            iter = start;
+            break;
+        }
+        if (held) {
+            music.push_back(std::move(*held));
+            consumed = start;
+        }
+        held = std::move(c);
+    }
+    if (held and last) {
+        music.push_back(std::move(*held));
+        consumed = iter;
+    }
+
+    m_pending.erase(0, static_cast<std::size_t>(consumed - begin));
+}
+
 } // namespace stan::lilypond
@@ -0,0 +1,131 @@
+#include <stan/driver/lilypond.hpp>
+#include <stan/decompress.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace stan::lilypond {
+
+namespace {
+
+// Decompressed blocks in flight between the two threads.  Enough to absorb
+// jitter on either side while keeping memory at a few blocks.
+constexpr std::size_t queue_blocks = 4;
+
+struct cancelled
+{
+};
+
+class block_queue
+{
+  public:
+    // Blocks while the queue is full.  Throws cancelled once the consumer
+    // has given up, to unwind the producer.
+    void push(const char *data, std::size_t size)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this] { return m_cancelled or m_blocks.size() < queue_blocks; });
+        if (m_cancelled) {
+            throw cancelled{};
+        }
+        m_blocks.emplace_back(data, size);
+        m_changed.notify_all();
+    }
+
+    void close(std::exception_ptr error)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_error = error;
+        m_changed.notify_all();
+    }
+
+    void cancel()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelled = true;
+        m_changed.notify_all();
+    }
+
+    // Returns false at the end of the stream, and rethrows anything the
+    // producer threw.
+    bool pop(std::string &block)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this] { return m_closed or !m_blocks.empty(); });
+        if (m_blocks.empty()) {
+            if (m_error) {
+                std::rethrow_exception(m_error);
+            }
+            return false;
+        }
+        block.swap(m_blocks.front());
+        m_blocks.pop_front();
+        m_changed.notify_all();
+        return true;
+    }
+
+  private:
+    std::deque<std::string> m_blocks;
+    bool m_closed = false;
+    bool m_cancelled = false;
+    std::exception_ptr m_error;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+};
+
+// Parses the blocks that produce passes to its callback, running produce on
+// a second thread so that decompressing overlaps parsing.
+sequential read_blocks(const std::function<void(const block_callback &)> &produce)
+{
+    block_queue queue;
+    std::thread producer([&]() {
+        std::exception_ptr error;
+        try {
+            produce([&](const char *data, std::size_t size) { queue.push(data, size); });
+        } catch (cancelled &) {
+        } catch (...) {
+            error = std::current_exception();
+        }
+        queue.close(error);
+    });
+
+    sequential music;
+    try {
+        stream_reader read;
+        std::string block;
+        while (queue.pop(block)) {
+            read.feed(block.data(), block.size(), music);
+        }
+        read.finish(music);
+    } catch (...) {
+        queue.cancel();
+        producer.join();
+        throw;
+    }
+
+    producer.join();
+    return music;
+}
+
+} // namespace
+
+sequential read_file(const std::string &path, std::size_t block_size)
+{
+    return read_blocks([&](const block_callback &sink) {
+        decompress_file(path, block_size, sink);
+    });
+}
+
+sequential read_compressed(const std::string &data, std::size_t block_size)
+{
+    return read_blocks([&](const block_callback &sink) {
+        decompress(data.data(), data.size(), block_size, sink);
+    });
+}
+
+} // namespace stan::lilypond
@@ -3,7 +3,11 @@
 #include <stan/driver/lilypond.hpp>
 #include <stan/driver/debug.hpp>
 
+#include <algorithm>
+#include <cctype>
 #include <numeric>
+#include <optional>
+#include <string_view>
 
 namespace stan::lilypond {
 
@@ -82,6 +86,26 @@ std::string writer::operator()<beam>(beam const &r) const
     return fmt::format("[{}]", elements);
 }
 
+namespace {
+
+// The "\tuplet n/d" ratio of a tuplet's written to its actual duration.
+rational<std::uint16_t> tuplet_scale(const tuplet &r)
+{
+    duration inside = std::accumulate(
+        r.m_elements.begin(),
+        r.m_elements.end(),
+        duration::zero(),
+        [](duration res, const auto &p) { return res + p; });
+
+    duration outside = r.m_value;
+
+    float fi = inside;
+    float fo = outside;
+    return rational<std::uint16_t>::quantize(fi / fo);
+}
+
+} // namespace
+
 template <>
 std::string writer::operator()<tuplet>(tuplet const &r) const
 {
@@ -94,17 +118,7 @@ std::string writer::operator()<tuplet>(tuplet const &r) const
         [](std::string res, const auto &p) { return res + write(p) + " "; });
     elements.resize(elements.size() - 1);
 
-    duration inside = std::accumulate(
-        r.m_elements.begin(),
-        r.m_elements.end(),
-        duration::zero(),
-        [](duration res, const auto &p) { return res + p; });
-
-    duration outside = r.m_value;
-
-    float fi = inside;
-    float fo = outside;
-    auto scale = rational<std::uint16_t>::quantize(fi / fo);
+    auto scale = tuplet_scale(r);
     return fmt::format(R"(\tuplet {}/{} {{{}}})", scale.num(), scale.den(), elements);
 }
 
@@ -130,13 +144,14 @@ std::string writer::operator()<meter>(const meter &m) const
 template <>
 std::string writer::operator()<clef>(const clef &c) const
 {
-	static std::map<clef::type, std::string> name {
+	constexpr static_map<clef::type, const char *, 5> name { {{
 		{ clef::type::treble, "treble" },
 		{ clef::type::alto, "alto" },
 		{ clef::type::tenor, "tenor" },
 		{ clef::type::bass, "bass" },
 		{ clef::type::percussion, "percussion" },
-	};
+	}} };
+	static_assert(name.sorted());
 
 	return fmt::format(R"(\clef {})", name.at(c.m_type));
 }
@@ -164,4 +179,213 @@ std::string writer::operator()<column>(const column &v) const
     return std::visit([](auto &&ev) { return write(ev); }, v);
 }
 
+template <typename Iterator>
+std::string writer::list(Iterator begin, Iterator end) const
+{
+    std::string elements = std::accumulate(
+        begin,
+        end,
+        std::string(),
+        [this](std::string res, const auto &p) { return res + (*this)(p) + " "; });
+    return fmt::format("{{ {}}}", elements);
+}
+
+template <>
+std::string writer::operator()<sequential>(const sequential &s) const
+{
+    return list(s.begin(), s.end());
+}
+
+template <>
+std::string writer::operator()<transposed>(const transposed &s) const
+{
+    return list(s.begin(), s.end());
+}
+
+template <>
+std::string writer::operator()<rope>(const rope &s) const
+{
+    return list(s.begin(), s.end());
+}
+
+namespace {
+
+// A syllable as a word, or quoted where it would otherwise read as something
+// else: white space, braces, a command, a duration or a join.
+std::string syllable(std::string_view text)
+{
+    bool plain = !text.empty() and text != "_" and text != "--" and text != "__" and
+                 !std::isdigit(static_cast<unsigned char>(text.front())) and
+                 !std::isdigit(static_cast<unsigned char>(text.back())) and
+                 text.find_first_of(" \t\n\r\f\v{}\"\\") == std::string_view::npos;
+    if (plain) {
+        return std::string(text);
+    }
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' or c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + '"';
+}
+
+// The syllables of a verse, with "_" for each note passed over.
+std::string syllables(const lyrics &verse)
+{
+    std::string out;
+    std::uint32_t note = 0;
+    for (const auto &s : verse.syllables()) {
+        for (; note < s.m_note; ++note) {
+            out += "_ ";
+        }
+        out += syllable(verse.text(s));
+        if (s.m_join == lyrics::join::hyphen) {
+            out += " --";
+        } else if (s.m_join == lyrics::join::extender) {
+            out += " __";
+        }
+        out += ' ';
+        ++note;
+    }
+    return out;
+}
+
+// Music as writer writes it, with what the score's side tables attach to
+// each note written after it.
+struct score_writer
+{
+    const score &m_score;
+    std::uint32_t m_note = 0;
+
+    // Spanners by the note they start on, as in the score, and by the note
+    // they end on, each with the next one to write.
+    std::vector<const spanner *> m_by_last;
+    std::size_t m_started = 0;
+    std::size_t m_ended = 0;
+
+    explicit score_writer(const score &s) : m_score(s)
+    {
+        for (const auto &sp : s.m_spanners) {
+            m_by_last.push_back(&sp);
+        }
+        std::stable_sort(m_by_last.begin(), m_by_last.end(),
+                         [](const spanner *s1, const spanner *s2) {
+                             return s1->m_last < s2->m_last;
+                         });
+    }
+
+    std::string operator()(const sequential &music)
+    {
+        std::string out;
+        for (const auto &c : music) {
+            out += (*this)(c) + " ";
+        }
+        return out;
+    }
+
+    std::string operator()(const column &c)
+    {
+        static writer write;
+
+        if (const auto *b = std::get_if<beam>(&c)) {
+            std::string elements = (*this)(b->m_elements);
+            elements.resize(elements.size() - 1);
+            return fmt::format("[{}]", elements);
+        }
+        if (const auto *t = std::get_if<tuplet>(&c)) {
+            std::string elements = (*this)(t->m_elements);
+            elements.resize(elements.size() - 1);
+            auto scale = tuplet_scale(*t);
+            return fmt::format(R"(\tuplet {}/{} {{{}}})", scale.num(), scale.den(), elements);
+        }
+
+        std::string out = write(c);
+        if (std::holds_alternative<stan::note>(c) or std::holds_alternative<chord>(c)) {
+            out += marks();
+            ++m_note;
+        }
+        return out;
+    }
+
+    // The marks of the current note.  Spanners from earlier notes end before
+    // new ones start, so that a hairpin can hand over to the next, but one
+    // that starts and ends on this note ends after it starts.
+    std::string marks()
+    {
+        constexpr const char *starts[] = { "(", R"(\()", R"(\<)", R"(\>)" };
+        constexpr const char *ends[] = { ")", R"(\))", R"(\!)", R"(\!)" };
+
+        std::string out;
+        auto [afirst, alast] = m_score.m_articulations.equal_range(m_note);
+        for (; afirst != alast; ++afirst) {
+            out += fmt::format("-{}", articulation_names.at(afirst->m_value));
+        }
+        auto [dfirst, dlast] = m_score.m_dynamics.equal_range(m_note);
+        for (; dfirst != dlast; ++dfirst) {
+            out += fmt::format(R"(\{})", dynamic_names.at(dfirst->m_value));
+        }
+
+        std::string same;
+        for (; m_ended < m_by_last.size() and m_by_last[m_ended]->m_last == m_note; ++m_ended) {
+            const spanner &sp = *m_by_last[m_ended];
+            (sp.m_first == m_note ? same : out) += ends[static_cast<int>(sp.m_type)];
+        }
+        const auto &spanners = m_score.m_spanners;
+        for (; m_started < spanners.size() and spanners[m_started].m_first == m_note;
+             ++m_started) {
+            out += starts[static_cast<int>(spanners[m_started].m_type)];
+        }
+        return out + same;
+    }
+};
+
+} // namespace
+
+template <>
+std::string writer::operator()<lyrics>(const lyrics &l) const
+{
+    return fmt::format(R"(\lyricmode {{ {}}})", syllables(l));
+}
+
+template <>
+std::string writer::operator()<score>(const score &s) const
+{
+    std::string out = fmt::format("{{ {}}}", score_writer(s)(s.m_music));
+    for (const auto &verse : s.m_verses) {
+        out += fmt::format(R"( \addlyrics {{ {}}})", syllables(verse));
+    }
+    return out;
+}
+
+std::string writer::chordmode(const sequential &music) const
+{
+    static writer write;
+
+    std::string out;
+    for (const auto &c : music) {
+        if (const auto *ch = std::get_if<chord>(&c)) {
+            std::optional<chord_name> n = name_of(*ch);
+            if (!n) {
+                throw invalid_chord("no name for {}", write(*ch));
+            }
+            out += write(n->m_root) + write(ch->m_value);
+            if (*n->m_quality->m_name != '\0') {
+                out += fmt::format(":{}", n->m_quality->m_name);
+            }
+            if (n->m_bass) {
+                out += fmt::format("/{}", pitchclass_names.at(*n->m_bass));
+            }
+        } else if (std::holds_alternative<note>(c) or std::holds_alternative<beam>(c) or
+                   std::holds_alternative<tuplet>(c)) {
+            throw invalid_chord("chord mode has no place for {}", write(c));
+        } else {
+            out += write(c);
+        }
+        out += ' ';
+    }
+    return fmt::format(R"(\chordmode {{ {}}})", out);
+}
+
 } // namespace stan::lilypond
@@ -0,0 +1,526 @@
+#include <stan/index.hpp>
+#include <stan/driver/lilypond.hpp>
+#include <stan/driver/lilypond_include.hpp>
+#include <stan/hash.hpp>
+#include <stan/ingest.hpp>
+#include <stan/scheduler.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <optional>
+
+namespace stan::index {
+
+namespace {
+
+// Shard file, all integers little endian:
+//
+//   header      'S' 'T' 'I' 'X' version 0 0 0
+//               u32 documents, u32 terms
+//   table       per term, in increasing order:
+//               u64 term, u64 offset, u32 documents, u32 reserved
+//   postings    per term, document numbers as LEB128 varints, the first
+//               as is and each later one as the gap from the one before;
+//               offsets in the table count from the start of this section
+constexpr std::size_t header_size = 16;
+constexpr std::size_t entry_size = 24;
+
+// Durations are exact moments rather than ticks, so that a rhythm's ratios
+// do not depend on rounding inside tuplets.
+struct event
+{
+    int m_semitone;
+    moment m_duration;
+};
+
+struct top_line
+{
+    std::vector<std::vector<event>> m_phrases{ 1 };
+
+    void end_phrase()
+    {
+        if (!m_phrases.back().empty()) {
+            m_phrases.emplace_back();
+        }
+    }
+
+    void add(const std::vector<column> &elements, const moment &scale)
+    {
+        for (const auto &c : elements) {
+            add(c, scale);
+        }
+    }
+
+    void add(const column &c, const moment &scale)
+    {
+        if (std::holds_alternative<rest>(c)) {
+            end_phrase();
+        } else if (const auto *n = std::get_if<note>(&c)) {
+            m_phrases.back().push_back(
+                { n->m_pitch.midi(), scale * moment(n->m_value) });
+        } else if (const auto *ch = std::get_if<chord>(&c)) {
+            int top = ch->m_pitches.front().midi();
+            for (const auto &p : ch->m_pitches) {
+                top = std::max(top, p.midi());
+            }
+            m_phrases.back().push_back({ top, scale * moment(ch->m_value) });
+        } else if (const auto *b = std::get_if<beam>(&c)) {
+            add(b->m_elements, scale);
+        } else if (const auto *t = std::get_if<tuplet>(&c)) {
+            add(t->m_elements, scale * time_scale(*t));
+        }
+    }
+};
+
+void put32(std::string &out, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>(v >> (8 * i)));
+    }
+}
+
+void put64(std::string &out, std::uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>(v >> (8 * i)));
+    }
+}
+
+std::uint32_t get32(const unsigned char *p)
+{
+    std::uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+std::uint64_t get64(const unsigned char *p)
+{
+    std::uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+void put_varint(std::string &out, std::uint32_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+// Reads one varint, or returns false at the end of the list or on a
+// malformed one.
+bool get_varint(const unsigned char *&p, const unsigned char *end, std::uint32_t &v)
+{
+    v = 0;
+    for (int shift = 0; p != end and shift < 35; shift += 7) {
+        unsigned char b = *p++;
+        v |= std::uint32_t(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string shard_path(const std::string &directory, std::size_t shard)
+{
+    return fmt::format("{}/shard-{:05}", directory, shard);
+}
+
+void write_file(const std::string &path, const std::string &data)
+{
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            ::unlink(temporary.c_str());
+            throw index_error("cannot write {}", path);
+        }
+    }
+    if (::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        throw index_error("cannot write {}: {}", path, std::strerror(errno));
+    }
+}
+
+void check_length(unsigned length)
+{
+    if (length < 2) {
+        throw index_error("n-grams need at least two notes, not {}", length);
+    }
+}
+
+} // namespace
+
+std::vector<term> terms(const sequential &music, unsigned length, unsigned kinds)
+{
+    check_length(length);
+
+    top_line m;
+    m.add(music, moment(1, 1));
+
+    std::vector<term> out;
+    std::string gram;
+    for (const auto &phrase : m.m_phrases) {
+        for (std::size_t i = 0; i + length <= phrase.size(); ++i) {
+            if (kinds & melody) {
+                gram.assign(1, 'm');
+                for (std::size_t k = i + 1; k < i + length; ++k) {
+                    int interval = phrase[k].m_semitone - phrase[k - 1].m_semitone;
+                    gram.push_back(static_cast<char>(std::clamp(interval, -127, 127)));
+                }
+                out.push_back(hash(gram, version).m_low);
+            }
+            if (kinds & rhythm) {
+                gram.assign(1, 'r');
+                for (std::size_t k = i + 1; k < i + length; ++k) {
+                    const moment &d1 = phrase[k - 1].m_duration;
+                    const moment &d2 = phrase[k].m_duration;
+                    moment ratio(d2.m_num * d1.m_den, d2.m_den * d1.m_num);
+                    put64(gram, ratio.m_num);
+                    put64(gram, ratio.m_den);
+                }
+                out.push_back(hash(gram, version).m_low);
+            }
+        }
+    }
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+shard_writer::shard_writer(unsigned length) : m_length(length)
+{
+    check_length(length);
+}
+
+std::uint32_t shard_writer::add(const sequential &music)
+{
+    return add(terms(music, m_length));
+}
+
+std::uint32_t shard_writer::add(const std::vector<term> &sorted_terms)
+{
+    for (term t : sorted_terms) {
+        m_postings.emplace_back(t, m_documents);
+    }
+    return m_documents++;
+}
+
+void shard_writer::write(const std::string &path) const
+{
+    // Documents were added in order, so a stable sort by term leaves each
+    // term's documents increasing.
+    std::vector<std::pair<term, std::uint32_t>> postings = m_postings;
+    std::stable_sort(postings.begin(), postings.end(),
+                     [](const auto &p1, const auto &p2) { return p1.first < p2.first; });
+
+    std::string table;
+    std::string lists;
+    std::uint32_t count = 0;
+    for (auto p = postings.begin(); p != postings.end();) {
+        auto end = std::find_if(p, postings.end(),
+                                [&](const auto &q) { return q.first != p->first; });
+        put64(table, p->first);
+        put64(table, lists.size());
+        put32(table, static_cast<std::uint32_t>(end - p));
+        put32(table, 0);
+
+        std::uint32_t previous = 0;
+        for (; p != end; ++p) {
+            put_varint(lists, p->second - previous);
+            previous = p->second;
+        }
+        ++count;
+    }
+
+    std::string out("STIX");
+    out.push_back(static_cast<char>(version));
+    out.append(3, '\0');
+    put32(out, m_documents);
+    put32(out, count);
+    out += table;
+    out += lists;
+    write_file(path, out);
+}
+
+void build(const std::string &directory, const std::vector<std::string> &paths,
+           const build_options &options, const build_error_callback &on_error)
+{
+    check_length(options.m_length);
+    if (options.m_shard_documents == 0 or options.m_shard_documents > UINT32_MAX) {
+        throw index_error("invalid shard size {}", options.m_shard_documents);
+    }
+    if (::mkdir(directory.c_str(), 0755) != 0 and errno != EEXIST) {
+        throw index_error("cannot create {}: {}", directory, std::strerror(errno));
+    }
+
+    std::string names;
+    for (const auto &p : paths) {
+        if (p.find('\n') != std::string::npos) {
+            throw index_error("cannot index a path containing a newline");
+        }
+        names += p + '\n';
+    }
+
+    std::size_t shards = (paths.size() + options.m_shard_documents - 1) / options.m_shard_documents;
+    lilypond::include_reader includes(options.m_include_path);
+
+    // Each shard is built by one task, which loads its files with
+    // stan::ingest() and keeps only their terms until the shard is written.
+    std::optional<scheduler> own;
+    if (options.m_threads != 0) {
+        own.emplace(options.m_threads);
+    }
+    parallel_for(own ? *own : default_executor(), 0, shards, [&](std::size_t s) {
+        std::size_t begin = s * options.m_shard_documents;
+        std::size_t end = std::min(paths.size(), begin + options.m_shard_documents);
+        std::vector<std::string> shard_paths(paths.begin() + begin, paths.begin() + end);
+        std::vector<std::vector<term>> documents(end - begin);
+        lilypond::reader read;
+
+        ingest_options io;
+        io.m_threads = 1;
+        ingest(shard_paths,
+               [&](std::size_t i, std::string &contents, int error) {
+                   try {
+                       if (error != 0) {
+                           throw index_error("cannot read: {}", std::strerror(error));
+                       }
+                       sequential music = lilypond::read_contents(
+                           shard_paths[i], contents, includes,
+                           [&](const std::string &text) { return read.sequence(text); });
+                       documents[i] = terms(music, options.m_length);
+                   } catch (std::exception &e) {
+                       if (on_error) {
+                           on_error(begin + i, e.what());
+                       }
+                   }
+               },
+               io);
+
+        shard_writer writer(options.m_length);
+        for (const auto &d : documents) {
+            writer.add(d);
+        }
+        writer.write(shard_path(directory, s));
+    });
+
+    write_file(directory + "/documents", names);
+    // Written last, so an interrupted build is never mistaken for an index.
+    write_file(directory + "/meta", fmt::format("stan-index {}\nlength {}\nshards {}\n",
+                                                version, options.m_length, shards));
+}
+
+struct searcher::shard
+{
+    const unsigned char *m_data = nullptr;
+    std::size_t m_size = 0;
+    std::uint32_t m_documents = 0;
+    std::uint32_t m_terms = 0;
+    std::size_t m_first = 0;
+
+    shard(const std::string &path, std::size_t first) : m_first(first)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw index_error("cannot open {}: {}", path, std::strerror(errno));
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw index_error("cannot stat {}: {}", path, std::strerror(errno));
+        }
+        m_size = static_cast<std::size_t>(st.st_size);
+        if (m_size > 0) {
+            void *p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw index_error("cannot map {}: {}", path, std::strerror(errno));
+            }
+            m_data = static_cast<const unsigned char *>(p);
+        }
+        ::close(fd);
+
+        if (m_size < header_size or std::memcmp(m_data, "STIX", 4) != 0 or
+            m_data[4] != version) {
+            unmap();
+            throw index_error("{} is not a version {} shard", path, version);
+        }
+        m_documents = get32(m_data + 8);
+        m_terms = get32(m_data + 12);
+        if (m_size < header_size + std::size_t(m_terms) * entry_size) {
+            unmap();
+            throw index_error("{} is truncated", path);
+        }
+    }
+
+    ~shard() { unmap(); }
+
+    void unmap()
+    {
+        if (m_data != nullptr) {
+            ::munmap(const_cast<unsigned char *>(m_data), m_size);
+            m_data = nullptr;
+        }
+    }
+
+    struct list
+    {
+        const unsigned char *m_begin;
+        const unsigned char *m_end;
+        std::uint32_t m_count;
+    };
+
+    // Binary search of the term table.
+    bool find(term t, list &l) const
+    {
+        const unsigned char *table = m_data + header_size;
+        const unsigned char *postings = table + std::size_t(m_terms) * entry_size;
+        const unsigned char *end = m_data + m_size;
+
+        std::size_t lo = 0;
+        std::size_t hi = m_terms;
+        while (lo < hi) {
+            std::size_t mid = lo + (hi - lo) / 2;
+            term found = get64(table + mid * entry_size);
+            if (found < t) {
+                lo = mid + 1;
+            } else if (t < found) {
+                hi = mid;
+            } else {
+                std::uint64_t offset = get64(table + mid * entry_size + 8);
+                std::uint64_t next = mid + 1 < m_terms
+                    ? get64(table + (mid + 1) * entry_size + 8)
+                    : std::uint64_t(end - postings);
+                if (offset > next or next > std::uint64_t(end - postings)) {
+                    throw index_error("corrupt shard");
+                }
+                l = { postings + offset, postings + next, get32(table + mid * entry_size + 16) };
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::size_t> search(const std::vector<term> &query) const
+    {
+        std::vector<list> lists;
+        for (term t : query) {
+            list l;
+            if (!find(t, l)) {
+                return {};
+            }
+            lists.push_back(l);
+        }
+
+        // Start from the shortest list, so each later pass only filters a
+        // set that is already as small as any one term allows.
+        std::sort(lists.begin(), lists.end(),
+                  [](const list &l1, const list &l2) { return l1.m_count < l2.m_count; });
+
+        std::vector<std::uint32_t> matches;
+        std::uint32_t gap;
+        std::uint32_t document = 0;
+        for (const unsigned char *p = lists.front().m_begin;
+             get_varint(p, lists.front().m_end, gap);) {
+            matches.push_back(document += gap);
+        }
+
+        for (auto l = lists.begin() + 1; l != lists.end() and !matches.empty(); ++l) {
+            std::size_t kept = 0;
+            std::size_t m = 0;
+            document = 0;
+            for (const unsigned char *p = l->m_begin;
+                 m < matches.size() and get_varint(p, l->m_end, gap);) {
+                document += gap;
+                while (m < matches.size() and matches[m] < document) {
+                    ++m;
+                }
+                if (m < matches.size() and matches[m] == document) {
+                    matches[kept++] = matches[m++];
+                }
+            }
+            matches.resize(kept);
+        }
+
+        std::vector<std::size_t> out;
+        for (std::uint32_t d : matches) {
+            if (d < m_documents) {
+                out.push_back(m_first + d);
+            }
+        }
+        return out;
+    }
+};
+
+searcher::searcher(const std::string &directory)
+{
+    std::ifstream meta(directory + "/meta");
+    std::string magic;
+    std::string key;
+    unsigned format = 0;
+    std::size_t shards = 0;
+    if (!(meta >> magic >> format) or magic != "stan-index") {
+        throw index_error("{} is not an index", directory);
+    }
+    if (format != version) {
+        throw index_error("{} is a version {} index, not version {}", directory, format, version);
+    }
+    if (!(meta >> key >> m_length) or key != "length" or !(meta >> key >> shards) or
+        key != "shards") {
+        throw index_error("{} has a malformed meta file", directory);
+    }
+    check_length(m_length);
+
+    std::ifstream documents(directory + "/documents");
+    for (std::string line; std::getline(documents, line);) {
+        m_names.push_back(line);
+    }
+
+    std::size_t first = 0;
+    for (std::size_t s = 0; s < shards; ++s) {
+        m_shards.push_back(std::make_unique<shard>(shard_path(directory, s), first));
+        first += m_shards.back()->m_documents;
+    }
+    if (first != m_names.size()) {
+        throw index_error("{} lists {} documents but its shards hold {}", directory,
+                          m_names.size(), first);
+    }
+}
+
+searcher::~searcher() = default;
+
+std::vector<std::size_t> searcher::search(const sequential &query, unsigned kinds) const
+{
+    std::vector<term> q = terms(query, m_length, kinds);
+    if (q.empty()) {
+        throw index_error("a query needs a run of at least {} notes without rests", m_length);
+    }
+
+    std::vector<std::vector<std::size_t>> found(m_shards.size());
+    parallel_for(0, m_shards.size(), [&](std::size_t s) { found[s] = m_shards[s]->search(q); });
+
+    std::vector<std::size_t> out;
+    for (const auto &f : found) {
+        out.insert(out.end(), f.begin(), f.end());
+    }
+    return out;
+}
+
+} // namespace stan::index
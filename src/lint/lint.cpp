@@ -0,0 +1,273 @@
+#include <stan/lint.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+
+namespace stan::lint {
+
+namespace {
+
+std::string spelling(const pitch &p)
+{
+    return fmt::format("{}{}", pitchclass_names.at(p.m_pitchclass),
+                       static_cast<unsigned>(static_cast<std::uint8_t>(p.m_octave)));
+}
+
+// Sharps, less one per flat or plus one per sharp, as for pitch::midi().
+int accidental(pitchclass pc)
+{
+    auto code = static_cast<std::uint8_t>(pc);
+    int natural = (code >> 4) < 3 ? 4 : 3;
+    return (code & 0x0f) - natural;
+}
+
+bool long_value(const value &v)
+{
+    return v.num() * 4 >= v.den();
+}
+
+} // namespace
+
+void context::report(severity s, std::string message)
+{
+    std::optional<source_span> span;
+    if (m_voice->m_spans and m_preorder < m_voice->m_spans->size()) {
+        span = (*m_voice->m_spans)[m_preorder];
+    }
+    m_out->push_back({ m_rule, s, m_voice_index, m_path, span, std::move(message) });
+}
+
+namespace detail {
+
+struct walker
+{
+    context &m_ctx;
+    dispatch m_visit;
+    void *m_rules;
+    moment m_at;
+    std::size_t m_next = 0;
+
+    static void start(context &ctx, const voice &v, std::size_t index,
+                      std::vector<diagnostic> &out)
+    {
+        static const key c_major(pitchclass::c, mode::major);
+        ctx.m_voice = &v;
+        ctx.m_voice_index = index;
+        ctx.m_out = &out;
+        ctx.m_key = &c_major;
+    }
+
+    void walk(const sequential &music, const moment &scale)
+    {
+        for (std::size_t i = 0; i < music.size(); ++i) {
+            const column &c = music[i];
+            moment start = m_at;
+            moment end = start + scale * moment(duration::zero() + c);
+
+            context &ctx = m_ctx;
+            ctx.m_path.push_back(i);
+            ctx.m_preorder = m_next++;
+            ctx.m_onset = start.ticks();
+            ctx.m_end = end.ticks();
+            while (ctx.m_onset >= ctx.bar_end()) {
+                ctx.m_bar_start += ctx.m_bar_length;
+                ++ctx.m_measure;
+            }
+
+            m_visit(m_rules, c, ctx);
+
+            if (const auto *m = std::get_if<meter>(&c)) {
+                // A change of meter partway through a measure starts a new one.
+                if (ctx.m_onset > ctx.m_bar_start) {
+                    ++ctx.m_measure;
+                    ctx.m_bar_start = ctx.m_onset;
+                }
+                // meter::validate() rejects measures of no length, but a
+                // meter changed after construction could still have one,
+                // and the bars above would then never end; keep the last.
+                int beats = std::accumulate(m->m_beats.begin(), m->m_beats.end(), 0);
+                std::int64_t length = moment(std::uint64_t(beats) * m->m_value.num(),
+                                               m->m_value.den())
+                                          .ticks();
+                if (length > 0) {
+                    ctx.m_bar_length = length;
+                }
+            } else if (const auto *k = std::get_if<key>(&c)) {
+                ctx.m_key = k;
+            } else if (const auto *b = std::get_if<beam>(&c)) {
+                walk(b->m_elements, scale);
+            } else if (const auto *t = std::get_if<tuplet>(&c)) {
+                walk(t->m_elements, scale * time_scale(*t));
+            }
+
+            m_at = end;
+            ctx.m_path.pop_back();
+        }
+    }
+};
+
+void walk(const voice &v, std::size_t index, std::vector<diagnostic> &out, dispatch visit,
+          void *rules)
+{
+    context ctx;
+    walker::start(ctx, v, index, out);
+    walker{ ctx, visit, rules }.walk(*v.m_music, moment(1, 1));
+}
+
+} // namespace detail
+
+void parallel_fifths::visit(const chord &c, context &ctx)
+{
+    std::vector<int> pitches;
+    pitches.reserve(c.m_pitches.size());
+    for (const auto &p : c.m_pitches) {
+        pitches.push_back(p.midi());
+    }
+    std::sort(pitches.begin(), pitches.end());
+
+    if (pitches.size() == m_previous.size()) {
+        for (std::size_t i = 0; i < pitches.size(); ++i) {
+            for (std::size_t j = i + 1; j < pitches.size(); ++j) {
+                int before = m_previous[j] - m_previous[i];
+                int after = pitches[j] - pitches[i];
+                if (before % 12 == 7 and after % 12 == 7 and m_previous[i] != pitches[i]) {
+                    ctx.report(severity::warning,
+                               fmt::format("parallel fifths between voices {} and {}", i + 1,
+                                           j + 1));
+                    m_previous = std::move(pitches);
+                    return;
+                }
+            }
+        }
+    }
+    m_previous = std::move(pitches);
+}
+
+void out_of_range::visit(const note &n, context &ctx)
+{
+    check(n.m_pitch, ctx);
+}
+
+void out_of_range::visit(const chord &c, context &ctx)
+{
+    for (const auto &p : c.m_pitches) {
+        check(p, ctx);
+    }
+}
+
+void out_of_range::check(const pitch &p, context &ctx) const
+{
+    if (p.midi() < m_lowest.midi()) {
+        ctx.report(severity::error, fmt::format("{} is below the lowest note, {}", spelling(p),
+                                                spelling(m_lowest)));
+    } else if (p.midi() > m_highest.midi()) {
+        ctx.report(severity::error, fmt::format("{} is above the highest note, {}", spelling(p),
+                                                spelling(m_highest)));
+    }
+}
+
+namespace {
+
+// Notes and chords under a beam, and whether any directly under it or in its
+// tuplets is too long for one; nested beams are checked on their own.
+void beamed(const sequential &music, bool nested, std::size_t &notes, bool &long_notes)
+{
+    for (const auto &c : music) {
+        if (const auto *n = std::get_if<note>(&c)) {
+            ++notes;
+            long_notes = long_notes or (!nested and long_value(n->m_value));
+        } else if (const auto *ch = std::get_if<chord>(&c)) {
+            ++notes;
+            long_notes = long_notes or (!nested and long_value(ch->m_value));
+        } else if (const auto *b = std::get_if<beam>(&c)) {
+            beamed(b->m_elements, true, notes, long_notes);
+        } else if (const auto *t = std::get_if<tuplet>(&c)) {
+            beamed(t->m_elements, nested, notes, long_notes);
+        }
+    }
+}
+
+} // namespace
+
+void odd_beaming::visit(const beam &b, context &ctx)
+{
+    std::size_t notes = 0;
+    bool long_notes = false;
+    beamed(b.m_elements, false, notes, long_notes);
+
+    if (notes < 2) {
+        ctx.report(severity::warning, "beam over fewer than two notes");
+    }
+    if (long_notes) {
+        ctx.report(severity::warning, "beam over a quarter note or longer");
+    }
+    if (ctx.end() > ctx.bar_end()) {
+        ctx.report(severity::warning, "beam crosses a bar line");
+    }
+}
+
+void bar_length::visit(const meter &, context &ctx)
+{
+    if (ctx.onset() > ctx.bar_start()) {
+        ctx.report(severity::warning,
+                   fmt::format("meter change cuts measure {} short", ctx.measure() + 1));
+    }
+}
+
+void bar_length::overrun(context &ctx) const
+{
+    if (ctx.end() > ctx.bar_end()) {
+        ctx.report(severity::error,
+                   fmt::format("runs over the end of measure {}", ctx.measure() + 1));
+    }
+}
+
+void unnecessary_accidentals::visit(const note &n, context &ctx)
+{
+    check(n.m_pitch, ctx);
+}
+
+void unnecessary_accidentals::visit(const chord &c, context &ctx)
+{
+    for (const auto &p : c.m_pitches) {
+        check(p, ctx);
+    }
+}
+
+void unnecessary_accidentals::check(const pitch &p, context &ctx) const
+{
+    // clang-format off
+    static constexpr const char *naturals[] = { "c", nullptr, "d", nullptr, "e", "f",
+                                                nullptr, "g", nullptr, "a", nullptr, "b" };
+    static constexpr const char *sharps[] = { nullptr, "cs", nullptr, "ds", nullptr, nullptr,
+                                              "fs", nullptr, "gs", nullptr, "as", nullptr };
+    static constexpr const char *flats[] = { nullptr, "df", nullptr, "ef", nullptr, nullptr,
+                                             "gf", nullptr, "af", nullptr, "bf", nullptr };
+    // clang-format on
+
+    int sharp = accidental(p.m_pitchclass);
+    if (sharp == 0 or ctx.key().contains(p)) {
+        return;
+    }
+    int semitone = p.midi() % 12;
+    const char *simpler = naturals[semitone];
+    if (!simpler and std::abs(sharp) == 2) {
+        simpler = sharp > 0 ? sharps[semitone] : flats[semitone];
+    }
+    if (simpler) {
+        ctx.report(severity::warning, fmt::format("{} could be written {}",
+                                                  pitchclass_names.at(p.m_pitchclass), simpler));
+    }
+}
+
+std::vector<diagnostic> check(const std::vector<voice> &voices)
+{
+    static const standard rules(parallel_fifths{}, out_of_range{}, odd_beaming{}, bar_length{},
+                                unnecessary_accidentals{});
+    return rules(voices);
+}
+
+} // namespace stan::lint
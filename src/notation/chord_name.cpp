@@ -0,0 +1,140 @@
+#include <stan/notation/chord_name.hpp>
+#include <stan/notation/equal.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace stan {
+
+namespace {
+
+using chord_qualities::all;
+
+// A quality's semitones above the root, five bits each, then how many there
+// are, so that a pattern from a chord compares equal only if it has as many
+// notes.  Offsets of 32 or more match no quality.
+constexpr std::uint64_t pattern(const chord_quality &q)
+{
+    std::uint64_t p = 0;
+    for (std::size_t i = 0; i < q.m_size; ++i) {
+        p = p * 32 + static_cast<std::uint64_t>(q.m_intervals[i].m_semitones);
+    }
+    return p * 8 + q.m_size;
+}
+
+// Every quality's pattern, times 32 plus its place in the table, ascending,
+// so that recognizing a root position chord is one binary search.
+constexpr std::array<std::uint64_t, all.size()> sorted_patterns()
+{
+    std::array<std::uint64_t, all.size()> out{};
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        std::uint64_t p = pattern(all[i]) * 32 + i;
+        std::size_t j = i;
+        for (; j > 0 and out[j - 1] > p; --j) {
+            out[j] = out[j - 1];
+        }
+        out[j] = p;
+    }
+    return out;
+}
+
+constexpr std::array<std::uint64_t, all.size()> patterns = sorted_patterns();
+
+constexpr bool distinct()
+{
+    for (std::size_t i = 1; i < patterns.size(); ++i) {
+        if (patterns[i - 1] / 32 == patterns[i] / 32) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(all.size() <= 32 and distinct(), "chord qualities must differ in semitones");
+
+const chord_quality *recognize(const std::vector<pitch> &pitches)
+{
+    if (pitches.size() > all.front().m_intervals.size()) {
+        return nullptr;
+    }
+    std::uint64_t p = 0;
+    for (const auto &n : pitches) {
+        int offset = n.midi() - pitches.front().midi();
+        if (offset < 0 or offset >= 32) {
+            return nullptr;
+        }
+        p = p * 32 + static_cast<std::uint64_t>(offset);
+    }
+    p = p * 8 + pitches.size();
+
+    auto found = std::lower_bound(patterns.begin(), patterns.end(), p * 32);
+    if (found == patterns.end() or *found / 32 != p) {
+        return nullptr;
+    }
+    return &all[*found % 32];
+}
+
+} // namespace
+
+chord spell(const value &v, const chord_name &n)
+{
+    std::vector<pitch> pitches;
+    for (std::size_t i = 0; i < n.m_quality->m_size; ++i) {
+        pitch p = n.m_root + n.m_quality->m_intervals[i];
+        if (!n.m_bass or p.m_pitchclass != *n.m_bass) {
+            pitches.push_back(p);
+        }
+    }
+
+    if (n.m_bass) {
+        // Stacked intervals ascend, so the first pitch left is the lowest, and
+        // every quality has at least two pitch classes.
+        pitch lowest = pitches.front();
+        pitch bass(*n.m_bass, lowest.m_octave);
+        if (!(bass < lowest)) {
+            if (lowest.m_octave == octave(0)) {
+                throw invalid_chord("no octave for the bass below {}", lowest.midi());
+            }
+            bass = pitch(*n.m_bass, lowest.m_octave - octave(1));
+        }
+        pitches.insert(pitches.begin(), bass);
+    }
+    return chord(v, std::move(pitches));
+}
+
+namespace {
+
+// Whether a name spells exactly the pitches of a chord.  A chord with the
+// right semitones can still be spelled too far from the name's to build.
+bool spells(const chord_name &n, const chord &c)
+{
+    try {
+        return spell(c.m_value, n).m_pitches == c.m_pitches;
+    } catch (exception &) {
+        return false;
+    }
+}
+
+} // namespace
+
+std::optional<chord_name> name_of(const chord &c)
+{
+    const auto &pitches = c.m_pitches;
+    if (const chord_quality *q = recognize(pitches)) {
+        chord_name n{ pitches.front(), q, std::nullopt };
+        if (spells(n, c)) {
+            return n;
+        }
+    }
+
+    // The bass below a chord, moved down from it or added.
+    for (const auto &q : all) {
+        chord_name n{ pitches[1], &q, pitches.front().m_pitchclass };
+        if (spells(n, c)) {
+            return n;
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace stan
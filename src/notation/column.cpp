@@ -4,6 +4,8 @@
 #include <stan/driver/debug.hpp>
 #include <stan/driver/lilypond.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <numeric>
 
 namespace stan {
@@ -32,6 +34,125 @@ duration operator+(stan::duration const &d, stan::column const &c)
     return d + std::visit(get_duration(), c);
 }
 
+namespace {
+
+// Every note value, tuplets included, is a multiple of a power of two
+// fraction of a whole note, so positions in a measure are exact in ticks.
+constexpr std::uint64_t ticks_per_whole = 1u << 20;
+
+std::uint64_t ticks(const duration &d)
+{
+    return std::uint64_t(d.num()) * (ticks_per_whole / d.den());
+}
+
+} // namespace
+
+std::vector<std::size_t> measures(const sequential &music)
+{
+    std::uint64_t bar = ticks_per_whole;
+    std::uint64_t position = 0;
+    std::size_t measure = 0;
+
+    std::vector<std::size_t> out;
+    out.reserve(music.size());
+    for (const auto &c : music) {
+        if (const auto *m = std::get_if<stan::meter>(&c)) {
+            std::uint64_t beats = std::accumulate(m->m_beats.begin(), m->m_beats.end(), 0u);
+            bar = beats * ticks(m->m_value);
+            if (position != 0) {
+                // A change of meter mid measure starts a new one.
+                ++measure;
+                position = 0;
+            }
+        }
+        out.push_back(measure);
+
+        for (position += ticks(duration::zero() + c); position >= bar; position -= bar) {
+            ++measure;
+        }
+    }
+    return out;
+}
+
+std::size_t note_count(const sequential &music)
+{
+    std::size_t count = 0;
+    for (const auto &c : music) {
+        if (const auto *b = std::get_if<beam>(&c)) {
+            count += note_count(b->m_elements);
+        } else if (const auto *t = std::get_if<tuplet>(&c)) {
+            count += note_count(t->m_elements);
+        } else if (std::holds_alternative<note>(c) or std::holds_alternative<chord>(c)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+moment::moment(std::uint64_t num, std::uint64_t den)
+{
+    std::uint64_t g = std::max<std::uint64_t>(1, std::gcd(num, den));
+    m_num = num / g;
+    m_den = den / g;
+}
+
+moment::moment(const duration &d) : moment(d.num(), d.den()) {}
+
+moment operator+(const moment &m1, const moment &m2)
+{
+    std::uint64_t den = std::lcm(m1.m_den, m2.m_den);
+    return { m1.m_num * (den / m1.m_den) + m2.m_num * (den / m2.m_den), den };
+}
+
+moment operator*(const moment &m1, const moment &m2)
+{
+    return { m1.m_num * m2.m_num, m1.m_den * m2.m_den };
+}
+
+std::int64_t moment::ticks() const
+{
+    constexpr std::uint64_t per_whole = 4 * ticks_per_quarter;
+    return static_cast<std::int64_t>((2 * m_num * per_whole + m_den) / (2 * m_den));
+}
+
+moment time_scale(const tuplet &t)
+{
+    duration inner = std::accumulate(t.m_elements.begin(), t.m_elements.end(),
+                                     duration::zero());
+    return { std::uint64_t(t.m_value.num()) * inner.den(),
+             std::uint64_t(t.m_value.den()) * inner.num() };
+}
+
+namespace {
+
+void note_times(const sequential &music, const moment &scale, moment &at,
+                std::vector<note_time> &out)
+{
+    for (const auto &c : music) {
+        if (const auto *b = std::get_if<beam>(&c)) {
+            note_times(b->m_elements, scale, at, out);
+        } else if (const auto *t = std::get_if<tuplet>(&c)) {
+            note_times(t->m_elements, scale * time_scale(*t), at, out);
+        } else {
+            moment end = at + scale * moment(duration::zero() + c);
+            if (std::holds_alternative<note>(c) or std::holds_alternative<chord>(c)) {
+                out.push_back({ at.ticks(), end.ticks() });
+            }
+            at = end;
+        }
+    }
+}
+
+} // namespace
+
+std::vector<note_time> note_times(const sequential &music)
+{
+    std::vector<note_time> out;
+    moment at;
+    note_times(music, moment(1, 1), at, out);
+    return out;
+}
+
 value tuplet::scale(int num, int den, const duration &inner)
 {
     stan::duration outer(inner.num() * den, inner.den() * num);
@@ -60,7 +181,7 @@ void tuplet::validate() const
 
 void meter::validate() const
 {
-    static std::set<value> valid_values{
+    constexpr std::array<value, 5> valid_values{
         value::half(),
         value::quarter(),
         value::eighth(),
@@ -71,7 +192,11 @@ void meter::validate() const
     if (m_beats.empty()) {
         throw invalid_meter("no beats");
     }
-    if (valid_values.count(m_value) == 0) {
+    if (std::accumulate(m_beats.begin(), m_beats.end(), 0u) == 0) {
+        throw invalid_meter("measures of no beats");
+    }
+    if (std::find(valid_values.begin(), valid_values.end(), m_value) ==
+        valid_values.end()) {
         throw invalid_meter(
             "value must be half, quarter, eighth, sixteenth, or thirtysecond");
     }
@@ -0,0 +1,66 @@
+#include <stan/notation/interval.hpp>
+
+namespace stan {
+
+namespace {
+
+// The high nibble of a pitchclass is its letter, c = 0 through b = 6, and
+// the low nibble is 4 for natural c, d and e and 3 for the other letters,
+// less one per flat or plus one per sharp.
+constexpr int semitones[] = { 0, 2, 4, 5, 7, 9, 11 };
+
+int letter(pitchclass pc) { return static_cast<std::uint8_t>(pc) >> 4; }
+int natural(int letter) { return letter < 3 ? 4 : 3; }
+int alteration(pitchclass pc)
+{
+    return (static_cast<std::uint8_t>(pc) & 0x0f) - natural(letter(pc));
+}
+
+pitchclass spell(int letter, int alteration)
+{
+    if (alteration < -2 or alteration > 2) {
+        throw invalid_interval("alteration of {} semitones", alteration);
+    }
+    return static_cast<pitchclass>((letter << 4) | (natural(letter) + alteration));
+}
+
+int floor_div(int n, int d) { return n / d - (n % d < 0 ? 1 : 0); }
+int floor_mod(int n, int d) { return n - d * floor_div(n, d); }
+
+} // namespace
+
+pitch operator+(const pitch &p, const interval &i)
+{
+    int steps = static_cast<std::uint8_t>(p.m_octave) * 7 + letter(p.m_pitchclass) + i.m_steps;
+    int l = floor_mod(steps, 7);
+    int o = floor_div(steps, 7);
+    if (o < 0 or o > 9) {
+        throw invalid_interval("octave {}", o);
+    }
+    int target = p.midi() + i.m_semitones;
+    int written = 12 * (o + 1) + semitones[l];
+    return pitch(spell(l, target - written), octave(static_cast<std::uint8_t>(o)));
+}
+
+pitch operator-(const pitch &p, const interval &i)
+{
+    return p + -i;
+}
+
+pitchclass operator+(pitchclass pc, const interval &i)
+{
+    int l = floor_mod(letter(pc) + i.m_steps, 7);
+    int target = semitones[letter(pc)] + alteration(pc) + i.m_semitones;
+    // The alteration is the difference of two semitones counts, which can be
+    // an octave apart when the letters wrap.
+    return spell(l, floor_mod(target - semitones[l] + 6, 12) - 6);
+}
+
+interval operator-(const pitch &p1, const pitch &p2)
+{
+    int steps = (static_cast<std::uint8_t>(p1.m_octave) - static_cast<std::uint8_t>(p2.m_octave)) * 7 +
+                letter(p1.m_pitchclass) - letter(p2.m_pitchclass);
+    return { static_cast<std::int8_t>(steps), static_cast<std::int8_t>(p1.midi() - p2.midi()) };
+}
+
+} // namespace stan
@@ -0,0 +1,58 @@
+#include <stan/notation/lyrics.hpp>
+
+#include <algorithm>
+
+namespace stan {
+
+void lyrics::add(std::uint32_t note, std::string_view text, join j)
+{
+    add_with(note, [&](std::string &pool) { pool.append(text); }, j);
+}
+
+void lyrics::check(std::uint32_t note) const
+{
+    if (!m_syllables.empty() and note <= m_syllables.back().m_note) {
+        throw invalid_lyrics("syllable for note {} after one for note {}", note,
+                             m_syllables.back().m_note);
+    }
+}
+
+void lyrics::push(std::uint32_t note, std::size_t start, join j)
+{
+    std::size_t length = m_pool.size() - start;
+    if (length > UINT16_MAX) {
+        throw invalid_lyrics("syllable of {} bytes", length);
+    }
+    if (m_pool.size() > UINT32_MAX) {
+        throw invalid_lyrics("more than 4GiB of text");
+    }
+    m_syllables.push_back({ note, static_cast<std::uint32_t>(start),
+                            static_cast<std::uint16_t>(length), j });
+}
+
+void lyrics::set_join(join j)
+{
+    if (m_syllables.empty()) {
+        throw invalid_lyrics("no syllable to join from");
+    }
+    m_syllables.back().m_join = j;
+}
+
+const lyrics::syllable *lyrics::find(std::uint32_t note) const
+{
+    auto found = std::lower_bound(m_syllables.begin(), m_syllables.end(), note,
+                                  [](const syllable &s, std::uint32_t n) { return s.m_note < n; });
+    return found != m_syllables.end() and found->m_note == note ? &*found : nullptr;
+}
+
+bool operator==(const lyrics &l1, const lyrics &l2)
+{
+    return std::equal(l1.m_syllables.begin(), l1.m_syllables.end(), l2.m_syllables.begin(),
+                      l2.m_syllables.end(),
+                      [&](const lyrics::syllable &s1, const lyrics::syllable &s2) {
+                          return s1.m_note == s2.m_note and s1.m_join == s2.m_join and
+                                 l1.text(s1) == l2.text(s2);
+                      });
+}
+
+} // namespace stan
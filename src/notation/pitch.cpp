@@ -2,48 +2,9 @@
 #include <stan/exception.hpp>
 
 #include <algorithm>
-#include <map>
 
 namespace stan {
 
-const std::map<pitchclass, const char *> pitchclass_names = {
-    { pitchclass::cff, "cff" },
-    { pitchclass::cf, "cf" },
-    { pitchclass::c, "c" },
-    { pitchclass::cs, "cs" },
-    { pitchclass::css, "css" },
-    { pitchclass::dff, "dff" },
-    { pitchclass::df, "df" },
-    { pitchclass::d, "d" },
-    { pitchclass::ds, "ds" },
-    { pitchclass::dss, "dss" },
-    { pitchclass::eff, "eff" },
-    { pitchclass::ef, "ef" },
-    { pitchclass::e, "e" },
-    { pitchclass::es, "es" },
-    { pitchclass::ess, "ess" },
-    { pitchclass::fff, "fff" },
-    { pitchclass::ff, "ff" },
-    { pitchclass::f, "f" },
-    { pitchclass::fs, "fs" },
-    { pitchclass::fss, "fss" },
-    { pitchclass::gff, "gff" },
-    { pitchclass::gf, "gf" },
-    { pitchclass::g, "g" },
-    { pitchclass::gs, "gs" },
-    { pitchclass::gss, "gss" },
-    { pitchclass::aff, "aff" },
-    { pitchclass::af, "af" },
-    { pitchclass::a, "a" },
-    { pitchclass::as, "as" },
-    { pitchclass::ass, "ass" },
-    { pitchclass::bff, "bff" },
-    { pitchclass::bf, "bf" },
-    { pitchclass::b, "b" },
-    { pitchclass::bs, "bs" },
-    { pitchclass::bss, "bss" }
-};
-
 valid_pitchclass::valid_pitchclass()
 {
     for (auto [key, value] : pitchclass_names) {
@@ -53,51 +14,27 @@ valid_pitchclass::valid_pitchclass()
 
 staffline pitch::get_staffline() const
 {
-    // Compute the staff line offset, referenced to C4=0.
-
-    static const std::map<pitchclass, std::uint8_t> line{
-        { pitchclass::cff, 0 },
-        { pitchclass::cf, 0 },
-        { pitchclass::c, 0 },
-        { pitchclass::cs, 0 },
-        { pitchclass::css, 0 },
-        { pitchclass::dff, 1 },
-        { pitchclass::df, 1 },
-        { pitchclass::d, 1 },
-        { pitchclass::ds, 1 },
-        { pitchclass::dss, 1 },
-        { pitchclass::eff, 2 },
-        { pitchclass::ef, 2 },
-        { pitchclass::e, 2 },
-        { pitchclass::es, 2 },
-        { pitchclass::ess, 2 },
-        { pitchclass::fff, 3 },
-        { pitchclass::ff, 3 },
-        { pitchclass::f, 3 },
-        { pitchclass::fs, 3 },
-        { pitchclass::fss, 3 },
-        { pitchclass::gff, 4 },
-        { pitchclass::gf, 4 },
-        { pitchclass::g, 4 },
-        { pitchclass::gs, 4 },
-        { pitchclass::gss, 4 },
-        { pitchclass::aff, 5 },
-        { pitchclass::af, 5 },
-        { pitchclass::a, 5 },
-        { pitchclass::as, 5 },
-        { pitchclass::ass, 5 },
-        { pitchclass::bff, 6 },
-        { pitchclass::bf, 6 },
-        { pitchclass::b, 6 },
-        { pitchclass::bs, 6 },
-        { pitchclass::bss, 6 }
-    };
+    // Compute the staff line offset, referenced to C4=0.  The high nibble of
+    // every pitchclass code is its letter name (c=0 through b=6), so the line
+    // falls straight out of the encoding without a lookup table.
 
-    static const octave middle_C(4);
-    return staffline(line.at(m_pitchclass) +
+    constexpr octave middle_C(4);
+    return staffline((static_cast<std::uint8_t>(m_pitchclass) >> 4) +
                      (static_cast<std::uint8_t>(m_octave - middle_C)) * 7);
 };
 
+int pitch::midi() const
+{
+    // The low nibble of a pitchclass is 4 for natural c, d and e and 3 for
+    // the other letters, less one per flat or plus one per sharp.
+    constexpr int letters[] = { 0, 2, 4, 5, 7, 9, 11 };
+    auto code = static_cast<std::uint8_t>(m_pitchclass);
+    int letter = code >> 4;
+    int natural = letter < 3 ? 4 : 3;
+    return 12 * (static_cast<std::uint8_t>(m_octave) + 1) + letters[letter] + (code & 0x0f) -
+        natural;
+}
+
 bool operator<(const pitch &p1, const pitch &p2)
 {
     if (p1.m_octave != p2.m_octave) {
@@ -0,0 +1,445 @@
+#include <stan/notation.hpp>
+#include <stan/notation/rope.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace stan {
+
+namespace {
+
+// Nodes split above the maximum width and merge with or borrow from a
+// neighbour below the minimum; a tree built from a list fills them to
+// three quarters.
+constexpr std::size_t max_width = 64;
+constexpr std::size_t min_width = max_width / 4;
+constexpr std::size_t fill_width = max_width * 3 / 4;
+
+// The length of a column in ticks, rounded as stan::note_times() rounds.
+std::int64_t length(const column &c)
+{
+    return moment(duration::zero() + c).ticks();
+}
+
+// Moves elements across the boundary between two neighbouring vectors until
+// the first holds n of them.
+template <typename T>
+void shift(std::vector<T> &left, std::vector<T> &right, std::size_t n)
+{
+    if (left.size() < n) {
+        auto last = right.begin() + (n - left.size());
+        left.insert(left.end(), std::make_move_iterator(right.begin()),
+                    std::make_move_iterator(last));
+        right.erase(right.begin(), last);
+    } else if (left.size() > n) {
+        auto first = left.begin() + n;
+        right.insert(right.begin(), std::make_move_iterator(first),
+                     std::make_move_iterator(left.end()));
+        left.erase(first, left.end());
+    }
+}
+
+void out_of_range(std::size_t i, std::size_t size)
+{
+    throw std::out_of_range("rope: position " + std::to_string(i) + " past size " +
+                            std::to_string(size));
+}
+
+} // namespace
+
+rope::const_iterator &rope::const_iterator::operator++()
+{
+    if (++m_index == m_leaf->m_columns.size() and m_leaf->m_next) {
+        m_leaf = m_leaf->m_next;
+        m_index = 0;
+    }
+    return *this;
+}
+
+rope::const_iterator &rope::const_iterator::operator--()
+{
+    if (m_index == 0) {
+        m_leaf = m_leaf->m_prev;
+        m_index = m_leaf->m_columns.size();
+    }
+    --m_index;
+    return *this;
+}
+
+rope::rope() = default;
+
+rope::rope(const sequential &music)
+{
+    if (music.empty()) {
+        return;
+    }
+
+    // Spreads n items evenly over as few nodes as hold fill_width each, so
+    // that no node but a lone root is below the minimum.
+    auto groups = [](std::size_t n) { return (n + fill_width - 1) / fill_width; };
+
+    std::vector<std::unique_ptr<node>> level;
+    std::size_t leaves = groups(music.size());
+    node *prev = nullptr;
+    for (std::size_t g = 0, first = 0; g < leaves; ++g) {
+        std::size_t last = music.size() * (g + 1) / leaves;
+        auto leaf = std::make_unique<node>();
+        leaf->m_leaf = true;
+        leaf->m_columns.assign(music.begin() + first, music.begin() + last);
+        leaf->m_prev = prev;
+        if (prev) {
+            prev->m_next = leaf.get();
+        }
+        prev = leaf.get();
+        level.push_back(std::move(leaf));
+        first = last;
+    }
+
+    while (level.size() > 1) {
+        std::vector<std::unique_ptr<node>> up;
+        std::size_t branches = groups(level.size());
+        for (std::size_t g = 0, first = 0; g < branches; ++g) {
+            std::size_t last = level.size() * (g + 1) / branches;
+            auto branch = std::make_unique<node>();
+            branch->m_leaf = false;
+            for (std::size_t i = first; i < last; ++i) {
+                branch->m_children.push_back(std::move(level[i]));
+                branch->m_counts.push_back(0);
+                branch->m_ticks.push_back(0);
+                recount(*branch, branch->m_children.size() - 1);
+            }
+            up.push_back(std::move(branch));
+            first = last;
+        }
+        level = std::move(up);
+    }
+
+    m_root = std::move(level.front());
+    m_size = music.size();
+    for (const auto &c : music) {
+        m_ticks += length(c);
+    }
+}
+
+rope::rope(const rope &r) : rope(r.flatten()) {}
+
+rope::rope(rope &&r) noexcept :
+    m_root(std::move(r.m_root)),
+    m_size(std::exchange(r.m_size, 0)),
+    m_ticks(std::exchange(r.m_ticks, 0))
+{
+}
+
+rope &rope::operator=(const rope &r)
+{
+    if (this != &r) {
+        *this = rope(r);
+    }
+    return *this;
+}
+
+rope &rope::operator=(rope &&r) noexcept
+{
+    m_root = std::move(r.m_root);
+    m_size = std::exchange(r.m_size, 0);
+    m_ticks = std::exchange(r.m_ticks, 0);
+    return *this;
+}
+
+rope::~rope() = default;
+
+const column &rope::operator[](std::size_t i) const
+{
+    const node *n = m_root.get();
+    while (!n->m_leaf) {
+        std::size_t k = 0;
+        while (i >= n->m_counts[k]) {
+            i -= n->m_counts[k++];
+        }
+        n = n->m_children[k].get();
+    }
+    return n->m_columns[i];
+}
+
+const column &rope::at(std::size_t i) const
+{
+    if (i >= m_size) {
+        out_of_range(i, m_size);
+    }
+    return (*this)[i];
+}
+
+void rope::recount(node &parent, std::size_t child)
+{
+    const node &n = *parent.m_children[child];
+    std::size_t count = 0;
+    std::int64_t ticks = 0;
+    if (n.m_leaf) {
+        count = n.m_columns.size();
+        for (const auto &c : n.m_columns) {
+            ticks += length(c);
+        }
+    } else {
+        for (std::size_t k = 0; k < n.m_children.size(); ++k) {
+            count += n.m_counts[k];
+            ticks += n.m_ticks[k];
+        }
+    }
+    parent.m_counts[child] = count;
+    parent.m_ticks[child] = ticks;
+}
+
+std::unique_ptr<rope::node> rope::split(node &n)
+{
+    auto right = std::make_unique<node>();
+    right->m_leaf = n.m_leaf;
+    std::size_t half = n.width() / 2;
+    if (n.m_leaf) {
+        shift(n.m_columns, right->m_columns, half);
+        right->m_prev = &n;
+        right->m_next = n.m_next;
+        if (n.m_next) {
+            n.m_next->m_prev = right.get();
+        }
+        n.m_next = right.get();
+    } else {
+        shift(n.m_children, right->m_children, half);
+        shift(n.m_counts, right->m_counts, half);
+        shift(n.m_ticks, right->m_ticks, half);
+    }
+    return right;
+}
+
+std::unique_ptr<rope::node> rope::insert(node &n, std::size_t i, column &c, std::int64_t ticks)
+{
+    if (n.m_leaf) {
+        n.m_columns.insert(n.m_columns.begin() + i, std::move(c));
+    } else {
+        // At the end of a child rather than the start of the next, so that
+        // appending stays on the rightmost path.
+        std::size_t k = 0;
+        while (i > n.m_counts[k]) {
+            i -= n.m_counts[k++];
+        }
+        if (auto right = insert(*n.m_children[k], i, c, ticks)) {
+            n.m_children.insert(n.m_children.begin() + k + 1, std::move(right));
+            n.m_counts.insert(n.m_counts.begin() + k + 1, 0);
+            n.m_ticks.insert(n.m_ticks.begin() + k + 1, 0);
+            recount(n, k);
+            recount(n, k + 1);
+        } else {
+            n.m_counts[k] += 1;
+            n.m_ticks[k] += ticks;
+        }
+    }
+    return n.width() > max_width ? split(n) : nullptr;
+}
+
+void rope::insert(std::size_t i, column c)
+{
+    if (i > m_size) {
+        out_of_range(i, m_size);
+    }
+    if (!m_root) {
+        m_root = std::make_unique<node>();
+        m_root->m_leaf = true;
+    }
+
+    std::int64_t ticks = length(c);
+    if (auto right = insert(*m_root, i, c, ticks)) {
+        auto root = std::make_unique<node>();
+        root->m_leaf = false;
+        root->m_children.push_back(std::move(m_root));
+        root->m_children.push_back(std::move(right));
+        root->m_counts.assign(2, 0);
+        root->m_ticks.assign(2, 0);
+        recount(*root, 0);
+        recount(*root, 1);
+        m_root = std::move(root);
+    }
+    m_size += 1;
+    m_ticks += ticks;
+}
+
+void rope::rebalance(node &parent, std::size_t child)
+{
+    std::size_t l = child > 0 ? child - 1 : child;
+    node &left = *parent.m_children[l];
+    node &right = *parent.m_children[l + 1];
+    std::size_t total = left.width() + right.width();
+    std::size_t n = total <= max_width ? total : total / 2;
+
+    if (left.m_leaf) {
+        shift(left.m_columns, right.m_columns, n);
+    } else {
+        shift(left.m_children, right.m_children, n);
+        shift(left.m_counts, right.m_counts, n);
+        shift(left.m_ticks, right.m_ticks, n);
+    }
+
+    if (n == total) {
+        if (left.m_leaf) {
+            left.m_next = right.m_next;
+            if (right.m_next) {
+                right.m_next->m_prev = &left;
+            }
+        }
+        parent.m_children.erase(parent.m_children.begin() + l + 1);
+        parent.m_counts.erase(parent.m_counts.begin() + l + 1);
+        parent.m_ticks.erase(parent.m_ticks.begin() + l + 1);
+    } else {
+        recount(parent, l + 1);
+    }
+    recount(parent, l);
+}
+
+std::int64_t rope::erase(node &n, std::size_t i)
+{
+    if (n.m_leaf) {
+        std::int64_t ticks = length(n.m_columns[i]);
+        n.m_columns.erase(n.m_columns.begin() + i);
+        return ticks;
+    }
+
+    std::size_t k = 0;
+    while (i >= n.m_counts[k]) {
+        i -= n.m_counts[k++];
+    }
+    std::int64_t ticks = erase(*n.m_children[k], i);
+    n.m_counts[k] -= 1;
+    n.m_ticks[k] -= ticks;
+    if (n.m_children[k]->width() < min_width) {
+        rebalance(n, k);
+    }
+    return ticks;
+}
+
+void rope::erase(std::size_t i)
+{
+    if (i >= m_size) {
+        out_of_range(i, m_size);
+    }
+    m_ticks -= erase(*m_root, i);
+    m_size -= 1;
+    if (!m_root->m_leaf and m_root->m_children.size() == 1) {
+        m_root = std::move(m_root->m_children.front());
+    }
+}
+
+std::int64_t rope::replace(node &n, std::size_t i, column &c, std::int64_t ticks)
+{
+    if (n.m_leaf) {
+        std::int64_t change = ticks - length(n.m_columns[i]);
+        n.m_columns[i] = std::move(c);
+        return change;
+    }
+
+    std::size_t k = 0;
+    while (i >= n.m_counts[k]) {
+        i -= n.m_counts[k++];
+    }
+    std::int64_t change = replace(*n.m_children[k], i, c, ticks);
+    n.m_ticks[k] += change;
+    return change;
+}
+
+void rope::replace(std::size_t i, column c)
+{
+    if (i >= m_size) {
+        out_of_range(i, m_size);
+    }
+    std::int64_t ticks = length(c);
+    m_ticks += replace(*m_root, i, c, ticks);
+}
+
+std::int64_t rope::onset(std::size_t i) const
+{
+    if (i > m_size) {
+        out_of_range(i, m_size);
+    }
+    if (i == m_size) {
+        return m_ticks;
+    }
+
+    std::int64_t ticks = 0;
+    const node *n = m_root.get();
+    while (!n->m_leaf) {
+        std::size_t k = 0;
+        while (i >= n->m_counts[k]) {
+            i -= n->m_counts[k];
+            ticks += n->m_ticks[k++];
+        }
+        n = n->m_children[k].get();
+    }
+    for (std::size_t j = 0; j < i; ++j) {
+        ticks += length(n->m_columns[j]);
+    }
+    return ticks;
+}
+
+std::size_t rope::at_time(std::int64_t t) const
+{
+    // Before the start reads as the start, and an empty rope has no root to
+    // walk: it takes no time, so any tick is at its end.
+    t = std::max<std::int64_t>(t, 0);
+    if (t >= m_ticks) {
+        return m_size;
+    }
+
+    std::size_t index = 0;
+    const node *n = m_root.get();
+    while (!n->m_leaf) {
+        std::size_t k = 0;
+        while (t >= n->m_ticks[k]) {
+            t -= n->m_ticks[k];
+            index += n->m_counts[k++];
+        }
+        n = n->m_children[k].get();
+    }
+    for (const auto &c : n->m_columns) {
+        std::int64_t ticks = length(c);
+        if (t < ticks) {
+            break;
+        }
+        t -= ticks;
+        ++index;
+    }
+    return index;
+}
+
+rope::const_iterator rope::begin() const
+{
+    if (!m_root) {
+        return {};
+    }
+    const node *n = m_root.get();
+    while (!n->m_leaf) {
+        n = n->m_children.front().get();
+    }
+    return { n, 0 };
+}
+
+rope::const_iterator rope::end() const
+{
+    if (!m_root) {
+        return {};
+    }
+    const node *n = m_root.get();
+    while (!n->m_leaf) {
+        n = n->m_children.back().get();
+    }
+    return { n, n->m_columns.size() };
+}
+
+sequential rope::flatten() const
+{
+    sequential music;
+    music.reserve(m_size);
+    for (const node *n = begin().m_leaf; n; n = n->m_next) {
+        music.insert(music.end(), n->m_columns.begin(), n->m_columns.end());
+    }
+    return music;
+}
+
+} // namespace stan
@@ -0,0 +1,71 @@
+#include <stan/notation.hpp>
+
+#include <algorithm>
+
+namespace stan {
+
+namespace {
+
+interval_tree<std::uint32_t> index_notes(const std::vector<spanner> &spanners)
+{
+    std::vector<interval_tree<std::uint32_t>::interval> intervals;
+    intervals.reserve(spanners.size());
+    for (std::size_t i = 0; i < spanners.size(); ++i) {
+        intervals.push_back(
+            { spanners[i].m_first, spanners[i].m_last, static_cast<std::uint32_t>(i) });
+    }
+    return interval_tree<std::uint32_t>(std::move(intervals));
+}
+
+interval_tree<std::int64_t> index_times(const score &s)
+{
+    std::vector<interval_tree<std::int64_t>::interval> intervals;
+    if (s.m_spanners.empty()) {
+        return {};
+    }
+
+    // Closed intervals of ticks, so a spanner ends the tick before its last
+    // note does.
+    std::vector<note_time> times = note_times(s.m_music);
+    intervals.reserve(s.m_spanners.size());
+    for (std::size_t i = 0; i < s.m_spanners.size(); ++i) {
+        std::int64_t onset = times.at(s.m_spanners[i].m_first).m_onset;
+        std::int64_t end = times.at(s.m_spanners[i].m_last).m_end;
+        intervals.push_back({ onset, std::max(onset, end - 1), static_cast<std::uint32_t>(i) });
+    }
+    return interval_tree<std::int64_t>(std::move(intervals));
+}
+
+} // namespace
+
+spanner_index::spanner_index(const score &s) :
+    m_spanners(s.m_spanners), m_notes(index_notes(s.m_spanners)), m_times(index_times(s))
+{
+}
+
+std::vector<const spanner *> spanner_index::notes(std::uint32_t first, std::uint32_t last) const
+{
+    std::vector<std::uint32_t> ids;
+    m_notes.overlapping(first, last, [&](std::uint32_t id) { ids.push_back(id); });
+    return collect(std::move(ids));
+}
+
+std::vector<const spanner *> spanner_index::times(std::int64_t begin, std::int64_t end) const
+{
+    std::vector<std::uint32_t> ids;
+    m_times.overlapping(begin, end - 1, [&](std::uint32_t id) { ids.push_back(id); });
+    return collect(std::move(ids));
+}
+
+std::vector<const spanner *> spanner_index::collect(std::vector<std::uint32_t> ids) const
+{
+    std::sort(ids.begin(), ids.end());
+    std::vector<const spanner *> out;
+    out.reserve(ids.size());
+    for (std::uint32_t id : ids) {
+        out.push_back(&m_spanners[id]);
+    }
+    return out;
+}
+
+} // namespace stan
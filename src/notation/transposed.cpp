@@ -0,0 +1,139 @@
+#include <stan/notation.hpp>
+#include <stan/notation/transposed.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace stan {
+
+namespace {
+
+struct transposer
+{
+    const interval &m_interval;
+
+    column operator()(const note &n) const { return note(n.m_value, n.m_pitch + m_interval); }
+
+    column operator()(const chord &c) const
+    {
+        std::vector<pitch> pitches;
+        pitches.reserve(c.m_pitches.size());
+        for (const auto &p : c.m_pitches) {
+            pitches.push_back(p + m_interval);
+        }
+        return chord(c.m_value, std::move(pitches));
+    }
+
+    column operator()(const beam &b) const { return beam(transpose(b.m_elements, m_interval)); }
+
+    column operator()(const tuplet &t) const
+    {
+        return tuplet(t.m_value, transpose(t.m_elements, m_interval));
+    }
+
+    column operator()(const key &k) const { return key(k.m_tonic + m_interval, k.m_mode); }
+
+    template <typename C>
+    column operator()(const C &c) const
+    {
+        return c;
+    }
+};
+
+// Whether transposing changes a column at all.
+bool pitched(const column &c)
+{
+    if (const auto *b = std::get_if<beam>(&c)) {
+        return std::any_of(b->m_elements.begin(), b->m_elements.end(), pitched);
+    }
+    if (const auto *t = std::get_if<tuplet>(&c)) {
+        return std::any_of(t->m_elements.begin(), t->m_elements.end(), pitched);
+    }
+    return std::holds_alternative<note>(c) or std::holds_alternative<chord>(c) or
+           std::holds_alternative<key>(c);
+}
+
+} // namespace
+
+column transpose(const column &c, const interval &i)
+{
+    return std::visit(transposer{ i }, c);
+}
+
+namespace {
+
+// What a view moved from reads.
+const sequential nothing;
+
+} // namespace
+
+sequential transpose(const sequential &music, const interval &i)
+{
+    sequential out;
+    out.reserve(music.size());
+    for (const auto &c : music) {
+        out.push_back(transpose(c, i));
+    }
+    return out;
+}
+
+transposed::transposed(const sequential &music, const interval &by) :
+    m_music(&music), m_interval(by), m_cache(new std::atomic<const column *>[music.size()])
+{
+    for (std::size_t i = 0; i < music.size(); ++i) {
+        m_cache[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+transposed::transposed(transposed &&t) noexcept :
+    m_music(t.m_music), m_interval(t.m_interval), m_cache(std::move(t.m_cache))
+{
+    t.m_music = &nothing;
+}
+
+transposed::~transposed()
+{
+    if (m_cache) {
+        for (std::size_t i = 0; i < size(); ++i) {
+            delete m_cache[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+const column &transposed::operator[](std::size_t i) const
+{
+    if (!m_cache) {
+        throw std::out_of_range("transposed: column " + std::to_string(i) +
+                                " of a view moved from");
+    }
+    const column &written = (*m_music)[i];
+    if (const column *cached = m_cache[i].load(std::memory_order_acquire)) {
+        return *cached;
+    }
+    if (m_interval == intervals::P1 or !pitched(written)) {
+        return written;
+    }
+
+    auto mine = std::make_unique<const column>(transpose(written, m_interval));
+    const column *expected = nullptr;
+    if (m_cache[i].compare_exchange_strong(expected, mine.get(), std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+        return *mine.release();
+    }
+    return *expected;
+}
+
+std::size_t transposed::cached() const
+{
+    if (!m_cache) {
+        return 0;
+    }
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < size(); ++i) {
+        count += m_cache[i].load(std::memory_order_relaxed) != nullptr;
+    }
+    return count;
+}
+
+} // namespace stan
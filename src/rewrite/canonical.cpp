@@ -0,0 +1,124 @@
+#include <stan/canonical.hpp>
+#include <stan/driver/binary.hpp>
+
+#include <optional>
+#include <type_traits>
+
+namespace stan::canonical {
+
+namespace {
+
+// Meter, clef and key changes written together, as pairs of neighbouring
+// changes out of order: the later of two changes of one kind overrides the
+// earlier, and changes of different kinds are sorted meter, clef, key.
+template <typename First, typename Second>
+rewrite::rule changes()
+{
+    auto rewrite = [](const column *run) -> std::optional<sequential> {
+        if constexpr (std::is_same_v<First, Second>) {
+            return sequential{ run[1] };
+        } else {
+            return sequential{ run[1], run[0] };
+        }
+    };
+    return { "order-changes", { rewrite::kind<First>(), rewrite::kind<Second>() }, rewrite };
+}
+
+// The clef and key in force while walking music in order.
+struct in_force
+{
+    std::optional<clef> m_clef;
+    std::optional<key> m_key;
+};
+
+// Drops every clef and key that restates the one in force, except where a
+// beam or tuplet would be left with fewer than two columns, and tells whether
+// any was dropped.  The columns kept are moved down over those dropped, in
+// one pass.
+bool drop_restated(sequential &music, in_force &state, std::size_t least)
+{
+    bool dropped = false;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < music.size(); ++i) {
+        column &c = music[i];
+        bool restated = false;
+        if (auto *b = std::get_if<beam>(&c)) {
+            dropped |= drop_restated(b->m_elements, state, 2);
+        } else if (auto *t = std::get_if<tuplet>(&c)) {
+            dropped |= drop_restated(t->m_elements, state, 2);
+        } else if (auto *cl = std::get_if<clef>(&c)) {
+            restated = state.m_clef and *state.m_clef == *cl;
+            state.m_clef = *cl;
+        } else if (auto *k = std::get_if<key>(&c)) {
+            restated = state.m_key and *state.m_key == *k;
+            state.m_key = *k;
+        }
+
+        if (restated and kept + (music.size() - i - 1) >= least) {
+            dropped = true;
+            continue;
+        }
+        if (kept != i) {
+            music[kept] = std::move(c);
+        }
+        ++kept;
+    }
+    music.erase(music.begin() + kept, music.end());
+    return dropped;
+}
+
+} // namespace
+
+std::vector<rewrite::rule> rules()
+{
+    std::vector<rewrite::rule> out = rewrite::standard();
+    out.push_back(changes<meter, meter>());
+    out.push_back(changes<clef, meter>());
+    out.push_back(changes<clef, clef>());
+    out.push_back(changes<key, meter>());
+    out.push_back(changes<key, clef>());
+    out.push_back(changes<key, key>());
+    return out;
+}
+
+canonicalizer::canonicalizer() : m_rewrite(rules())
+{
+}
+
+sequential canonicalizer::operator()(const sequential &music)
+{
+    // Dropping a restatement can bring columns together that a rule joins,
+    // and joining changes can make one a restatement, so the two alternate
+    // until neither finds anything.  Restatements depend on the clef and key
+    // in force, which the memoized, bottom up rewrite cannot know, so they
+    // are dropped in a walk of their own.  Rests are dotted last, within
+    // measures, which neither of the others can know: dotting joins only
+    // rests, so it leaves nothing for them to find.
+    sequential out = m_rewrite(music);
+    for (;;) {
+        in_force state;
+        if (!drop_restated(out, state, 0)) {
+            break;
+        }
+        out = m_rewrite(out);
+    }
+    rewrite::dot_rests_within_measures(out);
+    return out;
+}
+
+hash128 canonicalizer::fingerprint(const sequential &music)
+{
+    return driver::binary::hash((*this)(music));
+}
+
+sequential form(const sequential &music)
+{
+    return canonicalizer()(music);
+}
+
+hash128 fingerprint(const sequential &music)
+{
+    return canonicalizer().fingerprint(music);
+}
+
+} // namespace stan::canonical
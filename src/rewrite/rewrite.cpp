@@ -0,0 +1,323 @@
+#include <stan/rewrite.hpp>
+#include <stan/driver/binary.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+namespace stan::rewrite {
+
+namespace {
+
+// The dotted rest two rests make, if they make one.
+std::optional<value> dotted(const value &first, const value &second)
+{
+    if (first.dots() >= 2 or first.num() == 0) {
+        return std::nullopt;
+    }
+    value out = dot(first);
+    if (static_cast<duration>(first) + static_cast<duration>(second) !=
+        static_cast<duration>(out)) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+// Walks music in order keeping the time and the measure as lint::context
+// does, and dots rests in each list in one pass, compacting it as it goes.
+struct rest_dotter
+{
+    // Where a column kept in a list ends, and where the measure it starts in
+    // ends, in ticks.
+    struct placed
+    {
+        std::int64_t m_end;
+        std::int64_t m_bar_end;
+    };
+
+    moment m_at;
+    std::int64_t m_bar_start = 0;
+    std::int64_t m_bar_length = 4 * ticks_per_quarter;
+    bool m_dotted = false;
+
+    void walk(sequential &music, const moment &scale, std::size_t least)
+    {
+        std::vector<placed> places;
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < music.size(); ++i) {
+            column &c = music[i];
+            std::int64_t onset = m_at.ticks();
+            moment end = m_at + scale * moment(duration::zero() + c);
+            while (onset >= m_bar_start + m_bar_length) {
+                m_bar_start += m_bar_length;
+            }
+
+            if (const auto *m = std::get_if<meter>(&c)) {
+                // A change of meter partway through a measure starts a new one.
+                m_bar_start = onset;
+                int beats = std::accumulate(m->m_beats.begin(), m->m_beats.end(), 0);
+                std::int64_t length =
+                    moment(std::uint64_t(beats) * m->m_value.num(), m->m_value.den()).ticks();
+                if (length > 0) {
+                    m_bar_length = length;
+                }
+            } else if (auto *b = std::get_if<beam>(&c)) {
+                walk(b->m_elements, scale, 2);
+            } else if (auto *t = std::get_if<tuplet>(&c)) {
+                walk(t->m_elements, scale * time_scale(*t), 2);
+            }
+            m_at = end;
+
+            if (kept != i) {
+                music[kept] = std::move(c);
+            }
+            places.push_back({ end.ticks(), m_bar_start + m_bar_length });
+            ++kept;
+
+            // A dotted rest can dot again with the rest before it, so the
+            // last two kept are tried until they do not dot.
+            while (kept >= 2 and kept - 1 + (music.size() - i - 1) >= least) {
+                const auto *first = std::get_if<rest>(&music[kept - 2]);
+                const auto *second = std::get_if<rest>(&music[kept - 1]);
+                if (!first or !second or places[kept - 1].m_end > places[kept - 2].m_bar_end) {
+                    break;
+                }
+                std::optional<value> joined = dotted(first->m_value, second->m_value);
+                if (!joined) {
+                    break;
+                }
+                music[kept - 2] = rest(*joined);
+                places[kept - 2].m_end = places[kept - 1].m_end;
+                places.pop_back();
+                --kept;
+                m_dotted = true;
+            }
+        }
+        music.erase(music.begin() + kept, music.end());
+    }
+};
+
+} // namespace
+
+rule dot_rests()
+{
+    auto rewrite = [](const column *run) -> std::optional<sequential> {
+        std::optional<value> joined =
+            dotted(std::get<rest>(run[0]).m_value, std::get<rest>(run[1]).m_value);
+        if (!joined) {
+            return std::nullopt;
+        }
+        return sequential{ rest(*joined) };
+    };
+    return { "dot-rests", { kind<rest>(), kind<rest>() }, rewrite };
+}
+
+bool dot_rests_within_measures(sequential &music)
+{
+    rest_dotter dotter;
+    dotter.walk(music, moment(1, 1), 0);
+    return dotter.m_dotted;
+}
+
+rule flatten_beams()
+{
+    auto rewrite = [](const column *run) -> std::optional<sequential> {
+        return std::get<beam>(run[0]).m_elements;
+    };
+    return { "flatten-beams", { kind<beam>() }, rewrite, scope::in_beam };
+}
+
+rule unwrap_tuplets()
+{
+    auto even = [](const tuplet &t) {
+        duration inner = std::accumulate(t.m_elements.begin(), t.m_elements.end(),
+                                         duration::zero());
+        return inner == static_cast<duration>(t.m_value);
+    };
+    auto rewrite = [](const column *run) -> std::optional<sequential> {
+        return std::get<tuplet>(run[0]).m_elements;
+    };
+    return { "unwrap-tuplets", { kind<tuplet>(even) }, rewrite };
+}
+
+std::vector<rule> standard()
+{
+    return { flatten_beams(), unwrap_tuplets() };
+}
+
+rewriter::rewriter(std::vector<rule> rules) : m_rules(std::move(rules))
+{
+    for (std::size_t r = 0; r < m_rules.size(); ++r) {
+        const auto &pattern = m_rules[r].m_pattern;
+        if (!pattern.empty()) {
+            m_starting[pattern.front().m_kind].push_back(r);
+            m_longest = std::max(m_longest, pattern.size());
+        }
+    }
+}
+
+sequential rewriter::operator()(const sequential &music)
+{
+    m_keys.clear();
+    for (const auto &c : music) {
+        index(c);
+    }
+    m_next = 0;
+    return list(music, scope::top_level);
+}
+
+void rewriter::clear()
+{
+    m_memo.clear();
+    m_hits = 0;
+}
+
+// A beam or tuplet is keyed on the keys of the columns it holds rather than
+// on its whole encoding, so that each column is hashed once however deeply
+// it is nested.  Equal columns have equal keys.
+hash128 rewriter::index(const column &c)
+{
+    const auto *b = std::get_if<beam>(&c);
+    const auto *t = std::get_if<tuplet>(&c);
+    if (!b and !t) {
+        return driver::binary::hash(c);
+    }
+
+    std::size_t at = m_keys.size();
+    m_keys.emplace_back();
+
+    stan::hasher h;
+    h.byte(static_cast<std::uint8_t>(c.index()));
+    if (t) {
+        hash128 ratio = driver::binary::hash(rest(t->m_value));
+        h.update(&ratio, sizeof(ratio));
+    }
+    for (const auto &e : b ? b->m_elements : t->m_elements) {
+        hash128 key = index(e);
+        h.update(&key, sizeof(key));
+    }
+    m_keys[at] = { h.digest(), m_keys.size() - at };
+    return m_keys[at].m_key;
+}
+
+sequential rewriter::list(const sequential &music, scope where)
+{
+    sequential out;
+    out.reserve(music.size());
+    for (const auto &c : music) {
+        out.push_back(node(c));
+    }
+    apply(out, where);
+    return out;
+}
+
+column rewriter::node(const column &c)
+{
+    const auto *b = std::get_if<beam>(&c);
+    const auto *t = std::get_if<tuplet>(&c);
+    if (!b and !t) {
+        return c;
+    }
+
+    // A hash can collide, so a hit counts only if the column it was
+    // remembered for is this one.  A hit skips the keys of the beams and
+    // tuplets inside it, which are not visited.
+    const subtree &s = m_keys[m_next];
+    hash128 key = s.m_key;
+    auto found = m_memo.find(key);
+    if (found != m_memo.end() and found->second.m_original == c) {
+        ++m_hits;
+        m_next += s.m_size;
+        return found->second.m_rewritten;
+    }
+    ++m_next;
+
+    // A rewrite that leaves a beam or tuplet invalid, such as one that
+    // brings a rest into a beam, is not made.
+    column out = c;
+    try {
+        if (b) {
+            out = beam(list(b->m_elements, scope::in_beam));
+        } else {
+            out = tuplet(t->m_value, list(t->m_elements, scope::in_tuplet));
+        }
+    } catch (const exception &) {
+    }
+    if (found == m_memo.end()) {
+        m_memo.emplace(key, remembered{ c, out });
+    }
+    return out;
+}
+
+// One forward pass, using music as a gap buffer: the columns before write
+// are done, those from read on are still to be matched, and the slots
+// between are free.  A replacement is written just before read, and the last
+// few columns done are moved back in front of it, since it can complete a
+// match that starts a little earlier.  A replacement longer than the gap
+// grows the gap by at least the size of the list, so growing is amortized
+// over the columns that fill it.
+void rewriter::apply(sequential &music, scope where) const
+{
+    // Beams and tuplets hold at least two columns.
+    std::size_t least = where == scope::top_level ? 0 : 2;
+
+    std::size_t write = 0;
+    std::size_t read = 0;
+    while (read < music.size()) {
+        std::size_t length = write + (music.size() - read);
+        std::optional<sequential> replacement;
+        std::size_t replaced = 0;
+        for (std::size_t r : m_starting[music[read].index()]) {
+            const rule &rule = m_rules[r];
+            const auto &pattern = rule.m_pattern;
+            if ((rule.m_scope != scope::anywhere and rule.m_scope != where) or
+                read + pattern.size() > music.size()) {
+                continue;
+            }
+            bool matched = true;
+            for (std::size_t j = 0; matched and j < pattern.size(); ++j) {
+                const column &c = music[read + j];
+                matched = c.index() == pattern[j].m_kind and
+                          (!pattern[j].m_test or pattern[j].m_test(c));
+            }
+            if (!matched) {
+                continue;
+            }
+            replacement = rule.m_rewrite(&music[read]);
+            if (replacement and length - pattern.size() + replacement->size() >= least) {
+                replaced = pattern.size();
+                break;
+            }
+            replacement.reset();
+        }
+
+        if (!replacement) {
+            if (write != read) {
+                music[write] = std::move(music[read]);
+            }
+            ++write;
+            ++read;
+            continue;
+        }
+
+        std::size_t size = replacement->size();
+        if (size > replaced + (read - write)) {
+            // Free slots hold rests, the cheapest column to make and move.
+            std::size_t grow = std::max(size - replaced, music.size());
+            music.insert(music.begin() + write, grow, rest(value::quarter()));
+            read += grow;
+        }
+        read = read + replaced - size;
+        std::move(replacement->begin(), replacement->end(), music.begin() + read);
+
+        std::size_t back = std::min(write, m_longest - 1);
+        if (write != read) {
+            std::move_backward(music.begin() + (write - back), music.begin() + write,
+                               music.begin() + read);
+        }
+        write -= back;
+        read -= back;
+    }
+    music.erase(music.begin() + write, music.end());
+}
+
+} // namespace stan::rewrite
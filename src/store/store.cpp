@@ -0,0 +1,635 @@
+#include <stan/store.hpp>
+#include <stan/driver/binary.hpp>
+
+#include <zlib.h>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace stan {
+
+// Pages, all integers little endian:
+//
+//   every page  u32 CRC-32 of the rest of the page, u8 type, u8 0, u16 count
+//   header      "STANSTOR", u32 version, u32 page size,
+//               u64 transaction, u64 root page (0 if empty), u64 pages
+//   branch      count children: u64 score, u32 measure, u64 page, where the
+//               key is the least key in the child
+//   leaf        count entries: u64 score, u32 measure, u64 page, u32 offset,
+//               u32 length, locating the measure's encoding in data pages
+//   data        encodings, one after another, continuing onto the next page
+//
+// Pages 0 and 1 are headers.  Transaction t commits by writing header t % 2,
+// so a torn header write only ever loses the transaction being committed.
+
+namespace {
+
+enum page_type : std::uint8_t
+{
+    header_page = 1,
+    branch_page = 2,
+    leaf_page = 3,
+    data_page = 4
+};
+
+constexpr std::size_t page_header = 8;
+constexpr std::size_t payload = score_store::page_size - page_header;
+constexpr std::size_t branch_entry = 20;
+constexpr std::size_t leaf_entry = 28;
+constexpr std::size_t branch_capacity = payload / branch_entry;
+constexpr std::size_t leaf_capacity = payload / leaf_entry;
+
+// Mapped beyond the end of the file, so that it rarely needs remapping.
+constexpr std::size_t min_map = std::size_t(1) << 30;
+
+void put16(unsigned char *p, std::uint16_t v)
+{
+    p[0] = static_cast<unsigned char>(v);
+    p[1] = static_cast<unsigned char>(v >> 8);
+}
+
+void put32(unsigned char *p, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+void put64(unsigned char *p, std::uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+std::uint16_t get16(const unsigned char *p)
+{
+    return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+
+std::uint32_t get32(const unsigned char *p)
+{
+    std::uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+std::uint64_t get64(const unsigned char *p)
+{
+    std::uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+std::uint32_t checksum(const unsigned char *page)
+{
+    return static_cast<std::uint32_t>(
+        crc32(0, page + 4, static_cast<uInt>(score_store::page_size - 4)));
+}
+
+void seal(unsigned char *page, page_type type, std::size_t count)
+{
+    page[4] = type;
+    page[5] = 0;
+    put16(page + 6, static_cast<std::uint16_t>(count));
+    put32(page, checksum(page));
+}
+
+void write_all(int fd, const unsigned char *data, std::size_t size, std::uint64_t offset,
+               const std::string &path)
+{
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0 and errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw store_error("cannot write {}: {}", path, std::strerror(errno));
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+}
+
+void sync(int fd, const std::string &path)
+{
+    if (::fdatasync(fd) != 0) {
+        throw store_error("cannot sync {}: {}", path, std::strerror(errno));
+    }
+}
+
+// Holds flock(2) for the life of a write.
+struct file_lock
+{
+    int m_fd;
+
+    explicit file_lock(int fd) : m_fd(fd)
+    {
+        while (::flock(m_fd, LOCK_EX) != 0) {
+            if (errno != EINTR) {
+                throw store_error("cannot lock: {}", std::strerror(errno));
+            }
+        }
+    }
+
+    ~file_lock() { ::flock(m_fd, LOCK_UN); }
+};
+
+} // namespace
+
+struct score_store::key
+{
+    std::uint64_t m_score;
+    std::uint32_t m_measure;
+
+    friend bool operator<(const key &k1, const key &k2)
+    {
+        return k1.m_score != k2.m_score ? k1.m_score < k2.m_score : k1.m_measure < k2.m_measure;
+    }
+
+    friend bool operator<=(const key &k1, const key &k2) { return !(k2 < k1); }
+
+    static key read(const unsigned char *p) { return { get64(p), get32(p + 8) }; }
+
+    void write(unsigned char *p) const
+    {
+        put64(p, m_score);
+        put32(p + 8, m_measure);
+    }
+};
+
+// Builds the pages of one change: the new measures' data pages, then copies
+// of every tree node on a path to a change, each page numbered as it will be
+// once appended to the file.
+struct score_store::transaction
+{
+    struct entry
+    {
+        key m_key;
+        std::uint64_t m_page;
+        std::uint32_t m_offset;
+        std::uint32_t m_length;
+    };
+
+    struct child
+    {
+        key m_key;
+        std::uint64_t m_page;
+    };
+
+    const score_store &m_store;
+    const meta &m_meta;
+
+    // Scores replaced or removed, and the new entries, both sorted.
+    std::vector<std::uint64_t> m_scores;
+    std::vector<entry> m_entries;
+
+    std::vector<unsigned char> m_pages;
+
+    transaction(const score_store &store, const meta &m) : m_store(store), m_meta(m) {}
+
+    std::uint64_t next_page() const { return m_meta.m_pages + m_pages.size() / page_size; }
+
+    unsigned char *new_page()
+    {
+        m_pages.resize(m_pages.size() + page_size, 0);
+        return m_pages.data() + m_pages.size() - page_size;
+    }
+
+    // Appends the scores' measures to data pages and records their entries.
+    void add(const std::vector<std::pair<std::uint64_t, const sequential *>> &scores)
+    {
+        driver::binary::writer encode;
+        std::string data;
+        std::uint64_t first = next_page();
+
+        for (const auto &[score, music] : scores) {
+            m_scores.push_back(score);
+            std::vector<std::size_t> measure = stan::measures(*music);
+            for (std::size_t begin = 0; begin < music->size();) {
+                std::size_t end = begin;
+                while (end < music->size() and measure[end] == measure[begin]) {
+                    ++end;
+                }
+                if (measure[begin] > UINT32_MAX) {
+                    throw store_error("score {} has too many measures", score);
+                }
+                std::size_t position = data.size();
+                encode.append(data, sequential(music->begin() + begin, music->begin() + end));
+                m_entries.push_back({ { score, static_cast<std::uint32_t>(measure[begin]) },
+                                      first + position / payload,
+                                      static_cast<std::uint32_t>(position % payload),
+                                      static_cast<std::uint32_t>(data.size() - position) });
+                begin = end;
+            }
+        }
+
+        for (std::size_t at = 0; at < data.size(); at += payload) {
+            unsigned char *p = new_page();
+            std::size_t n = std::min(payload, data.size() - at);
+            std::memcpy(p + page_header, data.data() + at, n);
+            seal(p, data_page, n);
+        }
+
+        std::sort(m_scores.begin(), m_scores.end());
+        std::sort(m_entries.begin(), m_entries.end(),
+                  [](const entry &e1, const entry &e2) { return e1.m_key < e2.m_key; });
+    }
+
+    bool replaced(std::uint64_t score) const
+    {
+        return std::binary_search(m_scores.begin(), m_scores.end(), score);
+    }
+
+    // Whether any change falls in keys [low, high).
+    bool touches(const key &low, const key &high) const
+    {
+        auto s = std::lower_bound(m_scores.begin(), m_scores.end(), low.m_score);
+        if (s != m_scores.end() and key{ *s, 0 } < high) {
+            return true;
+        }
+        auto e = std::lower_bound(m_entries.begin(), m_entries.end(), low,
+                                  [](const entry &e, const key &k) { return e.m_key < k; });
+        return e != m_entries.end() and e->m_key < high;
+    }
+
+    // Splits items into as few nodes as fit, of near equal size.
+    template <typename Item, typename Write>
+    std::vector<child> pack(const std::vector<Item> &items, std::size_t capacity,
+                            page_type type, std::size_t size, const Write &write_item)
+    {
+        std::vector<child> nodes;
+        std::size_t count = (items.size() + capacity - 1) / capacity;
+        for (std::size_t n = 0; n < count; ++n) {
+            std::size_t begin = items.size() * n / count;
+            std::size_t end = items.size() * (n + 1) / count;
+            nodes.push_back({ items[begin].m_key, next_page() });
+            unsigned char *p = new_page();
+            for (std::size_t i = begin; i < end; ++i) {
+                write_item(p + page_header + (i - begin) * size, items[i]);
+            }
+            seal(p, type, end - begin);
+        }
+        return nodes;
+    }
+
+    std::vector<child> leaves(const std::vector<entry> &entries)
+    {
+        return pack(entries, leaf_capacity, leaf_page, leaf_entry,
+                    [](unsigned char *p, const entry &e) {
+                        e.m_key.write(p);
+                        put64(p + 12, e.m_page);
+                        put32(p + 20, e.m_offset);
+                        put32(p + 24, e.m_length);
+                    });
+    }
+
+    std::vector<child> branches(const std::vector<child> &children)
+    {
+        return pack(children, branch_capacity, branch_page, branch_entry,
+                    [](unsigned char *p, const child &c) {
+                        c.m_key.write(p);
+                        put64(p + 12, c.m_page);
+                    });
+    }
+
+    // The nodes replacing node, which holds keys in [low, high).
+    std::vector<child> rewrite(std::uint64_t node, const key &low, const key &high)
+    {
+        const unsigned char *p = m_store.page(m_meta, node, 0);
+        std::size_t count = get16(p + 6);
+        p += page_header;
+
+        if (p[-page_header + 4] == leaf_page) {
+            auto added = std::lower_bound(
+                m_entries.begin(), m_entries.end(), low,
+                [](const entry &e, const key &k) { return e.m_key < k; });
+            std::vector<entry> entries;
+            for (std::size_t i = 0; i < count; ++i, p += leaf_entry) {
+                entry e{ key::read(p), get64(p + 12), get32(p + 20), get32(p + 24) };
+                if (replaced(e.m_key.m_score)) {
+                    continue;
+                }
+                for (; added != m_entries.end() and added->m_key < e.m_key; ++added) {
+                    entries.push_back(*added);
+                }
+                entries.push_back(e);
+            }
+            for (; added != m_entries.end() and added->m_key < high; ++added) {
+                entries.push_back(*added);
+            }
+            return leaves(entries);
+        }
+
+        std::vector<child> children;
+        for (std::size_t i = 0; i < count; ++i) {
+            key k = key::read(p + i * branch_entry);
+            std::uint64_t page = get64(p + i * branch_entry + 12);
+            key child_low = i == 0 ? low : k;
+            key child_high = i + 1 < count ? key::read(p + (i + 1) * branch_entry) : high;
+            if (touches(child_low, child_high)) {
+                std::vector<child> replaced = rewrite(page, child_low, child_high);
+                children.insert(children.end(), replaced.begin(), replaced.end());
+            } else {
+                children.push_back({ k, page });
+            }
+        }
+        return branches(children);
+    }
+
+    std::uint64_t commit(std::uint64_t root)
+    {
+        std::vector<child> top;
+        if (root == 0) {
+            top = leaves(m_entries);
+        } else {
+            top = rewrite(root, { 0, 0 }, { UINT64_MAX, UINT32_MAX });
+        }
+        while (top.size() > 1) {
+            top = branches(top);
+        }
+        return top.empty() ? 0 : top.front().m_page;
+    }
+};
+
+score_store::score_store(const std::string &path) : m_path(path)
+{
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        throw store_error("cannot open {}: {}", path, std::strerror(errno));
+    }
+
+    try {
+        struct stat st;
+        {
+            file_lock lock(m_fd);
+            if (::fstat(m_fd, &st) != 0) {
+                throw store_error("cannot stat {}: {}", path, std::strerror(errno));
+            }
+            if (st.st_size == 0) {
+                std::vector<unsigned char> headers(2 * page_size, 0);
+                unsigned char *h = headers.data();
+                std::memcpy(h + page_header, "STANSTOR", 8);
+                put32(h + page_header + 8, version);
+                put32(h + page_header + 12, page_size);
+                put64(h + page_header + 16, 0);
+                put64(h + page_header + 24, 0);
+                put64(h + page_header + 32, 2);
+                seal(h, header_page, 0);
+                write_all(m_fd, headers.data(), headers.size(), 0, m_path);
+                sync(m_fd, m_path);
+                st.st_size = static_cast<off_t>(headers.size());
+            }
+        }
+
+        remap(static_cast<std::uint64_t>(st.st_size) / page_size);
+        std::shared_lock<std::shared_mutex> lock(m_map_mutex);
+        current(lock);
+    } catch (...) {
+        if (m_map != nullptr) {
+            ::munmap(m_map, m_map_size);
+        }
+        ::close(m_fd);
+        throw;
+    }
+}
+
+score_store::~score_store()
+{
+    ::munmap(m_map, m_map_size);
+    ::close(m_fd);
+}
+
+void score_store::remap(std::uint64_t pages) const
+{
+    std::size_t size = std::max<std::size_t>(min_map, 2 * pages * page_size);
+    void *p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (p == MAP_FAILED) {
+        throw store_error("cannot map {}: {}", m_path, std::strerror(errno));
+    }
+    if (m_map != nullptr) {
+        ::munmap(m_map, m_map_size);
+    }
+    m_map = static_cast<unsigned char *>(p);
+    m_map_size = size;
+}
+
+score_store::meta score_store::current(std::shared_lock<std::shared_mutex> &lock) const
+{
+    for (;;) {
+        bool found = false;
+        meta newest;
+        for (std::uint64_t slot = 0; slot < 2; ++slot) {
+            const unsigned char *h = m_map + slot * page_size;
+            const unsigned char *body = h + page_header;
+            if (get32(h) != checksum(h) or h[4] != header_page or
+                std::memcmp(body, "STANSTOR", 8) != 0) {
+                continue;
+            }
+            if (get32(body + 8) != version or get32(body + 12) != page_size) {
+                throw store_error("{} is a version {} store with {} byte pages", m_path,
+                                  get32(body + 8), get32(body + 12));
+            }
+            meta m{ get64(body + 16), get64(body + 24), get64(body + 32) };
+            if (!found or m.m_transaction > newest.m_transaction) {
+                newest = m;
+                found = true;
+            }
+        }
+        if (!found) {
+            throw store_error("{} is not a score store", m_path);
+        }
+        if (newest.m_pages * page_size <= m_map_size) {
+            return newest;
+        }
+
+        // Another writer grew the file past the map.
+        lock.unlock();
+        {
+            std::unique_lock<std::shared_mutex> exclusive(m_map_mutex);
+            if (newest.m_pages * page_size > m_map_size) {
+                remap(newest.m_pages);
+            }
+        }
+        lock.lock();
+    }
+}
+
+const unsigned char *score_store::page(const meta &m, std::uint64_t number,
+                                       std::uint8_t type) const
+{
+    if (number < 2 or number >= m.m_pages) {
+        throw store_error("{}: page {} is out of range", m_path, number);
+    }
+    const unsigned char *p = m_map + number * page_size;
+    if (get32(p) != checksum(p)) {
+        throw store_error("{}: page {} fails its checksum", m_path, number);
+    }
+    if (type != 0 ? p[4] != type : p[4] != branch_page and p[4] != leaf_page) {
+        throw store_error("{}: page {} has unexpected type {}", m_path, number, p[4]);
+    }
+    return p;
+}
+
+template <typename Visit>
+void score_store::scan(const meta &m, std::uint64_t node, const key &low, const key &high,
+                       const Visit &visit) const
+{
+    const unsigned char *p = page(m, node, 0);
+    std::size_t count = get16(p + 6);
+    bool leaf = p[4] == leaf_page;
+    p += page_header;
+
+    if (leaf) {
+        for (std::size_t i = 0; i < count; ++i, p += leaf_entry) {
+            key k = key::read(p);
+            if (high < k) {
+                break;
+            }
+            if (low <= k) {
+                visit(k, get64(p + 12), get32(p + 20), get32(p + 24));
+            }
+        }
+        return;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i > 0 and high < key::read(p + i * branch_entry)) {
+            break;
+        }
+        // Every key in child i is below the first key of child i + 1.
+        if (i + 1 < count and key::read(p + (i + 1) * branch_entry) <= low) {
+            continue;
+        }
+        scan(m, get64(p + i * branch_entry + 12), low, high, visit);
+    }
+}
+
+void score_store::write(const std::vector<std::pair<std::uint64_t, const sequential *>> &scores)
+{
+    std::lock_guard<std::mutex> guard(m_write_mutex);
+    file_lock lock(m_fd);
+
+    // The last version of a score given twice wins.
+    std::vector<std::pair<std::uint64_t, const sequential *>> unique;
+    for (auto s = scores.rbegin(); s != scores.rend(); ++s) {
+        if (std::none_of(unique.begin(), unique.end(),
+                         [&](const auto &u) { return u.first == s->first; })) {
+            unique.push_back(*s);
+        }
+    }
+
+    std::shared_lock<std::shared_mutex> reading(m_map_mutex);
+    meta m = current(reading);
+    transaction t(*this, m);
+    t.add(unique);
+    std::uint64_t root = t.commit(m.m_root);
+    reading.unlock();
+
+    write_all(m_fd, t.m_pages.data(), t.m_pages.size(), m.m_pages * page_size, m_path);
+    sync(m_fd, m_path);
+
+    meta next{ m.m_transaction + 1, root, t.next_page() };
+    unsigned char header[page_size] = {};
+    std::memcpy(header + page_header, "STANSTOR", 8);
+    put32(header + page_header + 8, version);
+    put32(header + page_header + 12, page_size);
+    put64(header + page_header + 16, next.m_transaction);
+    put64(header + page_header + 24, next.m_root);
+    put64(header + page_header + 32, next.m_pages);
+    seal(header, header_page, 0);
+    write_all(m_fd, header, page_size, (next.m_transaction % 2) * page_size, m_path);
+    sync(m_fd, m_path);
+}
+
+void score_store::put(std::uint64_t score, const sequential &music)
+{
+    write({ { score, &music } });
+}
+
+void score_store::put(const std::vector<std::pair<std::uint64_t, sequential>> &scores)
+{
+    std::vector<std::pair<std::uint64_t, const sequential *>> refs;
+    for (const auto &s : scores) {
+        refs.emplace_back(s.first, &s.second);
+    }
+    write(refs);
+}
+
+void score_store::remove(std::uint64_t score)
+{
+    sequential empty;
+    write({ { score, &empty } });
+}
+
+sequential score_store::get(std::uint64_t score, std::size_t first_measure,
+                            std::size_t last_measure) const
+{
+    sequential music;
+    if (first_measure > last_measure or first_measure > UINT32_MAX) {
+        return music;
+    }
+    last_measure = std::min<std::size_t>(last_measure, UINT32_MAX);
+
+    driver::binary::reader decode;
+    std::string data;
+    std::shared_lock<std::shared_mutex> lock(m_map_mutex);
+    meta m = current(lock);
+    if (m.m_root == 0) {
+        return music;
+    }
+
+    scan(m, m.m_root, { score, static_cast<std::uint32_t>(first_measure) },
+         { score, static_cast<std::uint32_t>(last_measure) },
+         [&](const key &, std::uint64_t page, std::uint32_t offset, std::uint32_t length) {
+             data.clear();
+             while (data.size() < length) {
+                 const unsigned char *p = this->page(m, page++, data_page);
+                 std::size_t used = get16(p + 6);
+                 if (offset >= used) {
+                     throw store_error("{}: corrupt measure reference", m_path);
+                 }
+                 std::size_t n = std::min<std::size_t>(used - offset, length - data.size());
+                 data.append(reinterpret_cast<const char *>(p + page_header + offset), n);
+                 offset = 0;
+             }
+             sequential measure = decode.sequence(data);
+             std::move(measure.begin(), measure.end(), std::back_inserter(music));
+         });
+    return music;
+}
+
+sequential score_store::get(std::uint64_t score) const
+{
+    return get(score, 0, UINT32_MAX);
+}
+
+std::size_t score_store::measures(std::uint64_t score) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_map_mutex);
+    meta m = current(lock);
+    if (m.m_root == 0) {
+        return 0;
+    }
+
+    std::size_t count = 0;
+    scan(m, m.m_root, { score, 0 }, { score, UINT32_MAX },
+         [&](const key &k, std::uint64_t, std::uint32_t, std::uint32_t) {
+             count = std::size_t(k.m_measure) + 1;
+         });
+    return count;
+}
+
+} // namespace stan
@@ -0,0 +1,267 @@
+#include <stan/decompress.hpp>
+
+#include <zlib.h>
+#ifdef STAN_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace stan {
+
+const char *to_string(compression c)
+{
+    switch (c) {
+    case compression::none:
+        return "none";
+    case compression::gzip:
+        return "gzip";
+    case compression::zstd:
+        return "zstd";
+    }
+    return "unknown";
+}
+
+compression detect_compression(const char *data, std::size_t size)
+{
+    auto byte = [data](std::size_t i) { return static_cast<unsigned char>(data[i]); };
+
+    if (size >= 2 and byte(0) == 0x1f and byte(1) == 0x8b) {
+        return compression::gzip;
+    }
+    if (size >= 4 and byte(0) == 0x28 and byte(1) == 0xb5 and byte(2) == 0x2f and
+        byte(3) == 0xfd) {
+        return compression::zstd;
+    }
+    return compression::none;
+}
+
+struct decompressor::impl
+{
+    virtual ~impl() = default;
+    virtual void input(const char *data, std::size_t size) = 0;
+    virtual bool read(std::string &block, std::size_t block_size) = 0;
+    virtual bool finished() const = 0;
+};
+
+namespace {
+
+struct passthrough : decompressor::impl
+{
+    const char *m_data = nullptr;
+    std::size_t m_size = 0;
+
+    void input(const char *data, std::size_t size) override
+    {
+        m_data = data;
+        m_size = size;
+    }
+
+    bool read(std::string &block, std::size_t block_size) override
+    {
+        std::size_t n = std::min(block_size, m_size);
+        block.assign(m_data, n);
+        m_data += n;
+        m_size -= n;
+        return n > 0;
+    }
+
+    // Uncompressed input has no end marker; it ends when the caller stops.
+    bool finished() const override { return false; }
+};
+
+struct gzip : decompressor::impl
+{
+    z_stream m_stream{};
+    bool m_finished = false;
+
+    gzip()
+    {
+        // 15 window bits, plus 16 to expect a gzip rather than zlib header.
+        if (inflateInit2(&m_stream, 15 + 16) != Z_OK) {
+            throw decompress_error("cannot initialize zlib");
+        }
+    }
+
+    ~gzip() override { inflateEnd(&m_stream); }
+
+    void input(const char *data, std::size_t size) override
+    {
+        m_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        m_stream.avail_in = static_cast<uInt>(size);
+    }
+
+    bool read(std::string &block, std::size_t block_size) override
+    {
+        block.resize(block_size);
+        m_stream.next_out = reinterpret_cast<Bytef *>(&block[0]);
+        m_stream.avail_out = static_cast<uInt>(block_size);
+
+        while (m_stream.avail_out > 0) {
+            if (m_finished) {
+                if (m_stream.avail_in == 0) {
+                    break;
+                }
+                // gzip allows several members back to back, as produced by
+                // concatenating .gz files.
+                inflateReset(&m_stream);
+                m_finished = false;
+            }
+            int rc = inflate(&m_stream, Z_NO_FLUSH);
+            if (rc == Z_STREAM_END) {
+                m_finished = true;
+            } else if (rc == Z_BUF_ERROR) {
+                break;
+            } else if (rc != Z_OK) {
+                throw decompress_error("gzip: {}", m_stream.msg ? m_stream.msg : "corrupt data");
+            }
+        }
+
+        block.resize(block_size - m_stream.avail_out);
+        return !block.empty();
+    }
+
+    bool finished() const override { return m_finished; }
+};
+
+#ifdef STAN_HAVE_ZSTD
+struct zstd : decompressor::impl
+{
+    ZSTD_DStream *m_stream;
+    ZSTD_inBuffer m_in{ nullptr, 0, 0 };
+    bool m_finished = false;
+
+    zstd() : m_stream(ZSTD_createDStream())
+    {
+        if (m_stream == nullptr) {
+            throw decompress_error("cannot initialize zstd");
+        }
+    }
+
+    ~zstd() override { ZSTD_freeDStream(m_stream); }
+
+    void input(const char *data, std::size_t size) override { m_in = { data, size, 0 }; }
+
+    bool read(std::string &block, std::size_t block_size) override
+    {
+        block.resize(block_size);
+        ZSTD_outBuffer out{ &block[0], block_size, 0 };
+
+        while (out.pos < out.size) {
+            std::size_t in_before = m_in.pos;
+            std::size_t out_before = out.pos;
+            std::size_t rc = ZSTD_decompressStream(m_stream, &out, &m_in);
+            if (ZSTD_isError(rc)) {
+                throw decompress_error("zstd: {}", ZSTD_getErrorName(rc));
+            }
+            if (m_in.pos == in_before and out.pos == out_before) {
+                break;
+            }
+            // Zero means a frame is complete; another may follow.
+            m_finished = rc == 0;
+        }
+
+        block.resize(out.pos);
+        return !block.empty();
+    }
+
+    bool finished() const override { return m_finished; }
+};
+#endif
+
+std::unique_ptr<decompressor::impl> make_impl(compression c)
+{
+    switch (c) {
+    case compression::none:
+        return std::make_unique<passthrough>();
+    case compression::gzip:
+        return std::make_unique<gzip>();
+    case compression::zstd:
+#ifdef STAN_HAVE_ZSTD
+        return std::make_unique<zstd>();
+#else
+        throw decompress_error("libstan was built without zstd support");
+#endif
+    }
+    throw decompress_error("unknown compression");
+}
+
+void check_complete(compression c, const decompressor &d)
+{
+    if (c != compression::none and !d.finished()) {
+        throw decompress_error("{} stream is truncated", to_string(c));
+    }
+}
+
+} // namespace
+
+decompressor::decompressor(compression c) : m_impl(make_impl(c)) {}
+decompressor::~decompressor() = default;
+decompressor::decompressor(decompressor &&) noexcept = default;
+decompressor &decompressor::operator=(decompressor &&) noexcept = default;
+
+void decompressor::input(const char *data, std::size_t size)
+{
+    m_impl->input(data, size);
+}
+
+bool decompressor::read(std::string &block, std::size_t block_size)
+{
+    return m_impl->read(block, block_size);
+}
+
+bool decompressor::finished() const
+{
+    return m_impl->finished();
+}
+
+void decompress(const char *data, std::size_t size, std::size_t block_size,
+                const block_callback &sink)
+{
+    compression c = detect_compression(data, size);
+    decompressor d(c);
+    d.input(data, size);
+
+    std::string block;
+    while (d.read(block, block_size)) {
+        sink(block.data(), block.size());
+    }
+    check_complete(c, d);
+}
+
+void decompress_file(const std::string &path, std::size_t block_size,
+                     const block_callback &sink)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw decompress_error("cannot open {}: {}", path, std::strerror(errno));
+    }
+
+    // At least large enough to hold any format's magic number.
+    std::vector<char> compressed(std::max<std::size_t>(block_size, 4096));
+    std::string block;
+
+    in.read(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+    auto n = static_cast<std::size_t>(in.gcount());
+    compression c = detect_compression(compressed.data(), n);
+    decompressor d(c);
+
+    while (n > 0) {
+        d.input(compressed.data(), n);
+        while (d.read(block, block_size)) {
+            sink(block.data(), block.size());
+        }
+        in.read(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+        n = static_cast<std::size_t>(in.gcount());
+    }
+    if (in.bad()) {
+        throw decompress_error("cannot read {}: {}", path, std::strerror(errno));
+    }
+    check_complete(c, d);
+}
+
+} // namespace stan
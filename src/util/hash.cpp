@@ -0,0 +1,148 @@
+#include <stan/hash.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace stan {
+
+namespace {
+
+inline std::uint64_t rotl(std::uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline std::uint64_t fmix(std::uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+inline std::uint64_t load64(const unsigned char *p)
+{
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+constexpr std::uint64_t c1 = 0x87c37b91114253d5ull;
+constexpr std::uint64_t c2 = 0x4cf5ad432745937full;
+
+} // namespace
+
+std::string hash128::hex() const
+{
+    return fmt::format("{:016x}{:016x}", m_high, m_low);
+}
+
+hash128 hash(const void *data, std::size_t size, std::uint64_t seed)
+{
+    hasher h(seed);
+    h.update(data, size);
+    return h.digest();
+}
+
+void hasher::round(const unsigned char *block)
+{
+    std::uint64_t k1 = load64(block);
+    std::uint64_t k2 = load64(block + 8);
+
+    k1 *= c1;
+    k1 = rotl(k1, 31);
+    k1 *= c2;
+    m_h1 ^= k1;
+
+    m_h1 = rotl(m_h1, 27);
+    m_h1 += m_h2;
+    m_h1 = m_h1 * 5 + 0x52dce729;
+
+    k2 *= c2;
+    k2 = rotl(k2, 33);
+    k2 *= c1;
+    m_h2 ^= k2;
+
+    m_h2 = rotl(m_h2, 31);
+    m_h2 += m_h1;
+    m_h2 = m_h2 * 5 + 0x38495ab5;
+
+    m_size += 16;
+}
+
+void hasher::update(const void *data, std::size_t size)
+{
+    const auto *bytes = static_cast<const unsigned char *>(data);
+
+    if (m_used > 0) {
+        std::size_t n = std::min(size, sizeof(m_pending) - m_used);
+        std::memcpy(m_pending + m_used, bytes, n);
+        m_used += n;
+        bytes += n;
+        size -= n;
+        if (m_used < sizeof(m_pending)) {
+            return;
+        }
+        round(m_pending);
+        m_used = 0;
+    }
+
+    for (; size >= 16; bytes += 16, size -= 16) {
+        round(bytes);
+    }
+    std::memcpy(m_pending, bytes, size);
+    m_used = size;
+}
+
+hash128 hasher::digest() const
+{
+    std::uint64_t h1 = m_h1;
+    std::uint64_t h2 = m_h2;
+    const unsigned char *tail = m_pending;
+    std::uint64_t k1 = 0;
+    std::uint64_t k2 = 0;
+
+    // clang-format off
+    switch (m_used) {
+    case 15: k2 ^= std::uint64_t(tail[14]) << 48; [[fallthrough]];
+    case 14: k2 ^= std::uint64_t(tail[13]) << 40; [[fallthrough]];
+    case 13: k2 ^= std::uint64_t(tail[12]) << 32; [[fallthrough]];
+    case 12: k2 ^= std::uint64_t(tail[11]) << 24; [[fallthrough]];
+    case 11: k2 ^= std::uint64_t(tail[10]) << 16; [[fallthrough]];
+    case 10: k2 ^= std::uint64_t(tail[9]) << 8; [[fallthrough]];
+    case 9:  k2 ^= std::uint64_t(tail[8]);
+             k2 *= c2; k2 = rotl(k2, 33); k2 *= c1; h2 ^= k2;
+             [[fallthrough]];
+    case 8:  k1 ^= std::uint64_t(tail[7]) << 56; [[fallthrough]];
+    case 7:  k1 ^= std::uint64_t(tail[6]) << 48; [[fallthrough]];
+    case 6:  k1 ^= std::uint64_t(tail[5]) << 40; [[fallthrough]];
+    case 5:  k1 ^= std::uint64_t(tail[4]) << 32; [[fallthrough]];
+    case 4:  k1 ^= std::uint64_t(tail[3]) << 24; [[fallthrough]];
+    case 3:  k1 ^= std::uint64_t(tail[2]) << 16; [[fallthrough]];
+    case 2:  k1 ^= std::uint64_t(tail[1]) << 8; [[fallthrough]];
+    case 1:  k1 ^= std::uint64_t(tail[0]);
+             k1 *= c1; k1 = rotl(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+    // clang-format on
+
+    std::uint64_t size = m_size + m_used;
+    h1 ^= size;
+    h2 ^= size;
+
+    h1 += h2;
+    h2 += h1;
+
+    h1 = fmix(h1);
+    h2 = fmix(h2);
+
+    h1 += h2;
+    h2 += h1;
+
+    return { h1, h2 };
+}
+
+} // namespace stan
@@ -0,0 +1,554 @@
+#include <stan/ingest.hpp>
+#include <stan/exception.hpp>
+#include <stan/scheduler.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define STAN_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace stan {
+
+const char *to_string(ingest_backend b)
+{
+    switch (b) {
+    case ingest_backend::automatic:
+        return "automatic";
+    case ingest_backend::io_uring:
+        return "io_uring";
+    case ingest_backend::threads:
+        return "threads";
+    }
+    return "unknown";
+}
+
+namespace {
+
+// First guess at a file's size when it is not known up front.  Most scores
+// fit, so the usual cost of a file is one open, one read and one close.
+constexpr std::size_t initial_read = 16 << 10;
+
+int read_file(const std::string &path, std::string &contents)
+{
+    contents.clear();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return errno;
+    }
+
+    struct stat st;
+    std::size_t size = ::fstat(fd, &st) == 0 and st.st_size > 0
+        ? static_cast<std::size_t>(st.st_size) + 1
+        : initial_read;
+    contents.resize(size);
+
+    std::size_t done = 0;
+    int error = 0;
+    for (;;) {
+        ssize_t n = ::read(fd, &contents[done], contents.size() - done);
+        if (n < 0 and errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            error = errno;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += static_cast<std::size_t>(n);
+        if (done == contents.size()) {
+            contents.resize(contents.size() * 2);
+        }
+    }
+    ::close(fd);
+
+    contents.resize(error ? 0 : done);
+    return error;
+}
+
+void ingest_threads(const std::vector<std::string> &paths, const ingest_callback &callback,
+                    unsigned threads)
+{
+    executor &ex = default_executor();
+    if (threads == 0) {
+        threads = ex.concurrency();
+    }
+    threads = static_cast<unsigned>(
+        std::clamp<std::size_t>(threads, 1, paths.size()));
+
+    // Each task reads paths until none are left.  The first exception from
+    // the callback stops every task taking more, and is rethrown once they
+    // have all finished.
+    std::atomic<std::size_t> next{ 0 };
+    detail::join_counter join(threads);
+    auto run = [&]() {
+        std::string contents;
+        try {
+            for (std::size_t i = next++; i < paths.size(); i = next++) {
+                int error = read_file(paths[i], contents);
+                callback(i, contents, error);
+            }
+            join.finish();
+        } catch (...) {
+            next = paths.size();
+            join.finish(std::current_exception());
+        }
+    };
+
+    for (unsigned t = 1; t < threads; ++t) {
+        ex.submit(run);
+    }
+    run();
+    join.wait(ex);
+}
+
+#ifdef STAN_HAVE_IO_URING
+
+// A minimal io_uring, driven through the raw system calls so that libstan
+// does not depend on liburing.  Only what ingestion needs: one submitter,
+// never more operations in flight than the ring has entries.
+struct ring
+{
+    ~ring() { close(); }
+
+    // Tears the ring down, cancelling whatever is still in flight.
+    void close()
+    {
+        if (m_sqes != nullptr) {
+            ::munmap(m_sqes, m_sqes_size);
+            m_sqes = nullptr;
+        }
+        if (m_cq_ptr != nullptr and m_cq_ptr != m_sq_ptr) {
+            ::munmap(m_cq_ptr, m_cq_size);
+        }
+        m_cq_ptr = nullptr;
+        if (m_sq_ptr != nullptr) {
+            ::munmap(m_sq_ptr, m_sq_size);
+            m_sq_ptr = nullptr;
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    // Returns zero, or an errno value if io_uring or one of the operations
+    // ingestion uses is not available.
+    int open(unsigned entries)
+    {
+        io_uring_params p{};
+        m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+        if (m_fd < 0) {
+            return errno;
+        }
+        if (int error = probe()) {
+            return error;
+        }
+
+        m_sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        m_cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) {
+            m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+        }
+
+        m_sq_ptr = map(m_sq_size, IORING_OFF_SQ_RING);
+        if (m_sq_ptr == nullptr) {
+            return errno;
+        }
+        m_cq_ptr = single ? m_sq_ptr : map(m_cq_size, IORING_OFF_CQ_RING);
+        if (m_cq_ptr == nullptr) {
+            return errno;
+        }
+        m_sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe *>(map(m_sqes_size, IORING_OFF_SQES));
+        if (m_sqes == nullptr) {
+            return errno;
+        }
+
+        auto *sq = static_cast<char *>(m_sq_ptr);
+        m_sq_head = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+        m_sq_tail = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+        m_sq_mask = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+        m_sq_array = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+
+        auto *cq = static_cast<char *>(m_cq_ptr);
+        m_cq_head = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+        m_cq_tail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+        m_cq_mask = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+
+        m_entries = p.sq_entries;
+        return 0;
+    }
+
+    unsigned entries() const { return m_entries; }
+
+    // True if next() has no free entry until submit_and_wait() is called.
+    bool full() const { return m_queued + m_unsubmitted >= m_entries; }
+
+    io_uring_sqe &next()
+    {
+        unsigned tail = *m_sq_tail + m_queued;
+        unsigned i = tail & m_sq_mask;
+        m_sq_array[i] = i;
+        ++m_queued;
+        io_uring_sqe &sqe = m_sqes[i];
+        std::memset(&sqe, 0, sizeof(sqe));
+        return sqe;
+    }
+
+    // Submits everything queued by next() and waits for at least one
+    // completion.  If it throws, whatever was not submitted is submitted by
+    // the next call.
+    void submit_and_wait()
+    {
+        __atomic_store_n(m_sq_tail, *m_sq_tail + m_queued, __ATOMIC_RELEASE);
+        m_unsubmitted += m_queued;
+        m_queued = 0;
+
+        for (;;) {
+            long n = ::syscall(__NR_io_uring_enter, m_fd, m_unsubmitted, 1u,
+                               IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (n >= 0) {
+                m_unsubmitted -= static_cast<unsigned>(n);
+                if (m_unsubmitted == 0) {
+                    return;
+                }
+            } else if (errno != EINTR and errno != EAGAIN) {
+                throw exception("io_uring_enter: {}", std::strerror(errno));
+            }
+        }
+    }
+
+    template <typename F>
+    void drain(F &&f)
+    {
+        unsigned head = *m_cq_head;
+        unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe &cqe = m_cqes[head & m_cq_mask];
+            std::uint64_t data = cqe.user_data;
+            int res = cqe.res;
+            // Release the entry before handling it; the handler may queue
+            // more work, but that only touches the submission ring.
+            __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+            f(data, res);
+        }
+    }
+
+  private:
+    void *map(std::size_t size, off_t offset)
+    {
+        void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         m_fd, offset);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    int probe()
+    {
+        constexpr unsigned ops = 256;
+        std::vector<char> storage(sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op));
+        auto *probe = reinterpret_cast<io_uring_probe *>(storage.data());
+        if (::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe, ops) < 0) {
+            return errno;
+        }
+        for (unsigned op : { IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE,
+                             IORING_OP_ASYNC_CANCEL }) {
+            if (op > probe->last_op or !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                return EOPNOTSUPP;
+            }
+        }
+        return 0;
+    }
+
+    int m_fd = -1;
+    unsigned m_entries = 0;
+    unsigned m_queued = 0;
+    unsigned m_unsubmitted = 0;
+
+    void *m_sq_ptr = nullptr;
+    void *m_cq_ptr = nullptr;
+    std::size_t m_sq_size = 0;
+    std::size_t m_cq_size = 0;
+    io_uring_sqe *m_sqes = nullptr;
+    std::size_t m_sqes_size = 0;
+
+    unsigned *m_sq_head = nullptr;
+    unsigned *m_sq_tail = nullptr;
+    unsigned m_sq_mask = 0;
+    unsigned *m_sq_array = nullptr;
+
+    unsigned *m_cq_head = nullptr;
+    unsigned *m_cq_tail = nullptr;
+    unsigned m_cq_mask = 0;
+    io_uring_cqe *m_cqes = nullptr;
+};
+
+// Each slot carries one file through open, read and close, with exactly one
+// operation in flight at a time.  The ring holds one entry per slot, so it can
+// never overflow; only abandon() queues more, and it waits for room.
+//
+// Once the callback or the ring throws, no file is started or read further,
+// but every operation in flight is waited for and every open file closed
+// before the first exception is rethrown, as the kernel may still be writing
+// to a slot's buffer until then.
+struct uring_ingest
+{
+    enum class state
+    {
+        opening,
+        reading,
+        closing
+    };
+
+    struct slot
+    {
+        std::size_t m_index;
+        bool m_busy = false;
+        state m_state;
+        int m_fd;
+        int m_error;
+        std::size_t m_done;
+        std::size_t m_requested;
+        std::string m_contents;
+    };
+
+    const std::vector<std::string> &m_paths;
+    const ingest_callback &m_callback;
+    ring &m_ring;
+    std::vector<slot> m_slots;
+    std::size_t m_next = 0;
+    std::size_t m_active = 0;
+    std::exception_ptr m_failure;
+
+    void start(std::size_t s)
+    {
+        slot &sl = m_slots[s];
+        sl.m_index = m_next++;
+        sl.m_busy = true;
+        sl.m_state = state::opening;
+        sl.m_fd = -1;
+        sl.m_error = 0;
+        sl.m_done = 0;
+
+        io_uring_sqe &sqe = m_ring.next();
+        sqe.opcode = IORING_OP_OPENAT;
+        sqe.fd = AT_FDCWD;
+        sqe.addr = reinterpret_cast<std::uint64_t>(m_paths[sl.m_index].c_str());
+        sqe.open_flags = O_RDONLY | O_CLOEXEC;
+        sqe.user_data = s;
+        ++m_active;
+    }
+
+    void read(std::size_t s)
+    {
+        slot &sl = m_slots[s];
+        sl.m_state = state::reading;
+        if (sl.m_contents.size() < sl.m_done + initial_read) {
+            sl.m_contents.resize(std::max(sl.m_contents.size() * 2, sl.m_done + initial_read));
+        }
+
+        io_uring_sqe &sqe = m_ring.next();
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = sl.m_fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(&sl.m_contents[sl.m_done]);
+        sl.m_requested = std::min<std::size_t>(sl.m_contents.size() - sl.m_done, 1u << 30);
+        sqe.len = static_cast<unsigned>(sl.m_requested);
+        sqe.off = sl.m_done;
+        sqe.user_data = s;
+    }
+
+    void close(std::size_t s)
+    {
+        slot &sl = m_slots[s];
+        sl.m_state = state::closing;
+
+        io_uring_sqe &sqe = m_ring.next();
+        sqe.opcode = IORING_OP_CLOSE;
+        sqe.fd = sl.m_fd;
+        sqe.user_data = s;
+    }
+
+    void finish(std::size_t s)
+    {
+        slot &sl = m_slots[s];
+        sl.m_contents.resize(sl.m_error ? 0 : sl.m_done);
+        if (!m_failure) {
+            try {
+                m_callback(sl.m_index, sl.m_contents, sl.m_error);
+            } catch (...) {
+                m_failure = std::current_exception();
+            }
+        }
+
+        sl.m_busy = false;
+        --m_active;
+        if (!m_failure and m_next < m_paths.size()) {
+            start(s);
+        }
+    }
+
+    void complete(std::size_t s, int res)
+    {
+        slot &sl = m_slots[s];
+        switch (sl.m_state) {
+        case state::opening:
+            if (res < 0) {
+                sl.m_error = -res;
+                finish(s);
+            } else {
+                sl.m_fd = res;
+                if (m_failure) {
+                    close(s);
+                } else {
+                    read(s);
+                }
+            }
+            break;
+
+        case state::reading:
+            if (m_failure) {
+                close(s);
+            } else if (res < 0) {
+                sl.m_error = -res;
+                close(s);
+            } else {
+                // A short read of a regular file means end of file, which
+                // saves the usual small file a second, empty read.
+                sl.m_done += static_cast<std::size_t>(res);
+                if (static_cast<std::size_t>(res) < sl.m_requested) {
+                    close(s);
+                } else {
+                    read(s);
+                }
+            }
+            break;
+
+        case state::closing:
+            finish(s);
+            break;
+        }
+    }
+
+    void run()
+    {
+        m_slots.resize(std::min<std::size_t>(m_ring.entries(), m_paths.size()));
+        for (std::size_t s = 0; s < m_slots.size(); ++s) {
+            start(s);
+        }
+        while (m_active > 0) {
+            try {
+                m_ring.submit_and_wait();
+            } catch (...) {
+                if (m_failure) {
+                    abandon();
+                    std::rethrow_exception(m_failure);
+                }
+                m_failure = std::current_exception();
+                continue;
+            }
+            m_ring.drain([this](std::uint64_t s, int res) { complete(s, res); });
+        }
+        if (m_failure) {
+            std::rethrow_exception(m_failure);
+        }
+    }
+
+    // The ring has failed twice, so the files in flight are not carried on.
+    // Their operations are cancelled and waited for, and the files left open
+    // closed here, before the slots' buffers can be freed.  If the ring fails
+    // even at that, it is torn down, which cancels what is still in flight.
+    void abandon()
+    {
+        // Marks the user data of a cancellation, which targets a slot's.
+        constexpr std::uint64_t cancel = std::uint64_t(1) << 63;
+        auto done = [this](std::uint64_t data, int res) {
+            if (data & cancel) {
+                return;
+            }
+            slot &sl = m_slots[data];
+            if (sl.m_state == state::opening and res >= 0) {
+                ::close(res);
+            } else if (sl.m_state == state::reading) {
+                ::close(sl.m_fd);
+            }
+            sl.m_busy = false;
+            --m_active;
+        };
+
+        try {
+            for (std::size_t s = 0; s < m_slots.size(); ++s) {
+                if (m_ring.full()) {
+                    m_ring.submit_and_wait();
+                    m_ring.drain(done);
+                }
+                if (m_slots[s].m_busy) {
+                    io_uring_sqe &sqe = m_ring.next();
+                    sqe.opcode = IORING_OP_ASYNC_CANCEL;
+                    sqe.addr = s;
+                    sqe.user_data = s | cancel;
+                }
+            }
+            while (m_active > 0) {
+                m_ring.submit_and_wait();
+                m_ring.drain(done);
+            }
+        } catch (...) {
+            m_ring.close();
+            for (slot &sl : m_slots) {
+                if (sl.m_busy and sl.m_state == state::reading) {
+                    ::close(sl.m_fd);
+                }
+            }
+        }
+    }
+};
+
+#endif // STAN_HAVE_IO_URING
+
+} // namespace
+
+ingest_backend ingest(const std::vector<std::string> &paths, const ingest_callback &callback,
+                      const ingest_options &options)
+{
+#ifdef STAN_HAVE_IO_URING
+    if (options.m_backend != ingest_backend::threads) {
+        ring r;
+        int error = r.open(std::max(1u, options.m_queue_depth));
+        if (error == 0) {
+            if (!paths.empty()) {
+                uring_ingest{ paths, callback, r }.run();
+            }
+            return ingest_backend::io_uring;
+        }
+        if (options.m_backend == ingest_backend::io_uring) {
+            throw exception("io_uring is not available: {}", std::strerror(error));
+        }
+    }
+#else
+    if (options.m_backend == ingest_backend::io_uring) {
+        throw exception("io_uring is not available on this system");
+    }
+#endif
+
+    if (!paths.empty()) {
+        ingest_threads(paths, callback, options.m_threads);
+    }
+    return ingest_backend::threads;
+}
+
+} // namespace stan
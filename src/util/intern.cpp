@@ -0,0 +1,57 @@
+#include <stan/intern.hpp>
+#include <stan/driver/binary.hpp>
+
+#include <thread>
+
+namespace stan {
+
+namespace {
+
+// Threads take reader slots in turn, so up to epoch_gate::slots threads
+// each count on a cache line of their own.
+std::size_t reader_slot()
+{
+    static std::atomic<std::size_t> next{ 0 };
+    thread_local std::size_t slot = next++;
+    return slot;
+}
+
+} // namespace
+
+epoch_gate::guard epoch_gate::enter()
+{
+    slot &s = m_slots[reader_slot() % slots];
+    for (;;) {
+        std::uint64_t epoch = m_epoch.load();
+        std::atomic<std::uint64_t> &count = s.m_readers[epoch & 1];
+        count.fetch_add(1);
+
+        // If the epoch moved on in between, synchronize() may already have
+        // checked this count, so count again in the new epoch.
+        if (m_epoch.load() == epoch) {
+            return guard(&count);
+        }
+        count.fetch_sub(1);
+    }
+}
+
+void epoch_gate::synchronize()
+{
+    std::lock_guard<std::mutex> lock(m_synchronize_mutex);
+
+    // Readers entering from now count under the other parity.  Those of the
+    // epoch before last were waited for by the previous call.
+    std::uint64_t previous = m_epoch.fetch_add(1);
+    for (const slot &s : m_slots) {
+        while (s.m_readers[previous & 1].load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+std::size_t column_hash::operator()(const column &c) const
+{
+    return static_cast<std::size_t>(driver::binary::hash(c).m_low);
+}
+
+} // namespace stan
@@ -0,0 +1,255 @@
+#include <stan/scheduler.hpp>
+
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace stan {
+
+namespace {
+
+using task = std::function<void()>;
+
+// A queue guarded by its own lock.  Its owner pushes and pops at the back
+// while thieves take from the front, so the two rarely want the lock at
+// once, and every critical section is a few pointer moves.
+struct task_queue
+{
+    std::mutex m_mutex;
+    std::deque<task> m_tasks;
+
+    void push(task t)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(t));
+    }
+
+    bool pop_back(task &t)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_tasks.empty()) {
+            return false;
+        }
+        t = std::move(m_tasks.back());
+        m_tasks.pop_back();
+        return true;
+    }
+
+    bool pop_front(task &t)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_tasks.empty()) {
+            return false;
+        }
+        t = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        return true;
+    }
+};
+
+} // namespace
+
+struct scheduler::state
+{
+    explicit state(unsigned threads) : m_queues(threads) {}
+
+    // One queue per thread, and m_shared for tasks from other threads.
+    std::vector<task_queue> m_queues;
+    task_queue m_shared;
+
+    // Tasks queued and not yet taken.  Threads sleep only when it is zero.
+    std::atomic<std::size_t> m_queued{ 0 };
+    std::atomic<unsigned> m_sleeping{ 0 };
+    bool m_stopping = false;
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wake;
+
+    std::vector<std::thread> m_threads;
+
+    // The calling thread's queue, if it is one of this scheduler's threads.
+    static thread_local state *t_owner;
+    static thread_local std::size_t t_index;
+
+    bool find(task &t)
+    {
+        bool own = t_owner == this;
+        if (m_queued.load() == 0) {
+            return false;
+        }
+        bool found = (own and m_queues[t_index].pop_back(t)) or m_shared.pop_front(t);
+        for (std::size_t i = 1; !found and i <= m_queues.size(); ++i) {
+            std::size_t victim = ((own ? t_index : 0) + i) % m_queues.size();
+            found = m_queues[victim].pop_front(t);
+        }
+        if (found) {
+            --m_queued;
+        }
+        return found;
+    }
+
+    void work(std::size_t index)
+    {
+        t_owner = this;
+        t_index = index;
+        for (task t;;) {
+            if (find(t)) {
+                t();
+                t = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_sleep_mutex);
+            ++m_sleeping;
+            m_wake.wait(lock, [&]() { return m_queued.load() != 0 or m_stopping; });
+            --m_sleeping;
+            if (m_stopping and m_queued.load() == 0) {
+                return;
+            }
+        }
+    }
+};
+
+thread_local scheduler::state *scheduler::state::t_owner = nullptr;
+thread_local std::size_t scheduler::state::t_index = 0;
+
+scheduler::scheduler(unsigned threads)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_state = std::make_unique<state>(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        m_state->m_threads.emplace_back([this, i]() { m_state->work(i); });
+    }
+}
+
+scheduler::~scheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_state->m_sleep_mutex);
+        m_state->m_stopping = true;
+    }
+    m_state->m_wake.notify_all();
+    for (auto &t : m_state->m_threads) {
+        t.join();
+    }
+}
+
+void scheduler::submit(std::function<void()> t)
+{
+    state &s = *m_state;
+    if (state::t_owner == &s) {
+        s.m_queues[state::t_index].push(std::move(t));
+    } else {
+        s.m_shared.push(std::move(t));
+    }
+    ++s.m_queued;
+
+    // Both counters are sequentially consistent, so either a thread going to
+    // sleep sees the new task or this sees the sleeper.  Taking the lock
+    // makes sure the sleeper is waiting before it is woken.
+    if (s.m_sleeping.load() != 0) {
+        { std::lock_guard<std::mutex> lock(s.m_sleep_mutex); }
+        s.m_wake.notify_one();
+    }
+}
+
+unsigned scheduler::concurrency() const
+{
+    return static_cast<unsigned>(m_state->m_queues.size());
+}
+
+bool scheduler::run_one()
+{
+    task t;
+    if (!m_state->find(t)) {
+        return false;
+    }
+    t();
+    return true;
+}
+
+namespace {
+
+std::mutex default_mutex;
+std::shared_ptr<executor> default_instance;
+
+// Executors that have been replaced as the default.  References to them may
+// still be in use, so they live until exit.
+std::vector<std::shared_ptr<executor>> retired;
+
+unsigned configured_threads()
+{
+    const char *threads = std::getenv("STAN_THREADS");
+    if (threads == nullptr) {
+        return 0;
+    }
+    try {
+        return static_cast<unsigned>(std::max(0, std::stoi(threads)));
+    } catch (std::exception &) {
+        return 0;
+    }
+}
+
+} // namespace
+
+executor &default_executor()
+{
+    std::lock_guard<std::mutex> lock(default_mutex);
+    if (!default_instance) {
+        default_instance = std::make_shared<scheduler>(configured_threads());
+    }
+    return *default_instance;
+}
+
+void set_default_executor(std::shared_ptr<executor> ex)
+{
+    std::lock_guard<std::mutex> lock(default_mutex);
+    if (default_instance) {
+        retired.push_back(std::move(default_instance));
+    }
+    default_instance = std::move(ex);
+}
+
+namespace detail {
+
+void join_counter::finish(std::exception_ptr failure)
+{
+    if (failure) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_failure) {
+            m_failure = failure;
+        }
+        m_failed = true;
+    }
+    if (m_pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done.notify_all();
+    }
+}
+
+void join_counter::wait(executor &ex)
+{
+    while (m_pending.load() != 0) {
+        if (ex.run_one()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [&]() { return m_pending.load() == 0; });
+    }
+    // Taken out of the counter, which a finished task may yet release on
+    // another thread.
+    std::exception_ptr failure;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        failure = std::move(m_failure);
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+} // namespace detail
+
+} // namespace stan
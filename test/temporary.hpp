@@ -0,0 +1,97 @@
+#pragma once
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// A fresh directory under /tmp for a test that touches the file system,
+// removed with everything in it when the test ends.
+struct temporary_directory
+{
+    temporary_directory()
+    {
+        char name[] = "/tmp/stan-test.XXXXXX";
+        if (::mkdtemp(name) == nullptr) {
+            fail("mkdtemp", name);
+        }
+        m_path = name;
+    }
+
+    ~temporary_directory() { remove(m_path); }
+
+    temporary_directory(const temporary_directory &) = delete;
+    temporary_directory &operator=(const temporary_directory &) = delete;
+
+    // The path of name within the directory, which need not exist.
+    std::string path(const std::string &name) const { return m_path + '/' + name; }
+
+    // Writes a file, making no directories on the way, and returns its path.
+    std::string file(const std::string &name, const std::string &contents) const
+    {
+        std::string p = path(name);
+        std::ofstream(p, std::ios::binary) << contents;
+        return p;
+    }
+
+    std::string directory(const std::string &name) const
+    {
+        std::string p = path(name);
+        ::mkdir(p.c_str(), 0755);
+        return p;
+    }
+
+    // The names of the entries directly within the directory, leaving out
+    // hidden ones such as a writer's temporary files.
+    std::vector<std::string> files() const
+    {
+        std::vector<std::string> names;
+        DIR *dir = ::opendir(m_path.c_str());
+        if (dir == nullptr) {
+            fail("opendir", m_path);
+        }
+        while (dirent *d = ::readdir(dir)) {
+            if (d->d_name[0] != '.') {
+                names.push_back(d->d_name);
+            }
+        }
+        ::closedir(dir);
+        return names;
+    }
+
+    std::string m_path;
+
+  private:
+    // Thrown out of the test, which fails it.
+    [[noreturn]] static void fail(const char *call, const std::string &path)
+    {
+        throw std::runtime_error(std::string(call) + " " + path + ": " + std::strerror(errno));
+    }
+
+    static void remove(const std::string &path)
+    {
+        if (DIR *dir = ::opendir(path.c_str())) {
+            while (dirent *d = ::readdir(dir)) {
+                std::string name = d->d_name;
+                if (name != "." and name != "..") {
+                    remove(path + '/' + name);
+                }
+            }
+            ::closedir(dir);
+            ::rmdir(path.c_str());
+        } else {
+            ::unlink(path.c_str());
+        }
+    }
+};
+
+} // namespace
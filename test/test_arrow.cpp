@@ -0,0 +1,81 @@
+#include <stan/driver/arrow.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+#include "property.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::greater;
+
+namespace {
+
+stan::lilypond::reader lily;
+
+// The bytes of a column of little endian values, to find in a file.
+template <typename T>
+std::string column(std::initializer_list<T> values)
+{
+    std::string bytes;
+    for (T v : values) {
+        char b[sizeof(T)];
+        std::memcpy(b, &v, sizeof(T));
+        bytes.append(b, sizeof(T));
+    }
+    return bytes;
+}
+
+bool framed(const std::string &file)
+{
+    if (file.size() < 18 or file.compare(0, 8, std::string("ARROW1\0\0", 8)) != 0 or
+        file.compare(file.size() - 6, 6, "ARROW1") != 0) {
+        return false;
+    }
+    std::int32_t footer;
+    std::memcpy(&footer, file.data() + file.size() - 10, sizeof(footer));
+    return footer > 0 and static_cast<std::size_t>(footer) + 18 <= file.size();
+}
+
+} // namespace
+
+mettle::suite<> suite("arrow", [](auto &_) {
+    property(_, "framing", [](stan::sequential music) {
+        stan::driver::arrow::writer write;
+        expect(framed(write(music)), equal_to(true));
+    });
+
+    _.test("columns", []() {
+        stan::driver::arrow::writer write;
+        std::string file =
+            write(lily.sequence(R"(c4 r8 [d8 e8] \tuplet 3/2 { f8 g8 a8 } r8 <c' e'>2)"));
+        expect(framed(file), equal_to(true));
+
+        auto has = [&](const std::string &bytes) {
+            return file.find(bytes) != std::string::npos;
+        };
+        expect(has(column<std::int64_t>({ 0, 1440, 1920, 2400, 2720, 3040, 3840, 3840 })),
+               equal_to(true));
+        expect(has(column<std::int64_t>({ 960, 480, 480, 320, 320, 320, 1920, 1920 })),
+               equal_to(true));
+        expect(has(column<std::int16_t>({ 60, 62, 64, 65, 67, 69, 72, 76 })), equal_to(true));
+        expect(has(column<std::uint32_t>({ 0, 0, 0, 0, 0, 0, 1, 1 })), equal_to(true));
+    });
+
+    _.test("threads", []() {
+        std::vector<stan::sequential> scores(100, lily.sequence("c4 d4 e4 f4 g1"));
+        stan::driver::arrow::writer one;
+        one.m_threads = 1;
+        stan::driver::arrow::writer many;
+        many.m_threads = 8;
+        std::string a = one(scores), b = many(scores);
+        expect(framed(a), equal_to(true));
+        expect(framed(b), equal_to(true));
+        expect(b.size(), greater(a.size()));
+    });
+});
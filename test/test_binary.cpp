@@ -0,0 +1,85 @@
+#include <stan/notation.hpp>
+#include <stan/driver/binary.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+#include "property.hpp"
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+using stan::driver::binary::invalid_binary;
+
+mettle::suite<
+    stan::rest,
+    stan::note,
+    stan::chord,
+    stan::beam,
+    stan::tuplet,
+    stan::meter,
+    stan::clef,
+    stan::key
+    >
+    suite(
+        "binary", mettle::type_only, [](auto &_) {
+            static stan::driver::binary::reader read;
+            static stan::driver::binary::writer write;
+
+            using Event = mettle::fixture_type_t<decltype(_)>;
+
+            property(_, "writeread", [](Event n) {
+                expect(read(write(n)), equal_to<stan::column>(stan::column{ n }));
+            });
+
+            property(_, "truncated", [](Event n) {
+                std::string data = write(n);
+                data.pop_back();
+                expect([data] { read(data); }, thrown<invalid_binary>());
+            });
+        });
+
+mettle::suite<> sequence_suite("binary sequence", [](auto &_) {
+    static stan::driver::binary::reader read;
+    static stan::driver::binary::writer write;
+
+    property(_, "writeread", [](stan::sequential s) {
+        expect(read.sequence(write(s)), equal_to(s));
+    });
+
+    _.test("header", []() {
+        std::string data = write(stan::sequential{});
+        expect(read.sequence(data).size(), equal_to(0u));
+
+        std::string magic = data;
+        magic[0] = 'X';
+        expect([magic] { read.sequence(magic); },
+               thrown<invalid_binary>("invalid binary: bad magic number"));
+
+        expect([data] { read(data); },
+               thrown<invalid_binary>("invalid binary: expected a column"));
+        expect([data] { read.sequence(data + '\0'); },
+               thrown<invalid_binary>("invalid binary: 1 trailing bytes"));
+    });
+
+    _.test("values outside value::all", []() {
+        static stan::lilypond::reader lily;
+        for (const char *text : { "c64. d4", "c32.. d4", "c64.. d4", "r64. [c64. d32..]" }) {
+            stan::sequential music = lily.sequence(text);
+            expect(read.sequence(write(music)), equal_to(music));
+        }
+
+        expect(stan::driver::binary::hash(lily.sequence("c64. d4")) ==
+                   stan::driver::binary::hash(lily.sequence("c32.. d4")),
+               equal_to(false));
+        expect(stan::driver::binary::hash(lily.sequence("c64.")[0]) ==
+                   stan::driver::binary::hash(lily.sequence("c64..")[0]),
+               equal_to(false));
+
+        std::string data = write(lily.sequence("c64."));
+        data[data.size() - 3] = 3;
+        expect([data] { read.sequence(data); },
+               thrown<invalid_binary>("invalid binary: value 1/2^6 with 3 dots out of range"));
+    });
+});
@@ -0,0 +1,143 @@
+#include <stan/canonical.hpp>
+#include <stan/driver/binary.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+#include <string>
+
+using mettle::equal_to;
+using mettle::expect;
+
+namespace {
+
+stan::lilypond::reader lily;
+
+stan::sequential form(const std::string &text)
+{
+    return stan::canonical::form(lily.sequence(text));
+}
+
+bool same(const std::string &text1, const std::string &text2)
+{
+    return stan::canonical::fingerprint(lily.sequence(text1)) ==
+           stan::canonical::fingerprint(lily.sequence(text2));
+}
+
+} // namespace
+
+mettle::suite<> suite("canonical", [](auto &_) {
+    _.test("hash in pieces", []() {
+        std::string text = "The quick brown fox jumps over the lazy dog, twice over.";
+        for (std::size_t cut = 0; cut <= text.size(); ++cut) {
+            stan::hasher h(7);
+            h.update(text.data(), cut);
+            for (std::size_t i = cut; i < text.size(); ++i) {
+                h.byte(static_cast<std::uint8_t>(text[i]));
+            }
+            expect(h.digest(), equal_to(stan::hash(text, 7)));
+        }
+
+        // Hashed as encoded, the same as hashing the encoding.
+        stan::sequential music = lily.sequence(R"(c4 [d8 e8] \tuplet 3/2 { f8 g8 a8 } <c e g>2)");
+        std::string encoded = stan::driver::binary::writer()(music);
+        expect(stan::driver::binary::hash(music),
+               equal_to(stan::hash(encoded.substr(5))));
+        encoded = stan::driver::binary::writer()(music[1]);
+        expect(stan::driver::binary::hash(music[1]),
+               equal_to(stan::hash(encoded.substr(5))));
+    });
+
+    _.test("beams and tuplets", []() {
+        expect(form("[[c16 d16] e8] f4"), equal_to(lily.sequence("[c16 d16 e8] f4")));
+        expect(form(R"(\tuplet 1/1 { c8 d8 } e4)"), equal_to(lily.sequence("c8 d8 e4")));
+        expect(same(R"(\tuplet 6/4 { c8 d8 e8 })", R"(\tuplet 3/2 { c8 d8 e8 })"), equal_to(true));
+        expect(same(R"([c16 [d16 e16] \tuplet 1/1 { f16 g16 }] r4 r8)", "[c16 d16 e16 f16 g16] r4."),
+               equal_to(true));
+    });
+
+    _.test("rests", []() {
+        expect(form("c4 r4 r8 c8 c4"), equal_to(lily.sequence("c4 r4. c8 c4")));
+        expect(form(R"(r4 \tuplet 1/1 { r8 c8 } c2)"), equal_to(lily.sequence("r4. c8 c2")));
+
+        // Across the bar line, which "r4." would run over.
+        std::string straddling = R"(\time 3/4 c2 r4 r8 c8 c2)";
+        expect(form(straddling), equal_to(lily.sequence(straddling)));
+        expect(same(straddling, R"(\time 3/4 c2 r4. c8 c2)"), equal_to(false));
+    });
+
+    _.test("changes", []() {
+        expect(form(R"(\key g \major \clef bass \time 3/4 c4)"),
+               equal_to(lily.sequence(R"(\time 3/4 \clef bass \key g \major c4)")));
+        expect(form(R"(\clef bass \key d \major \clef alto \key g \major c4)"),
+               equal_to(lily.sequence(R"(\clef alto \key g \major c4)")));
+        expect(form(R"(\clef bass c4 \clef treble d4 \clef treble e4 \clef bass f4)"),
+               equal_to(lily.sequence(R"(\clef bass c4 \clef treble d4 e4 \clef bass f4)")));
+        expect(form(R"(\key g \major c4 \tuplet 3/2 { d8 \key g \major e8 f8 } r4 \key g \major r8)"),
+               equal_to(lily.sequence(R"(\key g \major c4 \tuplet 3/2 { d8 e8 f8 } r4.)")));
+        // Not where it would leave a tuplet one column.
+        expect(form(R"(\key g \major \tuplet 3/2 { \key g \major c4. })"),
+               equal_to(lily.sequence(R"(\key g \major \tuplet 3/2 { \key g \major c4. })")));
+
+        // Restated once the changes between are joined.
+        expect(form(R"(\clef bass c4 \clef treble \clef bass d4)"),
+               equal_to(lily.sequence(R"(\clef bass c4 d4)")));
+
+        // A meter restated part way through a measure starts a new one.
+        expect(form(R"(\time 3/4 c4 \time 3/4 d2.)"),
+               equal_to(lily.sequence(R"(\time 3/4 c4 \time 3/4 d2.)")));
+    });
+
+    _.test("many restatements", []() {
+        std::string restated = R"(\clef bass)", kept = R"(\clef bass)";
+        for (int i = 0; i < 3000; ++i) {
+            restated += R"( c4 \clef bass \key g \major)";
+            kept += " c4";
+            if (i == 0) {
+                kept += R"( \key g \major)";
+            }
+        }
+        expect(form(restated), equal_to(lily.sequence(kept)));
+    });
+
+    _.test("distinct music stays distinct", []() {
+        expect(same("c4 d4", "d4 c4"), equal_to(false));
+        expect(same("r4 r4", "r2"), equal_to(false));
+        expect(same(R"(\clef bass c4)", R"(c4 \clef bass)"), equal_to(false));
+        expect(same(R"(\tuplet 3/2 { c8 d8 e8 })", "c8 d8 e8"), equal_to(false));
+        expect(same(R"(\key g \major c4)", R"(\key e \minor c4)"), equal_to(false));
+        expect(same("c64. d4", "c32.. d4"), equal_to(false));
+        expect(same("c64.. d4", "c32.. d4"), equal_to(false));
+    });
+
+    _.test("normal form is a fixpoint", []() {
+        for (const char *text : { R"({ \clef bass \clef treble [[c16 d16] e8] r8 r16 r32 })",
+                                  R"(\key f \major \tuplet 1/1 { \key f \major r4 r8 } c4)",
+                                  R"(\time 2/4 \tuplet 3/2 { [c8 [d16 e16]] \clef bass f8 })",
+                                  R"(\time 3/4 c2 r4 r8 r16 \clef bass r16 c2)" }) {
+            stan::sequential once = form(text);
+            expect(stan::canonical::form(once), equal_to(once));
+            expect(stan::canonical::fingerprint(once),
+                   equal_to(stan::canonical::fingerprint(lily.sequence(text))));
+        }
+    });
+
+    _.test("stable fingerprint", []() {
+        // Fingerprints are stored, so they may only change with the binary
+        // encoding's version.
+        expect(stan::canonical::fingerprint(lily.sequence("[[c16 d16] e8] r4 r8")).hex(),
+               equal_to("57defa2cef75c5c694f2c63d2737e572"));
+        expect(stan::canonical::fingerprint({}).hex(),
+               equal_to(stan::hash(std::string(1, '\0')).hex()));
+    });
+
+    _.test("one canonicalizer for many", []() {
+        stan::canonical::canonicalizer canonical;
+        stan::sequential music = lily.sequence(R"([[c16 d16] e8] r4 [[c16 d16] e8])");
+        for (int i = 0; i < 3; ++i) {
+            expect(canonical(music), equal_to(lily.sequence("[c16 d16 e8] r4 [c16 d16 e8]")));
+        }
+        expect(canonical.fingerprint(music), equal_to(stan::canonical::fingerprint(music)));
+    });
+});
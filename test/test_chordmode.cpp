@@ -0,0 +1,109 @@
+#include <stan/notation.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+#include <stdexcept>
+#include <string>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+namespace {
+
+stan::lilypond::reader lily;
+stan::lilypond::writer to_lily;
+
+using stan::octave;
+using stan::pitch;
+using stan::pitchclass;
+namespace iv = stan::intervals;
+
+} // namespace
+
+mettle::suite<> suite("chordmode", [](auto &_) {
+    _.test("intervals", []() {
+        pitch af(pitchclass::af, octave(4));
+        expect(af + iv::M3 == pitch(pitchclass::c, octave(5)), equal_to(true));
+        expect(af + iv::d4 == pitch(pitchclass::dff, octave(5)), equal_to(true));
+        expect(pitch(pitchclass::b, octave(3)) + iv::m2 == pitch(pitchclass::c, octave(4)),
+               equal_to(true));
+        expect(pitch(pitchclass::c, octave(4)) - iv::m3 == pitch(pitchclass::a, octave(3)),
+               equal_to(true));
+        expect(pitch(pitchclass::e, octave(5)) - pitch(pitchclass::c, octave(4)) == iv::M3 + iv::P8,
+               equal_to(true));
+        expect(pitchclass::bf + iv::M2 == pitchclass::c, equal_to(true));
+        expect(pitchclass::fs + iv::A4 == pitchclass::bs, equal_to(true));
+        expect([]() { pitch(pitchclass::bss, octave(4)) + iv::A1; },
+               thrown<stan::invalid_interval>());
+    });
+
+    _.test("read", []() {
+        stan::sequential music = lily.chordmode(R"(\chordmode { c1 a2:m7 r2 bf4:7/d \time 3/4 g2.:sus4 })");
+        expect(music.size(), equal_to(6u));
+        expect(music[0], equal_to(lily(R"(<c e g>1)")));
+        expect(music[1], equal_to(lily(R"(<a c' e' g'>2)")));
+        expect(music[3], equal_to(lily(R"(<d bf f' af'>4)")));
+        expect(music[4], equal_to(lily(R"(\time 3/4)")));
+
+        // A bass outside the chord is added below it.
+        expect(lily.chordmode("e4:m/c")[0], equal_to(lily(R"(<c e g b>4)")));
+        expect(lily.chordmode("c'8:13")[0], equal_to(lily(R"(<c' e' g' bf' d'' a''>8)")));
+    });
+
+    _.test("name", []() {
+        for (const auto &q : stan::chord_qualities::all) {
+            for (pitchclass root : { pitchclass::c, pitchclass::fs, pitchclass::ef }) {
+                stan::chord_name n{ pitch(root, octave(3)), &q, std::nullopt };
+                stan::chord c = stan::spell(stan::value::half(), n);
+                auto named = stan::name_of(c);
+                expect(bool(named), equal_to(true));
+                expect(named->m_quality == &q, equal_to(true));
+                expect(named->m_root == n.m_root, equal_to(true));
+
+                // First inversion, the chord's second pitch in the bass.
+                n.m_bass = c.m_pitches[1].m_pitchclass;
+                auto inverted = stan::name_of(stan::spell(stan::value::half(), n));
+                expect(bool(inverted), equal_to(true));
+                expect(stan::spell(stan::value::half(), *inverted) ==
+                           stan::spell(stan::value::half(), n),
+                       equal_to(true));
+            }
+        }
+
+        // Spelled as no table entry is.
+        expect(bool(stan::name_of(std::get<stan::chord>(lily(R"(<c ds g>4)")))), equal_to(false));
+
+        // An inversion voiced other than as spell() builds it.
+        expect(bool(stan::name_of(std::get<stan::chord>(lily(R"(<e g c'>4)")))), equal_to(false));
+        expect(bool(stan::name_of(std::get<stan::chord>(lily(R"(<e, c g>4)")))), equal_to(true));
+    });
+
+    _.test("write", []() {
+        std::string names = R"(\chordmode { c1 a2:m7 r2 bf4:7/d \time 3/4 g2.:sus4 c4/g })";
+        expect(to_lily.chordmode(lily.chordmode(names)), equal_to(names));
+        expect([]() { to_lily.chordmode(lily.sequence("c4")); }, thrown<stan::invalid_chord>());
+        expect([]() { to_lily.chordmode(lily.sequence("<c ds g>4")); },
+               thrown<stan::invalid_chord>());
+    });
+
+    _.test("power chords", []() {
+        // A step number alone extends the stack, as in LilyPond: "c:5" is the
+        // triad, and the power chord lists its steps.
+        expect(lily.chordmode("c4:5")[0], equal_to(lily(R"(<c e g>4)")));
+        expect(lily.chordmode("c4:1.5")[0], equal_to(lily(R"(<c g>4)")));
+        expect(to_lily.chordmode(lily.sequence("<c g>4 <d a>2")),
+               equal_to(R"(\chordmode { c4:1.5 d2:1.5 })"));
+
+        std::string power = R"(\chordmode { c4:1.5 g,2:1.5/d })";
+        expect(to_lily.chordmode(lily.chordmode(power)), equal_to(power));
+    });
+
+    _.test("errors", []() {
+        expect([]() { lily.chordmode("c1:xyz"); }, thrown<std::runtime_error>());
+        expect([]() { lily.chordmode("c1 [d8 e8]"); }, thrown<std::runtime_error>());
+        expect([]() { lily.chordmode(R"(\chordmode { c1 )"); }, thrown<std::runtime_error>());
+    });
+});
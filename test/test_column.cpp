@@ -1,4 +1,5 @@
 #include <stan/notation.hpp>
+#include <stan/driver/lilypond.hpp>
 #include "to_printable.hpp"
 #include "property.hpp"
 
@@ -14,4 +15,19 @@ mettle::suite<> suite("column", [](auto &_) {
     property(_, "duration", [](column v) {
         expect(duration::zero() + v, mettle::greater_equal(duration::zero()));
     });
+
+    _.test("moment", []() {
+        moment third(1, 12);
+        expect(third.ticks(), equal_to(320));
+        expect((third + third + third).ticks(), equal_to(4 * 240));
+        expect(moment(2, 3).ticks(), equal_to(2560));
+        expect(moment(1, 7).ticks(), equal_to(549));
+
+        lilypond::reader lily;
+        auto triplet = std::get<tuplet>(lily.sequence(R"(\tuplet 3/2 { c8 d8 e8 })").front());
+        moment scale = time_scale(triplet);
+        expect(scale.m_num, equal_to(2u));
+        expect(scale.m_den, equal_to(3u));
+        expect((scale * moment(1, 8)).ticks(), equal_to(320));
+    });
 });
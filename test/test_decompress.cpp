@@ -0,0 +1,74 @@
+#include <stan/decompress.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+namespace {
+
+// gzip of "{ c4 d8 [e16 f16] }\n".
+const unsigned char gzipped[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xab, 0x56, 0x48, 0x36,
+    0x51, 0x48, 0xb1, 0x50, 0x88, 0x4e, 0x35, 0x34, 0x53, 0x48, 0x33, 0x34, 0x8b, 0x55,
+    0xa8, 0xe5, 0x02, 0x00, 0x92, 0x97, 0x93, 0x5a, 0x14, 0x00, 0x00, 0x00
+};
+
+const std::string plain = "{ c4 d8 [e16 f16] }\n";
+
+std::string inflated(const std::string &data, std::size_t block_size)
+{
+    std::string out;
+    stan::decompress(data.data(), data.size(), block_size,
+                     [&](const char *block, std::size_t size) {
+                         expect(size <= block_size, equal_to(true));
+                         out.append(block, size);
+                     });
+    return out;
+}
+
+} // namespace
+
+mettle::suite<> suite("decompress", [](auto &_) {
+    static const std::string gz(reinterpret_cast<const char *>(gzipped), sizeof(gzipped));
+
+    _.test("detect", []() {
+        expect(stan::detect_compression(gz.data(), gz.size()),
+               equal_to(stan::compression::gzip));
+        expect(stan::detect_compression("\x28\xb5\x2f\xfd", 4),
+               equal_to(stan::compression::zstd));
+        expect(stan::detect_compression(plain.data(), plain.size()),
+               equal_to(stan::compression::none));
+    });
+
+    _.test("gzip", []() {
+        for (std::size_t block_size : { 1, 3, 7, 64 }) {
+            expect(inflated(gz, block_size), equal_to(plain));
+        }
+        expect(inflated(gz + gz, 5), equal_to(plain + plain));
+    });
+
+    _.test("uncompressed", []() {
+        for (std::size_t block_size : { 1, 3, 64 }) {
+            expect(inflated(plain, block_size), equal_to(plain));
+        }
+    });
+
+    _.test("truncated", []() {
+        expect([] { inflated(gz.substr(0, gz.size() - 4), 64); },
+               thrown<stan::decompress_error>("decompress error: gzip stream is truncated"));
+    });
+
+    _.test("read compressed", []() {
+        stan::lilypond::reader read;
+        for (std::size_t block_size : { 1, 5, 64 }) {
+            expect(stan::lilypond::read_compressed(gz, block_size),
+                   equal_to(read.sequence(plain)));
+        }
+        expect([] { stan::lilypond::read_compressed(gz.substr(0, gz.size() - 4)); },
+               thrown<stan::decompress_error>("decompress error: gzip stream is truncated"));
+    });
+});
@@ -0,0 +1,64 @@
+#include <stan/diff.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+#include "property.hpp"
+
+using mettle::equal_to;
+using mettle::expect;
+
+namespace {
+
+stan::lilypond::reader lily;
+
+std::string diff(const std::string &from, const std::string &to)
+{
+    stan::sequential s1 = lily.sequence(from);
+    stan::sequential s2 = lily.sequence(to);
+    return stan::diff::summary(stan::diff::compare(s1, s2));
+}
+
+} // namespace
+
+mettle::suite<> suite("diff", [](auto &_) {
+    property(_, "identical", [](stan::sequential s) {
+        expect(stan::diff::compare(s, s).size(), equal_to(0u));
+    });
+
+    property(_, "from nothing", [](stan::sequential s) {
+        auto edits = stan::diff::compare({}, s);
+        expect(edits.size(), equal_to(s.size()));
+        for (const auto &e : edits) {
+            expect(e.m_operation == stan::diff::operation::insert, equal_to(true));
+        }
+    });
+
+    _.test("top level", []() {
+        expect(diff("c4 d4 e4", "c4 e4 f4"),
+               equal_to("- 2      d4:4\n"
+                        "+ 3      f4:4\n"));
+        expect(diff("c4 d4 e4", "c4 g4 e4"), equal_to("~ 2      d4:4 -> g4:4\n"));
+    });
+
+    _.test("inside beams", []() {
+        expect(diff("c4 [d8 e8] f4", "c4 [d8 g8] f4"), equal_to("~ 2.2    e4:8 -> g4:8\n"));
+        expect(diff("c4 d4 [e8 f8 g8]", "c4 [e8 f8 a8]"),
+               equal_to("- 2      d4:4\n"
+                        "~ 3.3    g4:8 -> a4:8\n"));
+    });
+
+    _.test("inside tuplets", []() {
+        expect(diff(R"(\tuplet 3/2 { c8 d8 e8 })", R"(\tuplet 3/2 { c8 d8 f8 })"),
+               equal_to("~ 1.3    e4:8 -> f4:8\n"));
+    });
+
+    _.test("paths", []() {
+        stan::sequential s1 = lily.sequence("c4 [d8 e8]");
+        stan::sequential s2 = lily.sequence("r4 c4 [d8 f8]");
+        auto edits = stan::diff::compare(s1, s2);
+        expect(edits.size(), equal_to(2u));
+        expect(edits[1].m_old_path, equal_to(stan::diff::path{ 1, 1 }));
+        expect(edits[1].m_new_path, equal_to(stan::diff::path{ 2, 1 }));
+    });
+});
@@ -0,0 +1,93 @@
+#include <stan/index.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "temporary.hpp"
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+namespace {
+
+stan::lilypond::reader lily;
+
+std::vector<stan::index::term> terms(const std::string &music, unsigned kinds)
+{
+    return stan::index::terms(lily.sequence(music), 4, kinds);
+}
+
+} // namespace
+
+mettle::suite<> suite("index", [](auto &_) {
+    _.test("intervals in any key", []() {
+        expect(terms("c'4 d'4 e'4 f'4", stan::index::melody),
+               equal_to(terms("g4 a4 b4 c'4", stan::index::melody)));
+        expect(terms("c'4 d'4 e'4 f'4", stan::index::melody) ==
+                   terms("c'4 d'4 e'4 fs'4", stan::index::melody),
+               equal_to(false));
+    });
+
+    _.test("rhythm at any tempo", []() {
+        expect(terms("c4 d4 e4 f2", stan::index::rhythm),
+               equal_to(terms("g8 f8 e8 d4", stan::index::rhythm)));
+        expect(terms("c8 d8 e8 f4.", stan::index::rhythm),
+               equal_to(terms("\\tuplet 3/2 { g8 f8 e8 } d4", stan::index::rhythm)));
+    });
+
+    _.test("beams and chords", []() {
+        expect(terms("c'4 [d'8 e'8] <c' f'>4", stan::index::melody),
+               equal_to(terms("c'4 d'4 e'4 f'4", stan::index::melody)));
+    });
+
+    _.test("rests end a phrase", []() {
+        expect(terms("c4 d4 r4 e4 f4", stan::index::both).size(), equal_to(0u));
+        expect(terms("c4 d4 e4 f4 r4 g4", stan::index::both),
+               equal_to(terms("c4 d4 e4 f4", stan::index::both)));
+    });
+
+    _.test("length", []() {
+        expect([]() { stan::index::terms(lily.sequence("c4 d4"), 1); },
+               thrown<stan::index::index_error>());
+    });
+
+    _.test("build and search", []() {
+        temporary_directory dir;
+        std::vector<std::string> paths;
+        for (int i = 0; i < 300; ++i) {
+            // Every 37th file holds the fragment, sometimes transposed.
+            std::string music = i % 37 == 0 ? (i % 2 ? "r4 g4 a4 b4 c'4 r4" : "c'4 d'4 e'4 f'4")
+                                            : "c4 e4 g4 c'4 e'4 g'4";
+            paths.push_back(dir.file(std::to_string(i) + ".ly", music));
+        }
+        paths.push_back(dir.file("broken.ly", "c4 ["));
+
+        stan::index::build_options options;
+        options.m_shard_documents = 256;
+        options.m_threads = 2;
+        std::vector<std::size_t> failed;
+        stan::index::build(dir.m_path, paths, options,
+                           [&](std::size_t i, const std::string &) { failed.push_back(i); });
+        expect(failed, equal_to(std::vector<std::size_t>{ 300 }));
+
+        stan::index::searcher index(dir.m_path);
+        expect(index.documents(), equal_to(301u));
+        expect(index.name(300), equal_to(paths[300]));
+
+        std::vector<std::size_t> expected;
+        for (std::size_t i = 0; i < 300; i += 37) {
+            expected.push_back(i);
+        }
+        expect(index.search(lily.sequence("d4 e4 fs4 g4")), equal_to(expected));
+        expect(index.search(lily.sequence("d4 e4 fs4 a4")), equal_to(std::vector<std::size_t>{}));
+        expect([&]() { index.search(lily.sequence("d4 e4 r4 fs4 g4")); },
+               thrown<stan::index::index_error>());
+    });
+
+    _.test("not an index", []() {
+        temporary_directory dir;
+        expect([&]() { stan::index::searcher index(dir.m_path); },
+               thrown<stan::index::index_error>());
+    });
+});
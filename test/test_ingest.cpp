@@ -0,0 +1,101 @@
+#include <stan/ingest.hpp>
+#include "temporary.hpp"
+
+#include <mettle.hpp>
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <mutex>
+#include <stdexcept>
+
+using mettle::equal_to;
+using mettle::expect;
+
+namespace {
+
+// Sizes straddle the initial read size, so some files need more than one read.
+std::string contents(std::size_t i)
+{
+    return std::string(i * 997, static_cast<char>('a' + i % 26));
+}
+
+std::size_t open_files()
+{
+    std::size_t n = 0;
+    DIR *dir = ::opendir("/proc/self/fd");
+    while (::readdir(dir) != nullptr) {
+        ++n;
+    }
+    ::closedir(dir);
+    return n;
+}
+
+} // namespace
+
+mettle::suite<> suite("ingest", [](auto &_) {
+    for (auto backend : { stan::ingest_backend::threads, stan::ingest_backend::automatic }) {
+        _.test(stan::to_string(backend), [backend]() {
+            temporary_directory dir;
+            std::vector<std::string> paths;
+            for (std::size_t i = 0; i < 100; ++i) {
+                paths.push_back(dir.file(std::to_string(i), contents(i)));
+            }
+            paths.push_back(dir.path("missing"));
+
+            std::mutex mutex;
+            std::vector<int> seen(paths.size(), 0);
+            std::size_t mismatches = 0;
+            stan::ingest_options options;
+            options.m_backend = backend;
+            options.m_queue_depth = 8;
+            stan::ingest(
+                paths,
+                [&](std::size_t i, std::string &c, int error) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++seen[i];
+                    if (i < 100 ? error != 0 or c != contents(i) : error != ENOENT) {
+                        ++mismatches;
+                    }
+                },
+                options);
+
+            expect(mismatches, equal_to(0u));
+            expect(std::count(seen.begin(), seen.end(), 1), equal_to(101));
+        });
+    }
+
+    for (auto backend : { stan::ingest_backend::threads, stan::ingest_backend::automatic }) {
+        _.test(std::string("throwing callback with ") + stan::to_string(backend), [backend]() {
+            temporary_directory dir;
+            std::vector<std::string> paths;
+            for (std::size_t i = 0; i < 100; ++i) {
+                paths.push_back(dir.file(std::to_string(i), contents(i)));
+            }
+
+            std::size_t files = open_files();
+            std::mutex mutex;
+            std::size_t calls = 0;
+            stan::ingest_options options;
+            options.m_backend = backend;
+            options.m_queue_depth = 8;
+            options.m_threads = 4;
+            expect(
+                [&] {
+                    stan::ingest(
+                        paths,
+                        [&](std::size_t, std::string &, int) {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            if (++calls == 10) {
+                                throw std::runtime_error("stop");
+                            }
+                        },
+                        options);
+                },
+                mettle::thrown<std::runtime_error>("stop"));
+            expect(calls < paths.size(), equal_to(true));
+            expect(open_files(), equal_to(files));
+        });
+    }
+});
@@ -0,0 +1,118 @@
+#include <stan/intern.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+#include "property.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using mettle::equal_to;
+using mettle::expect;
+
+namespace {
+
+stan::lilypond::reader lily;
+
+} // namespace
+
+mettle::suite<> suite("intern", [](auto &_) {
+    property(_, "columns", [](stan::sequential music) {
+        stan::intern_table<stan::column, stan::column_hash> table;
+        std::vector<const stan::column *> first;
+        for (const auto &c : music) {
+            first.push_back(table.intern(c));
+        }
+        for (std::size_t i = 0; i < music.size(); ++i) {
+            expect(*first[i], equal_to(music[i]));
+            expect(table.intern(stan::column(music[i])), equal_to(first[i]));
+            expect(table.find(music[i]), equal_to(first[i]));
+        }
+    });
+
+    _.test("handles", []() {
+        stan::intern_table<std::string> table(stan::reclamation::epoch, 4);
+        const std::string *c = table.intern("c'4");
+        expect(table.intern("c'4"), equal_to(c));
+        expect(table.intern("d'4") == c, equal_to(false));
+        expect(table.find("e'4") == nullptr, equal_to(true));
+
+        // Growing many times over never moves what is stored.
+        for (int i = 0; i < 10000; ++i) {
+            table.intern(std::to_string(i));
+        }
+        expect(table.size(), equal_to(10002u));
+        expect(table.find("c'4"), equal_to(c));
+        expect(*c, equal_to(std::string("c'4")));
+    });
+
+    _.test("chords", []() {
+        stan::intern_table<stan::column, stan::column_hash> table;
+        auto a = table.intern(lily.sequence("<c e g>4")[0]);
+        auto b = table.intern(lily.sequence("<g e c>4")[0]);
+        auto c = table.intern(lily.sequence("<c e g>8")[0]);
+        expect(a, equal_to(b));
+        expect(a == c, equal_to(false));
+    });
+
+    for (auto r : { stan::reclamation::none, stan::reclamation::epoch }) {
+        _.test(std::string("threads, reclamation ") +
+                   (r == stan::reclamation::none ? "none" : "epoch"),
+               [r]() {
+                   constexpr int threads = 8;
+                   constexpr int keys = 20000;
+                   stan::intern_table<int> table(r, 16);
+                   std::vector<std::vector<const int *>> handles(
+                       threads, std::vector<const int *>(keys));
+
+                   std::vector<std::thread> pool;
+                   for (int t = 0; t < threads; ++t) {
+                       pool.emplace_back([&, t]() {
+                           for (int i = 0; i < keys; ++i) {
+                               int key = (i * 7 + t * 13) % keys;
+                               handles[t][key] = table.intern(key);
+                           }
+                       });
+                   }
+                   for (auto &t : pool) {
+                       t.join();
+                   }
+
+                   expect(table.size(), equal_to(std::size_t(keys)));
+                   for (int key = 0; key < keys; ++key) {
+                       expect(*handles[0][key], equal_to(key));
+                       for (int t = 1; t < threads; ++t) {
+                           expect(handles[t][key], equal_to(handles[0][key]));
+                       }
+                   }
+               });
+    }
+
+    _.test("more threads than a small table has room for", []() {
+        // Every thread inserting into a table of 16 slots at once, each
+        // under a stripe lock of its own, must not fill it.
+        constexpr int threads = 32;
+        for (int round = 0; round < 50; ++round) {
+            stan::intern_table<int> table(stan::reclamation::none, 4);
+            std::atomic<int> ready{ 0 };
+            std::vector<std::thread> pool;
+            for (int t = 0; t < threads; ++t) {
+                pool.emplace_back([&, t]() {
+                    ++ready;
+                    while (ready.load() < threads) {
+                    }
+                    for (int i = 0; i < 4; ++i) {
+                        table.intern(t * 4 + i);
+                    }
+                });
+            }
+            for (auto &t : pool) {
+                t.join();
+            }
+            expect(table.size(), equal_to(std::size_t(threads * 4)));
+        }
+    });
+});
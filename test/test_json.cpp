@@ -0,0 +1,147 @@
+#include <stan/driver/json.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+#include <string>
+
+using mettle::equal_to;
+using mettle::expect;
+
+namespace {
+
+stan::lilypond::reader lily;
+stan::driver::json::writer to_json;
+
+std::string json(const std::string &text)
+{
+    return to_json(lily.sequence(text));
+}
+
+std::string escaped(const std::string &text)
+{
+    std::string out = "prefix ";
+    stan::driver::json::escape(out, text);
+    return out.substr(7);
+}
+
+// One byte at a time, to check the block by block routine against.
+std::string escaped_slowly(const std::string &text)
+{
+    std::string out;
+    for (unsigned char c : text) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (c < 0x20) {
+                const char *hex = "0123456789abcdef";
+                out += std::string("\\u00") + hex[c >> 4] + hex[c & 15];
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+mettle::suite<> suite("json", [](auto &_) {
+    _.test("columns", []() {
+        expect(json("r4. c8"),
+               equal_to(std::string(R"([{"type":"rest","value":"4."},)"
+                                    R"({"type":"note","value":"8","pitch":"c4"}])")));
+        expect(json("<c' e' gs'>2.. bf,,16"),
+               equal_to(std::string(R"([{"type":"chord","value":"2..","pitches":["c5","e5","gs5"]},)"
+                                    R"({"type":"note","value":"16","pitch":"bf2"}])")));
+        expect(json(R"([c16 d16 e8] \tuplet 3/2 { f8 g8 a8 })"),
+               equal_to(std::string(R"([{"type":"beam","elements":[)"
+                                    R"({"type":"note","value":"16","pitch":"c4"},)"
+                                    R"({"type":"note","value":"16","pitch":"d4"},)"
+                                    R"({"type":"note","value":"8","pitch":"e4"}]},)"
+                                    R"({"type":"tuplet","value":"4","elements":[)"
+                                    R"({"type":"note","value":"8","pitch":"f4"},)"
+                                    R"({"type":"note","value":"8","pitch":"g4"},)"
+                                    R"({"type":"note","value":"8","pitch":"a4"}]}])")));
+        expect(json(""), equal_to(std::string("[]")));
+
+        // Values outside value::all, and each spelling read back.
+        std::string out = json("c64. d32.. e64..");
+        expect(out, equal_to(std::string(R"([{"type":"note","value":"64.","pitch":"c4"},)"
+                                         R"({"type":"note","value":"32..","pitch":"d4"},)"
+                                         R"({"type":"note","value":"64..","pitch":"e4"}])")));
+        std::string notes;
+        for (std::size_t at = out.find(R"("value":")"); at != std::string::npos;
+             at = out.find(R"("value":")", at + 1)) {
+            std::size_t begin = at + 9;
+            notes += "c" + out.substr(begin, out.find('"', begin) - begin) + ' ';
+        }
+        expect(lily.sequence(notes), equal_to(lily.sequence("c64. c32.. c64..")));
+    });
+
+    _.test("changes", []() {
+        expect(json(R"(\time 3/4 \clef bass \key fs \minor)"),
+               equal_to(std::string(R"([{"type":"meter","beats":[3],"value":"4"},)"
+                                    R"({"type":"clef","clef":"bass"},)"
+                                    R"({"type":"key","tonic":"fs","mode":"minor"}])")));
+        stan::sequential dorian{ stan::key(stan::pitchclass::d, { 0, 2, 3, 5, 7, 9, 10 }) };
+        expect(to_json(dorian),
+               equal_to(std::string(R"([{"type":"key","tonic":"d","mode":[0,2,3,5,7,9,10]}])")));
+    });
+
+    _.test("score", []() {
+        stan::score s = lily.score(R"({ c4-> ( d4\mf [e8-. f8] ) g2 })"
+                                   R"( \addlyrics { Twin4 -- kle "\"lit\" tle" star __ })");
+        expect(to_json(s),
+               equal_to(std::string(R"({"music":[{"type":"note","value":"4","pitch":"c4"},)"
+                                    R"({"type":"note","value":"4","pitch":"d4"},)"
+                                    R"({"type":"beam","elements":[)"
+                                    R"({"type":"note","value":"8","pitch":"e4"},)"
+                                    R"({"type":"note","value":"8","pitch":"f4"}]},)"
+                                    R"({"type":"note","value":"2","pitch":"g4"}],)"
+                                    R"("verses":[[{"note":0,"text":"Twin","join":"hyphen"},)"
+                                    R"({"note":1,"text":"kle"},)"
+                                    R"({"note":2,"text":"\"lit\" tle"},)"
+                                    R"({"note":3,"text":"star","join":"extender"}]],)"
+                                    R"("dynamics":[{"note":1,"dynamic":"mf"}],)"
+                                    R"("articulations":[{"note":0,"articulation":"accent"},)"
+                                    R"({"note":2,"articulation":"staccato"}],)"
+                                    R"("spanners":[{"type":"slur","first":0,"last":3}]})")));
+
+        std::string out = "[";
+        to_json.append(out, stan::score{});
+        expect(out, equal_to(std::string(R"([{"music":[],"verses":[],"dynamics":[],)"
+                                         R"("articulations":[],"spanners":[]})")));
+    });
+
+    _.test("escape", []() {
+        expect(escaped(""), equal_to(std::string()));
+        expect(escaped("plain"), equal_to(std::string("plain")));
+        expect(escaped("say \"hi\"\\\n"), equal_to(std::string("say \\\"hi\\\"\\\\\\n")));
+        expect(escaped(std::string("\x01\x1f\x7f", 3)), equal_to(std::string("\\u0001\\u001f\x7f")));
+        expect(escaped("Grüß Gott, 春の海"), equal_to(std::string("Grüß Gott, 春の海")));
+
+        // Every special byte at every position of blocks and tails.
+        std::string base = "Ah, vous dirai-je, maman, ce qui cause mon tourment?";
+        for (char special : { '"', '\\', '\n', '\t', '\0', '\x1b' }) {
+            for (std::size_t at = 0; at < base.size(); ++at) {
+                std::string text = base;
+                text[at] = special;
+                text.insert(at / 2, 1, special);
+                expect(escaped(text), equal_to(escaped_slowly(text)));
+            }
+        }
+    });
+});
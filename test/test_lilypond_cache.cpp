@@ -0,0 +1,80 @@
+#include <stan/driver/lilypond_cache.hpp>
+#include "temporary.hpp"
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+#include <fstream>
+#include <iterator>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+mettle::suite<> suite("lilypond cache", [](auto &_) {
+    static stan::lilypond::reader read;
+
+    _.test("hit", []() {
+        temporary_directory dir;
+        std::string lily = "{ c4 d8 [e16 f16] <c e g>4 }";
+        {
+            stan::lilypond::cached_reader cache(dir.m_path);
+            expect(cache.sequence(lily), equal_to(read.sequence(lily)));
+            expect(cache.stats().m_misses, equal_to(1u));
+        }
+        stan::lilypond::cached_reader cache(dir.m_path);
+        expect(cache.sequence(lily), equal_to(read.sequence(lily)));
+        expect(cache.stats().m_hits, equal_to(1u));
+        expect(dir.files().size(), equal_to(1u));
+    });
+
+    _.test("corrupt entry", []() {
+        temporary_directory dir;
+        std::string lily = "c4 d4";
+        stan::lilypond::cached_reader cache(dir.m_path);
+        cache.sequence(lily);
+        std::ofstream(dir.path(dir.files().front())) << "garbage";
+
+        expect(cache.sequence(lily), equal_to(read.sequence(lily)));
+        expect(cache.stats().m_misses, equal_to(2u));
+    });
+
+    _.test("entry breaking the rules of notation", []() {
+        temporary_directory dir;
+        std::string lily = "<c e>4";
+        stan::lilypond::cached_reader cache(dir.m_path);
+        cache.sequence(lily);
+
+        // Make the chord's second pitch repeat its first.
+        std::string path = dir.path(dir.files().front());
+        std::string data;
+        {
+            std::ifstream in(path, std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        data[data.size() - 2] = data[data.size() - 4];
+        std::ofstream(path, std::ios::binary) << data;
+
+        expect(cache.sequence(lily), equal_to(read.sequence(lily)));
+        expect(cache.stats().m_misses, equal_to(2u));
+        expect(dir.files().size(), equal_to(1u));
+    });
+
+    _.test("parse error", []() {
+        temporary_directory dir;
+        stan::lilypond::cached_reader cache(dir.m_path);
+        expect([&] { cache.sequence("{ c4"); },
+               thrown<std::runtime_error>("incomplete parse"));
+        expect(dir.files().size(), equal_to(0u));
+    });
+
+    _.test("eviction", []() {
+        temporary_directory dir;
+        stan::lilypond::cached_reader cache(dir.m_path, 64);
+        for (const char *lily : { "c4", "d4", "e4", "f4", "g4", "a4", "b4", "c'4" }) {
+            cache.sequence(lily);
+        }
+        expect(cache.stats().m_evictions > 0, equal_to(true));
+        expect(dir.files().size() < 8, equal_to(true));
+    });
+});
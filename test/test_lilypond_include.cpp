@@ -0,0 +1,116 @@
+#include <stan/driver/lilypond_include.hpp>
+#include <stan/scheduler.hpp>
+#include "temporary.hpp"
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+mettle::suite<> suite("lilypond include", [](auto &_) {
+    static stan::lilypond::reader read;
+
+    _.test("splice", []() {
+        temporary_directory dir;
+        dir.directory("lib");
+        std::string main = dir.file("main.ly", R"({ c4 \include "a.ly" d4 \include "b.ly" })");
+        dir.file("a.ly", R"(e8 \include "lib/c.ly" f8)");
+        dir.file("b.ly", R"(\include "lib/c.ly")");
+        dir.file("lib/c.ly", "[g16 a16]");
+
+        stan::lilypond::include_reader includes;
+        expect(includes.read(main),
+               equal_to(read.sequence("c4 e8 [g16 a16] f8 d4 [g16 a16]")));
+        expect(includes.files(), equal_to(4u));
+    });
+
+    _.test("search path", []() {
+        temporary_directory dir;
+        std::string lib = dir.directory("lib");
+        std::string main = dir.file("main.ly", R"(c4 \include "c.ly")");
+        dir.file("lib/c.ly", "d4");
+
+        expect([&] { stan::lilypond::include_reader().read(main); },
+               thrown<stan::lilypond::include_error>());
+        stan::lilypond::include_reader includes({ lib });
+        expect(includes.read(main), equal_to(read.sequence("c4 d4")));
+    });
+
+    _.test("cycle", []() {
+        temporary_directory dir;
+        std::string a = dir.file("a.ly", R"(c4 \include "b.ly")");
+        dir.file("b.ly", R"(d4 \include "a.ly")");
+
+        stan::lilypond::include_reader includes;
+        expect([&] { includes.read(a); }, thrown<stan::lilypond::include_error>());
+    });
+
+    _.test("articulations and hairpins", []() {
+        temporary_directory dir;
+        std::string main = dir.file(
+            "main.ly", R"({ c4-> d4 \include "a.ly" e4\< <c e>4\! \include "a.ly" f4\> g4-! \include "a.ly" })");
+        dir.file("a.ly", "<e g>8");
+
+        stan::lilypond::include_reader includes;
+        expect(includes.read(main),
+               equal_to(read.sequence("c4-> d4 <e g>8 e4\\< <c e>4\\! <e g>8 f4\\> g4-! <e g>8")));
+    });
+
+    _.test("parse error", []() {
+        temporary_directory dir;
+        std::string main = dir.file("main.ly", R"(c4 \include "bad.ly")");
+        std::string bad = dir.file("bad.ly", "c4 x");
+
+        stan::lilypond::include_reader includes;
+        expect([&] { includes.read(main); },
+               thrown<stan::lilypond::include_error>(
+                   "include error: " + bad + ": incomplete parse"));
+    });
+
+    _.test("read contents", []() {
+        temporary_directory dir;
+        dir.file("a.ly", "d4");
+        std::string main = dir.path("main.ly");
+
+        stan::lilypond::include_reader includes;
+        int plain = 0;
+        auto parse = [&](const std::string &text) {
+            ++plain;
+            return read.sequence(text);
+        };
+        expect(stan::lilypond::read_contents(main, R"(c4 \include "a.ly")", includes, parse),
+               equal_to(read.sequence("c4 d4")));
+        expect(stan::lilypond::read_contents(main, "e4", includes, parse),
+               equal_to(read.sequence("e4")));
+        expect(plain, equal_to(1));
+    });
+
+    _.test("one thread", []() {
+        // Loads share the executor, so a project deeper and wider than its
+        // threads still loads: each waiting file parses its includes itself.
+        temporary_directory dir;
+        std::string main = dir.file("main.ly", R"(\include "deep0.ly" \include "wide.ly")");
+        std::string wide, deep, leaves;
+        for (int i = 0; i < 64; ++i) {
+            dir.file("deep" + std::to_string(i) + ".ly",
+                     "c4 \\include \"deep" + std::to_string(i + 1) + ".ly\"");
+            dir.file("leaf" + std::to_string(i) + ".ly", "d8");
+            wide += "\\include \"leaf" + std::to_string(i) + ".ly\" ";
+            deep += "c4 ";
+            leaves += " d8";
+        }
+        dir.file("deep64.ly", "e2");
+        dir.file("wide.ly", wide);
+
+        stan::set_default_executor(std::make_shared<stan::scheduler>(1));
+        {
+            stan::lilypond::include_reader includes;
+            expect(includes.read(main), equal_to(read.sequence(deep + "e2" + leaves)));
+            expect(includes.files(), equal_to(131u));
+        }
+        stan::set_default_executor(nullptr);
+    });
+});
+
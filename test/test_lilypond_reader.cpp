@@ -40,3 +40,69 @@ mettle::suite<
                        thrown<std::runtime_error>("incomplete parse"));
             });
         });
+
+mettle::suite<> sequence_suite("lilypond sequence reader", [](auto &_) {
+    static stan::lilypond::reader read;
+    static stan::lilypond::writer write;
+
+    property(_, "writeread", [](stan::sequential s) {
+        expect(read.sequence(write(s)), equal_to(s));
+    });
+
+    _.test("bare", []() {
+        expect(read.sequence("c4 d8 [e16 f16]"),
+               equal_to(read.sequence("{ c4 d8 [e16 f16] }")));
+        expect(read.sequence("").size(), equal_to(0u));
+    });
+
+    _.test("meters", []() {
+        expect(read.sequence(R"(\time 255/4 c4)").size(), equal_to(2u));
+        expect([] { read.sequence(R"(\time 0/4 c4)"); },
+               thrown<stan::invalid_meter>("invalid meter: measures of no beats"));
+        expect([] { read.sequence(R"(\time 256/4 c4)"); },
+               thrown<stan::invalid_meter>("invalid meter: 256 beats are more than 255"));
+    });
+
+    _.test("unbalanced", []() {
+        expect([] { read.sequence("{ c4 d4"); },
+               thrown<std::runtime_error>("incomplete parse"));
+        expect([] { read.sequence("c4 d4 }"); },
+               thrown<std::runtime_error>("incomplete parse"));
+    });
+});
+
+mettle::suite<> stream_suite("lilypond stream reader", [](auto &_) {
+    static stan::lilypond::reader read;
+    static stan::lilypond::writer write;
+
+    // Feed the text in pieces of every size from one byte up, so that every
+    // column is at some point cut short at every position.
+    auto streamed = [](const std::string &lily, std::size_t piece) {
+        stan::sequential music;
+        stan::lilypond::stream_reader stream;
+        for (std::size_t i = 0; i < lily.size(); i += piece) {
+            stream.feed(lily.data() + i, std::min(piece, lily.size() - i), music);
+        }
+        stream.finish(music);
+        return music;
+    };
+
+    property(_, "writeread", [streamed](stan::sequential s, std::uint8_t piece) {
+        expect(streamed(write(s), piece % 16 + 1), equal_to(s));
+    });
+
+    _.test("bare", [streamed]() {
+        for (std::size_t piece = 1; piece < 8; ++piece) {
+            expect(streamed("c4 d8. [e16 f16]", piece),
+                   equal_to(read.sequence("c4 d8. [e16 f16]")));
+        }
+        expect(streamed("", 1).size(), equal_to(0u));
+    });
+
+    _.test("unbalanced", [streamed]() {
+        expect([streamed] { streamed("{ c4 d4", 1); },
+               thrown<std::runtime_error>("incomplete parse"));
+        expect([streamed] { streamed("c4 d4 }", 1); },
+               thrown<std::runtime_error>("incomplete parse"));
+    });
+});
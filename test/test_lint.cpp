@@ -0,0 +1,192 @@
+#include <stan/lint.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+#include <string>
+#include <vector>
+
+using mettle::equal_to;
+using mettle::expect;
+
+namespace {
+
+stan::lilypond::reader lily;
+
+// Each diagnostic as "rule path: message", for comparing whole runs.
+std::vector<std::string> found(const std::vector<stan::sequential> &music)
+{
+    std::vector<stan::lint::voice> voices(music.begin(), music.end());
+    std::vector<std::string> out;
+    for (const auto &d : stan::lint::check(voices)) {
+        std::string path;
+        for (std::size_t i : d.m_path) {
+            path += (path.empty() ? "" : ".") + std::to_string(i);
+        }
+        out.push_back(std::string(d.m_rule) + " " + path + ": " + d.m_message);
+    }
+    return out;
+}
+
+std::vector<std::string> found(const std::string &text)
+{
+    return found(std::vector<stan::sequential>{ lily.sequence(text) });
+}
+
+using strings = std::vector<std::string>;
+
+// Reports every clef and every key, to see rules share one walk and only
+// see the kinds they visit.
+struct changes
+{
+    static constexpr const char *name = "changes";
+    using visits = stan::lint::visits<stan::clef, stan::key>;
+
+    void visit(const stan::clef &, stan::lint::context &ctx)
+    {
+        ctx.report(stan::lint::severity::warning, "clef " + std::to_string(++m_seen));
+    }
+    void visit(const stan::key &, stan::lint::context &ctx)
+    {
+        ctx.report(stan::lint::severity::warning, "key " + std::to_string(++m_seen));
+    }
+
+    int m_seen = 0;
+};
+
+struct measures
+{
+    static constexpr const char *name = "measures";
+    using visits = stan::lint::visits<stan::note>;
+
+    void visit(const stan::note &, stan::lint::context &ctx)
+    {
+        ctx.report(stan::lint::severity::warning,
+                   std::to_string(ctx.measure()) + " " + std::to_string(ctx.onset()) + " " +
+                       std::to_string(ctx.end()));
+    }
+};
+
+} // namespace
+
+mettle::suite<> suite("lint", [](auto &_) {
+    _.test("source spans", []() {
+        std::vector<stan::source_span> spans;
+        std::string text = R"({ c4-. [d8 e8] \tuplet 3/2 { f8 g8 a8 } })";
+        stan::sequential music = lily.sequence(text, spans);
+        expect(music, equal_to(lily.sequence(text)));
+
+        std::vector<std::string> read;
+        for (const auto &s : spans) {
+            read.push_back(text.substr(s.m_begin, s.m_end - s.m_begin));
+        }
+        expect(read, equal_to(strings{ "c4-.", "[d8 e8]", "d8", "e8",
+                                       R"(\tuplet 3/2 { f8 g8 a8 })", "f8", "g8", "a8" }));
+    });
+
+    _.test("clean", []() {
+        expect(found(R"({ \time 3/4 \key d \major d4 [fs8 a8] <d fs a>4 r2. })"),
+               equal_to(strings{}));
+    });
+
+    _.test("parallel fifths", []() {
+        expect(found("<c g>4 <d a>4 <d a>4 <e b>4 c4 <f c'>4"),
+               equal_to(strings{ "parallel-fifths 1: parallel fifths between voices 1 and 2",
+                                 "parallel-fifths 3: parallel fifths between voices 1 and 2" }));
+        expect(found("<c e g>4 <d f a>4"),
+               equal_to(strings{ "parallel-fifths 1: parallel fifths between voices 1 and 3" }));
+        expect(found("<c g>4 <c g'>4 <c e g>4 <d a>4"), equal_to(strings{}));
+    });
+
+    _.test("out of range", []() {
+        expect(found(R"(g,,,,4 a,,,,4 <c e g'''>4)"),
+               equal_to(strings{ "out-of-range 0: g0 is below the lowest note, a0" }));
+        stan::sequential high{ stan::note(stan::value::quarter(),
+                                          stan::pitch(stan::pitchclass::d, stan::octave(8))) };
+        expect(found(std::vector<stan::sequential>{ high }),
+               equal_to(strings{ "out-of-range 0: d8 is above the highest note, c8" }));
+
+        stan::lint::linter<stan::lint::out_of_range> violin(
+            stan::lint::out_of_range(stan::pitch(stan::pitchclass::g, stan::octave(3)),
+                                     stan::pitch(stan::pitchclass::a, stan::octave(7))));
+        stan::sequential music = lily.sequence("f,4 g,4 a'''4 b'''4");
+        auto d = violin({ music });
+        expect(d.size(), equal_to(2u));
+        expect(d[0].m_path, equal_to(stan::lint::path{ 0 }));
+        expect(d[1].m_path, equal_to(stan::lint::path{ 3 }));
+        expect(d[1].m_severity == stan::lint::severity::error, equal_to(true));
+    });
+
+    _.test("odd beaming", []() {
+        expect(found(R"([c4 d4] [e8 \tuplet 3/2 { r16 r16 r16 }] [f8 g8 a8 b8 c'8 d'8 e'8 f'8 g'8])"),
+               equal_to(strings{ "odd-beaming 0: beam over a quarter note or longer",
+                                 "odd-beaming 1: beam over fewer than two notes",
+                                 "odd-beaming 2: beam crosses a bar line" }));
+        expect(found(R"([c8 \tuplet 3/2 { d16 e16 f16 }] [[g16 a16] b8])"), equal_to(strings{}));
+    });
+
+    _.test("bar length", []() {
+        expect(found(R"(\time 3/4 c2 d2 e2 f4 \time 2/4 g2 a2)"),
+               equal_to(strings{ "bar-length 2: runs over the end of measure 1",
+                                 "bar-length 5: meter change cuts measure 3 short" }));
+        expect(found(R"(\tuplet 3/2 { c4 d4 e4 } f2 g1)"), equal_to(strings{}));
+        expect(found(R"(c2 \tuplet 3/2 { d2 e2 f2 })"),
+               equal_to(strings{ "bar-length 1.1: runs over the end of measure 1" }));
+    });
+
+    _.test("unnecessary accidentals", []() {
+        expect(found(R"(es4 cf4 fss4 ess4 fs4 bf4)"),
+               equal_to(strings{ "unnecessary-accidentals 0: es could be written f",
+                                 "unnecessary-accidentals 1: cf could be written b",
+                                 "unnecessary-accidentals 2: fss could be written g",
+                                 "unnecessary-accidentals 3: ess could be written fs" }));
+        expect(found(R"(\key cs \major es4 bs4 \key c \major <c es>4)"),
+               equal_to(strings{ "unnecessary-accidentals 4: es could be written f" }));
+    });
+
+    _.test("meter of no length", []() {
+        // Not something the reader gives, but lint must not hang on it.
+        stan::meter empty{ { 3 }, stan::value::quarter() };
+        empty.m_beats[0] = 0;
+        stan::sequential music = lily.sequence("c2 d2 e2 f2");
+        music.insert(music.begin() + 1, empty);
+        expect(found(std::vector<stan::sequential>{ music }),
+               equal_to(strings{ "bar-length 1: meter change cuts measure 1 short" }));
+    });
+
+    _.test("one walk per voice", []() {
+        stan::sequential first = lily.sequence(R"({ \clef bass c4 \key g \major d4 \clef treble })");
+        stan::sequential second = lily.sequence(R"({ \time 3/8 c8 d4 e4. \tuplet 3/2 { f8 g8 a8 } })");
+
+        stan::lint::linter<changes, measures> rules(changes{}, measures{});
+        auto d = rules({ first, second });
+        std::vector<std::string> messages;
+        for (const auto &x : d) {
+            messages.push_back(std::to_string(x.m_voice) + " " + x.m_rule + " " + x.m_message);
+        }
+        expect(messages, equal_to(strings{ "0 changes clef 1", "0 measures 0 0 960",
+                                           "0 changes key 2", "0 measures 0 960 1920",
+                                           "0 changes clef 3", "1 measures 0 0 480",
+                                           "1 measures 0 480 1440", "1 measures 1 1440 2880",
+                                           "1 measures 2 2880 3200", "1 measures 2 3200 3520",
+                                           "1 measures 2 3520 3840" }));
+
+        // Many voices at once come back in order.
+        std::vector<stan::sequential> many(200, lily.sequence(R"({ es4 [c4 d4] })"));
+        auto all = found(many);
+        expect(all.size(), equal_to(400u));
+    });
+
+    _.test("spans in diagnostics", []() {
+        std::string text = R"({ c4 [d8 \tuplet 3/2 { r16 r16 r16 }] })";
+        std::vector<stan::source_span> spans;
+        stan::sequential music = lily.sequence(text, spans);
+        auto d = stan::lint::check({ stan::lint::voice(music, &spans) });
+        expect(d.size(), equal_to(1u));
+        expect(text.substr(d[0].m_span->m_begin, d[0].m_span->m_end - d[0].m_span->m_begin),
+               equal_to(R"([d8 \tuplet 3/2 { r16 r16 r16 }])"));
+        expect(stan::lint::check({ stan::lint::voice(music) })[0].m_span.has_value(),
+               equal_to(false));
+    });
+});
@@ -0,0 +1,85 @@
+#include <stan/notation.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+#include <stdexcept>
+#include <string>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+namespace {
+
+stan::lilypond::reader lily;
+stan::lilypond::writer to_lily;
+
+const std::string song = R"({ c4 d4 [e8 f8] r4 \tuplet 3/2 { g8 a8 b8 } <c e g>2 })"
+                         R"( \addlyrics { Twin4 -- kle twin -- kle _ "lit tle" star __ })"
+                         R"( \addlyrics { a b c d e f g h i j })";
+
+} // namespace
+
+mettle::suite<> suite("lyrics", [](auto &_) {
+    _.test("pool", []() {
+        stan::lyrics verse;
+        verse.add(0, "Twin", stan::lyrics::join::hyphen);
+        verse.add(1, "kle");
+        verse.add(4, "star");
+        expect(verse.pool(), equal_to(std::string("Twinklestar")));
+        expect(std::string(verse.text(verse.syllables()[2])), equal_to(std::string("star")));
+        expect(verse.find(4), equal_to(&verse.syllables()[2]));
+        expect(verse.find(2) == nullptr, equal_to(true));
+        expect([&]() { verse.add(3, "little"); }, thrown<stan::invalid_lyrics>());
+
+        auto oversized = [](std::string &pool) { pool.append(70000, 'a'); };
+        expect([&]() { verse.add_with(5, oversized); }, thrown<stan::invalid_lyrics>());
+        expect(verse.pool(), equal_to(std::string("Twinklestar")));
+    });
+
+    _.test("quoted", []() {
+        stan::lyrics verse = lily.lyricmode(R"(\lyricmode { "\"lit\" tle" "a\\b" c })");
+        expect(verse.pool(), equal_to(std::string(R"("lit" tlea\bc)")));
+        expect(verse.syllables().size(), equal_to(3u));
+    });
+
+    _.test("note_count", []() {
+        expect(stan::note_count(lily.sequence(R"(c4 r4 [d8 e8] \tuplet 3/2 { f8 <g b>8 a8 })")),
+               equal_to(6u));
+    });
+
+    _.test("addlyrics", []() {
+        stan::score s = lily.score(song);
+        expect(s.m_verses.size(), equal_to(2u));
+
+        const stan::lyrics &first = s.m_verses[0];
+        expect(first.syllables().size(), equal_to(6u));
+        expect(first.syllables()[0].m_join, equal_to(stan::lyrics::join::hyphen));
+        expect(std::string(first.text(first.syllables()[4])), equal_to(std::string("lit tle")));
+        expect(first.syllables()[4].m_note, equal_to(5u));
+        expect(first.syllables()[5].m_join, equal_to(stan::lyrics::join::extender));
+
+        // Eight notes, so two syllables too many.
+        expect(s.m_verses[1].syllables().size(), equal_to(8u));
+        expect(s.m_verses[1].pool(), equal_to(std::string("abcdefgh")));
+    });
+
+    _.test("round trip", []() {
+        stan::score s = lily.score(song);
+        stan::score again = lily.score(to_lily(s));
+        expect(again.m_music, equal_to(s.m_music));
+        expect(again.m_verses == s.m_verses, equal_to(true));
+
+        stan::lyrics verse = lily.lyricmode(R"(\lyricmode { Hel -- lo "4th" \skip 4 wor8. -- ld })");
+        expect(to_lily(verse), equal_to(std::string(R"(\lyricmode { Hel -- lo "4th" _ wor -- ld })")));
+        expect(lily.lyricmode(to_lily(verse)) == verse, equal_to(true));
+    });
+
+    _.test("errors", []() {
+        expect([]() { lily.lyricmode(R"(\lyricmode { a b)"); }, thrown<std::runtime_error>());
+        expect([]() { lily.lyricmode(R"(a \markup b)"); }, thrown<std::runtime_error>());
+        expect([]() { lily.score(R"({ c4 } \addlyrics { a } b)"); }, thrown<std::runtime_error>());
+    });
+});
@@ -0,0 +1,78 @@
+#include <stan/notation.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+#include <stdexcept>
+#include <string>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+namespace {
+
+stan::lilypond::reader lily;
+stan::lilypond::writer to_lily;
+
+const std::string marked = R"({ c4\p d4-. [e8-> f8--\ff] r4 \tuplet 3/2 { g8 a8-.-> b8\sfz })"
+                           R"( <c e g>2\mf \time 3/4 c'4\pp })";
+
+} // namespace
+
+mettle::suite<> suite("marks", [](auto &_) {
+    _.test("note_table", []() {
+        stan::note_table<stan::dynamic> table;
+        table.add(7, stan::dynamic::f);
+        table.add(2, stan::dynamic::p);
+        table.add(7, stan::dynamic::p);
+        expect(table.size(), equal_to(3u));
+        expect(table.entries()[0].m_note, equal_to(2u));
+        expect(*table.find(7) == stan::dynamic::f, equal_to(true));
+        expect(table.find(3) == nullptr, equal_to(true));
+
+        auto [first, last] = table.equal_range(7);
+        expect(std::size_t(last - first), equal_to(2u));
+        expect(first[1].m_value == stan::dynamic::p, equal_to(true));
+    });
+
+    _.test("read", []() {
+        stan::score s = lily.score(marked);
+        expect(s.m_music, equal_to(lily.sequence(marked)));
+        expect(s.m_dynamics.size(), equal_to(5u));
+        expect(s.m_articulations.size(), equal_to(5u));
+
+        expect(*s.m_dynamics.find(0) == stan::dynamic::p, equal_to(true));
+        expect(*s.m_dynamics.find(3) == stan::dynamic::ff, equal_to(true));
+        expect(*s.m_dynamics.find(6) == stan::dynamic::sfz, equal_to(true));
+        expect(*s.m_dynamics.find(7) == stan::dynamic::mf, equal_to(true));
+        expect(*s.m_dynamics.find(8) == stan::dynamic::pp, equal_to(true));
+        expect(s.m_dynamics.find(1) == nullptr, equal_to(true));
+
+        auto [first, last] = s.m_articulations.equal_range(5);
+        expect(std::size_t(last - first), equal_to(2u));
+        expect(first[0].m_value == stan::articulation::staccato, equal_to(true));
+        expect(first[1].m_value == stan::articulation::accent, equal_to(true));
+        expect(*s.m_articulations.find(3) == stan::articulation::tenuto, equal_to(true));
+    });
+
+    _.test("round trip", []() {
+        stan::score s = lily.score(marked);
+        std::string text = to_lily(s);
+        expect(text, equal_to(std::string(
+                         R"({ c4\p d4-. [e8-> f8--\ff] r4 \tuplet 3/2 {g8 a8-.-> b8\sfz} )"
+                         R"(<c e g>2\mf \time 3/4 c'4\pp })")));
+
+        stan::score again = lily.score(text);
+        expect(again.m_music, equal_to(s.m_music));
+        expect(again.m_dynamics == s.m_dynamics, equal_to(true));
+        expect(again.m_articulations == s.m_articulations, equal_to(true));
+    });
+
+    _.test("errors", []() {
+        expect([]() { lily.score(R"({ c4\pq })"); }, thrown<std::runtime_error>());
+        expect([]() { lily.score(R"({ r4\p })"); }, thrown<std::runtime_error>());
+        expect([]() { lily.score(R"({ c4-x })"); }, thrown<std::runtime_error>());
+    });
+});
@@ -0,0 +1,62 @@
+#include <stan/merge.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+#include "property.hpp"
+
+using mettle::equal_to;
+using mettle::expect;
+
+namespace {
+
+stan::lilypond::reader lily;
+
+stan::merge::result merge(const std::string &base, const std::string &ours,
+                          const std::string &theirs)
+{
+    return stan::merge::merge(lily.sequence(base), lily.sequence(ours), lily.sequence(theirs));
+}
+
+const std::string base = "c4 d4 e4 f4 g4 a4 b4 c'4";
+
+} // namespace
+
+mettle::suite<> suite("merge", [](auto &_) {
+    property(_, "one side", [](stan::sequential b, stan::sequential s) {
+        expect(stan::merge::merge(b, s, b).m_merged, equal_to(s));
+        expect(stan::merge::merge(b, b, s).m_merged, equal_to(s));
+        expect(stan::merge::merge(b, s, s).m_conflicts.size(), equal_to(0u));
+    });
+
+    _.test("different measures", []() {
+        auto r = merge(base, "c4 r4 e4 f4 g4 a4 b4 c'4", "c4 d4 e4 f4 g4 a4 b4 d'4");
+        expect(r.m_conflicts.size(), equal_to(0u));
+        expect(r.m_merged, equal_to(lily.sequence("c4 r4 e4 f4 g4 a4 b4 d'4")));
+    });
+
+    _.test("same measure", []() {
+        auto r = merge(base, "c4 r4 e4 f4 g4 a4 b4 c'4", "c4 d4 e4 r4 g4 a4 b4 d'4");
+        expect(r.m_conflicts.size(), equal_to(1u));
+        const auto &c = r.m_conflicts.front();
+        expect(c.m_first_measure, equal_to(0u));
+        expect(c.m_last_measure, equal_to(0u));
+        expect(c.m_base, equal_to(lily.sequence("c4 d4 e4 f4")));
+        expect(c.m_theirs, equal_to(lily.sequence("c4 d4 e4 r4")));
+        expect(r.m_merged, equal_to(lily.sequence("c4 r4 e4 f4 g4 a4 b4 d'4")));
+    });
+
+    _.test("meter", []() {
+        std::string b = R"(\time 3/4 c4 d4 e4 f4 g4 a4)";
+        auto r = merge(b, R"(\time 3/4 c4 d4 r4 f4 g4 a4)", R"(\time 3/4 c4 d4 e4 r4 g4 a4)");
+        expect(r.m_conflicts.size(), equal_to(0u));
+        expect(r.m_merged, equal_to(lily.sequence(R"(\time 3/4 c4 d4 r4 r4 g4 a4)")));
+    });
+
+    _.test("inside a beam", []() {
+        auto r = merge("c4 [d8 e8] f4 g4 a4 b4 c'4 d'4", "c4 [d8 f8] f4 g4 a4 b4 c'4 d'4",
+                       "c4 [d8 e8] f4 g4 a4 b4 c'4 e'4");
+        expect(r.m_conflicts.size(), equal_to(0u));
+        expect(r.m_merged, equal_to(lily.sequence("c4 [d8 f8] f4 g4 a4 b4 c'4 e'4")));
+    });
+});
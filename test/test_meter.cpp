@@ -21,6 +21,10 @@ mettle::suite<> meter_suite("meter", [](auto &_) {
     _.test("invalid", []() {
         expect([] { meter{ {}, value::quarter() }; },
                thrown<invalid_meter>("invalid meter: no beats"));
+        expect([] { meter{ { 0 }, value::quarter() }; },
+               thrown<invalid_meter>("invalid meter: measures of no beats"));
+        expect([] { meter{ { 0, 0 }, value::eighth() }; },
+               thrown<invalid_meter>("invalid meter: measures of no beats"));
         expect([] { meter{ { 3 }, dot(value::quarter()) }; },
                thrown<invalid_meter>(
                    "invalid meter: value must be half, quarter, "
@@ -0,0 +1,115 @@
+#include <stan/parallel.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+#include "property.hpp"
+
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+namespace {
+
+stan::lilypond::reader lily;
+
+// Long enough to be split many times, with beams and nested tuplets.
+stan::sequential large()
+{
+    std::string music;
+    for (int i = 0; i < 2000; ++i) {
+        music += R"(c4 [d8 e8] \tuplet 3/2 { f8 g8 a8 } <c' e'>4 r4 )"
+                 R"(\tuplet 3/2 { \tuplet 3/2 { c16 d16 e16 } f8 g8 } )";
+    }
+    return lily.sequence(music);
+}
+
+stan::column up_an_octave(const stan::column &c)
+{
+    if (const auto *n = std::get_if<stan::note>(&c)) {
+        return stan::note(n->m_value, stan::pitch(n->m_pitch.m_pitchclass,
+                                                  n->m_pitch.m_octave + stan::octave(1)));
+    }
+    return c;
+}
+
+stan::duration total(const stan::sequential &music)
+{
+    return std::accumulate(music.begin(), music.end(), stan::duration::zero(),
+                           [](stan::duration d, const stan::column &c) { return d + c; });
+}
+
+} // namespace
+
+mettle::suite<> suite("parallel", [](auto &_) {
+    property(_, "transform identity", [](stan::sequential music) {
+        stan::scheduler ex(4);
+        expect(stan::parallel::transform(ex, music, [](const stan::column &c) { return c; }),
+               equal_to(music));
+    });
+
+    property(_, "duration", [](stan::sequential music) {
+        stan::scheduler ex(4);
+        stan::duration sum = stan::parallel::reduce(
+            ex, music, stan::duration::zero(), std::plus<>(),
+            [](const stan::column &c) { return stan::duration::zero() + c; },
+            [](const stan::tuplet &t, const stan::duration &) { return stan::duration(t); });
+        expect(sum, equal_to(total(music)));
+    });
+
+    _.test("transform", []() {
+        stan::scheduler ex(4);
+        stan::sequential music = large();
+        stan::sequential up = stan::parallel::transform(ex, music, up_an_octave);
+        expect(up.size(), equal_to(music.size()));
+        expect(up[0], equal_to(lily.sequence("c'4")[0]));
+        expect(up[1], equal_to(lily.sequence("[d'8 e'8]")[0]));
+        expect(up[3], equal_to(music[3]));
+    });
+
+    _.test("for_each", []() {
+        stan::scheduler ex(4);
+        stan::sequential music = large();
+        stan::parallel::for_each(ex, music, [](stan::column &c) { c = up_an_octave(c); });
+        expect(music, equal_to(stan::parallel::transform(ex, large(), up_an_octave)));
+    });
+
+    _.test("count_if", []() {
+        stan::scheduler ex(4);
+        stan::sequential music = large();
+        expect(stan::parallel::count_if(ex, music, [](const stan::column &c) {
+                   return std::holds_alternative<stan::chord>(c);
+               }),
+               equal_to(2000u));
+        expect(stan::parallel::count_if(ex, music, [](const stan::column &) { return true; }),
+               equal_to(26000u));
+    });
+
+    _.test("order", []() {
+        stan::scheduler ex(4);
+        stan::sequential music = large();
+        std::string kinds = stan::parallel::reduce(
+            ex, music, std::string(), std::plus<>(), [](const stan::column &c) {
+                return std::string(std::holds_alternative<stan::note>(c) ? "n" : "x");
+            });
+        expect(kinds.substr(0, 13), equal_to("nnnnnnxxnnnnn"));
+        expect(kinds.size(), equal_to(26000u));
+    });
+
+    _.test("exceptions", []() {
+        stan::scheduler ex(4);
+        stan::sequential music = large();
+        expect([&]() {
+            stan::parallel::for_each(ex, music, [](const stan::column &c) {
+                if (std::holds_alternative<stan::rest>(c)) {
+                    throw std::runtime_error("rest");
+                }
+            });
+        }, thrown<std::runtime_error>("rest"));
+    });
+});
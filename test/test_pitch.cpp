@@ -57,6 +57,23 @@ mettle::suite<> pitch_suite("pitch", [](auto &_) {
         expect(static_cast<std::uint8_t>(p.get_staffline()), all(greater_equal(0)));
     });
 
+    _.test("staffline", []() {
+        auto line = [](pitch p) { return static_cast<std::uint8_t>(p.get_staffline()); };
+        expect(line(pitch{ pc::c, octave(4) }), equal_to(0));
+        expect(line(pitch{ pc::dff, octave(4) }), equal_to(1));
+        expect(line(pitch{ pc::bss, octave(4) }), equal_to(6));
+        expect(line(pitch{ pc::cf, octave(5) }), equal_to(7));
+        expect(line(pitch{ pc::fs, octave(6) }), equal_to(17));
+    });
+
+    _.test("midi", []() {
+        expect(pitch({ pc::c, octave(4) }).midi(), equal_to(60));
+        expect(pitch({ pc::a, octave(4) }).midi(), equal_to(69));
+        expect(pitch({ pc::bs, octave(3) }).midi(), equal_to(60));
+        expect(pitch({ pc::cf, octave(5) }).midi(), equal_to(71));
+        expect(pitch({ pc::c, octave(0) }).midi(), equal_to(12));
+    });
+
     _.test("sorting", []() {
         expect(pitch{ pc::a, octave(3) }, less(pitch{ pc::bf, octave(3) }));
         expect(pitch{ pc::a, octave(3) }, is_not(less(pitch{ pc::bf, octave(2) })));
@@ -0,0 +1,168 @@
+#include <stan/rewrite.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+#include <string>
+
+using mettle::equal_to;
+using mettle::expect;
+
+namespace {
+
+stan::lilypond::reader lily;
+
+stan::sequential rewritten(const std::string &text)
+{
+    stan::rewrite::rewriter rewrite;
+    return rewrite(lily.sequence(text));
+}
+
+stan::sequential dotted(const std::string &text)
+{
+    stan::rewrite::rewriter rewrite({ stan::rewrite::dot_rests() });
+    return rewrite(lily.sequence(text));
+}
+
+stan::sequential dotted_within_measures(const std::string &text)
+{
+    stan::sequential music = lily.sequence(text);
+    stan::rewrite::dot_rests_within_measures(music);
+    return music;
+}
+
+} // namespace
+
+mettle::suite<> suite("rewrite", [](auto &_) {
+    _.test("dot rests", []() {
+        expect(dotted("r4 r8 c4"), equal_to(lily.sequence("r4. c4")));
+        expect(dotted("r4 r8 r16"), equal_to(lily.sequence("r4..")));
+        expect(dotted("c4 r2 r4"), equal_to(lily.sequence("c4 r2.")));
+        expect(dotted("r8 r4 r4 r4"), equal_to(lily.sequence("r8 r4 r4 r4")));
+        // Not a standard rule, as it cannot see the bar lines.
+        expect(rewritten("r4 r8 c4"), equal_to(lily.sequence("r4 r8 c4")));
+    });
+
+    _.test("dot rests within measures", []() {
+        expect(dotted_within_measures("r4 r8 c4"), equal_to(lily.sequence("r4. c4")));
+        expect(dotted_within_measures("r4 r8 r16"), equal_to(lily.sequence("r4..")));
+        expect(dotted_within_measures("c2 c4 r8 r16 r16 c4"),
+               equal_to(lily.sequence("c2 c4 r8. r16 c4")));
+
+        // The two rests straddle the bar line, and "r4." would run over it.
+        std::string straddling = R"(\time 3/4 c2 r4 r8 c8 c2)";
+        expect(dotted_within_measures(straddling), equal_to(lily.sequence(straddling)));
+        expect(dotted(straddling), equal_to(lily.sequence(R"(\time 3/4 c2 r4. c8 c2)")));
+
+        // Ending on the bar line is fine, and tuplets count in scaled time.
+        expect(dotted_within_measures(R"(\time 3/4 c4. r4 r8 c2.)"),
+               equal_to(lily.sequence(R"(\time 3/4 c4. r4. c2.)")));
+        expect(dotted_within_measures(R"(c2 c4 \tuplet 3/2 { c8 r8 r16 c16 })"),
+               equal_to(lily.sequence(R"(c2 c4 \tuplet 3/2 { c8 r8. c16 })")));
+        std::string scaled = R"(\time 3/8 c4 \tuplet 3/2 { c16 r8 r16 c16 c16 } c8)";
+        expect(dotted_within_measures(scaled), equal_to(lily.sequence(scaled)));
+        expect(dotted(scaled),
+               equal_to(lily.sequence(R"(\time 3/8 c4 \tuplet 3/2 { c16 r8. c16 c16 } c8)")));
+
+        // None leaving a tuplet one column.
+        expect(dotted_within_measures(R"(\tuplet 3/2 { r8 r16 })"),
+               equal_to(lily.sequence(R"(\tuplet 3/2 { r8 r16 })")));
+    });
+
+    _.test("flatten beams", []() {
+        expect(rewritten("[[c16 d16] e8] f4"), equal_to(lily.sequence("[c16 d16 e8] f4")));
+        expect(rewritten("[c16 [d32 [e64 f64]] g8]"),
+               equal_to(lily.sequence("[c16 d32 e64 f64 g8]")));
+    });
+
+    _.test("unwrap tuplets", []() {
+        expect(rewritten(R"(\tuplet 1/1 { c8 d8 } e4)"), equal_to(lily.sequence("c8 d8 e4")));
+        expect(rewritten(R"([c8 \tuplet 1/1 { d16 e16 }])"),
+               equal_to(lily.sequence("[c8 d16 e16]")));
+        expect(rewritten(R"(\tuplet 1/1 { r4 \tuplet 1/1 { r8 c8 } })"),
+               equal_to(lily.sequence("r4 r8 c8")));
+        expect(rewritten(R"(\tuplet 3/2 { c8 d8 e8 })"),
+               equal_to(lily.sequence(R"(\tuplet 3/2 { c8 d8 e8 })")));
+    });
+
+    _.test("keeps beams and tuplets valid", []() {
+        // Unwrapping would bring a rest into the beam.
+        expect(rewritten(R"([c8 \tuplet 1/1 { r16 e16 }])"),
+               equal_to(lily.sequence(R"([c8 \tuplet 1/1 { r16 e16 }])")));
+        // Dotting would leave the tuplet one column.
+        expect(dotted(R"(\tuplet 3/2 { r8 r16 })"),
+               equal_to(lily.sequence(R"(\tuplet 3/2 { r8 r16 })")));
+    });
+
+    _.test("long lists", []() {
+        // Every match is rewritten in place in one pass, so these stay
+        // linear in the length of the list.
+        std::string pairs, dots;
+        for (int i = 0; i < 5000; ++i) {
+            pairs += "r4 r8 c4 ";
+            dots += "r4. c4 ";
+        }
+        expect(dotted(pairs), equal_to(lily.sequence(dots)));
+
+        // Replacements longer than what they replace, which grow the list.
+        std::string nested = "[c8", flat = "[c8";
+        for (int i = 0; i < 2000; ++i) {
+            nested += " [d32 [e64 f64] g16]";
+            flat += " d32 e64 f64 g16";
+        }
+        expect(rewritten(nested + "]"), equal_to(lily.sequence(flat + "]")));
+        expect(rewritten(R"(\tuplet 1/1 { r4 \tuplet 1/1 { r8 c8 d8 e8 } })"),
+               equal_to(lily.sequence("r4 r8 c8 d8 e8")));
+    });
+
+    _.test("memoized", []() {
+        stan::rewrite::rewriter rewrite;
+        stan::sequential music = lily.sequence(R"([[c16 d16] e8] [[c16 d16] e8] r4 [[c16 d16] e8])");
+        expect(rewrite(music), equal_to(lily.sequence("[c16 d16 e8] [c16 d16 e8] r4 [c16 d16 e8]")));
+        // The outer beam and the beam inside it, each rewritten once.
+        expect(rewrite.memoized(), equal_to(2u));
+        expect(rewrite.hits(), equal_to(2u));
+
+        rewrite(music);
+        expect(rewrite.hits(), equal_to(5u));
+        rewrite.clear();
+        expect(rewrite.memoized(), equal_to(0u));
+    });
+
+    _.test("memoized on the exact subtree", []() {
+        // Values outside value::all, once spelled alike by the encoding.
+        stan::rewrite::rewriter rewrite;
+        for (const char *text : { "[c64. d64.] [c32.. d32..]", "[c32.. d32..] [c64. d64.]",
+                                  "[c64.. d64..] [c64. d64.] [c64.. d64..]" }) {
+            expect(rewrite(lily.sequence(text)), equal_to(lily.sequence(text)));
+        }
+    });
+
+    _.test("custom rules", []() {
+        namespace rw = stan::rewrite;
+
+        // A clef straight after a clef replaces it.
+        rw::rule clefs{ "repeated-clef",
+                        { rw::kind<stan::clef>(), rw::kind<stan::clef>() },
+                        [](const stan::column *run) -> std::optional<stan::sequential> {
+                            return stan::sequential{ run[1] };
+                        } };
+
+        // Middle C quarter notes in beams become eighths, where they may.
+        rw::rule halve{ "halve",
+                        { rw::kind<stan::note>([](const stan::note &n) {
+                            return n.m_pitch.m_pitchclass == stan::pitchclass::c and
+                                   n.m_value == stan::value::quarter();
+                        }) },
+                        [](const stan::column *run) -> std::optional<stan::sequential> {
+                            const auto &n = std::get<stan::note>(run[0]);
+                            return stan::sequential{ stan::note(stan::value::eighth(), n.m_pitch) };
+                        },
+                        rw::scope::in_beam };
+
+        rw::rewriter rewrite({ clefs, halve });
+        expect(rewrite(lily.sequence(R"(\clef bass \clef treble \clef alto c4 [c4 d8])")),
+               equal_to(lily.sequence(R"(\clef alto c4 [c8 d8])")));
+    });
+});
@@ -0,0 +1,151 @@
+#include <stan/notation.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+namespace {
+
+stan::lilypond::reader lily;
+stan::lilypond::writer to_lily;
+
+constexpr std::int64_t quarter = stan::ticks_per_quarter;
+
+// Columns of several lengths, some taking no time at all.
+std::vector<stan::column> palette()
+{
+    return { lily("c4"), lily("d8"), lily("r2"), lily(R"(\clef bass)"), lily("<c e g>4."),
+             lily("[e16 f16 g8]"), lily(R"(\tuplet 3/2 { c8 d8 e8 })"), lily(R"(\time 3/4)") };
+}
+
+std::int64_t length(const stan::column &c)
+{
+    stan::duration d = stan::duration::zero() + c;
+    return std::int64_t(d.num()) * 4 * quarter / d.den();
+}
+
+// Checks a rope against the vector it should equal, by every way of reading.
+void check(const stan::rope &r, const stan::sequential &v)
+{
+    expect(r.size(), equal_to(v.size()));
+    expect(r.flatten(), equal_to(v));
+    expect(stan::sequential(r.begin(), r.end()), equal_to(v));
+
+    std::int64_t at = 0;
+    std::size_t first = v.size(); // the first column to take time
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        expect(r[i], equal_to(v[i]));
+        expect(r.onset(i), equal_to(at));
+        std::int64_t ticks = length(v[i]);
+        if (ticks > 0) {
+            first = std::min(first, i);
+            expect(r.at_time(at), equal_to(i));
+            expect(r.at_time(at + ticks - 1), equal_to(i));
+        }
+        at += ticks;
+    }
+    expect(r.ticks(), equal_to(at));
+    expect(r.onset(v.size()), equal_to(at));
+    expect(r.at_time(at), equal_to(v.size()));
+    expect(r.at_time(-quarter), equal_to(first));
+
+    stan::sequential backward;
+    for (auto i = r.end(); i != r.begin();) {
+        backward.insert(backward.begin(), *--i);
+    }
+    expect(backward, equal_to(v));
+}
+
+} // namespace
+
+mettle::suite<> suite("rope", [](auto &_) {
+    _.test("empty", []() {
+        stan::rope r;
+        expect(r.empty(), equal_to(true));
+        expect(r.begin() == r.end(), equal_to(true));
+        expect(r.ticks(), equal_to(0));
+        expect(r.at_time(0), equal_to(0u));
+        expect(r.at_time(-1), equal_to(0u));
+        expect(to_lily(r), equal_to("{ }"));
+        expect([&]() { r.at(0); }, thrown<std::out_of_range>());
+        expect([&]() { r.erase(0); }, thrown<std::out_of_range>());
+        expect([&]() { r.insert(1, lily("c4")); }, thrown<std::out_of_range>());
+    });
+
+    _.test("from a list", []() {
+        stan::sequential music = lily.sequence(R"({ \time 3/4 c4 d8 e8 f4 r2. <c e g>2 g4 })");
+        stan::rope r(music);
+        check(r, music);
+        expect(r.ticks(), equal_to(9 * quarter));
+        expect(r.at_time(3 * quarter), equal_to(5u));
+        expect(to_lily(r), equal_to(to_lily(music)));
+
+        for (std::size_t n : { 1u, 47u, 48u, 49u, 100u, 3000u, 5000u }) {
+            stan::sequential v(n, stan::column(lily("c8")));
+            check(stan::rope(v), v);
+        }
+    });
+
+    _.test("edits", []() {
+        std::vector<stan::column> columns = palette();
+        std::mt19937 random(121);
+        stan::rope r;
+        stan::sequential v;
+
+        // Grow past a few levels, then shrink back to nothing, editing at
+        // random along the way.
+        for (int round = 0; round < 2; ++round) {
+            for (int step = 0; step < 6000; ++step) {
+                const stan::column &c = columns[random() % columns.size()];
+                std::size_t i = random() % (v.size() + 1);
+                bool grow = round == 0 ? random() % 4 != 0 : random() % 4 == 0;
+                if (grow or v.empty()) {
+                    r.insert(i, c);
+                    v.insert(v.begin() + i, c);
+                } else if (random() % 8 == 0) {
+                    i %= v.size();
+                    r.replace(i, c);
+                    v[i] = c;
+                } else {
+                    i %= v.size();
+                    r.erase(i);
+                    v.erase(v.begin() + i);
+                }
+                if (step % 1000 == 0) {
+                    check(r, v);
+                }
+            }
+            check(r, v);
+        }
+        while (!v.empty()) {
+            r.erase(0);
+            v.erase(v.begin());
+        }
+        check(r, v);
+    });
+
+    _.test("copies", []() {
+        stan::sequential music = lily.sequence(R"({ c4 d4 e4 f4 })");
+        stan::rope r(music);
+        stan::rope copy = r;
+        copy.push_back(lily("g4"));
+        check(r, music);
+        expect(copy.size(), equal_to(5u));
+
+        stan::rope moved = std::move(copy);
+        expect(moved.ticks(), equal_to(5 * quarter));
+        expect(copy.empty(), equal_to(true));
+        copy.push_back(lily("a4"));
+        check(copy, lily.sequence(R"({ a4 })"));
+    });
+});
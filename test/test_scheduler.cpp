@@ -0,0 +1,100 @@
+#include <stan/scheduler.hpp>
+
+#include <mettle.hpp>
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+namespace {
+
+long fibonacci(stan::executor &ex, int n)
+{
+    if (n < 10) {
+        return n < 2 ? n : fibonacci(ex, n - 1) + fibonacci(ex, n - 2);
+    }
+    long a = 0;
+    long b = 0;
+    stan::fork_join(ex, [&]() { a = fibonacci(ex, n - 1); }, [&]() { b = fibonacci(ex, n - 2); });
+    return a + b;
+}
+
+// An executor that never runs anything until asked, as a pool whose
+// threads are all busy would.
+struct stalled : stan::executor
+{
+    void submit(std::function<void()> task) override { m_tasks.push_back(std::move(task)); }
+    unsigned concurrency() const override { return 4; }
+
+    std::vector<std::function<void()>> m_tasks;
+};
+
+} // namespace
+
+mettle::suite<> suite("scheduler", [](auto &_) {
+    _.test("fork_join", []() {
+        for (unsigned threads : { 1u, 2u, 8u }) {
+            stan::scheduler s(threads);
+            expect(fibonacci(s, 25), equal_to(75025));
+        }
+    });
+
+    _.test("parallel_for", []() {
+        stan::scheduler s(4);
+        std::vector<std::size_t> v(100000);
+        stan::parallel_for(s, 0, v.size(), [&](std::size_t i) { v[i] = i; });
+        expect(std::accumulate(v.begin(), v.end(), std::size_t(0)),
+               equal_to(std::size_t(99999) * 100000 / 2));
+    });
+
+    _.test("nested", []() {
+        stan::scheduler s(4);
+        std::atomic<std::size_t> total{ 0 };
+        stan::parallel_for(s, 0, 100, [&](std::size_t i) {
+            stan::parallel_for(s, 0, 100, [&](std::size_t j) { total += i * j; });
+        });
+        expect(total.load(), equal_to(std::size_t(4950) * 4950));
+    });
+
+    _.test("exceptions", []() {
+        stan::scheduler s(4);
+        expect([&]() {
+            stan::parallel_for(s, 0, 1000, [](std::size_t i) {
+                if (i == 500) {
+                    throw std::runtime_error("parallel_for");
+                }
+            });
+        }, thrown<std::runtime_error>("parallel_for"));
+        expect([&]() {
+            stan::fork_join(s, []() {}, []() { throw std::runtime_error("fork_join"); });
+        }, thrown<std::runtime_error>("fork_join"));
+    });
+
+    _.test("external executor", []() {
+        stalled ex;
+        std::atomic<std::size_t> total{ 0 };
+        stan::parallel_for(ex, 0, 1000, [&](std::size_t i) { total += i; });
+        expect(total.load(), equal_to(std::size_t(499500)));
+        expect(fibonacci(ex, 15), equal_to(610));
+
+        // Tasks run late find their work already done.
+        for (auto &task : ex.m_tasks) {
+            task();
+        }
+        expect(total.load(), equal_to(std::size_t(499500)));
+    });
+
+    _.test("default executor", []() {
+        stan::set_default_executor(std::make_shared<stan::scheduler>(3));
+        expect(stan::default_executor().concurrency(), equal_to(3u));
+        stan::set_default_executor(nullptr);
+        std::atomic<int> calls{ 0 };
+        stan::parallel_for(0, 10, [&](std::size_t) { ++calls; });
+        expect(calls.load(), equal_to(10));
+    });
+});
@@ -0,0 +1,139 @@
+#include <stan/interval_tree.hpp>
+#include <stan/notation.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+namespace {
+
+stan::lilypond::reader lily;
+stan::lilypond::writer to_lily;
+
+using type = stan::spanner::type;
+
+// Notes 0 to 9, each a quarter (960 ticks) but for the triplet eighths 4 to
+// 6, which take 320 each, and the half note chord 7.
+const std::string phrase = R"({ c4( d4\< [e8 f8]) r4 \tuplet 3/2 { g8\( a8 b8\f } )"
+                           R"(<c e g>2\> c'4\! d'4\) e'4( f'4) })";
+
+std::vector<std::uint32_t> ids(const std::vector<const stan::spanner *> &found,
+                               const stan::score &s)
+{
+    std::vector<std::uint32_t> out;
+    for (const auto *sp : found) {
+        out.push_back(static_cast<std::uint32_t>(sp - s.m_spanners.data()));
+    }
+    return out;
+}
+
+} // namespace
+
+mettle::suite<> suite("spanner", [](auto &_) {
+    _.test("interval_tree", []() {
+        std::mt19937 random(1);
+        for (int round = 0; round < 50; ++round) {
+            std::vector<stan::interval_tree<int>::interval> intervals;
+            for (std::uint32_t i = 0; i < std::uint32_t(round * 3); ++i) {
+                int low = int(random() % 100);
+                intervals.push_back({ low, low + int(random() % 20), i });
+            }
+            stan::interval_tree<int> tree(intervals);
+            expect(tree.size(), equal_to(intervals.size()));
+
+            for (int query = 0; query < 20; ++query) {
+                int low = int(random() % 120);
+                int high = low + int(random() % 10);
+                std::vector<std::uint32_t> found;
+                tree.overlapping(low, high, [&](std::uint32_t id) { found.push_back(id); });
+                std::sort(found.begin(), found.end());
+
+                std::vector<std::uint32_t> expected;
+                for (const auto &i : intervals) {
+                    if (i.m_low <= high and low <= i.m_high) {
+                        expected.push_back(i.m_id);
+                    }
+                }
+                expect(found, equal_to(expected));
+            }
+        }
+    });
+
+    _.test("note_times", []() {
+        auto times = stan::note_times(lily.sequence(phrase));
+        expect(times.size(), equal_to(12u));
+        expect(times[2].m_onset, equal_to(1920));
+        expect(times[3].m_end, equal_to(2880));
+        expect(times[5].m_onset, equal_to(4160));
+        expect(times[7].m_onset, equal_to(4800));
+        expect(times[7].m_end, equal_to(6720));
+    });
+
+    _.test("read", []() {
+        stan::score s = lily.score(phrase);
+        expect(s.m_music, equal_to(lily.sequence(phrase)));
+        expect(s.m_spanners == std::vector<stan::spanner>{
+                                   { 0, 3, type::slur },
+                                   { 1, 6, type::crescendo },
+                                   { 4, 9, type::phrasing_slur },
+                                   { 7, 8, type::decrescendo },
+                                   { 10, 11, type::slur },
+                               },
+               equal_to(true));
+        expect(*s.m_dynamics.find(6) == stan::dynamic::f, equal_to(true));
+    });
+
+    _.test("index", []() {
+        stan::score s = lily.score(phrase);
+        stan::spanner_index index(s);
+
+        expect(ids(index.notes(5, 5), s), equal_to(std::vector<std::uint32_t>{ 1, 2 }));
+        expect(ids(index.notes(3, 4), s), equal_to(std::vector<std::uint32_t>{ 0, 1, 2 }));
+        expect(ids(index.notes(9, 10), s), equal_to(std::vector<std::uint32_t>{ 2, 4 }));
+        expect(index.notes(12, 20).empty(), equal_to(true));
+
+        // The rest, between the first slur and the triplet.
+        expect(ids(index.times(2880, 3840), s), equal_to(std::vector<std::uint32_t>{ 1 }));
+        // The end of the chord, and the start of the note after it.
+        expect(ids(index.times(6719, 6721), s), equal_to(std::vector<std::uint32_t>{ 2, 3 }));
+        expect(index.times(0, 0).empty(), equal_to(true));
+    });
+
+    _.test("round trip", []() {
+        stan::score s = lily.score(phrase);
+        stan::score again = lily.score(to_lily(s));
+        expect(again.m_music, equal_to(s.m_music));
+        expect(again.m_spanners == s.m_spanners, equal_to(true));
+        expect(again.m_dynamics == s.m_dynamics, equal_to(true));
+
+        // Hairpins handing over on one note, and a slur on a single note.
+        stan::score handover = lily.score(R"({ c4\< d4\> e4\! f4() })");
+        expect(handover.m_spanners == std::vector<stan::spanner>{
+                                          { 0, 1, type::crescendo },
+                                          { 1, 2, type::decrescendo },
+                                          { 3, 3, type::slur },
+                                      },
+               equal_to(true));
+        expect(to_lily(handover),
+               equal_to(std::string(R"({ c4\< d4\!\> e4\! f4() })")));
+    });
+
+    _.test("errors", []() {
+        expect([]() { lily.score(R"({ c4) })"); }, thrown<std::runtime_error>());
+        expect([]() { lily.score(R"({ c4( d4( e4) })"); }, thrown<std::runtime_error>());
+        expect([]() { lily.score(R"({ c4\( d4 })"); }, thrown<std::runtime_error>());
+        expect([]() { lily.score(R"({ c4\< d4 })"); }, thrown<std::runtime_error>());
+        expect(lily.sequence(R"({ c4) })").size(), equal_to(1u));
+    });
+});
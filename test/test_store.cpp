@@ -0,0 +1,96 @@
+#include <stan/store.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "temporary.hpp"
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+#include "property.hpp"
+
+#include <fstream>
+
+using mettle::equal_to;
+using mettle::expect;
+using mettle::thrown;
+
+namespace {
+
+stan::lilypond::reader lily;
+
+const std::string score = R"(c4 d4 e4 f4 \time 3/4 g2 a4 [b8 c'8] d'2 e'2.)";
+
+} // namespace
+
+mettle::suite<> suite("store", [](auto &_) {
+    property(_, "round trip", [](stan::sequential music) {
+        temporary_directory dir;
+        stan::score_store store(dir.path("store"));
+        store.put(7, music);
+        expect(store.get(7), equal_to(music));
+    });
+
+    _.test("measures", []() {
+        temporary_directory dir;
+        stan::score_store store(dir.path("store"));
+        store.put(1, lily.sequence(score));
+
+        expect(store.measures(1), equal_to(4u));
+        expect(store.get(1, 0, 0), equal_to(lily.sequence("c4 d4 e4 f4")));
+        expect(store.get(1, 1, 2), equal_to(lily.sequence(R"(\time 3/4 g2 a4 [b8 c'8] d'2)")));
+        expect(store.get(1, 3, 100), equal_to(lily.sequence("e'2.")));
+        expect(store.get(1, 5, 9), equal_to(stan::sequential{}));
+        expect(store.get(2), equal_to(stan::sequential{}));
+        expect(store.measures(2), equal_to(0u));
+    });
+
+    _.test("replace and remove", []() {
+        temporary_directory dir;
+        stan::score_store store(dir.path("store"));
+        store.put({ { 1, lily.sequence(score) }, { 2, lily.sequence("c1 d1") } });
+        store.put(1, lily.sequence("e1"));
+        expect(store.get(1), equal_to(lily.sequence("e1")));
+        expect(store.get(2), equal_to(lily.sequence("c1 d1")));
+
+        store.remove(2);
+        expect(store.measures(2), equal_to(0u));
+        expect(store.get(1), equal_to(lily.sequence("e1")));
+    });
+
+    _.test("many scores", []() {
+        temporary_directory dir;
+        std::vector<std::pair<std::uint64_t, stan::sequential>> scores;
+        for (std::uint64_t id = 0; id < 2000; ++id) {
+            scores.emplace_back(id * 3, lily.sequence(id % 2 ? score : "c4 d4 e4 f4 g1 a1"));
+        }
+        {
+            stan::score_store store(dir.path("store"));
+            store.put(scores);
+        }
+
+        stan::score_store store(dir.path("store"));
+        for (const auto &[id, music] : scores) {
+            expect(store.get(id), equal_to(music));
+        }
+        expect(store.get(1, 0, 10), equal_to(stan::sequential{}));
+    });
+
+    _.test("checksum", []() {
+        temporary_directory dir;
+        {
+            stan::score_store store(dir.path("store"));
+            store.put(1, lily.sequence(score));
+        }
+        {
+            std::fstream f(dir.path("store"), std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(2 * stan::score_store::page_size + 100);
+            f.put('x');
+        }
+        stan::score_store store(dir.path("store"));
+        expect([&]() { store.get(1); }, thrown<stan::store_error>());
+    });
+
+    _.test("not a store", []() {
+        temporary_directory dir;
+        std::ofstream(dir.path("store")) << std::string(2 * stan::score_store::page_size, 'x');
+        expect([&]() { stan::score_store store(dir.path("store")); }, thrown<stan::store_error>());
+    });
+});
@@ -0,0 +1,100 @@
+#include <stan/notation.hpp>
+#include <stan/parallel.hpp>
+#include <stan/driver/arrow.hpp>
+#include <stan/driver/lilypond.hpp>
+#include "to_printable.hpp"
+
+#include <mettle.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using mettle::equal_to;
+using mettle::expect;
+
+namespace {
+
+stan::lilypond::reader lily;
+stan::lilypond::writer to_lily;
+
+namespace iv = stan::intervals;
+
+// A B flat clarinet part as written.
+const std::string written = R"({ \key d \major \time 3/4 r4 d4 [fs8 a8] r2. )"
+                            R"(\tuplet 3/2 { e8 g8 b8 } <d fs a>2 })";
+const std::string concert = R"({ \key c \major \time 3/4 r4 c4 [e8 g8] r2. )"
+                            R"(\tuplet 3/2 { d8 f8 a8 } <c e g>2 })";
+
+} // namespace
+
+mettle::suite<> suite("transposed", [](auto &_) {
+    _.test("transpose", []() {
+        expect(stan::transpose(lily.sequence(written), -iv::M2),
+               equal_to(lily.sequence(concert)));
+        expect(stan::transpose(lily(R"(<c e g>4)"), iv::m3), equal_to(lily(R"(<ef g bf>4)")));
+    });
+
+    _.test("view", []() {
+        stan::sequential part = lily.sequence(written);
+        stan::sequential expected = lily.sequence(concert);
+        stan::transposed view(part, -iv::M2);
+        expect(view.size(), equal_to(part.size()));
+        expect(view.cached(), equal_to(0u));
+
+        // Only columns with pitches are kept, and only once read.
+        expect(view[4], equal_to(expected[4]));
+        expect(view.cached(), equal_to(1u));
+        expect(&view[2] == &part[2], equal_to(true));
+        expect(&view[4] == &view[4], equal_to(true));
+
+        expect(stan::sequential(view.begin(), view.end()), equal_to(expected));
+        expect(view.cached(), equal_to(5u));
+        expect(part, equal_to(lily.sequence(written)));
+
+        stan::transposed moved(std::move(view));
+        expect(stan::sequential(moved.begin(), moved.end()), equal_to(expected));
+        expect(moved.cached(), equal_to(5u));
+        expect(view.empty(), equal_to(true));
+        expect(view.cached(), equal_to(0u));
+        expect(view.begin() == view.end(), equal_to(true));
+        expect([&]() { view[0]; }, mettle::thrown<std::out_of_range>());
+    });
+
+    _.test("writers", []() {
+        stan::sequential part = lily.sequence(written);
+        stan::sequential expected = lily.sequence(concert);
+        stan::transposed view(part, -iv::M2);
+        expect(to_lily(view), equal_to(to_lily(expected)));
+
+        stan::driver::arrow::writer arrow;
+        expect(arrow(view), equal_to(arrow(expected)));
+    });
+
+    _.test("parallel", []() {
+        // Enough columns to split, read from several threads at once.
+        stan::sequential part;
+        for (int i = 0; i < 5000; ++i) {
+            part.push_back(lily(R"([d8 fs8])"));
+            part.push_back(lily(R"(r4)"));
+        }
+        stan::transposed view(part, -iv::M2);
+
+        auto is_c = [](const stan::column &c) {
+            const auto *n = std::get_if<stan::note>(&c);
+            return n != nullptr and n->m_pitch.m_pitchclass == stan::pitchclass::c;
+        };
+        std::vector<std::thread> threads;
+        std::vector<std::size_t> counts(4);
+        for (std::size_t t = 0; t < counts.size(); ++t) {
+            threads.emplace_back([&, t]() { counts[t] = stan::parallel::count_if(view, is_c); });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        for (std::size_t count : counts) {
+            expect(count, equal_to(5000u));
+        }
+        expect(view.cached(), equal_to(5000u));
+    });
+});
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stan/notation.hpp>
+#include <stan/driver/lilypond.hpp>
+#include <stan/driver/debug.hpp>
+#include <stan/driver/json.hpp>
+
+#include <string>
+
+// Output formats shared by the command line tools.  LilyPond is the only
+// reader, so every tool reads LilyPond and writes one of these.
+
+namespace stan::tools {
+
+enum struct format
+{
+    lilypond,
+    debug,
+    json
+};
+
+inline format parse_format(const std::string &name)
+{
+    if (name == "lilypond") {
+        return format::lilypond;
+    }
+    if (name == "debug") {
+        return format::debug;
+    }
+    if (name == "json") {
+        return format::json;
+    }
+    throw stan::exception("unknown output format: {}", name);
+}
+
+inline const char *extension(format f)
+{
+    switch (f) {
+    case format::lilypond:
+        return ".ly";
+    case format::debug:
+        return ".txt";
+    case format::json:
+        return ".json";
+    }
+    return "";
+}
+
+// The writers are stateless, but a tool holds one of these per thread so that
+// any state they grow later stays thread local.
+struct writer
+{
+    stan::lilypond::writer m_lilypond;
+    stan::driver::debug::writer m_debug;
+    stan::driver::json::writer m_json;
+
+    std::string operator()(format f, const sequential &music) const
+    {
+        switch (f) {
+        case format::lilypond:
+            return m_lilypond(music);
+        case format::debug:
+            return m_debug(music);
+        case format::json:
+            return m_json(music);
+        }
+        return std::string();
+    }
+};
+
+} // namespace stan::tools
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <stan/exception.hpp>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Wire protocol between stan-daemon and its clients, over a Unix domain
+// stream socket.  Every message is a four byte big endian length followed by
+// that many bytes of payload.  A request payload is a command line, a newline,
+// and the LilyPond input:
+//
+//     parse\n{ c4 d4 }          reply: the debug writer's rendering
+//     convert debug\n{ c4 d4 }  reply: the input in the named format
+//     validate\n{ c4 d4 }       reply: a one line summary
+//     ping\n                    reply: pong
+//
+// A reply payload is "ok\n" or "error\n" followed by the body.  A connection
+// carries any number of request/reply pairs, in order.
+
+namespace stan::protocol {
+
+// Generous for any score, small enough that a corrupt length prefix cannot
+// make the daemon allocate without bound.
+constexpr std::uint32_t max_message = 64u << 20;
+
+struct error : stan::exception
+{
+    template <typename... Args>
+    error(const char *format, Args... args) :
+        stan::exception((std::string("protocol error: ") + format).c_str(),
+                        std::forward<Args>(args)...) {}
+};
+
+// Returns false if the peer closed the connection before the first byte.
+inline bool read_exactly(int fd, char *data, std::size_t size)
+{
+    std::size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::read(fd, data + done, size - done);
+        if (n == 0 and done == 0) {
+            return false;
+        }
+        if (n == 0) {
+            throw error("connection closed mid message");
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw error("read: {}", std::strerror(errno));
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+inline void write_exactly(int fd, const char *data, std::size_t size)
+{
+    std::size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::send(fd, data + done, size - done, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw error("write: {}", std::strerror(errno));
+        }
+        done += static_cast<std::size_t>(n);
+    }
+}
+
+// Reads one message into payload, reusing its storage.  Returns false on a
+// clean end of stream.
+inline bool read_message(int fd, std::string &payload)
+{
+    unsigned char header[4];
+    if (!read_exactly(fd, reinterpret_cast<char *>(header), sizeof(header))) {
+        return false;
+    }
+
+    std::uint32_t size = (std::uint32_t(header[0]) << 24) |
+        (std::uint32_t(header[1]) << 16) | (std::uint32_t(header[2]) << 8) |
+        std::uint32_t(header[3]);
+    if (size > max_message) {
+        throw error("message of {} bytes exceeds the {} byte limit", size, max_message);
+    }
+
+    payload.resize(size);
+    if (size > 0 and !read_exactly(fd, &payload[0], size)) {
+        throw error("connection closed mid message");
+    }
+    return true;
+}
+
+inline void write_message(int fd, const std::string &payload)
+{
+    if (payload.size() > max_message) {
+        throw error("message of {} bytes exceeds the {} byte limit",
+                    payload.size(), max_message);
+    }
+
+    auto size = static_cast<std::uint32_t>(payload.size());
+    unsigned char header[4] = {
+        static_cast<unsigned char>(size >> 24),
+        static_cast<unsigned char>(size >> 16),
+        static_cast<unsigned char>(size >> 8),
+        static_cast<unsigned char>(size),
+    };
+    write_exactly(fd, reinterpret_cast<const char *>(header), sizeof(header));
+    write_exactly(fd, payload.data(), payload.size());
+}
+
+inline sockaddr_un address(const std::string &path)
+{
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw error("socket path too long: {}", path);
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+inline constexpr const char *default_socket = "/tmp/stan-daemon.sock";
+
+} // namespace stan::protocol
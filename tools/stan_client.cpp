@@ -0,0 +1,116 @@
+#include "protocol.hpp"
+
+#include <fmt/format.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// stan-client sends one request per input file to a running stan-daemon and
+// prints each reply.  It exists so the daemon can be driven and tested from a
+// shell with nothing but the tools built here.
+
+namespace {
+
+const char *usage = R"(usage: stan-client [-s SOCKET] COMMAND [file...]
+
+Send requests to stan-daemon, one per file, or one for stdin if no files are
+given.  COMMAND is one of: parse, validate, ping, or "convert FORMAT".
+
+options:
+  -s, --socket PATH     daemon socket (default: /tmp/stan-daemon.sock)
+  -h, --help            show this message
+)";
+
+std::string slurp(std::istream &in)
+{
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string socket_path = stan::protocol::default_socket;
+    std::string command;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-s" or arg == "--socket") and i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "-h" or arg == "--help") {
+            std::cout << usage;
+            return 0;
+        } else if (command.empty()) {
+            command = arg;
+            if (command == "convert" and i + 1 < argc) {
+                command += std::string(" ") + argv[++i];
+            }
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (command.empty()) {
+        fmt::print(stderr, "{}", usage);
+        return 2;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    try {
+        sockaddr_un addr = stan::protocol::address(socket_path);
+        if (fd < 0 or ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+            throw stan::exception("cannot connect to {}: {}", socket_path, std::strerror(errno));
+        }
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-client: {}\n", e.what());
+        return 1;
+    }
+
+    std::vector<std::string> bodies;
+    if (files.empty()) {
+        bodies.push_back(command == "ping" ? std::string() : slurp(std::cin));
+    }
+    for (const auto &path : files) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            fmt::print(stderr, "stan-client: cannot open {}\n", path);
+            return 1;
+        }
+        bodies.push_back(slurp(in));
+    }
+
+    int status = 0;
+    try {
+        std::string reply;
+        for (const auto &body : bodies) {
+            stan::protocol::write_message(fd, command + '\n' + body);
+            if (!stan::protocol::read_message(fd, reply)) {
+                throw stan::exception("daemon closed the connection");
+            }
+
+            std::size_t newline = reply.find('\n');
+            std::string text = newline == std::string::npos ? std::string() : reply.substr(newline + 1);
+            if (reply.compare(0, newline, "ok") == 0) {
+                std::cout << text << '\n';
+            } else {
+                fmt::print(stderr, "stan-client: {}\n", text);
+                status = 1;
+            }
+        }
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-client: {}\n", e.what());
+        status = 1;
+    }
+
+    ::close(fd);
+    return status;
+}
@@ -0,0 +1,373 @@
+#include "format.hpp"
+
+#include <stan/driver/lilypond_cache.hpp>
+#include <stan/driver/lilypond_include.hpp>
+#include <stan/ingest.hpp>
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// stan-convert reads LilyPond music lists and writes them back out through one
+// of stan's writers.  Inputs come from the command line, a manifest file, or
+// both.  stan::ingest() loads them with many reads in flight and hands each
+// file's contents to a fixed pool of worker threads, which own their reader
+// and writer for the whole run, so a corpus of small files costs no per-file
+// setup and no worker ever blocks on I/O.
+
+namespace {
+
+const char *usage = R"(usage: stan-convert [options] [input...]
+
+Convert LilyPond input files with a pool of worker threads.  Inputs may be
+gzip or zstd compressed.
+
+options:
+  -t, --to FORMAT       output format: lilypond (default), debug or json
+  -o, --output DIR      write each result to DIR/<name>.<ext> instead of stdout
+  -m, --manifest FILE   also convert the files listed in FILE, one per line;
+                        "-" reads the list from stdin
+  -j, --jobs N          number of worker threads (default: one per core)
+  -I, --include-path DIR
+                        also look for \include files in DIR; may be repeated
+  -c, --cache DIR       keep parse results in DIR and reuse them for inputs
+                        that have not changed since an earlier run
+      --cache-size MB   evict least recently used entries beyond MB
+                        megabytes (default: 1024)
+      --io BACKEND      how to read inputs: auto (default), io_uring or
+                        threads
+  -q, --quiet           report only errors and the summary
+  -h, --help            show this message
+)";
+
+struct options
+{
+    stan::tools::format m_format = stan::tools::format::lilypond;
+    std::string m_output;
+    std::vector<std::string> m_inputs;
+    unsigned m_jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::string m_cache;
+    std::vector<std::string> m_include_path;
+    std::uint64_t m_cache_megabytes = 1024;
+    stan::ingest_backend m_io = stan::ingest_backend::automatic;
+    bool m_quiet = false;
+};
+
+struct result
+{
+    bool m_ok = false;
+    double m_millis = 0;
+    std::string m_error;
+};
+
+std::string basename(const std::string &path)
+{
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    for (const std::string suffix : { ".gz", ".zst" }) {
+        if (name.size() > suffix.size() and
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            name.resize(name.size() - suffix.size());
+        }
+    }
+    std::size_t dot = name.find_last_of('.');
+    return dot == 0 or dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+void write_file(const std::string &path, const std::string &text)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << text << '\n';
+    if (!out) {
+        throw stan::exception("cannot write {}: {}", path, std::strerror(errno));
+    }
+}
+
+void read_manifest(std::istream &in, std::vector<std::string> &inputs)
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() and line.front() != '#') {
+            inputs.push_back(line);
+        }
+    }
+}
+
+options parse_options(int argc, char **argv)
+{
+    options opts;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw stan::exception("{} requires an argument", arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-h" or arg == "--help") {
+            std::cout << usage;
+            std::exit(0);
+        } else if (arg == "-t" or arg == "--to") {
+            opts.m_format = stan::tools::parse_format(next());
+        } else if (arg == "-o" or arg == "--output") {
+            opts.m_output = next();
+        } else if (arg == "-m" or arg == "--manifest") {
+            std::string path = next();
+            if (path == "-") {
+                read_manifest(std::cin, opts.m_inputs);
+            } else {
+                std::ifstream manifest(path);
+                if (!manifest) {
+                    throw stan::exception("cannot open manifest {}", path);
+                }
+                read_manifest(manifest, opts.m_inputs);
+            }
+        } else if (arg == "-j" or arg == "--jobs") {
+            opts.m_jobs = static_cast<unsigned>(std::max(1, std::stoi(next())));
+        } else if (arg == "-I" or arg == "--include-path") {
+            opts.m_include_path.push_back(next());
+        } else if (arg == "-c" or arg == "--cache") {
+            opts.m_cache = next();
+        } else if (arg == "--cache-size") {
+            opts.m_cache_megabytes = std::stoull(next());
+        } else if (arg == "--io") {
+            std::string backend = next();
+            if (backend == "auto") {
+                opts.m_io = stan::ingest_backend::automatic;
+            } else if (backend == "io_uring") {
+                opts.m_io = stan::ingest_backend::io_uring;
+            } else if (backend == "threads") {
+                opts.m_io = stan::ingest_backend::threads;
+            } else {
+                throw stan::exception("unknown io backend: {}", backend);
+            }
+        } else if (arg == "-q" or arg == "--quiet") {
+            opts.m_quiet = true;
+        } else if (arg.size() > 1 and arg.front() == '-') {
+            throw stan::exception("unknown option: {}", arg);
+        } else {
+            opts.m_inputs.push_back(arg);
+        }
+    }
+
+    return opts;
+}
+
+struct loaded
+{
+    std::size_t m_index;
+    std::string m_contents;
+    int m_error;
+};
+
+// Carries files from ingestion to the workers.  Bounded, so that reading
+// faster than the workers convert does not pull the whole corpus into memory.
+class work_queue
+{
+  public:
+    explicit work_queue(std::size_t capacity) : m_capacity(capacity) {}
+
+    void push(loaded &&l)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this] { return m_items.size() < m_capacity; });
+        m_items.push_back(std::move(l));
+        m_not_empty.notify_one();
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_not_empty.notify_all();
+    }
+
+    // Returns false once the queue is closed and empty.
+    bool pop(loaded &l)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this] { return m_closed or !m_items.empty(); });
+        if (m_items.empty()) {
+            return false;
+        }
+        l = std::move(m_items.front());
+        m_items.pop_front();
+        m_not_full.notify_one();
+        return true;
+    }
+
+  private:
+    std::size_t m_capacity;
+    std::deque<loaded> m_items;
+    bool m_closed = false;
+    std::mutex m_mutex;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+};
+
+struct worker
+{
+    const options &m_options;
+    std::mutex &m_output_mutex;
+    stan::lilypond::cached_reader *m_cache;
+    stan::lilypond::include_reader &m_includes;
+
+    stan::lilypond::reader m_read;
+    stan::tools::writer m_write;
+
+    result convert(const std::string &path, const loaded &l)
+    {
+        auto start = std::chrono::steady_clock::now();
+        result r;
+
+        try {
+            if (l.m_error != 0) {
+                throw stan::exception("cannot read: {}", std::strerror(l.m_error));
+            }
+            // The cache is keyed on text, so compressed input bypasses it,
+            // and the include reader is shared by all workers, so a file
+            // included from many inputs is parsed once for the whole run.
+            stan::sequential music = stan::lilypond::read_contents(
+                path, l.m_contents, m_includes, [&](const std::string &text) {
+                    return m_cache ? m_cache->sequence(text) : m_read.sequence(text);
+                });
+            std::string text = m_write(m_options.m_format, music);
+
+            if (m_options.m_output.empty()) {
+                std::lock_guard<std::mutex> lock(m_output_mutex);
+                std::cout << text << '\n';
+            } else {
+                write_file(m_options.m_output + '/' + basename(path) +
+                               stan::tools::extension(m_options.m_format),
+                           text);
+            }
+            r.m_ok = true;
+        } catch (std::exception &e) {
+            r.m_error = e.what();
+        }
+
+        r.m_millis = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+        return r;
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    options opts;
+    try {
+        opts = parse_options(argc, argv);
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-convert: {}\n\n{}", e.what(), usage);
+        return 2;
+    }
+
+    if (opts.m_inputs.empty()) {
+        fmt::print(stderr, "stan-convert: no input files\n\n{}", usage);
+        return 2;
+    }
+
+    stan::lilypond::include_reader includes(opts.m_include_path);
+    std::unique_ptr<stan::lilypond::cached_reader> cache;
+    if (!opts.m_cache.empty()) {
+        try {
+            cache = std::make_unique<stan::lilypond::cached_reader>(
+                opts.m_cache, opts.m_cache_megabytes << 20);
+        } catch (std::exception &e) {
+            fmt::print(stderr, "stan-convert: {}\n", e.what());
+            return 2;
+        }
+    }
+
+    unsigned jobs = static_cast<unsigned>(
+        std::min<std::size_t>(opts.m_jobs, opts.m_inputs.size()));
+    work_queue queue(4 * jobs);
+    std::atomic<std::size_t> failures{ 0 };
+    std::mutex output_mutex;
+    std::mutex report_mutex;
+
+    auto run = [&]() {
+        worker w{ opts, output_mutex, cache.get(), includes };
+        loaded l;
+        while (queue.pop(l)) {
+            const std::string &path = opts.m_inputs[l.m_index];
+            result r = w.convert(path, l);
+
+            if (!r.m_ok) {
+                ++failures;
+            }
+            if (!r.m_ok or !opts.m_quiet) {
+                std::lock_guard<std::mutex> lock(report_mutex);
+                if (r.m_ok) {
+                    fmt::print(stderr, "ok    {:9.3f}ms  {}\n", r.m_millis, path);
+                } else {
+                    fmt::print(stderr, "error {:9.3f}ms  {}: {}\n", r.m_millis, path, r.m_error);
+                }
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> pool;
+    for (unsigned j = 0; j < jobs; ++j) {
+        pool.emplace_back(run);
+    }
+
+    stan::ingest_options io;
+    io.m_backend = opts.m_io;
+    io.m_threads = jobs;
+    stan::ingest_backend used = stan::ingest_backend::automatic;
+    try {
+        used = stan::ingest(
+            opts.m_inputs,
+            [&](std::size_t index, std::string &contents, int error) {
+                queue.push({ index, std::move(contents), error });
+            },
+            io);
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-convert: {}\n", e.what());
+        queue.close();
+        for (auto &t : pool) {
+            t.join();
+        }
+        return 2;
+    }
+    queue.close();
+    for (auto &t : pool) {
+        t.join();
+    }
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    fmt::print(stderr, "converted {} of {} files in {:.3f}s with {} jobs and {} ({} errors)\n",
+               opts.m_inputs.size() - failures, opts.m_inputs.size(), seconds,
+               jobs, stan::to_string(used), failures.load());
+    if (cache) {
+        auto stats = cache->stats();
+        fmt::print(stderr, "cache: {} hits, {} misses, {} evictions\n", stats.m_hits,
+                   stats.m_misses, stats.m_evictions);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+#include "format.hpp"
+#include "protocol.hpp"
+
+#include <fmt/format.h>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+// stan-daemon keeps stan loaded and its tables warm, and serves parse, convert
+// and validate requests over a Unix domain socket (see protocol.hpp).  The
+// main thread accepts connections and queues them; a fixed pool of workers
+// each serve one connection at a time, with a reader and writers that live as
+// long as the worker does.  A connection left idle for longer than the idle
+// timeout is closed, so clients that hold connections open cannot keep the
+// ones queued behind them waiting for a worker.
+
+namespace {
+
+const char *usage = R"(usage: stan-daemon [options]
+
+Serve stan requests over a Unix domain socket.
+
+options:
+  -s, --socket PATH     socket to listen on (default: /tmp/stan-daemon.sock)
+  -j, --jobs N          number of worker threads (default: one per core)
+  -i, --idle SECONDS    close connections idle this long (default: 30)
+  -h, --help            show this message
+)";
+
+std::string socket_path = stan::protocol::default_socket;
+int idle_seconds = 30;
+
+extern "C" void on_signal(int)
+{
+    ::unlink(socket_path.c_str());
+    std::_Exit(0);
+}
+
+// Connections waiting for a worker.
+struct connection_queue
+{
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<int> m_fds;
+
+    void push(int fd)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_fds.push_back(fd);
+        }
+        m_ready.notify_one();
+    }
+
+    int pop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_ready.wait(lock, [this] { return !m_fds.empty(); });
+        int fd = m_fds.front();
+        m_fds.pop_front();
+        return fd;
+    }
+};
+
+struct worker
+{
+    stan::lilypond::reader m_read;
+    stan::tools::writer m_write;
+    std::string m_request;
+
+    std::string handle(const std::string &request)
+    {
+        std::size_t newline = request.find('\n');
+        std::string command = request.substr(0, newline);
+        std::string body = newline == std::string::npos ? std::string()
+                                                        : request.substr(newline + 1);
+
+        if (command == "ping") {
+            return "pong";
+        }
+        if (command == "parse") {
+            return m_write(stan::tools::format::debug, m_read.sequence(body));
+        }
+        if (command.compare(0, 8, "convert ") == 0) {
+            stan::tools::format f = stan::tools::parse_format(command.substr(8));
+            return m_write(f, m_read.sequence(body));
+        }
+        if (command == "validate") {
+            stan::sequential music = m_read.sequence(body);
+            stan::duration total = std::accumulate(
+                music.begin(), music.end(), stan::duration::zero(),
+                [](stan::duration d, const stan::column &c) { return d + c; });
+            return fmt::format("valid: {} columns, duration {}/{}",
+                               music.size(), total.num(), total.den());
+        }
+        throw stan::exception("unknown command: {}", command);
+    }
+
+    // Waits for the start of the next request, and returns false if none
+    // comes within the idle timeout.
+    static bool ready(int fd)
+    {
+        pollfd p{ fd, POLLIN, 0 };
+        for (;;) {
+            int n = ::poll(&p, 1, idle_seconds * 1000);
+            if (n >= 0 or errno != EINTR) {
+                return n != 0;
+            }
+        }
+    }
+
+    void serve(int fd)
+    {
+        // The same timeout bounds a client that stalls partway through a
+        // request.
+        timeval timeout{ idle_seconds, 0 };
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        try {
+            while (ready(fd) and stan::protocol::read_message(fd, m_request)) {
+                std::string reply;
+                try {
+                    reply = "ok\n" + handle(m_request);
+                } catch (std::exception &e) {
+                    reply = std::string("error\n") + e.what();
+                }
+                stan::protocol::write_message(fd, reply);
+            }
+        } catch (std::exception &e) {
+            fmt::print(stderr, "stan-daemon: dropping connection: {}\n", e.what());
+        }
+        ::close(fd);
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-s" or arg == "--socket") and i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if ((arg == "-j" or arg == "--jobs") and i + 1 < argc) {
+            jobs = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if ((arg == "-i" or arg == "--idle") and i + 1 < argc) {
+            idle_seconds = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-h" or arg == "--help") {
+            std::cout << usage;
+            return 0;
+        } else {
+            fmt::print(stderr, "stan-daemon: bad argument: {}\n\n{}", arg, usage);
+            return 2;
+        }
+    }
+
+    // Warm up before accepting anything, so no client pays for the lazily
+    // built parser tables.
+    worker{}.handle("validate\n{ c4 <c e g>8 [c16 d16] \\tuplet 3/2 {c8 d8 e8} "
+                    "\\key c \\major \\clef treble \\time 4/4 r4 }");
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        fmt::print(stderr, "stan-daemon: socket: {}\n", std::strerror(errno));
+        return 1;
+    }
+
+    sockaddr_un addr;
+    try {
+        addr = stan::protocol::address(socket_path);
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-daemon: {}\n", e.what());
+        return 1;
+    }
+    ::unlink(socket_path.c_str());
+    if (::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 or
+        ::listen(listener, SOMAXCONN) < 0) {
+        fmt::print(stderr, "stan-daemon: {}: {}\n", socket_path, std::strerror(errno));
+        return 1;
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    connection_queue queue;
+    std::vector<std::thread> pool;
+    for (unsigned j = 0; j < jobs; ++j) {
+        pool.emplace_back([&queue] {
+            worker w;
+            for (;;) {
+                w.serve(queue.pop());
+            }
+        });
+    }
+
+    fmt::print(stderr, "stan-daemon: listening on {} with {} workers\n", socket_path, jobs);
+
+    for (;;) {
+        int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR or errno == ECONNABORTED) {
+                continue;
+            }
+            fmt::print(stderr, "stan-daemon: accept: {}\n", std::strerror(errno));
+            break;
+        }
+        queue.push(fd);
+    }
+
+    ::unlink(socket_path.c_str());
+    return 1;
+}
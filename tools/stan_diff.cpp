@@ -0,0 +1,51 @@
+#include <stan/diff.hpp>
+#include <stan/driver/lilypond_include.hpp>
+
+#include <fmt/format.h>
+
+#include <iostream>
+#include <string>
+
+// stan-diff prints the structural differences between two LilyPond music
+// lists, one line per edit, and like diff(1) exits 1 when they differ.
+
+namespace {
+
+const char *usage = R"(usage: stan-diff OLD NEW
+
+Compare two LilyPond files column by column, looking inside beams and
+tuplets, and print one line per change:
+
+  ~ 4.2    e4:8 -> f4:8      the second element of column 4 was replaced
+  - 7      r:4               column 7 of OLD was removed
+  + 9      c4:4              column 9 of NEW was inserted
+
+Includes are resolved and inputs may be gzip or zstd compressed.  Exits 0 if the files are the same,
+1 if they differ, and 2 on error.
+)";
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 and (std::string(argv[1]) == "-h" or std::string(argv[1]) == "--help")) {
+        std::cout << usage;
+        return 0;
+    }
+    if (argc != 3) {
+        fmt::print(stderr, "{}", usage);
+        return 2;
+    }
+
+    try {
+        stan::lilypond::include_reader read;
+        stan::sequential from = read.read(argv[1]);
+        stan::sequential to = read.read(argv[2]);
+        std::vector<stan::diff::edit> edits = stan::diff::compare(from, to);
+        std::cout << stan::diff::summary(edits);
+        return edits.empty() ? 0 : 1;
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-diff: {}\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,140 @@
+#include <stan/driver/arrow.hpp>
+#include <stan/driver/lilypond_include.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// stan-export writes the notes of many LilyPond files as one Arrow table,
+// for analysis with columnar tools.
+
+namespace {
+
+const char *usage = R"(usage: stan-export -o OUTPUT [options] [input...]
+
+Write every note of the inputs, which may be gzip or zstd compressed, to
+OUTPUT as an Arrow IPC file, one row per note.  The score column holds each
+input's position on the command line, counting manifest entries in order,
+from zero.
+
+options:
+  -o, --output FILE     the Arrow file to write
+  -m, --manifest FILE   also read the files listed in FILE, one per line;
+                        "-" reads the list from stdin
+  -j, --jobs N          parse and flatten with N threads (default: one per
+                        core)
+  -I, --include-path DIR
+                        also look for \include files in DIR; may be repeated
+)";
+
+void read_manifest(std::istream &in, std::vector<std::string> &inputs)
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() and line.front() != '#') {
+            inputs.push_back(line);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string output;
+    std::vector<std::string> inputs;
+    std::vector<std::string> include_path;
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw stan::exception("{} requires an argument", arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "-h" or arg == "--help") {
+                std::cout << usage;
+                return 0;
+            } else if (arg == "-o" or arg == "--output") {
+                output = next();
+            } else if (arg == "-m" or arg == "--manifest") {
+                std::string path = next();
+                if (path == "-") {
+                    read_manifest(std::cin, inputs);
+                } else {
+                    std::ifstream manifest(path);
+                    if (!manifest) {
+                        throw stan::exception("cannot open manifest {}", path);
+                    }
+                    read_manifest(manifest, inputs);
+                }
+            } else if (arg == "-j" or arg == "--jobs") {
+                jobs = static_cast<unsigned>(std::max(1, std::stoi(next())));
+            } else if (arg == "-I" or arg == "--include-path") {
+                include_path.push_back(next());
+            } else if (arg.size() > 1 and arg.front() == '-') {
+                throw stan::exception("unknown option: {}", arg);
+            } else {
+                inputs.push_back(arg);
+            }
+        }
+        if (output.empty()) {
+            throw stan::exception("no output file");
+        }
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-export: {}\n\n{}", e.what(), usage);
+        return 2;
+    }
+
+    std::vector<stan::sequential> scores(inputs.size());
+    std::atomic<std::size_t> next{ 0 };
+    std::atomic<std::size_t> failures{ 0 };
+    stan::lilypond::include_reader read(include_path);
+
+    auto parse = [&]() {
+        for (std::size_t i; (i = next++) < inputs.size();) {
+            try {
+                scores[i] = read.read(inputs[i]);
+            } catch (std::exception &e) {
+                ++failures;
+                fmt::print(stderr, "error {}: {}\n", inputs[i], e.what());
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned j = 1; j < jobs; ++j) {
+        pool.emplace_back(parse);
+    }
+    parse();
+    for (auto &t : pool) {
+        t.join();
+    }
+
+    try {
+        stan::driver::arrow::writer write;
+        write.m_threads = jobs;
+        std::string table = write(scores);
+        std::ofstream out(output, std::ios::binary | std::ios::trunc);
+        out.write(table.data(), static_cast<std::streamsize>(table.size()));
+        if (!out) {
+            throw stan::exception("cannot write {}", output);
+        }
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-export: {}\n", e.what());
+        return 2;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+#include <stan/index.hpp>
+#include <stan/driver/lilypond.hpp>
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// stan-index builds an n-gram index over a library of LilyPond files and
+// finds the files that contain a melodic or rhythmic fragment.
+
+namespace {
+
+const char *usage = R"(usage: stan-index build INDEX [options] [FILE...]
+       stan-index search INDEX [--melody | --rhythm] MUSIC
+
+build writes an index of the given LilyPond files, which may be gzip or zstd
+compressed, into the directory INDEX.
+
+  -m, --manifest FILE   also index the files listed in FILE, one per line;
+                        "-" reads the list from stdin
+  -j, --jobs N          build N shards at once (default: one per core)
+  -n, --length N        notes per n-gram (default: 4)
+  --shard-size N        documents per shard (default: 16384)
+  -I, --include-path DIR
+                        also look for \include files in DIR; may be repeated
+  -q, --quiet           do not report files that fail to parse
+
+search prints the files whose melody contains every n-gram of MUSIC, given
+in LilyPond notation, such as "c'8 d'8 e'4 g'4".  Intervals match in any
+key and durations at any tempo.  --melody matches the intervals alone and
+--rhythm the durations alone.  Exits 0 if anything matched, 1 if nothing
+did, and 2 on error.
+)";
+
+void read_manifest(std::istream &in, std::vector<std::string> &inputs)
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() and line.front() != '#') {
+            inputs.push_back(line);
+        }
+    }
+}
+
+int build(int argc, char **argv)
+{
+    std::string directory = argv[2];
+    std::vector<std::string> inputs;
+    stan::index::build_options options;
+    bool quiet = false;
+
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw stan::exception("{} requires an argument", arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-m" or arg == "--manifest") {
+            std::string path = next();
+            if (path == "-") {
+                read_manifest(std::cin, inputs);
+            } else {
+                std::ifstream manifest(path);
+                if (!manifest) {
+                    throw stan::exception("cannot open manifest {}", path);
+                }
+                read_manifest(manifest, inputs);
+            }
+        } else if (arg == "-j" or arg == "--jobs") {
+            options.m_threads = static_cast<unsigned>(std::max(1, std::stoi(next())));
+        } else if (arg == "-n" or arg == "--length") {
+            options.m_length = static_cast<unsigned>(std::max(0, std::stoi(next())));
+        } else if (arg == "--shard-size") {
+            options.m_shard_documents = std::stoull(next());
+        } else if (arg == "-I" or arg == "--include-path") {
+            options.m_include_path.push_back(next());
+        } else if (arg == "-q" or arg == "--quiet") {
+            quiet = true;
+        } else if (arg.size() > 1 and arg.front() == '-') {
+            throw stan::exception("unknown option: {}", arg);
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    std::atomic<std::size_t> failures{ 0 };
+    std::mutex report_mutex;
+    auto start = std::chrono::steady_clock::now();
+
+    stan::index::build(directory, inputs, options,
+                       [&](std::size_t index, const std::string &message) {
+                           ++failures;
+                           if (!quiet) {
+                               std::lock_guard<std::mutex> lock(report_mutex);
+                               fmt::print(stderr, "error {}: {}\n", inputs[index], message);
+                           }
+                       });
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    fmt::print(stderr, "indexed {} files in {:.3f}s ({} errors)\n", inputs.size(), seconds,
+               failures.load());
+    return failures == 0 ? 0 : 1;
+}
+
+int search(int argc, char **argv)
+{
+    unsigned kinds = stan::index::both;
+    std::string music;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--melody") {
+            kinds = stan::index::melody;
+        } else if (arg == "--rhythm") {
+            kinds = stan::index::rhythm;
+        } else if (arg.size() > 1 and arg.front() == '-') {
+            throw stan::exception("unknown option: {}", arg);
+        } else if (music.empty()) {
+            music = arg;
+        } else {
+            throw stan::exception("expected one fragment of music");
+        }
+    }
+    if (music.empty()) {
+        throw stan::exception("no music to search for");
+    }
+
+    stan::index::searcher index(argv[2]);
+    stan::lilypond::reader read;
+    std::vector<std::size_t> found = index.search(read.sequence(music), kinds);
+    for (std::size_t d : found) {
+        std::cout << index.name(d) << '\n';
+    }
+    return found.empty() ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 and (std::string(argv[1]) == "-h" or std::string(argv[1]) == "--help")) {
+        std::cout << usage;
+        return 0;
+    }
+    if (argc < 3) {
+        fmt::print(stderr, "{}", usage);
+        return 2;
+    }
+
+    try {
+        std::string command = argv[1];
+        if (command == "build") {
+            return build(argc, argv);
+        } else if (command == "search") {
+            return search(argc, argv);
+        }
+        throw stan::exception("unknown command: {}", command);
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-index: {}\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,104 @@
+#include <stan/driver/lilypond.hpp>
+#include <stan/lint.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// stan-lint runs the standard style and correctness checks over LilyPond
+// music lists and prints what they find the way compilers do, so editors
+// can jump to each problem.
+
+namespace {
+
+const char *usage = R"(usage: stan-lint FILE...
+
+Check each file, a LilyPond music list, for parallel fifths, notes out of a
+piano's range, odd beaming, measures that do not match their meter and
+unnecessary accidentals, and print one line per problem:
+
+  song.ly:3:7: warning: beam crosses a bar line [odd-beaming]
+
+Files are checked in parallel, each as one voice.  Exits 0 if nothing was
+found, 1 if something was, and 2 on error.
+)";
+
+struct file
+{
+    std::string m_name;
+    std::string m_text;
+    std::vector<std::size_t> m_lines; // offset of each line's start
+    stan::sequential m_music;
+    std::vector<stan::source_span> m_spans;
+};
+
+std::string read(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error(fmt::format("cannot open {}", path));
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 and (std::string(argv[1]) == "-h" or std::string(argv[1]) == "--help")) {
+        std::cout << usage;
+        return 0;
+    }
+    if (argc < 2) {
+        fmt::print(stderr, "{}", usage);
+        return 2;
+    }
+
+    std::vector<file> files(argc - 1);
+    try {
+        stan::lilypond::reader reader;
+        for (std::size_t f = 0; f < files.size(); ++f) {
+            file &in = files[f];
+            in.m_name = argv[f + 1];
+            in.m_text = read(in.m_name);
+            in.m_lines.push_back(0);
+            for (std::size_t i = 0; i < in.m_text.size(); ++i) {
+                if (in.m_text[i] == '\n') {
+                    in.m_lines.push_back(i + 1);
+                }
+            }
+            try {
+                in.m_music = reader.sequence(in.m_text, in.m_spans);
+            } catch (std::exception &e) {
+                throw std::runtime_error(fmt::format("{}: {}", in.m_name, e.what()));
+            }
+        }
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-lint: {}\n", e.what());
+        return 2;
+    }
+
+    std::vector<stan::lint::voice> voices;
+    for (const auto &f : files) {
+        voices.emplace_back(f.m_music, &f.m_spans);
+    }
+    std::vector<stan::lint::diagnostic> found = stan::lint::check(voices);
+
+    for (const auto &d : found) {
+        const file &f = files[d.m_voice];
+        std::size_t offset = d.m_span ? d.m_span->m_begin : 0;
+        auto line = std::upper_bound(f.m_lines.begin(), f.m_lines.end(), offset) - 1;
+        fmt::print("{}:{}:{}: {}: {} [{}]\n", f.m_name, line - f.m_lines.begin() + 1,
+                   offset - *line + 1,
+                   d.m_severity == stan::lint::severity::error ? "error" : "warning",
+                   d.m_message, d.m_rule);
+    }
+    return found.empty() ? 0 : 1;
+}
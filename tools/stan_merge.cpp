@@ -0,0 +1,54 @@
+#include <stan/merge.hpp>
+#include <stan/driver/lilypond.hpp>
+#include <stan/driver/lilypond_include.hpp>
+
+#include <fmt/format.h>
+
+#include <iostream>
+#include <string>
+
+// stan-merge combines two edits of a LilyPond music list made from a common
+// ancestor, writing the result to stdout and any conflicts to stderr.
+
+namespace {
+
+const char *usage = R"(usage: stan-merge BASE OURS THEIRS
+
+Merge the changes from BASE to OURS and from BASE to THEIRS.  Changes in
+different measures are both applied.  Where both sides changed the same
+measures differently, OURS is kept and the conflict is reported on stderr.
+Exits 0 on a clean merge, 1 with conflicts, and 2 on error.
+)";
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 and (std::string(argv[1]) == "-h" or std::string(argv[1]) == "--help")) {
+        std::cout << usage;
+        return 0;
+    }
+    if (argc != 4) {
+        fmt::print(stderr, "{}", usage);
+        return 2;
+    }
+
+    try {
+        stan::lilypond::include_reader read;
+        stan::lilypond::writer write;
+        stan::merge::result r =
+            stan::merge::merge(read.read(argv[1]), read.read(argv[2]), read.read(argv[3]));
+
+        std::cout << write(r.m_merged) << '\n';
+        for (const auto &c : r.m_conflicts) {
+            fmt::print(stderr,
+                       "conflict in measures {}-{}:\n  base:   {}\n  ours:   {}\n  theirs: {}\n",
+                       c.m_first_measure + 1, c.m_last_measure + 1, write(c.m_base),
+                       write(c.m_ours), write(c.m_theirs));
+        }
+        return r.m_conflicts.empty() ? 0 : 1;
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-merge: {}\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,82 @@
+#include <stan/store.hpp>
+#include <stan/driver/lilypond.hpp>
+#include <stan/driver/lilypond_include.hpp>
+
+#include <fmt/format.h>
+
+#include <iostream>
+#include <string>
+
+// stan-store adds LilyPond files to a score store and reads bars back out.
+
+namespace {
+
+const char *usage = R"(usage: stan-store STORE put ID FILE
+       stan-store STORE get ID [FIRST [LAST]]
+       stan-store STORE remove ID
+
+put parses FILE, which may be gzip or zstd compressed, and stores it as
+score ID, replacing any score already stored with that ID.  get prints bars
+FIRST through LAST of score ID, counted from 1, or the whole score, and
+exits 1 if there is no such score.  The store is created if it does not
+exist.
+)";
+
+std::uint64_t number(const char *arg)
+{
+    std::size_t end = 0;
+    std::uint64_t n = std::stoull(arg, &end);
+    if (arg[end] != '\0') {
+        throw stan::exception("not a number: {}", arg);
+    }
+    return n;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 and (std::string(argv[1]) == "-h" or std::string(argv[1]) == "--help")) {
+        std::cout << usage;
+        return 0;
+    }
+    if (argc < 4) {
+        fmt::print(stderr, "{}", usage);
+        return 2;
+    }
+
+    try {
+        std::string command = argv[2];
+        std::uint64_t id = number(argv[3]);
+        stan::score_store store(argv[1]);
+
+        if (command == "put" and argc == 5) {
+            stan::lilypond::include_reader read;
+            store.put(id, read.read(argv[4]));
+            return 0;
+        }
+        if (command == "remove" and argc == 4) {
+            store.remove(id);
+            return 0;
+        }
+        if (command == "get" and argc <= 6) {
+            std::size_t first = argc > 4 ? number(argv[4]) : 1;
+            std::size_t last = argc > 5 ? number(argv[5]) : argc > 4 ? first : SIZE_MAX;
+            if (first == 0 or last == 0) {
+                throw stan::exception("bars are counted from 1");
+            }
+            if (store.measures(id) == 0) {
+                fmt::print(stderr, "stan-store: no score {}\n", id);
+                return 1;
+            }
+            stan::lilypond::writer write;
+            std::cout << write(store.get(id, first - 1, last - 1)) << '\n';
+            return 0;
+        }
+        fmt::print(stderr, "{}", usage);
+        return 2;
+    } catch (std::exception &e) {
+        fmt::print(stderr, "stan-store: {}\n", e.what());
+        return 2;
+    }
+}
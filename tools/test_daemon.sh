@@ -0,0 +1,68 @@
+#!/bin/sh
+# End to end check of stan-daemon through stan-client, run by ctest.
+# usage: test_daemon.sh BINDIR
+
+set -e
+
+bin="$1"
+dir=$(mktemp -d)
+socket="$dir/stan.sock"
+trap 'kill $daemon 2>/dev/null; rm -rf "$dir"' EXIT
+
+"$bin/stan-daemon" --socket "$socket" --jobs 2 --idle 2 &
+daemon=$!
+
+tries=0
+until "$bin/stan-client" -s "$socket" ping >/dev/null 2>&1; do
+    tries=$((tries + 1))
+    [ $tries -lt 50 ] || { echo "daemon did not start"; exit 1; }
+    sleep 0.1
+done
+
+expect() {
+    if [ "$1" != "$2" ]; then
+        echo "expected: $2"
+        echo "     got: $1"
+        exit 1
+    fi
+}
+
+echo "{ c4 [d8 e8] }" > "$dir/good.ly"
+echo "{ c4 crash }" > "$dir/bad.ly"
+
+expect "$("$bin/stan-client" -s "$socket" parse "$dir/good.ly")" "{c4:4 [d4:8 e4:8]}"
+expect "$("$bin/stan-client" -s "$socket" convert lilypond "$dir/good.ly")" "{ c4 [d8 e8] }"
+expect "$("$bin/stan-client" -s "$socket" validate "$dir/good.ly")" "valid: 2 columns, duration 1/2"
+
+if "$bin/stan-client" -s "$socket" validate "$dir/bad.ly" 2>/dev/null; then
+    echo "invalid input was accepted"
+    exit 1
+fi
+
+# Many clients at once, more than there are workers.
+clients=
+for i in 1 2 3 4 5 6 7 8; do
+    "$bin/stan-client" -s "$socket" validate "$dir/good.ly" "$dir/good.ly" > "$dir/out.$i" &
+    clients="$clients $!"
+done
+wait $clients
+for i in 1 2 3 4 5 6 7 8; do
+    expect "$(sort -u "$dir/out.$i")" "valid: 2 columns, duration 1/2"
+done
+
+# Idle connections on every worker do not keep a new client waiting past
+# the idle timeout.  Each idle client is connected and waiting on a fifo
+# that never delivers its request.
+mkfifo "$dir/idle"
+exec 3<>"$dir/idle"
+idle=
+for i in 1 2; do
+    "$bin/stan-client" -s "$socket" validate < "$dir/idle" > /dev/null 2>&1 &
+    idle="$idle $!"
+done
+sleep 0.5
+expect "$(timeout 10 "$bin/stan-client" -s "$socket" ping)" "pong"
+kill $idle 2>/dev/null || true
+exec 3>&-
+
+echo "ok"